@@ -22,6 +22,20 @@ document.addEventListener('DOMContentLoaded', () => {
         }
     });
 
+    // Los widgets muestran el sensor principal (el primero de /api/latest);
+    // el stream manda las muestras de todos los sensores.
+    let primarySensor = null;
+
+    const showReading = (data) => {
+        if (data.error || data.temp === null || data.hum === null) {
+            tempValue.textContent = 'Error';
+            humValue.textContent = 'Error';
+            return;
+        }
+        tempValue.textContent = `${data.temp.toFixed(1)} °C`;
+        humValue.textContent = `${data.hum.toFixed(1)} %`;
+    };
+
     // Function to fetch and update sensor data
     const fetchSensorData = async () => {
         try {
@@ -30,35 +44,115 @@ document.addEventListener('DOMContentLoaded', () => {
             if (data.error) {
                 throw new Error(data.error);
             }
-            tempValue.textContent = `${data.temp.toFixed(1)} °C`;
-            humValue.textContent = `${data.hum.toFixed(1)} %`;
+            if (data.sensors && data.sensors.length) {
+                primarySensor = data.sensors[0].sensor;
+            }
+            showReading(data);
         } catch (error) {
             console.error('Error fetching sensor data:', error);
-            tempValue.textContent = 'Error';
-            humValue.textContent = 'Error';
+            showReading({ error: error.message });
+        }
+    };
+
+    // --- Actualización en vivo ---
+    // /api/stream empuja cada lectura y cada cambio del actuador. Si el
+    // navegador no tiene EventSource o el ESP32 rechaza la conexión (máximo de
+    // suscriptores), se vuelve al sondeo cada 30 s como antes.
+    const POLL_INTERVAL_MS = 30000;
+    const STREAM_MAX_FAILURES = 3;
+    let pollTimer = null;
+
+    const startPolling = () => {
+        if (pollTimer) return;
+        fetchSensorData();
+        pollTimer = setInterval(fetchSensorData, POLL_INTERVAL_MS);
+    };
+
+    const stopPolling = () => {
+        clearInterval(pollTimer);
+        pollTimer = null;
+    };
+
+    const startStream = () => {
+        if (!window.EventSource) {
+            startPolling();
+            return;
         }
+        let failures = 0;
+        const source = new EventSource('/api/stream');
+        source.onopen = () => {
+            failures = 0;
+            stopPolling();
+        };
+        source.addEventListener('sample', (e) => {
+            const sample = JSON.parse(e.data);
+            if (primarySensor === null || sample.sensor === primarySensor) {
+                showReading(sample);
+            }
+        });
+        source.addEventListener('actuator', (e) => {
+            showActuator(JSON.parse(e.data));
+        });
+        source.onerror = () => {
+            // EventSource reintenta solo; mientras tanto se sondea.
+            startPolling();
+            if (++failures >= STREAM_MAX_FAILURES || source.readyState === EventSource.CLOSED) {
+                source.close();
+            }
+        };
     };
 
-    // Initial fetch and set interval
+    // Initial fetch and live updates
     fetchSensorData();
-    setInterval(fetchSensorData, 30000); // Update every 30 seconds
+    startStream();
 
     // --- Funcionalidad del Actuador ---
 
-    // Variable para almacenar el historial de cambios del actuador
-    const actuatorHistory = JSON.parse(localStorage.getItem('actuatorHistory')) || [];
+    // El historial lo guarda el ESP32 (/api/actuator/history), así que todos
+    // los navegadores ven el mismo; se pide por páginas hacia atrás.
+    const ACTUATOR_PAGE = 50;
+    const ACTUATOR_SOURCES = { api: 'Manual', controller: 'Termostato', rule: 'Seguridad' };
+
+    const formatActuatorTime = (ts) => ts ? new Date(ts * 1000).toLocaleString('es-ES', {
+        year: 'numeric',
+        month: '2-digit',
+        day: '2-digit',
+        hour: '2-digit',
+        minute: '2-digit',
+        second: '2-digit'
+    }) : 'Sin hora';
+
+    const fetchActuatorPage = async (before) => {
+        const query = before === null ? '' : `&before=${before}`;
+        const response = await fetch(`/api/actuator/history?limit=${ACTUATOR_PAGE}${query}`);
+        if (!response.ok) {
+            throw new Error('No se pudo leer el historial del actuador');
+        }
+        return response.json();
+    };
+
+    const actuatorRows = (entries) => entries.map(record =>
+        `<tr><td>${formatActuatorTime(record.ts)}</td><td>${record.state}</td>` +
+        `<td>${ACTUATOR_SOURCES[record.source] || record.source}</td></tr>`).join('');
 
     // Función para mostrar el historial del actuador
-    window.showActuatorHistory = () => {
+    window.showActuatorHistory = async () => {
+        let page;
+        try {
+            page = await fetchActuatorPage(null);
+        } catch (error) {
+            console.error('Error al leer el historial del actuador:', error);
+            Swal.fire('Error', 'No se pudo leer el historial del actuador.', 'error');
+            return;
+        }
+        let next = page.next;
+
         let historyContent = '<div class="history-table-container">';
-        if (actuatorHistory.length === 0) {
+        if (page.entries.length === 0) {
             historyContent += '<p>No hay registros de cambios de estado.</p>';
         } else {
-            historyContent += '<table class="history-table"><thead><tr><th>Fecha y Hora</th><th>Estado</th></tr></thead><tbody>';
-            actuatorHistory.forEach(record => {
-                historyContent += `<tr><td>${record.timestamp}</td><td>${record.state}</td></tr>`;
-            });
-            historyContent += '</tbody></table>';
+            historyContent += '<table class="history-table"><thead><tr><th>Fecha y Hora</th><th>Estado</th><th>Origen</th></tr></thead>';
+            historyContent += `<tbody id="actuator-history-rows">${actuatorRows(page.entries)}</tbody></table>`;
         }
         historyContent += '</div>';
 
@@ -67,6 +161,18 @@ document.addEventListener('DOMContentLoaded', () => {
             html: historyContent,
             showConfirmButton: true,
             confirmButtonText: 'Cerrar',
+            showDenyButton: next !== null,
+            denyButtonText: 'Anteriores',
+            preDeny: async () => {
+                // Añade la página siguiente sin cerrar el diálogo
+                const more = await fetchActuatorPage(next);
+                document.getElementById('actuator-history-rows').insertAdjacentHTML('beforeend', actuatorRows(more.entries));
+                next = more.next;
+                if (next === null) {
+                    Swal.getDenyButton().style.display = 'none';
+                }
+                return false;
+            },
             didOpen: () => {
                 const tableContainer = document.querySelector('.history-table-container');
                 if (tableContainer) {
@@ -83,17 +189,37 @@ document.addEventListener('DOMContentLoaded', () => {
         });
     };
 
-    // Manejar el cambio del switch del actuador
+    // Modo del termostato: en automático solo se informa; forzado a mano, un
+    // clic lo devuelve al automático.
+    const actuatorMode = document.getElementById('actuator-mode');
+    function showActuator(status) {
+        actuatorToggle.checked = status.state === 'ON';
+        if (status.mode === 'off') {
+            actuatorMode.textContent = '';
+        } else if (status.auto) {
+            actuatorMode.textContent = `Automático · ${status.setpoint.toFixed(1)} °C`;
+        } else {
+            actuatorMode.textContent = 'Manual · volver a automático';
+        }
+        actuatorMode.classList.toggle('manual', status.mode !== 'off' && !status.auto);
+    }
+
+    window.resumeActuator = async () => {
+        if (!actuatorMode.classList.contains('manual')) return;
+        try {
+            await fetch('/api/actuator', {
+                method: 'POST',
+                headers: { 'Content-Type': 'application/x-www-form-urlencoded' },
+                body: 'state=AUTO'
+            });
+        } catch (error) {
+            console.error('Error al volver a automático:', error);
+        }
+    };
+
+    // Manejar el cambio del switch del actuador (el ESP32 lo anota en su diario)
     actuatorToggle.addEventListener('change', async () => {
         const newState = actuatorToggle.checked ? 'ON' : 'OFF';
-        const timestamp = new Date().toLocaleString('es-ES', {
-            year: 'numeric',
-            month: '2-digit',
-            day: '2-digit',
-            hour: '2-digit',
-            minute: '2-digit',
-            second: '2-digit'
-        });
 
         // Enviar el comando al ESP32 a través de una API
         try {
@@ -107,21 +233,6 @@ document.addEventListener('DOMContentLoaded', () => {
             if (!response.ok) {
                 throw new Error('No se pudo enviar el comando al ESP32');
             }
-
-            // Añadir el registro al historial si la llamada a la API fue exitosa
-            actuatorHistory.push({
-                timestamp: timestamp,
-                state: newState
-            });
-
-            // Limitar el historial para evitar un crecimiento excesivo (ej. 50 registros)
-            if (actuatorHistory.length > 50) {
-                actuatorHistory.shift();
-            }
-
-            // Guardar el historial en localStorage
-            localStorage.setItem('actuatorHistory', JSON.stringify(actuatorHistory));
-
         } catch (error) {
             console.error('Error al controlar el actuador:', error);
             Swal.fire('Error', 'No se pudo comunicar con el ESP32 para controlar el actuador.', 'error');
@@ -130,40 +241,125 @@ document.addEventListener('DOMContentLoaded', () => {
         }
     });
 
-    // --- Funcionalidad del Historial de Sensores (ya existente) ---
-    const parseCSV = (csv) => {
-        const lines = csv.split('\n').filter(line => line.trim() !== '');
-        const data = lines.map(line => {
-            const [timestamp, temp, hum] = line.split(',');
-            const date = new Date(parseInt(timestamp) * 1000); // Unix timestamp
-            return { date, temp: parseFloat(temp), hum: parseFloat(hum) };
-        });
-        return data;
+    // --- Funcionalidad del Historial de Sensores ---
+    // Las muestras sin reducir las sincroniza, guarda y reduce al ancho de la
+    // pantalla history_worker.js (IndexedDB + /api/history?since=). Para
+    // rangos anteriores a lo que tiene su caché, o sin Web Workers, el ESP32
+    // reduce el rango a como mucho HISTORY_BUCKETS puntos con min/media/max.
+    const HISTORY_BUCKETS = 300;
+    const DEFAULT_WINDOW_MS = 24 * 60 * 60 * 1000;
+    const POPUP_WIDTH = 0.8;  // width: '80%' del popup
+
+    const historyWorker = window.Worker ? new Worker('/history_worker.js') : null;
+    const workerRequests = new Map();
+    let nextWorkerRequest = 0;
+    if (historyWorker) {
+        historyWorker.onmessage = (e) => {
+            const resolve = workerRequests.get(e.data.id);
+            workerRequests.delete(e.data.id);
+            if (resolve) resolve(e.data);
+        };
+        historyWorker.onerror = (e) => {
+            workerRequests.forEach(resolve => resolve({ error: e.message }));
+            workerRequests.clear();
+        };
+    }
+
+    const askHistoryWorker = (request) => new Promise(resolve => {
+        const id = ++nextWorkerRequest;
+        workerRequests.set(id, resolve);
+        historyWorker.postMessage({ ...request, id });
+    });
+
+    // Devuelve [{date, temp: [min, media, max], hum: [...], held}]; desde la
+    // caché solo viene `key`, con min = media = max.
+    const fetchHistory = async (start, end, key) => {
+        const from = Math.floor(start.getTime() / 1000);
+        const to = Math.floor(end.getTime() / 1000);
+        if (historyWorker && primarySensor !== null) {
+            const width = Math.round(window.innerWidth * POPUP_WIDTH);
+            const result = await askHistoryWorker({ sensor: primarySensor, from, to, key, width });
+            if (result.points) {
+                return result.points.map(p => ({
+                    date: new Date(p.ts * 1000),
+                    [key]: [p.value, p.value, p.value],
+                    held: p.held
+                }));
+            }
+            if (result.error) {
+                console.warn('Caché del historial no disponible:', result.error);
+            }
+        }
+        const response = await fetch(`/api/history?from=${from}&to=${to}&buckets=${HISTORY_BUCKETS}`);
+        if (!response.ok) {
+            throw new Error(`HTTP ${response.status}`);
+        }
+        const data = await response.json();
+        return data.buckets.map(b => ({ date: new Date(b.ts * 1000), temp: b.temp, hum: b.hum }));
+    };
+
+    // Cada punto trae [min, media, max]; si en ninguno difieren (muestras
+    // sin agregar) solo se dibuja la media. Con muestras reducidas la media
+    // se dibuja en escalones (el valor se mantiene hasta el punto siguiente)
+    // en vez de unir los puntos.
+    const buildDatasets = (historicalData, key, label, color) => {
+        const datasets = [{
+            label: label,
+            data: historicalData.map(d => d[key][1]),
+            borderColor: color,
+            backgroundColor: 'rgba(0,0,0,0)',
+            borderWidth: 2,
+            pointRadius: 0,
+            tension: 0.1,
+            stepped: historicalData.some(d => d.held)
+        }];
+        if (!historicalData.some(d => d[key][0] !== d[key][2])) {
+            return datasets;
+        }
+        return datasets.concat([
+            {
+                label: 'Mín',
+                data: historicalData.map(d => d[key][0]),
+                borderColor: color.replace(', 1)', ', 0.35)'),
+                backgroundColor: 'rgba(0,0,0,0)',
+                borderWidth: 1,
+                pointRadius: 0,
+                tension: 0.1
+            },
+            {
+                label: 'Máx',
+                data: historicalData.map(d => d[key][2]),
+                borderColor: color.replace(', 1)', ', 0.35)'),
+                backgroundColor: 'rgba(0,0,0,0)',
+                borderWidth: 1,
+                pointRadius: 0,
+                tension: 0.1
+            }
+        ]);
     };
 
     window.openHistoryPopup = async (type) => {
         try {
-            const response = await fetch('/api/history');
-            const csvData = await response.text();
-            const historicalData = parseCSV(csvData);
-
-            let chartData = [];
+            let key = '';
             let label = '';
             let unit = '';
             let color = '';
 
             if (type === 'temperatura') {
-                chartData = historicalData.map(d => d.temp);
+                key = 'temp';
                 label = 'Temperatura (°C)';
                 unit = '°C';
                 color = 'rgba(255, 99, 132, 1)';
             } else {
-                chartData = historicalData.map(d => d.hum);
+                key = 'hum';
                 label = 'Humedad (%)';
                 unit = '%';
                 color = 'rgba(54, 162, 235, 1)';
             }
 
+            const end = new Date();
+            const start = new Date(end.getTime() - DEFAULT_WINDOW_MS);
+            const historicalData = await fetchHistory(start, end, key);
             const dates = historicalData.map(d => d.date.toLocaleString());
 
             const content = `
@@ -183,14 +379,7 @@ document.addEventListener('DOMContentLoaded', () => {
                         type: 'line',
                         data: {
                             labels: dates,
-                            datasets: [{
-                                label: label,
-                                data: chartData,
-                                borderColor: color,
-                                backgroundColor: 'rgba(0,0,0,0)',
-                                borderWidth: 2,
-                                tension: 0.1
-                            }]
+                            datasets: buildDatasets(historicalData, key, label, color)
                         },
                         options: {
                             scales: {
@@ -208,19 +397,23 @@ document.addEventListener('DOMContentLoaded', () => {
                     flatpickr("#date-range-picker", {
                         mode: "range",
                         dateFormat: "Y-m-d",
-                        onClose: function(selectedDates, dateStr, instance) {
+                        onClose: async function(selectedDates, dateStr, instance) {
                             if (selectedDates.length === 2) {
-                                const [start, end] = selectedDates;
-                                const filteredData = historicalData.filter(d => d.date >= start && d.date <= end);
-                                
-                                const filteredDates = filteredData.map(d => d.date.toLocaleString());
-                                const filteredChartData = filteredData.map(d => d[type === 'temperatura' ? 'temp' : 'hum']);
-
-                                // Update the chart
-                                const chart = Chart.getChart("historyChart");
-                                chart.data.labels = filteredDates;
-                                chart.data.datasets[0].data = filteredChartData;
-                                chart.update();
+                                const [rangeStart, rangeEnd] = selectedDates;
+                                // Incluir el día final completo
+                                const until = new Date(rangeEnd);
+                                until.setHours(23, 59, 59, 999);
+                                try {
+                                    const filteredData = await fetchHistory(rangeStart, until, key);
+
+                                    // Update the chart
+                                    const chart = Chart.getChart("historyChart");
+                                    chart.data.labels = filteredData.map(d => d.date.toLocaleString());
+                                    chart.data.datasets = buildDatasets(filteredData, key, label, color);
+                                    chart.update();
+                                } catch (error) {
+                                    console.error('Error fetching history range:', error);
+                                }
                             }
                         }
                     });
@@ -0,0 +1,234 @@
+// ====== HISTÓRICO EN SEGUNDO PLANO ======
+// Web Worker del popup de historial (app.js). Guarda en IndexedDB las
+// muestras sin reducir que ya bajó del ESP32 y en cada apertura solo pide las
+// nuevas (/api/history?since=), así que reabrir el gráfico cuesta unos
+// cientos de bytes. Decodifica aquí los bloques binarios y reduce la serie al
+// ancho de la pantalla con LTTB antes de devolverla: el hilo principal solo
+// dibuja.
+//
+// Petición:  {id, sensor, from, to, key: 'temp'|'hum', width}
+// Respuesta: {id, points: [{ts, value, held}]}
+//            {id, covered: false} si la caché no llega hasta `from` (la
+//            primera sincronización empieza en el `from` de la primera
+//            petición); app.js pide entonces los agregados al ESP32
+//            {id, error}
+
+const DB_NAME = 'historial';
+const DB_VERSION = 1;
+const CACHE_DAYS = 30;
+const HOLD_MAX_SECONDS = 3600;  // HISTORY_HOLD_MAX_S en el firmware
+const NO_HUM = 0xFFFF;
+const TAG_RAW = 0;
+
+// Decodifica los bloques de /api/history?format=bin (ver history_codec.h
+// en el firmware): cabecera de 16 bytes y diferencias con prefijos de
+// longitud variable. Devuelve [{ts, sensor, temp, hum, tag}] en °C y %;
+// tag es el motivo por el que se guardó (0 = sin reducir, ver reducer.h).
+const decodeHistoryBlocks = (buffer) => {
+    const TS_WIDTHS = [6, 9, 12, 32];
+    const VALUE_WIDTHS = [5, 8, 12, 17];
+    const view = new DataView(buffer);
+    const bytes = new Uint8Array(buffer);
+    const samples = [];
+    let offset = 0;
+    while (offset + 16 <= bytes.length) {
+        const firstTs = view.getUint32(offset, true);
+        const count = view.getUint16(offset + 8, true);
+        const bits = view.getUint16(offset + 10, true);
+        const version = bytes[offset + 12];
+        const data = offset + 16;
+        offset = data + Math.ceil(bits / 8);
+        let pos = 0;
+        const read = (n) => {
+            let value = 0;
+            for (let i = 0; i < n; i++, pos++) {
+                value = value * 2 + ((bytes[data + (pos >> 3)] >> (7 - (pos & 7))) & 1);
+            }
+            return value;
+        };
+        const readVar = (widths) => {
+            let ones = 0;
+            while (ones < 4 && read(1)) ones++;
+            if (!ones) return 0;
+            const z = read(widths[ones - 1]);
+            return z % 2 ? -(z + 1) / 2 : z / 2;
+        };
+        const last = {};
+        let sensor = -1;
+        for (let i = 0; i < count && pos <= bits; i++) {
+            if (read(1)) sensor = read(1) ? read(3) : sensor + 1;
+            const p = last[sensor] || (last[sensor] = { ts: firstTs, delta: 0, temp: 0, hum: 0, tag: TAG_RAW });
+            if (version >= 2 && read(1)) p.tag = read(2);
+            p.delta += readVar(TS_WIDTHS);
+            p.ts += p.delta;
+            p.temp += readVar(VALUE_WIDTHS);
+            p.hum += readVar(VALUE_WIDTHS);
+            samples.push({
+                ts: p.ts,
+                sensor,
+                temp: p.temp / 100,
+                hum: p.hum === NO_HUM ? null : p.hum / 100,
+                tag: p.tag
+            });
+        }
+    }
+    return samples;
+};
+
+// --- Caché ---
+// "samples": una entrada por (sensor, ts), con el id del sensor y no su
+// índice. Dos muestras del mismo sensor en el mismo segundo (solo con los
+// sensores simulados a alta frecuencia) se quedan en la última.
+// "cursors": por sensor, `since` (lo que se pide la próxima vez) y `first`
+// (desde dónde está completa la caché).
+const idb = (req) => new Promise((resolve, reject) => {
+    req.onsuccess = () => resolve(req.result);
+    req.onerror = () => reject(req.error);
+});
+
+const openDb = () => new Promise((resolve) => {
+    if (typeof indexedDB === 'undefined') {
+        resolve(null);
+        return;
+    }
+    const req = indexedDB.open(DB_NAME, DB_VERSION);
+    req.onupgradeneeded = () => {
+        req.result.createObjectStore('samples', { keyPath: ['sensor', 'ts'] });
+        req.result.createObjectStore('cursors', { keyPath: 'sensor' });
+    };
+    req.onsuccess = () => resolve(req.result);
+    req.onerror = () => resolve(null);
+});
+
+const dbStore = (db) => ({
+    cursor: (sensor) => idb(db.transaction('cursors').objectStore('cursors').get(sensor)),
+    save: (cursor, samples, cutoff) => {
+        const tx = db.transaction(['samples', 'cursors'], 'readwrite');
+        const store = tx.objectStore('samples');
+        store.delete(IDBKeyRange.bound([cursor.sensor, 0], [cursor.sensor, cutoff], false, true));
+        samples.forEach(s => store.put(s));
+        tx.objectStore('cursors').put(cursor);
+        return new Promise((resolve, reject) => {
+            tx.oncomplete = resolve;
+            tx.onerror = () => reject(tx.error);
+        });
+    },
+    range: (sensor, from, to) =>
+        idb(db.transaction('samples').objectStore('samples').getAll(IDBKeyRange.bound([sensor, from], [sensor, to])))
+});
+
+// Sin IndexedDB (p. ej. navegación privada) la caché dura lo que la página.
+const memoryStore = () => {
+    const cursors = new Map();
+    const samples = new Map();
+    return {
+        cursor: async (sensor) => cursors.get(sensor),
+        save: async (cursor, fresh, cutoff) => {
+            const byTs = new Map((samples.get(cursor.sensor) || []).filter(s => s.ts >= cutoff).map(s => [s.ts, s]));
+            fresh.forEach(s => byTs.set(s.ts, s));
+            samples.set(cursor.sensor, [...byTs.values()].sort((a, b) => a.ts - b.ts));
+            cursors.set(cursor.sensor, cursor);
+        },
+        range: async (sensor, from, to) => (samples.get(sensor) || []).filter(s => s.ts >= from && s.ts <= to)
+    };
+};
+
+const store = openDb().then(db => db ? dbStore(db) : memoryStore());
+
+// Trae lo posterior al cursor. El cursor se queda un segundo por detrás de la
+// última muestra: las que lleguen después dentro de ese mismo segundo entran
+// en la siguiente sincronización (las repetidas se sobrescriben).
+const sync = async (sensor, from) => {
+    const cache = await store;
+    const cursor = (await cache.cursor(sensor)) || { sensor, since: Math.max(0, from - 1), first: from };
+    const response = await fetch(`/api/history?format=bin&since=${cursor.since}&sensor=${encodeURIComponent(sensor)}`);
+    if (!response.ok) {
+        throw new Error(`HTTP ${response.status}`);
+    }
+    const samples = decodeHistoryBlocks(await response.arrayBuffer())
+        .map(({ ts, temp, hum, tag }) => ({ sensor, ts, temp, hum, tag }));
+    if (samples.length) {
+        cursor.since = Math.max(cursor.since, samples[samples.length - 1].ts - 1);
+    }
+    const cutoff = Math.floor(Date.now() / 1000) - CACHE_DAYS * 24 * 60 * 60;
+    cursor.first = Math.max(cursor.first, cutoff);
+    await cache.save(cursor, samples, cutoff);
+    return cursor;
+};
+
+// --- Reducción al ancho de la pantalla ---
+// Largest-Triangle-Three-Buckets: el primer y el último punto se quedan; del
+// resto, en cada uno de los `threshold - 2` cubos se elige el punto que forma
+// el triángulo más grande con el elegido antes y la media del cubo siguiente.
+// Conserva picos y escalones que una media borraría.
+const lttb = (points, threshold) => {
+    if (threshold < 3 || points.length <= threshold) return points;
+    const sampled = [points[0]];
+    const every = (points.length - 2) / (threshold - 2);
+    let a = 0;
+    for (let i = 0; i < threshold - 2; i++) {
+        const nextStart = Math.floor((i + 1) * every) + 1;
+        const nextEnd = Math.min(Math.floor((i + 2) * every) + 1, points.length);
+        let avgTs = 0;
+        let avgValue = 0;
+        for (let j = nextStart; j < nextEnd; j++) {
+            avgTs += points[j].ts;
+            avgValue += points[j].value;
+        }
+        avgTs /= nextEnd - nextStart;
+        avgValue /= nextEnd - nextStart;
+
+        const start = Math.floor(i * every) + 1;
+        const end = Math.floor((i + 1) * every) + 1;
+        const pa = points[a];
+        let best = start;
+        let bestArea = -1;
+        for (let j = start; j < end; j++) {
+            const area = Math.abs((pa.ts - avgTs) * (points[j].value - pa.value) -
+                                  (pa.ts - points[j].ts) * (avgValue - pa.value));
+            if (area > bestArea) {
+                bestArea = area;
+                best = j;
+            }
+        }
+        sampled.push(points[best]);
+        a = best;
+    }
+    sampled.push(points[points.length - 1]);
+    return sampled;
+};
+
+const handle = async ({ id, sensor, from, to, key, width }) => {
+    let cursor;
+    try {
+        cursor = await sync(sensor, from);
+    } catch (error) {
+        // Sin conexión con el ESP32 se dibuja lo que haya en la caché
+        cursor = await (await store).cursor(sensor);
+        if (!cursor) throw error;
+    }
+    if (from < cursor.first) {
+        return { id, covered: false };
+    }
+    const samples = await (await store).range(sensor, from, to);
+    const points = samples
+        .filter(s => s[key] !== null)
+        .map(s => ({ ts: s.ts, value: s[key], held: s.tag !== TAG_RAW }));
+    // Una muestra reducida vale hasta la siguiente: la última se alarga
+    // hasta el final del rango (como mucho HOLD_MAX_SECONDS)
+    const tail = points[points.length - 1];
+    if (tail && tail.held && tail.ts < to) {
+        points.push({ ...tail, ts: Math.min(to, tail.ts + HOLD_MAX_SECONDS) });
+    }
+    return { id, points: lttb(points, width) };
+};
+
+// Una petición detrás de otra: dos sincronizaciones a la vez pedirían lo
+// mismo al ESP32.
+let queue = Promise.resolve();
+self.onmessage = (e) => {
+    queue = queue
+        .then(() => handle(e.data))
+        .catch(error => ({ id: e.data.id, error: error.message }))
+        .then(reply => self.postMessage(reply));
+};
@@ -0,0 +1,90 @@
+#pragma once
+// Shim de Arduino-ESP32 para el entorno [env:native]: permite compilar y
+// ejecutar la lógica del firmware como un proceso Linux.
+#define ARDUINO_NATIVE 1
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "IPAddress.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+#define IRAM_ATTR
+#define RTC_NOINIT_ATTR
+#define RTC_DATA_ATTR
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+using std::isnan;
+using std::isinf;
+using std::min;
+using std::max;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+float temperatureRead();
+void configTime(long gmtOffset_sec, int daylightOffset_sec, const char* server1,
+                const char* server2 = nullptr, const char* server3 = nullptr);
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+uint32_t esp_random();
+
+#if !defined(__GLIBC__) || !__GLIBC_PREREQ(2, 38)
+size_t strlcpy(char* dst, const char* src, size_t size);
+#endif
+
+class HardwareSerial : public Stream {
+ public:
+  void begin(unsigned long) {}
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buf, size_t len) override;
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  using Print::write;
+};
+extern HardwareSerial Serial;
+
+class EspClass {
+ public:
+  void restart();
+  uint32_t getFreeHeap();
+  uint32_t getHeapSize();
+  uint32_t getMinFreeHeap();
+  uint32_t getMaxAllocHeap();
+  uint32_t getCycleCount();
+};
+extern EspClass ESP;
+
+// Control del entorno simulado (solo existe en native).
+namespace native {
+void setChipTemperature(float c);
+void advanceMillis(unsigned long ms);
+// Microsegundos reales desde el arranque (sin NATIVE_TIME_SCALE), para medir.
+uint64_t realMicros();
+int pinState(uint8_t pin);
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include "Arduino.h"
+
+#define DHT11 11
+#define DHT22 22
+#define DHT21 21
+#define AM2301 21
+
+// DHT simulado. Si NATIVE_DHT_TRACE apunta a un CSV "ms,temp,hum" se reproduce
+// esa traza (NaN o vacío = fallo de lectura); si no, una senoidal suave.
+class DHT {
+ public:
+  DHT(uint8_t pin, uint8_t type, uint8_t /*count*/ = 6) : pin_(pin), type_(type) {}
+  void begin(uint8_t usec = 55);
+  float readTemperature(bool fahrenheit = false, bool force = false);
+  float readHumidity(bool force = false);
+  bool read(bool force = false) { return !isnan(readTemperature(false, force)); }
+
+ private:
+  uint8_t pin_;
+  uint8_t type_;
+};
@@ -0,0 +1,85 @@
+#pragma once
+#include "Arduino.h"
+#include <memory>
+#include <string>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+class FileImpl;
+
+// Fichero respaldado por un fichero real bajo el directorio raíz del FS.
+class File : public Stream {
+ public:
+  File() {}
+  explicit File(std::shared_ptr<FileImpl> impl) : impl_(impl) {}
+
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* buf, size_t len) override;
+  using Print::write;
+  int available() override;
+  int read() override;
+  size_t read(uint8_t* buf, size_t len);
+  int peek() override;
+  void flush() override;
+  bool seek(uint32_t pos, SeekMode mode = SeekSet);
+  size_t position() const;
+  size_t size() const;
+  void close();
+  operator bool() const;
+  const char* name() const;
+  const char* path() const;
+  bool isDirectory() const;
+  File openNextFile(const char* mode = FILE_READ);
+  void rewindDirectory();
+
+ private:
+  std::shared_ptr<FileImpl> impl_;
+};
+
+class FS {
+ public:
+  FS(const char* label, size_t capacity) : label_(label), capacity_(capacity) {}
+  bool begin(bool formatOnFail = false, const char* basePath = nullptr, uint8_t maxOpenFiles = 10,
+             const char* partitionLabel = nullptr);
+  void end() { mounted_ = false; }
+  bool format();
+  File open(const char* path, const char* mode = FILE_READ, bool create = false);
+  File open(const String& path, const char* mode = FILE_READ, bool create = false) {
+    return open(path.c_str(), mode, create);
+  }
+  bool exists(const char* path);
+  bool exists(const String& path) { return exists(path.c_str()); }
+  bool remove(const char* path);
+  bool remove(const String& path) { return remove(path.c_str()); }
+  bool rename(const char* from, const char* to);
+  bool rename(const String& from, const String& to) { return rename(from.c_str(), to.c_str()); }
+  bool mkdir(const char* path);
+  bool mkdir(const String& path) { return mkdir(path.c_str()); }
+  bool rmdir(const char* path);
+  size_t totalBytes() { return capacity_; }
+  size_t usedBytes();
+
+  const std::string& root() const { return root_; }
+
+ private:
+  std::string hostPath(const char* path) const;
+  std::string label_;
+  std::string root_;
+  size_t capacity_;
+  bool mounted_ = false;
+};
+
+}  // namespace fs
+
+using fs::File;
+using fs::FS;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
@@ -0,0 +1,46 @@
+#pragma once
+#include "Arduino.h"
+#include "WiFiClient.h"
+#include <vector>
+
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED (-2)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED (-3)
+#define HTTPC_ERROR_NOT_CONNECTED (-4)
+#define HTTPC_ERROR_CONNECTION_LOST (-5)
+#define HTTPC_ERROR_NO_HTTP_SERVER (-7)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+typedef enum { HTTPC_DISABLE_FOLLOW_REDIRECTS, HTTPC_STRICT_FOLLOW_REDIRECTS, HTTPC_FORCE_FOLLOW_REDIRECTS } followRedirects_t;
+
+// Cliente HTTP/1.1 mínimo. No hay TLS en native: las URL https:// se envían en
+// claro a NATIVE_HTTPS_PROXY (host:puerto) si está definido, y si no fallan.
+class HTTPClient {
+ public:
+  bool begin(const String& url);
+  void end();
+  void addHeader(const String& name, const String& value) { headers_ += name + ": " + value + "\r\n"; }
+  void setTimeout(uint16_t ms) { timeoutMs_ = ms; }
+  void setConnectTimeout(int32_t ms) { connectTimeoutMs_ = ms; }
+  void setFollowRedirects(followRedirects_t f) { follow_ = f; }
+  void setReuse(bool) {}
+  int GET();
+  int POST(const String& payload) { return POST((uint8_t*)payload.c_str(), payload.length()); }
+  int POST(uint8_t* payload, size_t size);
+  int sendRequest(const char* method, uint8_t* payload, size_t size);
+  String getString() { return body_; }
+  int getSize() { return body_.length(); }
+  static String errorToString(int error);
+
+ private:
+  String host_;
+  uint16_t port_ = 80;
+  String path_;
+  String headers_;
+  String body_;
+  String location_;
+  uint16_t timeoutMs_ = 5000;
+  int32_t connectTimeoutMs_ = 5000;
+  followRedirects_t follow_ = HTTPC_DISABLE_FOLLOW_REDIRECTS;
+  bool valid_ = false;
+};
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include "Print.h"
+
+class IPAddress : public Printable {
+ public:
+  IPAddress() : addr_{0, 0, 0, 0} {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : addr_{a, b, c, d} {}
+  uint8_t operator[](int i) const { return addr_[i]; }
+  uint8_t& operator[](int i) { return addr_[i]; }
+  operator uint32_t() const {
+    return addr_[0] | (addr_[1] << 8) | (addr_[2] << 16) | ((uint32_t)addr_[3] << 24);
+  }
+  bool fromString(const char* s) {
+    unsigned a, b, c, d;
+    if (sscanf(s, "%u.%u.%u.%u", &a, &b, &c, &d) != 4) return false;
+    addr_[0] = a; addr_[1] = b; addr_[2] = c; addr_[3] = d;
+    return true;
+  }
+  String toString() const {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", addr_[0], addr_[1], addr_[2], addr_[3]);
+    return String(buf);
+  }
+  size_t printTo(Print& p) const override { return p.print(toString()); }
+
+ private:
+  uint8_t addr_[4];
+};
+
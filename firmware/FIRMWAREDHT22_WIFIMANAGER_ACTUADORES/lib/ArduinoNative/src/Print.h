@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include "WString.h"
+
+class Print;
+
+class Printable {
+ public:
+  virtual ~Printable() {}
+  virtual size_t printTo(Print& p) const = 0;
+};
+
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buf, size_t len) {
+    size_t n = 0;
+    while (len--) n += write(*buf++);
+    return n;
+  }
+  size_t write(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+  size_t write(const char* s, size_t len) { return write((const uint8_t*)s, len); }
+
+  size_t print(const char* s) { return write(s); }
+  size_t print(const String& s) { return write(s.c_str(), s.length()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int v) { return printf("%d", v); }
+  size_t print(unsigned int v) { return printf("%u", v); }
+  size_t print(long v) { return printf("%ld", v); }
+  size_t print(unsigned long v) { return printf("%lu", v); }
+  size_t print(long long v) { return printf("%lld", v); }
+  size_t print(unsigned long long v) { return printf("%llu", v); }
+  size_t print(double v, int decimals = 2) { return printf("%.*f", decimals, v); }
+  size_t print(const Printable& p) { return p.printTo(*this); }
+  template <typename T>
+  size_t println(const T& v) { size_t n = print(v); return n + println(); }
+  size_t println(double v, int decimals) { size_t n = print(v, decimals); return n + println(); }
+  size_t println() { return write("\r\n"); }
+
+  size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+    char small[256];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(small, sizeof(small), fmt, ap);
+    va_end(ap);
+    if (n < 0) return 0;
+    if ((size_t)n < sizeof(small)) return write((const uint8_t*)small, n);
+    std::string big(n + 1, '\0');
+    va_start(ap, fmt);
+    vsnprintf(&big[0], big.size(), fmt, ap);
+    va_end(ap);
+    return write((const uint8_t*)big.data(), n);
+  }
+  virtual void flush() {}
+};
@@ -0,0 +1,5 @@
+#pragma once
+#include "FS.h"
+
+// Partición SPIFFS del esquema "default" de esp32doit-devkit-v1 (~1.4 MB).
+extern fs::FS SPIFFS;
@@ -0,0 +1,35 @@
+#pragma once
+#include "Print.h"
+
+class Stream : public Print {
+ public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  virtual size_t readBytes(uint8_t* buf, size_t len) {
+    size_t n = 0;
+    while (n < len) {
+      int c = read();
+      if (c < 0) break;
+      buf[n++] = (uint8_t)c;
+    }
+    return n;
+  }
+  size_t readBytes(char* buf, size_t len) { return readBytes((uint8_t*)buf, len); }
+  size_t readBytesUntil(char term, char* buf, size_t len) {
+    size_t n = 0;
+    int c;
+    while (n < len && (c = read()) >= 0 && c != term) buf[n++] = (char)c;
+    return n;
+  }
+  String readStringUntil(char term) {
+    String out;
+    int c;
+    while ((c = read()) >= 0 && c != term) out += (char)c;
+    return out;
+  }
+  void setTimeout(unsigned long ms) { timeout_ = ms; }
+
+ protected:
+  unsigned long timeout_ = 1000;
+};
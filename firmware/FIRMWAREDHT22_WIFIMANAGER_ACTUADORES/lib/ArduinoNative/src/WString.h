@@ -0,0 +1,104 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// Subconjunto de la clase String de Arduino sobre std::string.
+class String {
+ public:
+  String() {}
+  String(const char* s) : s_(s ? s : "") {}
+  String(const std::string& s) : s_(s) {}
+  String(char c) : s_(1, c) {}
+  String(int v) : s_(std::to_string(v)) {}
+  String(unsigned int v) : s_(std::to_string(v)) {}
+  String(long v) : s_(std::to_string(v)) {}
+  String(unsigned long v) : s_(std::to_string(v)) {}
+  String(long long v) : s_(std::to_string(v)) {}
+  String(unsigned long long v) : s_(std::to_string(v)) {}
+  String(float v, unsigned int decimals = 2) { fmt(v, decimals); }
+  String(double v, unsigned int decimals = 2) { fmt(v, decimals); }
+
+  const char* c_str() const { return s_.c_str(); }
+  unsigned int length() const { return s_.size(); }
+  bool isEmpty() const { return s_.empty(); }
+  bool reserve(unsigned int n) { s_.reserve(n); return true; }
+  char operator[](unsigned int i) const { return i < s_.size() ? s_[i] : 0; }
+  char charAt(unsigned int i) const { return (*this)[i]; }
+
+  String& operator+=(const String& o) { s_ += o.s_; return *this; }
+  String& operator+=(const char* o) { s_ += o ? o : ""; return *this; }
+  String& operator+=(char c) { s_ += c; return *this; }
+  bool concat(const char* o, unsigned int n) { s_.append(o, n); return true; }
+
+  bool operator==(const String& o) const { return s_ == o.s_; }
+  bool operator==(const char* o) const { return s_ == (o ? o : ""); }
+  bool operator!=(const String& o) const { return s_ != o.s_; }
+  bool operator!=(const char* o) const { return !(*this == o); }
+  bool operator<(const String& o) const { return s_ < o.s_; }
+  bool equals(const String& o) const { return s_ == o.s_; }
+  bool equalsIgnoreCase(const String& o) const { return strcasecmp(c_str(), o.c_str()) == 0; }
+
+  bool startsWith(const String& p) const { return s_.compare(0, p.s_.size(), p.s_) == 0; }
+  bool endsWith(const String& p) const {
+    return s_.size() >= p.s_.size() && s_.compare(s_.size() - p.s_.size(), p.s_.size(), p.s_) == 0;
+  }
+  int indexOf(char c, unsigned int from = 0) const {
+    size_t i = s_.find(c, from);
+    return i == std::string::npos ? -1 : (int)i;
+  }
+  int indexOf(const String& p, unsigned int from = 0) const {
+    size_t i = s_.find(p.s_, from);
+    return i == std::string::npos ? -1 : (int)i;
+  }
+  int lastIndexOf(char c) const {
+    size_t i = s_.rfind(c);
+    return i == std::string::npos ? -1 : (int)i;
+  }
+  String substring(unsigned int from) const { return from >= s_.size() ? String() : String(s_.substr(from)); }
+  String substring(unsigned int from, unsigned int to) const {
+    if (from > to) std::swap(from, to);
+    if (from >= s_.size()) return String();
+    return String(s_.substr(from, to - from));
+  }
+  void replace(const String& a, const String& b) {
+    if (a.s_.empty()) return;
+    size_t pos = 0;
+    while ((pos = s_.find(a.s_, pos)) != std::string::npos) {
+      s_.replace(pos, a.s_.size(), b.s_);
+      pos += b.s_.size();
+    }
+  }
+  void trim() {
+    size_t a = s_.find_first_not_of(" \t\r\n");
+    size_t b = s_.find_last_not_of(" \t\r\n");
+    s_ = a == std::string::npos ? "" : s_.substr(a, b - a + 1);
+  }
+  void toLowerCase() { for (auto& c : s_) c = tolower(c); }
+  void toUpperCase() { for (auto& c : s_) c = toupper(c); }
+  long toInt() const { return strtol(s_.c_str(), nullptr, 10); }
+  float toFloat() const { return strtof(s_.c_str(), nullptr); }
+  double toDouble() const { return strtod(s_.c_str(), nullptr); }
+
+  const std::string& str() const { return s_; }
+
+ private:
+  void fmt(double v, unsigned int decimals) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", (int)decimals, v);
+    s_ = buf;
+  }
+  std::string s_;
+};
+
+inline String operator+(const String& a, const String& b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, const char* b) { String r(a); r += b; return r; }
+inline String operator+(const char* a, const String& b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, char b) { String r(a); r += b; return r; }
+inline bool operator==(const char* a, const String& b) { return b == a; }
+
+class __FlashStringHelper;
+#define F(s) (s)
+#define PSTR(s) (s)
@@ -0,0 +1,89 @@
+#pragma once
+#include "Arduino.h"
+#include "FS.h"
+#include "WiFiServer.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+enum HTTPMethod { HTTP_ANY = 0, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS };
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+#define CONTENT_LENGTH_NOT_SET ((size_t)-2)
+
+// Equivalente síncrono del WebServer de Arduino-ESP32: atiende un cliente por
+// llamada a handleClient() y cierra la conexión al terminar.
+class WebServer {
+ public:
+  typedef std::function<void(void)> THandlerFunction;
+
+  explicit WebServer(int port = 80) : server_(port) {}
+
+  void begin() { server_.begin(); }
+  void handleClient();
+  void close() { server_.end(); }
+
+  void on(const String& uri, THandlerFunction fn) { on(uri, HTTP_ANY, fn); }
+  void on(const String& uri, HTTPMethod method, THandlerFunction fn) { routes_.push_back({uri, method, fn}); }
+  void onNotFound(THandlerFunction fn) { notFound_ = fn; }
+
+  String uri() const { return uri_; }
+  HTTPMethod method() const { return method_; }
+  WiFiClient client() { return client_; }
+
+  String arg(const String& name) const;
+  String arg(int i) const { return i < (int)args_.size() ? args_[i].value : String(); }
+  String argName(int i) const { return i < (int)args_.size() ? args_[i].key : String(); }
+  int args() const { return args_.size(); }
+  bool hasArg(const String& name) const;
+
+  void collectHeaders(const char* headerKeys[], size_t count);
+  String header(const String& name) const;
+  bool hasHeader(const String& name) const;
+
+  void sendHeader(const String& name, const String& value, bool first = false);
+  void setContentLength(size_t len) { contentLength_ = len; }
+  void send(int code, const char* contentType = nullptr, const String& content = String());
+  void send(int code, const String& contentType, const String& content) {
+    send(code, contentType.c_str(), content);
+  }
+  void send(int code, const char* contentType, const char* content) { send(code, contentType, String(content)); }
+  void send_P(int code, const char* contentType, const char* content) { send(code, contentType, String(content)); }
+  void send_P(int code, const char* contentType, const char* content, size_t len) {
+    contentLength_ = len;
+    writeHead(code, contentType, len);
+    contentLength_ = CONTENT_LENGTH_NOT_SET;
+    sendContent(content, len);
+  }
+  void sendContent(const String& content) { sendContent(content.c_str(), content.length()); }
+  void sendContent(const char* content, size_t len);
+  size_t streamFile(fs::File& file, const String& contentType, int code = 200);
+
+ private:
+  struct Route {
+    String uri;
+    HTTPMethod method;
+    THandlerFunction fn;
+  };
+  struct KV {
+    String key;
+    String value;
+  };
+
+  bool readRequest();
+  void parseArgs(const String& data);
+  void writeHead(int code, const char* contentType, size_t contentLength);
+
+  WiFiServer server_;
+  WiFiClient client_;
+  std::vector<Route> routes_;
+  THandlerFunction notFound_;
+  String uri_;
+  HTTPMethod method_ = HTTP_GET;
+  std::vector<KV> args_;
+  std::vector<KV> headers_;
+  std::vector<String> collect_;
+  String pendingHeaders_;
+  size_t contentLength_ = CONTENT_LENGTH_NOT_SET;
+  bool chunked_ = false;
+};
@@ -0,0 +1,48 @@
+#pragma once
+#include "Arduino.h"
+#include "IPAddress.h"
+#include "WiFiClient.h"
+#include "WiFiServer.h"
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } wifi_mode_t;
+
+// En native la "red" es la interfaz del host: siempre conectada salvo que el
+// entorno la desconecte (native::setWiFiConnected) o se simule el tiempo de
+// asociación (NATIVE_WIFI_DELAY_MS, ver wifi_native.cpp).
+class WiFiClass {
+ public:
+  wl_status_t status();
+  bool mode(wifi_mode_t) { return true; }
+  wl_status_t begin(const char* ssid = nullptr, const char* pass = nullptr, int32_t channel = 0,
+                    const uint8_t* bssid = nullptr, bool connect = true);
+  bool config(IPAddress, IPAddress, IPAddress, IPAddress = IPAddress(), IPAddress = IPAddress()) { return true; }
+  bool disconnect(bool = false, bool = false);
+  bool reconnect() { begin(); return true; }
+  bool setAutoReconnect(bool) { return true; }
+  bool setSleep(bool) { return true; }
+  bool softAP(const char*, const char* = nullptr) { return true; }
+  bool setHostname(const char*) { return true; }
+  IPAddress localIP() { return IPAddress(127, 0, 0, 1); }
+  IPAddress softAPIP() { return IPAddress(192, 168, 4, 1); }
+  uint8_t* macAddress(uint8_t* mac);
+  String macAddress();
+  int8_t RSSI();
+  String SSID() { return String("native"); }
+  String psk() { return String("native"); }
+  uint8_t* BSSID() { static uint8_t b[6] = {0x02, 0, 0, 0, 0, 1}; return b; }
+  int32_t channel() { return 6; }
+};
+extern WiFiClass WiFi;
+
+namespace native {
+void setWiFiConnected(bool connected);
+}
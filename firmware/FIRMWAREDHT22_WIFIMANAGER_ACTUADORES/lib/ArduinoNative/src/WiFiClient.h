@@ -0,0 +1,34 @@
+#pragma once
+#include "Arduino.h"
+#include "IPAddress.h"
+#include <memory>
+
+// Cliente TCP sobre sockets POSIX (no bloqueante en lectura, como lwIP).
+class WiFiClient : public Stream {
+ public:
+  WiFiClient() {}
+  explicit WiFiClient(int fd);
+
+  int connect(const char* host, uint16_t port, int32_t timeoutMs = 3000);
+  int connect(IPAddress ip, uint16_t port) { return connect(ip.toString().c_str(), port); }
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* buf, size_t len) override;
+  using Print::write;
+  int available() override;
+  int read() override;
+  int read(uint8_t* buf, size_t len);
+  int peek() override;
+  int availableForWrite();
+  void flush() override {}
+  void stop();
+  uint8_t connected();
+  operator bool() { return fd() >= 0; }
+  bool operator==(const WiFiClient& o) const { return sock_ == o.sock_; }
+  IPAddress remoteIP() const;
+  int fd() const;
+  void setNoDelay(bool nodelay);
+
+ private:
+  struct Socket;
+  std::shared_ptr<Socket> sock_;
+};
@@ -0,0 +1,16 @@
+#pragma once
+#include "WiFi.h"
+
+// El portal cautivo no tiene sentido en native: la red del host ya está lista.
+class WiFiManager {
+ public:
+  void setHostname(const char*) {}
+  void setConfigPortalBlocking(bool) {}
+  void setConfigPortalTimeout(unsigned long) {}
+  void setConnectTimeout(unsigned long) {}
+  bool autoConnect(const char* = nullptr, const char* = nullptr) { return WiFi.begin() == WL_CONNECTED; }
+  bool startConfigPortal(const char* = nullptr, const char* = nullptr) { return true; }
+  bool process() { return WiFi.status() == WL_CONNECTED; }
+  void resetSettings() {}
+  String getWiFiSSID() { return WiFi.SSID(); }
+};
@@ -0,0 +1,26 @@
+#pragma once
+#include "WiFiClient.h"
+
+class WiFiServer {
+ public:
+  explicit WiFiServer(uint16_t port = 80, uint8_t /*maxClients*/ = 4) : port_(port) {}
+  void begin(uint16_t port = 0);
+  WiFiClient available();
+  WiFiClient accept() { return available(); }
+  bool hasClient();
+  void setNoDelay(bool nodelay) { noDelay_ = nodelay; }
+  void end();
+  void close() { end(); }
+  operator bool() { return fd_ >= 0; }
+  uint16_t port() const { return port_; }
+
+ private:
+  uint16_t port_;
+  int fd_ = -1;
+  bool noDelay_ = false;
+};
+
+namespace native {
+// Puerto real en el host: NATIVE_HTTP_PORT o puerto+8000 (80 -> 8080).
+uint16_t hostPort(uint16_t devicePort);
+}
@@ -0,0 +1,296 @@
+#include "Arduino.h"
+#include <malloc.h>
+#include <time.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <random>
+#include <thread>
+#include <vector>
+
+// ====== RELOJ ======
+// NATIVE_TIME_SCALE acelera el tiempo simulado: millis(), time() y todas las
+// esperas (delay, vTaskDelay, colas) van N veces más rápido que el reloj real.
+// Así un benchmark de 7 días de muestreo dura minutos.
+static double readTimeScale() {
+  const char* env = getenv("NATIVE_TIME_SCALE");
+  double scale = env ? atof(env) : 1.0;
+  return scale > 0 ? scale : 1.0;
+}
+
+static const double timeScale = readTimeScale();
+static const auto bootTime = std::chrono::steady_clock::now();
+static time_t realEpoch() {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return ts.tv_sec;
+}
+static const time_t bootEpoch = realEpoch();
+static std::atomic<unsigned long> extraMillis{0};
+
+static uint64_t elapsedMicros() {
+  uint64_t real = std::chrono::duration_cast<std::chrono::microseconds>(
+                      std::chrono::steady_clock::now() - bootTime).count();
+  return (uint64_t)(real * timeScale) + extraMillis * 1000ULL;
+}
+
+// Duración real de una espera de `ms` milisegundos simulados.
+static std::chrono::microseconds realDuration(unsigned long ms) {
+  return std::chrono::microseconds((uint64_t)(ms * 1000.0 / timeScale));
+}
+
+unsigned long millis() { return (unsigned long)(elapsedMicros() / 1000); }
+unsigned long micros() { return (unsigned long)elapsedMicros(); }
+void delay(unsigned long ms) { std::this_thread::sleep_for(realDuration(ms)); }
+void delayMicroseconds(unsigned int us) {
+  std::this_thread::sleep_for(std::chrono::microseconds((uint64_t)(us / timeScale)));
+}
+void yield() { std::this_thread::yield(); }
+
+// time() del firmware: la hora real del arranque más el tiempo simulado.
+// Con NATIVE_NTP_DELAY_MS la hora no es válida hasta ese tiempo después de
+// configTime(): mientras, como un ESP32 sin SNTP, cuenta desde 0 al arrancar.
+static long readNtpDelay() {
+  const char* env = getenv("NATIVE_NTP_DELAY_MS");
+  return env ? atol(env) : -1;
+}
+
+static const long ntpDelayMs = readNtpDelay();
+static std::atomic<long> ntpSyncMs{-1};
+
+extern "C" time_t time(time_t* out) {
+  time_t uptime = (time_t)(elapsedMicros() / 1000000);
+  long syncMs = ntpSyncMs;
+  bool synced = ntpDelayMs < 0 || (syncMs >= 0 && (long)millis() >= syncMs);
+  time_t now = synced ? bootEpoch + uptime : uptime;
+  if (out) *out = now;
+  return now;
+}
+
+void configTime(long, int, const char*, const char*, const char*) {
+  long none = -1;
+  if (ntpDelayMs >= 0) ntpSyncMs.compare_exchange_strong(none, (long)millis() + ntpDelayMs);
+}
+
+// ====== GPIO ======
+static std::mutex pinMutex;
+static std::map<uint8_t, int> pins;
+
+void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t pin, uint8_t val) {
+  std::lock_guard<std::mutex> lock(pinMutex);
+  pins[pin] = val;
+}
+int digitalRead(uint8_t pin) {
+  std::lock_guard<std::mutex> lock(pinMutex);
+  auto it = pins.find(pin);
+  return it == pins.end() ? LOW : it->second;
+}
+
+// ====== SENSOR INTERNO ======
+static std::atomic<float> chipTemp{45.0f};
+float temperatureRead() { return chipTemp; }
+
+// ====== ALEATORIOS ======
+static std::mt19937 rng(1);
+long random(long max) { return max <= 0 ? 0 : (long)(rng() % (unsigned long)max); }
+long random(long min, long max) { return max <= min ? min : min + random(max - min); }
+void randomSeed(unsigned long seed) { rng.seed(seed); }
+uint32_t esp_random() {
+  static std::random_device device;
+  return device();
+}
+
+#if !defined(__GLIBC__) || !__GLIBC_PREREQ(2, 38)
+size_t strlcpy(char* dst, const char* src, size_t size) {
+  size_t len = strlen(src);
+  if (size) {
+    size_t n = len < size - 1 ? len : size - 1;
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+  }
+  return len;
+}
+#endif
+
+// ====== SERIAL ======
+HardwareSerial Serial;
+static std::mutex serialMutex;
+
+size_t HardwareSerial::write(uint8_t c) { return write(&c, 1); }
+size_t HardwareSerial::write(const uint8_t* buf, size_t len) {
+  std::lock_guard<std::mutex> lock(serialMutex);
+  return fwrite(buf, 1, len, stdout);
+}
+
+// ====== ESP ======
+// Se emula el heap de un ESP32 (~320 KB) a partir de lo que malloc tiene en uso.
+static const uint32_t NATIVE_HEAP_SIZE = 320 * 1024;
+static size_t heapBaseline = mallinfo2().uordblks;
+static std::atomic<uint32_t> minFreeHeap{NATIVE_HEAP_SIZE};
+
+EspClass ESP;
+
+void EspClass::restart() {
+  fflush(stdout);
+  exit(0);
+}
+uint32_t EspClass::getHeapSize() { return NATIVE_HEAP_SIZE; }
+uint32_t EspClass::getFreeHeap() {
+  struct mallinfo2 mi = mallinfo2();
+  size_t used = mi.uordblks > heapBaseline ? mi.uordblks - heapBaseline : 0;
+  uint32_t free = used >= NATIVE_HEAP_SIZE ? 0 : NATIVE_HEAP_SIZE - used;
+  uint32_t low = minFreeHeap;
+  while (free < low && !minFreeHeap.compare_exchange_weak(low, free)) {}
+  return free;
+}
+uint32_t EspClass::getMinFreeHeap() {
+  getFreeHeap();
+  return minFreeHeap;
+}
+uint32_t EspClass::getMaxAllocHeap() {
+  // glibc no expone el mayor bloque libre: se descuentan los huecos libres que
+  // no están en la cima del arena (fragmentación), que es lo contiguo.
+  struct mallinfo2 mi = mallinfo2();
+  uint32_t free = getFreeHeap();
+  size_t holes = mi.fordblks > mi.keepcost ? mi.fordblks - mi.keepcost : 0;
+  return holes >= free ? 0 : free - (uint32_t)holes;
+}
+uint32_t EspClass::getCycleCount() { return (uint32_t)(elapsedMicros() * 240); }
+
+// ====== FREERTOS ======
+TickType_t xTaskGetTickCount() { return (TickType_t)millis(); }
+
+struct NativeTask {
+  std::thread thread;
+};
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char*, uint32_t, void* arg,
+                                   UBaseType_t, TaskHandle_t* handle, BaseType_t) {
+  NativeTask* t = new NativeTask();
+  t->thread = std::thread(fn, arg);
+  t->thread.detach();
+  if (handle) *handle = t;
+  return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stack, void* arg,
+                       UBaseType_t prio, TaskHandle_t* handle) {
+  return xTaskCreatePinnedToCore(fn, name, stack, arg, prio, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelay(TickType_t ticks) { delay(ticks); }
+
+BaseType_t xTaskDelayUntil(TickType_t* prev, TickType_t increment) {
+  TickType_t wake = *prev + increment;
+  TickType_t now = xTaskGetTickCount();
+  *prev = wake;
+  if ((int32_t)(wake - now) <= 0) return pdFALSE;
+  delay(wake - now);
+  return pdTRUE;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t) { return 0; }
+BaseType_t xPortGetCoreID() { return 1; }
+
+struct NativeQueue {
+  std::mutex m;
+  std::condition_variable cv;
+  std::deque<std::vector<uint8_t>> items;
+  UBaseType_t length;
+  UBaseType_t itemSize;
+};
+
+template <typename Pred>
+static bool waitFor(std::unique_lock<std::mutex>& lock, std::condition_variable& cv,
+                    TickType_t wait, Pred pred) {
+  if (wait == portMAX_DELAY) {
+    cv.wait(lock, pred);
+    return true;
+  }
+  return cv.wait_for(lock, realDuration(wait), pred);
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+  NativeQueue* q = new NativeQueue();
+  q->length = length;
+  q->itemSize = itemSize;
+  return q;
+}
+
+void vQueueDelete(QueueHandle_t q) { delete q; }
+
+BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t wait) {
+  std::unique_lock<std::mutex> lock(q->m);
+  if (!waitFor(lock, q->cv, wait, [q] { return q->items.size() < q->length; })) return pdFALSE;
+  const uint8_t* p = (const uint8_t*)item;
+  q->items.emplace_back(p, p + q->itemSize);
+  q->cv.notify_all();
+  return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void* item, TickType_t wait) {
+  std::unique_lock<std::mutex> lock(q->m);
+  if (!waitFor(lock, q->cv, wait, [q] { return !q->items.empty(); })) return pdFALSE;
+  memcpy(item, q->items.front().data(), q->itemSize);
+  q->items.pop_front();
+  q->cv.notify_all();
+  return pdTRUE;
+}
+
+BaseType_t xQueuePeek(QueueHandle_t q, void* item, TickType_t wait) {
+  std::unique_lock<std::mutex> lock(q->m);
+  if (!waitFor(lock, q->cv, wait, [q] { return !q->items.empty(); })) return pdFALSE;
+  memcpy(item, q->items.front().data(), q->itemSize);
+  return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+  std::lock_guard<std::mutex> lock(q->m);
+  return q->items.size();
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t q) {
+  std::lock_guard<std::mutex> lock(q->m);
+  return q->length - q->items.size();
+}
+
+struct NativeSemaphore {
+  std::mutex m;
+  std::condition_variable cv;
+  int count;
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex() { return new NativeSemaphore{{}, {}, 1}; }
+SemaphoreHandle_t xSemaphoreCreateBinary() { return new NativeSemaphore{{}, {}, 0}; }
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t wait) {
+  std::unique_lock<std::mutex> lock(s->m);
+  if (!waitFor(lock, s->cv, wait, [s] { return s->count > 0; })) return pdFALSE;
+  s->count--;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s) {
+  std::lock_guard<std::mutex> lock(s->m);
+  if (s->count > 0) return pdFALSE;
+  s->count++;
+  s->cv.notify_one();
+  return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t s) { delete s; }
+
+// ====== CONTROL DEL ENTORNO SIMULADO ======
+namespace native {
+void setChipTemperature(float c) { chipTemp = c; }
+void advanceMillis(unsigned long ms) { extraMillis += ms; }
+uint64_t realMicros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - bootTime).count();
+}
+int pinState(uint8_t pin) { return digitalRead(pin); }
+}
@@ -0,0 +1,65 @@
+#include "DHT.h"
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct TracePoint {
+  unsigned long ms;
+  float temp;
+  float hum;
+};
+
+std::once_flag traceOnce;
+std::vector<TracePoint> trace;
+
+void loadTrace() {
+  const char* path = getenv("NATIVE_DHT_TRACE");
+  if (!path) return;
+  FILE* f = fopen(path, "r");
+  if (!f) {
+    fprintf(stderr, "[native] No se pudo abrir la traza %s\n", path);
+    return;
+  }
+  char line[128];
+  while (fgets(line, sizeof(line), f)) {
+    if (line[0] == '#') continue;
+    TracePoint p;
+    char t[32] = "", h[32] = "";
+    if (sscanf(line, "%lu,%31[^,],%31s", &p.ms, t, h) < 1) continue;
+    p.temp = strtof(t, nullptr);
+    p.hum = strtof(h, nullptr);
+    if (!t[0] || !strcmp(t, "nan")) p.temp = NAN;
+    if (!h[0] || !strcmp(h, "nan")) p.hum = NAN;
+    trace.push_back(p);
+  }
+  fclose(f);
+}
+
+const TracePoint* current() {
+  std::call_once(traceOnce, loadTrace);
+  if (trace.empty()) return nullptr;
+  unsigned long now = millis() % (trace.back().ms + 1);
+  const TracePoint* best = &trace.front();
+  for (auto& p : trace) {
+    if (p.ms > now) break;
+    best = &p;
+  }
+  return best;
+}
+
+}  // namespace
+
+void DHT::begin(uint8_t) { std::call_once(traceOnce, loadTrace); }
+
+float DHT::readTemperature(bool fahrenheit, bool) {
+  const TracePoint* p = current();
+  // Sin traza, cada pin da una curva algo distinta para distinguir sensores.
+  float c = p ? p->temp : 24.0f + 1.5f * sinf(millis() / 600000.0f + pin_) + (pin_ - 4) * 0.5f;
+  return fahrenheit ? c * 1.8f + 32 : c;
+}
+
+float DHT::readHumidity(bool) {
+  const TracePoint* p = current();
+  return p ? p->hum : 55.0f + 5.0f * cosf(millis() / 900000.0f + pin_);
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+
+// FreeRTOS sobre hilos POSIX: un tick = 1 ms.
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define configTICK_RATE_HZ 1000
+#define tskNO_AFFINITY 0x7fffffff
+
+typedef std::recursive_mutex portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {}
+#define portENTER_CRITICAL(m) (m)->lock()
+#define portEXIT_CRITICAL(m) (m)->unlock()
+#define portENTER_CRITICAL_ISR(m) (m)->lock()
+#define portEXIT_CRITICAL_ISR(m) (m)->unlock()
+
+TickType_t xTaskGetTickCount();
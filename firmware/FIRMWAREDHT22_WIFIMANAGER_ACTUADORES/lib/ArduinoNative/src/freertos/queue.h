@@ -0,0 +1,16 @@
+#pragma once
+#include "FreeRTOS.h"
+
+struct NativeQueue;
+typedef NativeQueue* QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+void vQueueDelete(QueueHandle_t q);
+BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t wait);
+inline BaseType_t xQueueSendToBack(QueueHandle_t q, const void* item, TickType_t wait) {
+  return xQueueSend(q, item, wait);
+}
+BaseType_t xQueueReceive(QueueHandle_t q, void* item, TickType_t wait);
+BaseType_t xQueuePeek(QueueHandle_t q, void* item, TickType_t wait);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q);
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t q);
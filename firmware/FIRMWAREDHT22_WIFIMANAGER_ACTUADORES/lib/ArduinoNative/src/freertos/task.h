@@ -0,0 +1,16 @@
+#pragma once
+#include "FreeRTOS.h"
+
+struct NativeTask;
+typedef NativeTask* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stack, void* arg,
+                                   UBaseType_t prio, TaskHandle_t* handle, BaseType_t core);
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stack, void* arg,
+                       UBaseType_t prio, TaskHandle_t* handle);
+void vTaskDelay(TickType_t ticks);
+BaseType_t xTaskDelayUntil(TickType_t* prev, TickType_t increment);
+inline void vTaskDelayUntil(TickType_t* prev, TickType_t increment) { xTaskDelayUntil(prev, increment); }
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+BaseType_t xPortGetCoreID();
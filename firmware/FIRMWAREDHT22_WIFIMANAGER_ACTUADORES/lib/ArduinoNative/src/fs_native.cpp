@@ -0,0 +1,209 @@
+#include "FS.h"
+#include "SPIFFS.h"
+#include "LittleFS.h"
+#include <dirent.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace fs {
+
+class FileImpl {
+ public:
+  FILE* fp = nullptr;
+  DIR* dir = nullptr;
+  std::string hostPath;
+  std::string path;
+  std::string name;
+  ~FileImpl() {
+    if (fp) fclose(fp);
+    if (dir) closedir(dir);
+  }
+};
+
+static const char* baseName(const std::string& p) {
+  size_t i = p.rfind('/');
+  return i == std::string::npos ? p.c_str() : p.c_str() + i + 1;
+}
+
+size_t File::write(const uint8_t* buf, size_t len) {
+  if (!impl_ || !impl_->fp) return 0;
+  return fwrite(buf, 1, len, impl_->fp);
+}
+
+int File::available() {
+  if (!impl_ || !impl_->fp) return 0;
+  long s = (long)size();
+  long p = ftell(impl_->fp);
+  return s > p ? (int)(s - p) : 0;
+}
+
+int File::read() {
+  if (!impl_ || !impl_->fp) return -1;
+  int c = fgetc(impl_->fp);
+  return c == EOF ? -1 : c;
+}
+
+size_t File::read(uint8_t* buf, size_t len) {
+  if (!impl_ || !impl_->fp) return 0;
+  return fread(buf, 1, len, impl_->fp);
+}
+
+int File::peek() {
+  if (!impl_ || !impl_->fp) return -1;
+  int c = fgetc(impl_->fp);
+  if (c != EOF) ungetc(c, impl_->fp);
+  return c == EOF ? -1 : c;
+}
+
+void File::flush() {
+  if (impl_ && impl_->fp) fflush(impl_->fp);
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+  if (!impl_ || !impl_->fp) return false;
+  int whence = mode == SeekSet ? SEEK_SET : mode == SeekCur ? SEEK_CUR : SEEK_END;
+  return fseek(impl_->fp, (long)pos, whence) == 0;
+}
+
+size_t File::position() const {
+  if (!impl_ || !impl_->fp) return 0;
+  return (size_t)ftell(impl_->fp);
+}
+
+size_t File::size() const {
+  if (!impl_) return 0;
+  if (impl_->fp) fflush(impl_->fp);
+  struct stat st;
+  return stat(impl_->hostPath.c_str(), &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+void File::close() { impl_.reset(); }
+
+File::operator bool() const { return impl_ && (impl_->fp || impl_->dir); }
+
+const char* File::name() const { return impl_ ? impl_->name.c_str() : ""; }
+const char* File::path() const { return impl_ ? impl_->path.c_str() : ""; }
+bool File::isDirectory() const { return impl_ && impl_->dir; }
+
+File File::openNextFile(const char* mode) {
+  if (!impl_ || !impl_->dir) return File();
+  struct dirent* e;
+  while ((e = readdir(impl_->dir)) != nullptr) {
+    if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0) continue;
+    auto f = std::make_shared<FileImpl>();
+    f->hostPath = impl_->hostPath + "/" + e->d_name;
+    f->path = (impl_->path == "/" ? "" : impl_->path) + "/" + e->d_name;
+    f->name = e->d_name;
+    struct stat st;
+    if (stat(f->hostPath.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+      f->dir = opendir(f->hostPath.c_str());
+    } else {
+      f->fp = fopen(f->hostPath.c_str(), mode[0] == 'r' ? "rb" : "r+b");
+    }
+    return File(f);
+  }
+  return File();
+}
+
+void File::rewindDirectory() {
+  if (impl_ && impl_->dir) rewinddir(impl_->dir);
+}
+
+static void mkdirs(const std::string& dir) {
+  for (size_t i = 1; i <= dir.size(); ++i) {
+    if (i == dir.size() || dir[i] == '/') ::mkdir(dir.substr(0, i).c_str(), 0755);
+  }
+}
+
+bool FS::begin(bool, const char*, uint8_t, const char*) {
+  const char* env = getenv("NATIVE_FS_ROOT");
+  root_ = std::string(env ? env : "native_fs") + "/" + label_;
+  mkdirs(root_);
+  mounted_ = true;
+  return true;
+}
+
+bool FS::format() {
+  std::string cmd = "rm -rf '" + root_ + "'";
+  if (system(cmd.c_str()) != 0) return false;
+  mkdirs(root_);
+  return true;
+}
+
+std::string FS::hostPath(const char* path) const {
+  std::string p = path ? path : "/";
+  if (p.empty() || p[0] != '/') p = "/" + p;
+  return root_ + p;
+}
+
+// Como en el ESP32: SPIFFS es plano (una ruta con '/' es solo un nombre) y
+// LittleFS no crea los directorios de la ruta salvo con open(..., create=true)
+// ni mkdir más de un nivel.
+File FS::open(const char* path, const char* mode, bool create) {
+  if (!mounted_) return File();
+  auto f = std::make_shared<FileImpl>();
+  f->hostPath = hostPath(path);
+  f->path = path;
+  f->name = baseName(f->path);
+  struct stat st;
+  bool isDir = stat(f->hostPath.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+  if (isDir) {
+    f->dir = opendir(f->hostPath.c_str());
+    return File(f);
+  }
+  const char* m = "rb";
+  if (strcmp(mode, "w") == 0) m = "wb";
+  else if (strcmp(mode, "a") == 0) m = "ab";
+  else if (strcmp(mode, "r+") == 0) m = "r+b";
+  else if (strcmp(mode, "w+") == 0) m = "w+b";
+  else if (strcmp(mode, "a+") == 0) m = "a+b";
+  if (m[0] != 'r' && (label_ == "spiffs" || create)) mkdirs(f->hostPath.substr(0, f->hostPath.rfind('/')));
+  f->fp = fopen(f->hostPath.c_str(), m);
+  if (!f->fp) return File();
+  return File(f);
+}
+
+bool FS::exists(const char* path) {
+  struct stat st;
+  return mounted_ && stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool FS::remove(const char* path) { return mounted_ && ::unlink(hostPath(path).c_str()) == 0; }
+
+bool FS::rename(const char* from, const char* to) {
+  return mounted_ && ::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0;
+}
+
+bool FS::mkdir(const char* path) {
+  if (!mounted_) return false;
+  if (label_ != "spiffs") return ::mkdir(hostPath(path).c_str(), 0755) == 0;
+  mkdirs(hostPath(path));
+  return true;
+}
+
+bool FS::rmdir(const char* path) { return mounted_ && ::rmdir(hostPath(path).c_str()) == 0; }
+
+static size_t duBytes(const std::string& dir) {
+  size_t total = 0;
+  DIR* d = opendir(dir.c_str());
+  if (!d) return 0;
+  struct dirent* e;
+  while ((e = readdir(d)) != nullptr) {
+    if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0) continue;
+    std::string p = dir + "/" + e->d_name;
+    struct stat st;
+    if (stat(p.c_str(), &st) != 0) continue;
+    total += S_ISDIR(st.st_mode) ? duBytes(p) : (size_t)st.st_size;
+  }
+  closedir(d);
+  return total;
+}
+
+size_t FS::usedBytes() { return mounted_ ? duBytes(root_) : 0; }
+
+}  // namespace fs
+
+fs::FS SPIFFS("spiffs", 1378241);
+fs::FS LittleFS("littlefs", 1441792);
@@ -0,0 +1,88 @@
+#include "HTTPClient.h"
+
+bool HTTPClient::begin(const String& url) {
+  valid_ = false;
+  body_ = String();
+  String rest;
+  if (url.startsWith("http://")) {
+    rest = url.substring(7);
+    port_ = 80;
+  } else if (url.startsWith("https://")) {
+    rest = url.substring(8);
+    port_ = 443;
+  } else {
+    return false;
+  }
+  int slash = rest.indexOf('/');
+  String hostPort = slash < 0 ? rest : rest.substring(0, slash);
+  path_ = slash < 0 ? String("/") : rest.substring(slash);
+  int colon = hostPort.indexOf(':');
+  host_ = colon < 0 ? hostPort : hostPort.substring(0, colon);
+  if (colon >= 0) port_ = hostPort.substring(colon + 1).toInt();
+
+  if (url.startsWith("https://")) {
+    const char* proxy = getenv("NATIVE_HTTPS_PROXY");
+    if (!proxy) return false;
+    String p(proxy);
+    int c = p.indexOf(':');
+    host_ = c < 0 ? p : p.substring(0, c);
+    port_ = c < 0 ? 80 : p.substring(c + 1).toInt();
+  }
+  valid_ = true;
+  return true;
+}
+
+void HTTPClient::end() {
+  headers_ = String();
+  valid_ = false;
+}
+
+int HTTPClient::GET() { return sendRequest("GET", nullptr, 0); }
+int HTTPClient::POST(uint8_t* payload, size_t size) { return sendRequest("POST", payload, size); }
+
+int HTTPClient::sendRequest(const char* method, uint8_t* payload, size_t size) {
+  if (!valid_) return HTTPC_ERROR_CONNECTION_REFUSED;
+  WiFiClient client;
+  if (!client.connect(host_.c_str(), port_, connectTimeoutMs_)) return HTTPC_ERROR_CONNECTION_REFUSED;
+
+  String head = String(method) + " " + path_ + " HTTP/1.1\r\nHost: " + host_ +
+                "\r\nConnection: close\r\nUser-Agent: ESP32HTTPClient\r\n" + headers_;
+  if (payload || strcmp(method, "POST") == 0) head += String("Content-Length: ") + String((unsigned long)size) + "\r\n";
+  head += "\r\n";
+  if (client.write(head.c_str(), head.length()) != head.length()) return HTTPC_ERROR_SEND_HEADER_FAILED;
+  if (size && client.write(payload, size) != size) return HTTPC_ERROR_SEND_PAYLOAD_FAILED;
+
+  // Respuesta completa hasta que el servidor cierre (Connection: close).
+  String raw;
+  unsigned long start = millis();
+  uint8_t buf[512];
+  while (millis() - start < timeoutMs_) {
+    int n = client.read(buf, sizeof(buf));
+    if (n > 0) {
+      raw.concat((const char*)buf, n);
+      continue;
+    }
+    if (!client.connected()) break;
+    delay(1);
+  }
+  client.stop();
+  if (!raw.length()) return HTTPC_ERROR_READ_TIMEOUT;
+  if (!raw.startsWith("HTTP/1.")) return HTTPC_ERROR_NO_HTTP_SERVER;
+  int code = raw.substring(9, 12).toInt();
+  int split = raw.indexOf("\r\n\r\n");
+  body_ = split < 0 ? String() : raw.substring(split + 4);
+  return code;
+}
+
+String HTTPClient::errorToString(int error) {
+  switch (error) {
+    case HTTPC_ERROR_CONNECTION_REFUSED: return "connection refused";
+    case HTTPC_ERROR_SEND_HEADER_FAILED: return "send header failed";
+    case HTTPC_ERROR_SEND_PAYLOAD_FAILED: return "send payload failed";
+    case HTTPC_ERROR_NOT_CONNECTED: return "not connected";
+    case HTTPC_ERROR_CONNECTION_LOST: return "connection lost";
+    case HTTPC_ERROR_NO_HTTP_SERVER: return "no HTTP server";
+    case HTTPC_ERROR_READ_TIMEOUT: return "read Timeout";
+    default: return String();
+  }
+}
@@ -0,0 +1,17 @@
+#include "Arduino.h"
+#include "ESPmDNS.h"
+#include <time.h>
+
+MDNSResponder MDNS;
+
+void setup();
+void loop();
+
+// Punto de entrada del proceso: el mismo ciclo que el core de Arduino.
+int main() {
+  setvbuf(stdout, nullptr, _IOLBF, 0);
+  setup();
+  for (;;) {
+    loop();
+  }
+}
@@ -0,0 +1,98 @@
+#include "esp_partition.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <mutex>
+#include <string>
+
+// Particiones de datos de partitions_logs.csv que no son sistemas de archivos.
+static esp_partition_t partitions[] = {
+  {ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)0x40, 0x2C0000, 0x130000, "logs", false},
+};
+
+static FILE* files[sizeof(partitions) / sizeof(partitions[0])];
+static std::mutex flashMutex;
+
+static FILE* fileOf(const esp_partition_t* p) {
+  size_t i = p - partitions;
+  if (i >= sizeof(partitions) / sizeof(partitions[0])) return nullptr;
+  if (files[i]) return files[i];
+  const char* env = getenv("NATIVE_FS_ROOT");
+  std::string root = env ? env : "native_fs";
+  ::mkdir(root.c_str(), 0755);
+  std::string path = root + "/" + p->label + ".partition";
+  FILE* f = fopen(path.c_str(), "r+b");
+  if (!f) {
+    // Recién "flasheada": todo borrado
+    f = fopen(path.c_str(), "w+b");
+    if (!f) return nullptr;
+    static uint8_t erased[SPI_FLASH_SEC_SIZE];
+    memset(erased, 0xFF, sizeof(erased));
+    for (uint32_t done = 0; done < p->size; done += sizeof(erased)) fwrite(erased, 1, sizeof(erased), f);
+    fflush(f);
+  }
+  files[i] = f;
+  return f;
+}
+
+static bool inRange(const esp_partition_t* p, size_t offset, size_t size) {
+  return p && offset <= p->size && size <= p->size - offset;
+}
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char* label) {
+  for (esp_partition_t& p : partitions) {
+    if (p.type != type) continue;
+    if (subtype != ESP_PARTITION_SUBTYPE_ANY && p.subtype != subtype) continue;
+    if (label && strcmp(label, p.label)) continue;
+    return &p;
+  }
+  return nullptr;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* p, size_t offset, void* dst, size_t size) {
+  if (!inRange(p, offset, size)) return ESP_ERR_INVALID_SIZE;
+  std::lock_guard<std::mutex> lock(flashMutex);
+  FILE* f = fileOf(p);
+  if (!f || fseek(f, (long)offset, SEEK_SET) || fread(dst, 1, size, f) != size) return ESP_FAIL;
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* p, size_t offset, const void* src, size_t size) {
+  if (!inRange(p, offset, size)) return ESP_ERR_INVALID_SIZE;
+  std::lock_guard<std::mutex> lock(flashMutex);
+  FILE* f = fileOf(p);
+  if (!f) return ESP_FAIL;
+  const uint8_t* in = (const uint8_t*)src;
+  uint8_t buf[256];
+  for (size_t done = 0; done < size;) {
+    size_t n = size - done < sizeof(buf) ? size - done : sizeof(buf);
+    if (fseek(f, (long)(offset + done), SEEK_SET) || fread(buf, 1, n, f) != n) return ESP_FAIL;
+    for (size_t i = 0; i < n; i++) {
+      if (in[done + i] & ~buf[i]) {
+        fprintf(stderr, "[native] %s: escritura sin borrar en 0x%zx\n", p->label, offset + done + i);
+      }
+      buf[i] &= in[done + i];  // NOR: solo baja bits
+    }
+    if (fseek(f, (long)(offset + done), SEEK_SET) || fwrite(buf, 1, n, f) != n) return ESP_FAIL;
+    done += n;
+  }
+  fflush(f);
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* p, size_t offset, size_t size) {
+  if (offset % SPI_FLASH_SEC_SIZE || size % SPI_FLASH_SEC_SIZE) return ESP_ERR_INVALID_ARG;
+  if (!inRange(p, offset, size)) return ESP_ERR_INVALID_SIZE;
+  std::lock_guard<std::mutex> lock(flashMutex);
+  FILE* f = fileOf(p);
+  if (!f || fseek(f, (long)offset, SEEK_SET)) return ESP_FAIL;
+  static uint8_t erased[SPI_FLASH_SEC_SIZE];
+  memset(erased, 0xFF, sizeof(erased));
+  for (size_t done = 0; done < size; done += sizeof(erased)) {
+    if (fwrite(erased, 1, sizeof(erased), f) != sizeof(erased)) return ESP_FAIL;
+  }
+  fflush(f);
+  return ESP_OK;
+}
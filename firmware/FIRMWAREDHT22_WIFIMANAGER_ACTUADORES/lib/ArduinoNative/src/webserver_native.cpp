@@ -0,0 +1,241 @@
+#include "WebServer.h"
+
+static const unsigned long HTTP_READ_TIMEOUT_MS = 5000;
+
+static String urlDecode(const String& in) {
+  String out;
+  for (unsigned int i = 0; i < in.length(); ++i) {
+    char c = in[i];
+    if (c == '+') {
+      out += ' ';
+    } else if (c == '%' && i + 2 < in.length()) {
+      char hex[3] = {in[i + 1], in[i + 2], 0};
+      out += (char)strtol(hex, nullptr, 16);
+      i += 2;
+    } else {
+      out += c;
+    }
+  }
+  return out;
+}
+
+static const char* statusText(int code) {
+  switch (code) {
+    case 200: return "OK";
+    case 204: return "No Content";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 500: return "Internal Server Error";
+    case 503: return "Service Unavailable";
+    default: return "";
+  }
+}
+
+// Lee una línea terminada en \n con el mismo timeout que el WebServer real.
+static bool readLine(WiFiClient& c, String& line) {
+  line = String();
+  unsigned long start = millis();
+  while (millis() - start < HTTP_READ_TIMEOUT_MS) {
+    int ch = c.read();
+    if (ch < 0) {
+      if (!c.connected()) return false;
+      delay(1);
+      continue;
+    }
+    if (ch == '\n') {
+      if (line.endsWith("\r")) line = line.substring(0, line.length() - 1);
+      return true;
+    }
+    line += (char)ch;
+  }
+  return false;
+}
+
+void WebServer::parseArgs(const String& data) {
+  int pos = 0;
+  while (pos < (int)data.length()) {
+    int amp = data.indexOf('&', pos);
+    if (amp < 0) amp = data.length();
+    String pair = data.substring(pos, amp);
+    int eq = pair.indexOf('=');
+    if (pair.length()) {
+      if (eq < 0) args_.push_back({urlDecode(pair), String()});
+      else args_.push_back({urlDecode(pair.substring(0, eq)), urlDecode(pair.substring(eq + 1))});
+    }
+    pos = amp + 1;
+  }
+}
+
+bool WebServer::readRequest() {
+  String line;
+  if (!readLine(client_, line)) return false;
+  int sp1 = line.indexOf(' ');
+  int sp2 = line.indexOf(' ', sp1 + 1);
+  if (sp1 < 0 || sp2 < 0) return false;
+  String m = line.substring(0, sp1);
+  String target = line.substring(sp1 + 1, sp2);
+
+  method_ = HTTP_GET;
+  if (m == "POST") method_ = HTTP_POST;
+  else if (m == "PUT") method_ = HTTP_PUT;
+  else if (m == "DELETE") method_ = HTTP_DELETE;
+  else if (m == "HEAD") method_ = HTTP_HEAD;
+  else if (m == "PATCH") method_ = HTTP_PATCH;
+  else if (m == "OPTIONS") method_ = HTTP_OPTIONS;
+
+  args_.clear();
+  headers_.clear();
+  int q = target.indexOf('?');
+  uri_ = urlDecode(q < 0 ? target : target.substring(0, q));
+  if (q >= 0) parseArgs(target.substring(q + 1));
+
+  size_t bodyLen = 0;
+  bool form = false;
+  while (readLine(client_, line) && line.length()) {
+    int colon = line.indexOf(':');
+    if (colon < 0) continue;
+    String key = line.substring(0, colon);
+    String value = line.substring(colon + 1);
+    value.trim();
+    if (key.equalsIgnoreCase("Content-Length")) bodyLen = value.toInt();
+    if (key.equalsIgnoreCase("Content-Type") && value.startsWith("application/x-www-form-urlencoded")) form = true;
+    for (auto& k : collect_) {
+      if (k.equalsIgnoreCase(key)) headers_.push_back({k, value});
+    }
+  }
+
+  if (bodyLen) {
+    String body;
+    unsigned long start = millis();
+    while (body.length() < bodyLen && millis() - start < HTTP_READ_TIMEOUT_MS) {
+      int ch = client_.read();
+      if (ch < 0) {
+        delay(1);
+        continue;
+      }
+      body += (char)ch;
+    }
+    if (form) parseArgs(body);
+    else args_.push_back({"plain", body});
+  }
+  return true;
+}
+
+void WebServer::handleClient() {
+  client_ = server_.available();
+  if (!client_) {
+    // Igual que el WebServer real: cede la CPU si no hay nadie esperando.
+    delay(1);
+    return;
+  }
+
+  pendingHeaders_ = String();
+  contentLength_ = CONTENT_LENGTH_NOT_SET;
+  chunked_ = false;
+
+  if (readRequest()) {
+    bool handled = false;
+    for (auto& r : routes_) {
+      if (r.uri == uri_ && (r.method == HTTP_ANY || r.method == method_)) {
+        r.fn();
+        handled = true;
+        break;
+      }
+    }
+    if (!handled) {
+      if (notFound_) notFound_();
+      else send(404, "text/plain", String("Not found: ") + uri_);
+    }
+  }
+  client_.stop();
+}
+
+String WebServer::arg(const String& name) const {
+  for (auto& kv : args_) {
+    if (kv.key == name) return kv.value;
+  }
+  return String();
+}
+
+bool WebServer::hasArg(const String& name) const {
+  for (auto& kv : args_) {
+    if (kv.key == name) return true;
+  }
+  return false;
+}
+
+void WebServer::collectHeaders(const char* headerKeys[], size_t count) {
+  collect_.clear();
+  for (size_t i = 0; i < count; ++i) collect_.push_back(headerKeys[i]);
+}
+
+String WebServer::header(const String& name) const {
+  for (auto& kv : headers_) {
+    if (kv.key.equalsIgnoreCase(name)) return kv.value;
+  }
+  return String();
+}
+
+bool WebServer::hasHeader(const String& name) const {
+  for (auto& kv : headers_) {
+    if (kv.key.equalsIgnoreCase(name)) return true;
+  }
+  return false;
+}
+
+void WebServer::sendHeader(const String& name, const String& value, bool first) {
+  String line = name + ": " + value + "\r\n";
+  if (first) pendingHeaders_ = line + pendingHeaders_;
+  else pendingHeaders_ += line;
+}
+
+void WebServer::writeHead(int code, const char* contentType, size_t contentLength) {
+  String head = String("HTTP/1.1 ") + String(code) + " " + statusText(code) + "\r\n";
+  if (contentType && *contentType) head += String("Content-Type: ") + contentType + "\r\n";
+  if (contentLength == CONTENT_LENGTH_UNKNOWN) {
+    chunked_ = true;
+    head += "Transfer-Encoding: chunked\r\n";
+  } else {
+    head += String("Content-Length: ") + String((unsigned long)contentLength) + "\r\n";
+  }
+  head += pendingHeaders_;
+  head += "Connection: close\r\n\r\n";
+  pendingHeaders_ = String();
+  client_.write(head.c_str(), head.length());
+}
+
+void WebServer::send(int code, const char* contentType, const String& content) {
+  size_t len = contentLength_ == CONTENT_LENGTH_NOT_SET ? content.length() : contentLength_;
+  writeHead(code, contentType, len);
+  contentLength_ = CONTENT_LENGTH_NOT_SET;
+  if (content.length()) sendContent(content);
+}
+
+void WebServer::sendContent(const char* content, size_t len) {
+  if (chunked_) {
+    char size[12];
+    int n = snprintf(size, sizeof(size), "%zx\r\n", len);
+    client_.write(size, n);
+    if (len) client_.write(content, len);
+    client_.write("\r\n", 2);
+    if (len == 0) chunked_ = false;
+    return;
+  }
+  client_.write(content, len);
+}
+
+size_t WebServer::streamFile(fs::File& file, const String& contentType, int code) {
+  String name = file.name();
+  if (name.endsWith(".gz") && contentType != "application/x-gzip" && contentType != "application/octet-stream") {
+    sendHeader("Content-Encoding", "gzip");
+  }
+  contentLength_ = file.size();
+  writeHead(code, contentType.c_str(), contentLength_);
+  contentLength_ = CONTENT_LENGTH_NOT_SET;
+  uint8_t buf[1436];
+  size_t total = 0, n;
+  while ((n = file.read(buf, sizeof(buf))) > 0) total += client_.write(buf, n);
+  return total;
+}
@@ -0,0 +1,275 @@
+#include "WiFi.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+
+// ====== WIFI ======
+// Con NATIVE_WIFI_DELAY_MS la red no está lista hasta ese tiempo después de
+// begin(): lo que tarda en asociarse escaneando todos los canales. Con BSSID
+// y canal conocidos se salta el escaneo y tarda la cuarta parte.
+WiFiClass WiFi;
+static long readWiFiDelay() {
+  const char* env = getenv("NATIVE_WIFI_DELAY_MS");
+  return env ? atol(env) : 0;
+}
+
+static const long wifiDelayMs = readWiFiDelay();
+static std::atomic<bool> wifiConnected{wifiDelayMs <= 0};
+static std::atomic<long> wifiConnectMs{-1};
+
+wl_status_t WiFiClass::status() {
+  long at = wifiConnectMs;
+  if (at >= 0 && (long)millis() >= at) {
+    wifiConnected = true;
+    wifiConnectMs = -1;
+  }
+  return wifiConnected ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+wl_status_t WiFiClass::begin(const char*, const char*, int32_t channel, const uint8_t* bssid, bool) {
+  if (wifiDelayMs > 0 && !wifiConnected && wifiConnectMs < 0) {
+    wifiConnectMs = (long)millis() + (channel && bssid ? wifiDelayMs / 4 : wifiDelayMs);
+  }
+  return status();
+}
+bool WiFiClass::disconnect(bool, bool) { return true; }
+
+uint8_t* WiFiClass::macAddress(uint8_t* mac) {
+  static const uint8_t fake[6] = {0x24, 0x6F, 0x28, 0xAA, 0xBB, 0xCC};
+  memcpy(mac, fake, 6);
+  return mac;
+}
+
+String WiFiClass::macAddress() {
+  uint8_t m[6];
+  macAddress(m);
+  char buf[18];
+  snprintf(buf, sizeof(buf), "%02X:%02X:%02X:%02X:%02X:%02X", m[0], m[1], m[2], m[3], m[4], m[5]);
+  return String(buf);
+}
+
+int8_t WiFiClass::RSSI() { return wifiConnected ? -55 : 0; }
+
+namespace native {
+void setWiFiConnected(bool connected) { wifiConnected = connected; }
+
+uint16_t hostPort(uint16_t devicePort) {
+  const char* env = getenv("NATIVE_HTTP_PORT");
+  if (env && devicePort == 80) return (uint16_t)atoi(env);
+  return devicePort < 1024 ? devicePort + 8000 : devicePort;
+}
+}
+
+// ====== CLIENTE TCP ======
+struct WiFiClient::Socket {
+  int fd = -1;
+  int peeked = -1;
+  ~Socket() {
+    if (fd >= 0) ::close(fd);
+  }
+};
+
+static void ignoreSigpipe() {
+  static bool done = false;
+  if (!done) {
+    signal(SIGPIPE, SIG_IGN);
+    done = true;
+  }
+}
+
+WiFiClient::WiFiClient(int fd) : sock_(std::make_shared<Socket>()) {
+  ignoreSigpipe();
+  sock_->fd = fd;
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+int WiFiClient::fd() const { return sock_ ? sock_->fd : -1; }
+
+int WiFiClient::connect(const char* host, uint16_t port, int32_t timeoutMs) {
+  ignoreSigpipe();
+  stop();
+  struct addrinfo hints = {}, *res = nullptr;
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  char portStr[8];
+  snprintf(portStr, sizeof(portStr), "%u", port);
+  if (getaddrinfo(host, portStr, &hints, &res) != 0 || !res) return 0;
+  int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+  if (fd < 0) {
+    freeaddrinfo(res);
+    return 0;
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  int rc = ::connect(fd, res->ai_addr, res->ai_addrlen);
+  freeaddrinfo(res);
+  if (rc < 0 && errno == EINPROGRESS) {
+    struct pollfd p = {fd, POLLOUT, 0};
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (poll(&p, 1, timeoutMs) <= 0 || getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err) {
+      ::close(fd);
+      return 0;
+    }
+  } else if (rc < 0) {
+    ::close(fd);
+    return 0;
+  }
+  sock_ = std::make_shared<Socket>();
+  sock_->fd = fd;
+  return 1;
+}
+
+size_t WiFiClient::write(const uint8_t* buf, size_t len) {
+  if (fd() < 0) return 0;
+  size_t sent = 0;
+  unsigned long start = millis();
+  while (sent < len) {
+    ssize_t n = ::send(fd(), buf + sent, len - sent, MSG_NOSIGNAL);
+    if (n > 0) {
+      sent += n;
+      continue;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      if (millis() - start > timeout_ * 5) break;
+      struct pollfd p = {fd(), POLLOUT, 0};
+      poll(&p, 1, 10);
+      continue;
+    }
+    stop();
+    break;
+  }
+  return sent;
+}
+
+int WiFiClient::available() {
+  if (fd() < 0) return 0;
+  int n = 0;
+  if (ioctl(fd(), FIONREAD, &n) < 0) return 0;
+  return n + (sock_->peeked >= 0 ? 1 : 0);
+}
+
+int WiFiClient::read() {
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+int WiFiClient::read(uint8_t* buf, size_t len) {
+  if (fd() < 0 || len == 0) return -1;
+  size_t got = 0;
+  if (sock_->peeked >= 0) {
+    buf[got++] = (uint8_t)sock_->peeked;
+    sock_->peeked = -1;
+  }
+  if (got < len) {
+    ssize_t n = ::recv(fd(), buf + got, len - got, 0);
+    if (n > 0) got += n;
+    else if (n == 0 && got == 0) {
+      stop();
+      return -1;
+    }
+  }
+  return got ? (int)got : -1;
+}
+
+int WiFiClient::peek() {
+  if (fd() < 0) return -1;
+  if (sock_->peeked < 0) {
+    uint8_t c;
+    if (::recv(fd(), &c, 1, 0) == 1) sock_->peeked = c;
+  }
+  return sock_->peeked;
+}
+
+int WiFiClient::availableForWrite() {
+  if (fd() < 0) return 0;
+  int sndbuf = 0, queued = 0;
+  socklen_t len = sizeof(sndbuf);
+  getsockopt(fd(), SOL_SOCKET, SO_SNDBUF, &sndbuf, &len);
+  ioctl(fd(), TIOCOUTQ, &queued);
+  // Se limita al tamaño de ventana de lwIP en el ESP32.
+  int room = sndbuf / 2 - queued;
+  return room < 0 ? 0 : std::min(room, 5744);
+}
+
+// Igual que en el core del ESP32: stop() suelta esta referencia y el socket
+// se cierra cuando se suelta la última (así /api/stream puede quedarse con
+// una copia del cliente del WebServer).
+void WiFiClient::stop() { sock_.reset(); }
+
+uint8_t WiFiClient::connected() {
+  if (fd() < 0) return 0;
+  if (sock_->peeked >= 0) return 1;
+  uint8_t c;
+  ssize_t n = ::recv(fd(), &c, 1, MSG_PEEK);
+  if (n == 0) return 0;
+  if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) return 0;
+  return 1;
+}
+
+IPAddress WiFiClient::remoteIP() const {
+  struct sockaddr_in addr = {};
+  socklen_t len = sizeof(addr);
+  if (fd() < 0 || getpeername(fd(), (struct sockaddr*)&addr, &len) < 0) return IPAddress();
+  uint32_t a = ntohl(addr.sin_addr.s_addr);
+  return IPAddress(a >> 24, a >> 16, a >> 8, a);
+}
+
+void WiFiClient::setNoDelay(bool nodelay) {
+  int v = nodelay ? 1 : 0;
+  if (fd() >= 0) setsockopt(fd(), IPPROTO_TCP, TCP_NODELAY, &v, sizeof(v));
+}
+
+// ====== SERVIDOR TCP ======
+void WiFiServer::begin(uint16_t port) {
+  ignoreSigpipe();
+  if (port) port_ = port;
+  fd_ = socket(AF_INET, SOCK_STREAM, 0);
+  int one = 1;
+  setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  uint16_t hp = native::hostPort(port_);
+  addr.sin_port = htons(hp);
+  if (bind(fd_, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd_, 64) < 0) {
+    fprintf(stderr, "[native] No se pudo escuchar en el puerto %u: %s\n", hp, strerror(errno));
+    ::close(fd_);
+    fd_ = -1;
+    return;
+  }
+  fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) | O_NONBLOCK);
+  fprintf(stderr, "[native] Puerto %u del dispositivo -> http://127.0.0.1:%u\n", port_, hp);
+}
+
+bool WiFiServer::hasClient() {
+  if (fd_ < 0) return false;
+  struct pollfd p = {fd_, POLLIN, 0};
+  return poll(&p, 1, 0) > 0;
+}
+
+WiFiClient WiFiServer::available() {
+  if (fd_ < 0) return WiFiClient();
+  int c = ::accept(fd_, nullptr, nullptr);
+  if (c < 0) return WiFiClient();
+  // Buffer de envío como el de lwIP en el ESP32 (TCP_SND_BUF = 5744): con el
+  // de Linux (MB) un cliente lento nunca frenaría al servidor.
+  int sndbuf = 5744;
+  setsockopt(c, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+  WiFiClient client(c);
+  if (noDelay_) client.setNoDelay(true);
+  return client;
+}
+
+void WiFiServer::end() {
+  if (fd_ >= 0) ::close(fd_);
+  fd_ = -1;
+}
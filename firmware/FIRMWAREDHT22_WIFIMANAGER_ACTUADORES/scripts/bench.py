@@ -0,0 +1,345 @@
+#!/usr/bin/env python3
+# ====== BENCHMARK DEL FIRMWARE ======
+# Mide la cadena petición/muestra/registro y escribe los resultados en JSON
+# plano ({"metrics": {"nombre": valor}}) para poder compararlos entre commits.
+#
+# En el host (pio run -e native_bench):
+#   python scripts/bench.py --out bench.json
+#   python scripts/bench.py --out nuevo.json --compare bench.json
+#
+# En la placa (pio run -e esp32doit-devkit-v1_bench -t upload):
+#   python scripts/bench.py --host 192.168.1.50 --serial /dev/ttyUSB0
+#
+# Fases:
+#   history_<N>.*  latencia de /api/latest y /api/history con N muestras
+#   http.*         peticiones por segundo con varios clientes a la vez
+#   concurrent.*   latencia de /api/latest con 10 clientes a la vez, con y sin
+#                  keep-alive, mientras otro cliente descarga el CSV muy despacio
+#   soak.*         7 días simulados (NATIVE_TIME_SCALE): vueltas de loop(),
+#                  lectura del sensor, coste de guardar cada muestra y heap
+#
+# Los tiempos van en ms salvo los *_us. Con --compare, un valor que empeora
+# más de --threshold por ciento hace que el script termine con código 1.
+
+import argparse
+import http.client
+import json
+import os
+import platform
+import shutil
+import socket
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+PROJECT_DIR = os.path.abspath(os.path.join(os.path.dirname(__file__), ".."))
+DEFAULT_BINARY = os.path.join(PROJECT_DIR, ".pio", "build", "native_bench", "program")
+HISTORY_SIZES = (0, 1000, 5000, 17280)
+SAMPLE_PERIOD_S = 10
+
+
+def percentiles(samples, prefix):
+    samples = sorted(samples)
+    if not samples:
+        return {}
+    pick = lambda q: samples[min(len(samples) - 1, int(q * len(samples)))]
+    return {
+        prefix + ".p50_ms": round(pick(0.50), 3),
+        prefix + ".p99_ms": round(pick(0.99), 3),
+        prefix + ".max_ms": round(samples[-1], 3),
+    }
+
+
+def timed_get(host, port, path):
+    start = time.perf_counter()
+    conn = http.client.HTTPConnection(host, port, timeout=30)
+    conn.request("GET", path)
+    resp = conn.getresponse()
+    body = resp.read()
+    conn.close()
+    if resp.status != 200:
+        raise RuntimeError("%s -> HTTP %d" % (path, resp.status))
+    return (time.perf_counter() - start) * 1000.0, len(body)
+
+
+def measure_endpoints(host, port, prefix, rounds):
+    now = int(time.time())
+    metrics = {}
+    for name, path, n in (
+        ("latest", "/api/latest", rounds),
+        ("history_csv", "/api/history", max(3, rounds // 20)),
+        ("history_bin", "/api/history?format=bin", max(3, rounds // 20)),
+        ("history_day", "/api/history?from=%d&to=%d&buckets=300" % (now - 86400, now), max(5, rounds // 10)),
+    ):
+        samples, size = [], 0
+        for _ in range(n):
+            ms, size = timed_get(host, port, path)
+            samples.append(ms)
+        metrics.update(percentiles(samples, "%s.%s" % (prefix, name)))
+        metrics["%s.%s.bytes" % (prefix, name)] = size
+    return metrics
+
+
+def measure_throughput(host, port, clients, seconds):
+    done, errors = [0], [0]
+    lock = threading.Lock()
+    deadline = time.perf_counter() + seconds
+
+    def worker():
+        while time.perf_counter() < deadline:
+            try:
+                timed_get(host, port, "/api/latest")
+                with lock:
+                    done[0] += 1
+            except (OSError, RuntimeError, http.client.HTTPException):
+                with lock:
+                    errors[0] += 1
+
+    threads = [threading.Thread(target=worker) for _ in range(clients)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    return {
+        "http.latest.c%d_rps" % clients: round(done[0] / seconds, 1),
+        "http.latest.c%d_errors" % clients: errors[0],
+    }
+
+
+def measure_concurrent(host, port, clients, seconds, keep_alive):
+    """p50/p99 de /api/latest con `clients` hilos y una descarga lenta de fondo."""
+    samples, errors = [], [0]
+    lock = threading.Lock()
+    deadline = time.perf_counter() + seconds
+
+    def slow_reader():
+        # Lee el histórico entero a 4 KB/s: con un servidor de un solo
+        # cliente, todo lo demás espera a que termine
+        try:
+            sock = socket.socket()
+            sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 4096)  # antes de conectar
+            sock.settimeout(30)
+            sock.connect((host, port))
+            sock.sendall(b"GET /api/history HTTP/1.1\r\nHost: x\r\nConnection: close\r\n\r\n")
+            while time.perf_counter() < deadline and sock.recv(1024):
+                time.sleep(0.25)
+            sock.close()
+        except OSError:
+            pass
+
+    def worker():
+        conn = None
+        while time.perf_counter() < deadline:
+            start = time.perf_counter()
+            try:
+                if conn is None:
+                    conn = http.client.HTTPConnection(host, port, timeout=30)
+                conn.request("GET", "/api/latest", headers={} if keep_alive else {"Connection": "close"})
+                resp = conn.getresponse()
+                resp.read()
+                if not keep_alive or resp.getheader("Connection", "").lower() == "close":
+                    conn.close()
+                    conn = None
+                if resp.status != 200:
+                    raise RuntimeError(resp.status)
+                with lock:
+                    samples.append((time.perf_counter() - start) * 1000.0)
+            except (OSError, RuntimeError, http.client.HTTPException):
+                if conn:
+                    conn.close()
+                conn = None
+                with lock:
+                    errors[0] += 1
+
+    slow = threading.Thread(target=slow_reader, daemon=True)
+    slow.start()
+    time.sleep(0.2)
+    threads = [threading.Thread(target=worker) for _ in range(clients)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    prefix = "concurrent.c%d%s" % (clients, "_keepalive" if keep_alive else "")
+    metrics = percentiles(samples, prefix)
+    metrics[prefix + "_rps"] = round(len(samples) / seconds, 1)
+    metrics[prefix + "_errors"] = errors[0]
+    return metrics
+
+
+def parse_bench_lines(lines):
+    reports = [json.loads(l[len("BENCH "):]) for l in lines if l.startswith("BENCH {")]
+    if not reports:
+        return {}
+    last = reports[-1]
+    metrics = {"soak.reports": len(reports), "soak.uptime_h": round(last["uptimeMs"] / 3600000.0, 1)}
+    for probe in ("loop", "http", "sensor", "append"):
+        for k in ("n", "mean", "p50", "p90", "p99", "max"):
+            metrics["soak.%s.%s%s" % (probe, k, "" if k == "n" else "_us")] = last[probe][k]
+    heap = [r["heap"] for r in reports]
+    metrics["soak.heap.min_free"] = min(h["minFree"] for h in heap)
+    metrics["soak.heap.min_max_alloc"] = min(h["maxAlloc"] for h in heap)
+    metrics["soak.heap.max_frag_pct"] = max(h["frag"] for h in heap)
+    # Lo que se pierde entre el primer y el último informe (fugas)
+    metrics["soak.heap.drift"] = heap[0]["free"] - heap[-1]["free"]
+    return metrics
+
+
+# ====== PROCESO NATIVE ======
+class Firmware:
+    """El firmware de env:native_bench con un SPIFFS propio en un directorio temporal."""
+
+    def __init__(self, binary, history=0, time_scale=1):
+        self.root = tempfile.mkdtemp(prefix="bench_fs_")
+        spiffs = os.path.join(self.root, "spiffs")
+        assets = os.path.join(PROJECT_DIR, "build_data")
+        if os.path.isdir(assets):
+            shutil.copytree(assets, spiffs)  # incluye config/
+        else:
+            os.makedirs(spiffs)
+        if history:
+            # El firmware importa /data.csv al arrancar
+            now = int(time.time())
+            with open(os.path.join(spiffs, "data.csv"), "w") as f:
+                for i in range(history):
+                    f.write("%d,%.2f,%.2f\n" % (now - (history - i) * SAMPLE_PERIOD_S, 24 + i % 7 * 0.1, 55.0))
+
+        with socket.socket() as s:
+            s.bind(("127.0.0.1", 0))
+            self.port = s.getsockname()[1]
+        env = dict(os.environ, NATIVE_FS_ROOT=self.root, NATIVE_HTTP_PORT=str(self.port),
+                   NATIVE_TIME_SCALE=str(time_scale))
+        self.proc = subprocess.Popen([binary], env=env, stdout=subprocess.PIPE,
+                                     stderr=subprocess.STDOUT, text=True, errors="replace")
+        self.lines = []
+        self.ready = threading.Event()
+        threading.Thread(target=self._drain, daemon=True).start()
+        if not self.ready.wait(60):
+            self.stop()
+            raise RuntimeError("el firmware no arrancó:\n" + "".join(self.lines[-20:]))
+        # /api/latest da 500 hasta la primera lectura del DHT (~3 s simulados)
+        deadline = time.time() + 10
+        while True:
+            try:
+                timed_get("127.0.0.1", self.port, "/api/latest")
+                break
+            except (OSError, RuntimeError, http.client.HTTPException):
+                if time.time() > deadline:
+                    self.stop()
+                    raise
+                time.sleep(0.2)
+
+    def _drain(self):
+        for line in self.proc.stdout:
+            if line.startswith("BENCH ") or len(self.lines) < 200:
+                self.lines.append(line)
+            if "Servidor HTTP iniciado" in line:
+                self.ready.set()
+
+    def stop(self):
+        self.proc.terminate()
+        self.proc.wait()
+        shutil.rmtree(self.root, ignore_errors=True)
+
+
+def run_native(args):
+    metrics = {}
+    for size in HISTORY_SIZES:
+        fw = Firmware(args.binary, history=size)
+        try:
+            metrics.update(measure_endpoints("127.0.0.1", fw.port, "history_%d" % size, args.rounds))
+            if size == HISTORY_SIZES[1]:
+                for clients in (1, 4):
+                    metrics.update(measure_throughput("127.0.0.1", fw.port, clients, args.seconds))
+            if size == HISTORY_SIZES[-1]:
+                for keep_alive in (False, True):
+                    metrics.update(measure_concurrent("127.0.0.1", fw.port, 10, args.seconds, keep_alive))
+        finally:
+            fw.stop()
+
+    scale = max(1, int(args.soak_days * 86400 / args.soak_seconds))
+    fw = Firmware(args.binary, time_scale=scale)
+    try:
+        time.sleep(args.soak_seconds)
+    finally:
+        fw.stop()
+    metrics.update(parse_bench_lines(fw.lines))
+    return metrics
+
+
+def run_device(args):
+    metrics = {}
+    if args.host:
+        metrics.update(measure_endpoints(args.host, 80, "device", args.rounds))
+        metrics.update(measure_throughput(args.host, 80, 1, args.seconds))
+    if args.serial:
+        import serial  # pyserial, solo hace falta para la placa
+
+        lines = []
+        deadline = time.time() + args.soak_seconds
+        with serial.Serial(args.serial, 115200, timeout=1) as port:
+            while time.time() < deadline:
+                lines.append(port.readline().decode("utf-8", "replace"))
+        metrics.update(parse_bench_lines(lines))
+    return metrics
+
+
+def compare(metrics, baseline_path, threshold):
+    with open(baseline_path) as f:
+        baseline = json.load(f)["metrics"]
+    worse = []
+    for key in sorted(set(metrics) & set(baseline)):
+        old, new = baseline[key], metrics[key]
+        if not isinstance(old, (int, float)) or not old:
+            continue
+        delta = 100.0 * (new - old) / abs(old)
+        # Más es mejor solo en el rendimiento y en el heap libre
+        higher_is_better = key.endswith("_rps") or ".min_free" in key or ".min_max_alloc" in key
+        regression = -delta if higher_is_better else delta
+        flag = ""
+        if regression > threshold:
+            flag = "  <-- peor"
+            worse.append(key)
+        print("%-40s %12s %12s %+8.1f%%%s" % (key, old, new, delta, flag), file=sys.stderr)
+    return worse
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmark del firmware (host o placa)")
+    parser.add_argument("--binary", default=DEFAULT_BINARY, help="programa de env:native_bench")
+    parser.add_argument("--host", help="IP de la placa (mide la placa en lugar del host)")
+    parser.add_argument("--serial", help="puerto serie de la placa para las líneas BENCH")
+    parser.add_argument("--rounds", type=int, default=200, help="peticiones a /api/latest por caso")
+    parser.add_argument("--seconds", type=float, default=5, help="duración de cada prueba de rendimiento")
+    parser.add_argument("--soak-days", type=float, default=7, help="días simulados en la prueba larga")
+    parser.add_argument("--soak-seconds", type=float, default=60, help="duración real de la prueba larga")
+    parser.add_argument("--out", help="fichero JSON de resultados (por defecto, stdout)")
+    parser.add_argument("--compare", help="JSON de una ejecución anterior")
+    parser.add_argument("--threshold", type=float, default=15, help="%% de empeoramiento tolerado")
+    args = parser.parse_args()
+
+    device = bool(args.host or args.serial)
+    metrics = run_device(args) if device else run_native(args)
+    result = {
+        "meta": {
+            "target": "device" if device else "native",
+            "time": int(time.time()),
+            "host": platform.node(),
+            "soakDays": args.soak_days,
+        },
+        "metrics": metrics,
+    }
+    text = json.dumps(result, indent=2, sort_keys=True)
+    if args.out:
+        with open(args.out, "w") as f:
+            f.write(text + "\n")
+    else:
+        print(text)
+
+    if args.compare and compare(metrics, args.compare, args.threshold):
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,90 @@
+# ====== ASSETS WEB PRECOMPRIMIDOS ======
+# Script "pre:" de PlatformIO. Copia data/ a build_data/ (que es lo que sube
+# "Upload Filesystem Image"), comprimiendo con gzip lo que merezca la pena, y
+# escribe /manifest.txt con una línea por asset:
+#
+#   <ruta> <etag> <content-type> <gz|raw>
+#
+# El firmware (static_assets.cpp) carga el manifiesto en RAM al arrancar: el
+# content-type y el ETag ya vienen resueltos y un If-None-Match que coincide se
+# contesta con 304 sin tocar la flash.
+#
+# data/config/ es configuración que lee el firmware (p. ej. las reglas de
+# alertas): se copia sin comprimir y no entra en el manifiesto.
+#
+# También se puede ejecutar a mano: python scripts/web_assets.py
+
+import gzip
+import hashlib
+import os
+import shutil
+
+SRC_DIR = "data"
+OUT_DIR = "build_data"
+MANIFEST = "manifest.txt"
+CONFIG_PREFIX = "/config/"
+
+CONTENT_TYPES = {
+    ".html": "text/html",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".json": "application/json",
+    ".svg": "image/svg+xml",
+    ".png": "image/png",
+    ".jpg": "image/jpeg",
+    ".gif": "image/gif",
+    ".ico": "image/x-icon",
+}
+# Los formatos ya comprimidos se dejan tal cual.
+COMPRESSIBLE = {".html", ".css", ".js", ".json", ".svg"}
+
+
+def build(project_dir):
+    src = os.path.join(project_dir, SRC_DIR)
+    out = os.path.join(project_dir, OUT_DIR)
+    shutil.rmtree(out, ignore_errors=True)
+    os.makedirs(out)
+
+    lines = []
+    raw_total = served_total = 0
+    for root, _, files in os.walk(src):
+        for name in sorted(files):
+            path = os.path.join(root, name)
+            rel = "/" + os.path.relpath(path, src).replace(os.sep, "/")
+            ext = os.path.splitext(name)[1].lower()
+            if rel.startswith(CONFIG_PREFIX):
+                target = os.path.join(out, rel.lstrip("/"))
+                os.makedirs(os.path.dirname(target), exist_ok=True)
+                shutil.copyfile(path, target)
+                continue
+            with open(path, "rb") as f:
+                body = f.read()
+
+            encoding = "raw"
+            if ext in COMPRESSIBLE:
+                # mtime=0: mismo contenido -> mismos bytes -> mismo ETag
+                packed = gzip.compress(body, compresslevel=9, mtime=0)
+                if len(packed) < len(body):
+                    body, encoding = packed, "gz"
+
+            target = os.path.join(out, rel.lstrip("/") + (".gz" if encoding == "gz" else ""))
+            os.makedirs(os.path.dirname(target), exist_ok=True)
+            with open(target, "wb") as f:
+                f.write(body)
+
+            etag = hashlib.sha256(body).hexdigest()[:16]
+            content_type = CONTENT_TYPES.get(ext, "text/plain")
+            lines.append("%s %s %s %s\n" % (rel, etag, content_type, encoding))
+            raw_total += os.path.getsize(path)
+            served_total += len(body)
+
+    with open(os.path.join(out, MANIFEST), "w") as f:
+        f.writelines(lines)
+    print("web_assets: %d archivos, %d -> %d bytes" % (len(lines), raw_total, served_total))
+
+
+try:
+    Import("env")  # noqa: F821 (lo define PlatformIO)
+    build(env.subst("$PROJECT_DIR"))  # noqa: F821
+except NameError:
+    build(os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))
@@ -0,0 +1,157 @@
+#include "actuator_journal.h"
+#include <stddef.h>
+#include <algorithm>
+#include <time.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "crc32.h"
+
+static fs::FS* journalFs = nullptr;
+static SemaphoreHandle_t journalMutex = nullptr;
+static uint32_t head = 0;
+static uint32_t tail = 0;
+
+static String segmentPath(uint32_t segment) {
+  return String(JOURNAL_DIR "/") + String(segment) + ".bin";
+}
+
+static uint16_t entryCrc(const JournalEntry& e) {
+  return (uint16_t)crc32(&e, offsetof(JournalEntry, crc));
+}
+
+static bool entryValid(const JournalEntry& e, uint32_t seq) {
+  return e.seq == seq && e.crc == entryCrc(e);
+}
+
+const char* journalSourceName(JournalSource source) {
+  static const char* const names[] = {"api", "controller", "rule"};
+  return source <= JOURNAL_RULE ? names[source] : "?";
+}
+
+// Deja en el último segmento solo las entradas válidas (un corte de luz a
+// mitad de escritura deja un registro incompleto al final).
+static uint32_t recoverSegment(uint32_t segment) {
+  String path = segmentPath(segment);
+  File file = journalFs->open(path, "r");
+  if (!file) return 0;
+  uint32_t stored = file.size() / sizeof(JournalEntry);
+  uint32_t valid = 0;
+  JournalEntry e;
+  while (valid < stored && file.read((uint8_t*)&e, sizeof(e)) == sizeof(e) &&
+         entryValid(e, segment * JOURNAL_SEGMENT_ENTRIES + valid)) {
+    valid++;
+  }
+  bool clean = valid * sizeof(JournalEntry) == file.size();
+  file.close();
+  if (clean) return valid;
+
+  Serial.printf("[Diario] %s dañado, se conservan %u entradas\n", path.c_str(), (unsigned)valid);
+  String tmpPath = path + ".tmp";
+  File src = journalFs->open(path, "r");
+  File dst = journalFs->open(tmpPath, "w");
+  for (uint32_t i = 0; src && dst && i < valid; i++) {
+    src.read((uint8_t*)&e, sizeof(e));
+    dst.write((const uint8_t*)&e, sizeof(e));
+  }
+  if (src) src.close();
+  if (dst) dst.close();
+  journalFs->remove(path);
+  journalFs->rename(tmpPath, path);
+  return valid;
+}
+
+bool journalBegin(fs::FS& fs) {
+  journalFs = &fs;
+  if (!journalMutex) journalMutex = xSemaphoreCreateMutex();
+
+  // LittleFS no crea el directorio al abrir un segmento (en SPIFFS,
+  // que es plano, mkdir no hace nada y las rutas con '/' ya funcionan)
+  fs.mkdir(JOURNAL_DIR);
+
+  // Segmentos presentes: el primero marca head y el último tail
+  uint32_t first = UINT32_MAX, last = 0;
+  File dir = fs.open(JOURNAL_DIR);
+  if (dir && dir.isDirectory()) {
+    for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+      const char* name = strrchr(f.name(), '/');
+      name = name ? name + 1 : f.name();
+      char* end;
+      uint32_t segment = strtoul(name, &end, 10);
+      if (end != name && !strcmp(end, ".bin")) {
+        first = min(first, segment);
+        last = max(last, segment);
+      }
+    }
+  }
+  if (first == UINT32_MAX) {
+    head = tail = 0;
+  } else {
+    head = first * JOURNAL_SEGMENT_ENTRIES;
+    tail = last * JOURNAL_SEGMENT_ENTRIES + recoverSegment(last);
+  }
+  Serial.printf("[Diario] %u cambios del actuador guardados\n", (unsigned)(tail - head));
+  return true;
+}
+
+bool journalAppend(bool on, JournalSource source, float value) {
+  if (!journalFs) return false;
+  JournalEntry e = {};
+  time_t now = time(nullptr);
+  e.ts = now >= 1600000000 ? (uint32_t)now : 0;
+  e.value = value;
+  e.state = on ? 1 : 0;
+  e.source = source;
+
+  xSemaphoreTake(journalMutex, portMAX_DELAY);
+  e.seq = tail;
+  e.crc = entryCrc(e);
+  uint32_t segment = tail / JOURNAL_SEGMENT_ENTRIES;
+  // Segmento nuevo: se descartan enteros los que sobran por el principio
+  while (segment - head / JOURNAL_SEGMENT_ENTRIES >= JOURNAL_SEGMENTS) {
+    uint32_t oldest = head / JOURNAL_SEGMENT_ENTRIES;
+    journalFs->remove(segmentPath(oldest));
+    head = (oldest + 1) * JOURNAL_SEGMENT_ENTRIES;
+  }
+  // Cada entrada va a su posición fija y no al final: si una escritura falló
+  // a medias, la siguiente pisa esos bytes en lugar de quedar desplazada.
+  uint32_t offset = (tail % JOURNAL_SEGMENT_ENTRIES) * sizeof(JournalEntry);
+  File file = journalFs->open(segmentPath(segment), offset ? "r+" : "w");
+  bool ok = file && file.seek(offset) && file.write((const uint8_t*)&e, sizeof(e)) == sizeof(e);
+  if (file) file.close();
+  if (ok) tail++;
+  xSemaphoreGive(journalMutex);
+  if (!ok) Serial.println(F("[Diario] No se pudo guardar el cambio"));
+  return ok;
+}
+
+uint32_t journalRead(uint32_t before, JournalEntry* out, uint32_t limit) {
+  if (!journalFs) return 0;
+  xSemaphoreTake(journalMutex, portMAX_DELAY);
+  uint32_t end = min(before, tail);
+  uint32_t count = 0;
+  // Segmento a segmento hacia atrás: un seek y una lectura contigua por cada uno
+  while (count < limit && end > head) {
+    uint32_t segment = (end - 1) / JOURNAL_SEGMENT_ENTRIES;
+    uint32_t segStart = max(segment * JOURNAL_SEGMENT_ENTRIES, head);
+    uint32_t start = max(segStart, end - min(limit - count, end - segStart));
+    File file = journalFs->open(segmentPath(segment), "r");
+    if (file && file.seek((start - segment * JOURNAL_SEGMENT_ENTRIES) * sizeof(JournalEntry))) {
+      uint32_t n = file.read((uint8_t*)(out + count), (end - start) * sizeof(JournalEntry)) / sizeof(JournalEntry);
+      // El fichero va de antiguo a nuevo y la página de nuevo a antiguo
+      std::reverse(out + count, out + count + n);
+      uint32_t kept = 0;
+      for (uint32_t i = 0; i < n; i++) {
+        JournalEntry e = out[count + i];
+        if (entryValid(e, start + n - 1 - i)) out[count + kept++] = e;
+      }
+      count += kept;
+    }
+    if (file) file.close();
+    end = start;
+  }
+  xSemaphoreGive(journalMutex);
+  return count;
+}
+
+uint32_t journalHead() { return head; }
+uint32_t journalTail() { return tail; }
@@ -0,0 +1,43 @@
+#pragma once
+#include <Arduino.h>
+#include <FS.h>
+
+// ====== DIARIO DEL ACTUADOR ======
+// Cada cambio de la salida se añade a un diario en flash: registros de 16
+// bytes con un número de secuencia absoluto, repartidos en segmentos de
+// JOURNAL_SEGMENT_ENTRIES (/journal/<n>.bin, con n = seq / entradas por
+// segmento). Solo se escribe al final del último segmento; al abrir uno
+// nuevo se borran enteros los más antiguos hasta dejar JOURNAL_SEGMENTS, así
+// que el diario está acotado y compactar no reescribe nada.
+//
+// Como la posición de un seq es fija (segmento y desplazamiento), leer una
+// página hacia atrás desde un seq es un seek, no un recorrido.
+
+#define JOURNAL_DIR "/journal"
+#define JOURNAL_SEGMENT_ENTRIES 256  // 4 KB por segmento
+#define JOURNAL_SEGMENTS 8           // hasta 2048 cambios guardados
+#define JOURNAL_PAGE_MAX 100
+
+enum JournalSource : uint8_t {
+  JOURNAL_API = 0,         // forzado desde /api/actuator
+  JOURNAL_CONTROLLER = 1,  // termostato/PID
+  JOURNAL_RULE = 2         // regla de seguridad (p. ej. apagado sin datos)
+};
+
+struct JournalEntry {
+  uint32_t seq;
+  uint32_t ts;     // epoch (0 si aún no había hora NTP)
+  float value;     // medida del control en ese momento (NaN si no había)
+  uint8_t state;   // 1 = encendido
+  JournalSource source;
+  uint16_t crc;    // CRC-32 de lo anterior, truncado
+};
+
+bool journalBegin(fs::FS& fs);
+bool journalAppend(bool on, JournalSource source, float value);
+// Copia hasta `limit` entradas con seq < before, de la más nueva a la más
+// antigua. Devuelve cuántas copió.
+uint32_t journalRead(uint32_t before, JournalEntry* out, uint32_t limit);
+uint32_t journalHead();  // seq más antiguo conservado
+uint32_t journalTail();  // seq del próximo cambio
+const char* journalSourceName(JournalSource source);
@@ -0,0 +1,228 @@
+#include "alerts.h"
+#include "json_reader.h"
+
+struct RatePoint {
+  uint32_t ms;
+  float value;
+};
+
+struct RuleState {
+  AlertStatus status;
+  bool pending;             // condición cumplida, esperando "for"
+  uint32_t pendingSinceMs;
+  uint32_t lastNotifyMs;
+  bool everNotified;
+  RatePoint points[ALERT_RATE_POINTS];  // muestras espaciadas window/16
+  uint8_t pointCount;
+  uint8_t pointHead;
+};
+
+static AlertRule rules[ALERTS_MAX_RULES];
+static RuleState states[ALERTS_MAX_RULES];
+static uint8_t ruleCount = 0;
+static uint32_t lastOkMs[SENSOR_COUNT + 1];
+static AlertCallback onAlert = nullptr;
+
+// Reglas de fábrica: el aviso de chip sobrecalentado de siempre, ya con
+// histéresis y cooldown.
+static const char DEFAULT_RULES[] =
+    "{\"rules\":[{\"id\":\"chip_sobrecalentado\",\"sensor\":\"chip\",\"type\":\"above\","
+    "\"threshold\":70,\"hysteresis\":5,\"for\":5,\"cooldown\":600}]}";
+
+const char* alertsSourceId(uint8_t source) {
+  return source == ALERT_SOURCE_CHIP ? "chip" : sensorId(source);
+}
+
+static int sourceIndex(const char* id) {
+  int i = sensorIndex(id);
+  if (i >= 0) return i;
+  return strcmp(id, "chip") == 0 ? ALERT_SOURCE_CHIP : -1;
+}
+
+static bool parseType(const char* s, AlertType& type) {
+  if (!strcmp(s, "above")) type = ALERT_ABOVE;
+  else if (!strcmp(s, "below")) type = ALERT_BELOW;
+  else if (!strcmp(s, "rate")) type = ALERT_RATE;
+  else if (!strcmp(s, "stale")) type = ALERT_STALE;
+  else return false;
+  return true;
+}
+
+static bool parseRule(JsonReader& r, AlertRule& rule) {
+  memset(&rule, 0, sizeof(rule));
+  rule.type = ALERT_ABOVE;
+  rule.windowS = 300;
+  char key[16], text[24];
+  bool hasSource = false;
+  if (!r.beginObject()) return false;
+  while (r.nextKey(key, sizeof(key))) {
+    if (!strcmp(key, "id")) r.readString(rule.id, sizeof(rule.id));
+    else if (!strcmp(key, "sensor") && r.readString(text, sizeof(text))) {
+      int source = sourceIndex(text);
+      if (source < 0) {
+        Serial.printf("[Alertas] Sensor desconocido: %s\n", text);
+      } else {
+        rule.source = source;
+        hasSource = true;
+      }
+    } else if (!strcmp(key, "metric") && r.readString(text, sizeof(text))) {
+      rule.metric = strcmp(text, "hum") == 0 ? ALERT_HUM : ALERT_TEMP;
+    } else if (!strcmp(key, "type") && r.readString(text, sizeof(text))) {
+      if (!parseType(text, rule.type)) Serial.printf("[Alertas] Tipo desconocido: %s\n", text);
+    } else if (!strcmp(key, "threshold")) r.readNumber(rule.threshold);
+    else if (!strcmp(key, "hysteresis")) r.readNumber(rule.hysteresis);
+    else if (!strcmp(key, "for")) r.readNumber(rule.forS);
+    else if (!strcmp(key, "cooldown")) r.readNumber(rule.cooldownS);
+    else if (!strcmp(key, "window") || !strcmp(key, "seconds")) r.readNumber(rule.windowS);
+    else r.skipValue();
+  }
+  return r.ok() && hasSource && rule.id[0];
+}
+
+static uint8_t parseRules(const char* text, size_t len) {
+  JsonReader r(text, len);
+  char key[16];
+  ruleCount = 0;
+  if (!r.beginObject()) return 0;
+  while (r.nextKey(key, sizeof(key))) {
+    if (strcmp(key, "rules") || !r.beginArray()) {
+      r.skipValue();
+      continue;
+    }
+    while (r.nextElement()) {
+      AlertRule rule;
+      if (!parseRule(r, rule)) {
+        if (!r.ok()) break;
+        continue;  // regla incompleta: se ignora y se sigue
+      }
+      if (ruleCount < ALERTS_MAX_RULES) rules[ruleCount++] = rule;
+    }
+  }
+  if (!r.ok()) {
+    Serial.println(F("[Alertas] JSON no válido"));
+    ruleCount = 0;
+  }
+  return ruleCount;
+}
+
+uint8_t alertsBegin(fs::FS& fs, AlertCallback callback) {
+  onAlert = callback;
+  memset(states, 0, sizeof(states));
+  for (auto& ms : lastOkMs) ms = millis();
+
+  File file = fs.open(ALERTS_PATH, "r");
+  if (file && file.size() < 4096) {
+    static char text[4096];
+    size_t len = file.read((uint8_t*)text, sizeof(text) - 1);
+    text[len] = '\0';
+    parseRules(text, len);
+  }
+  if (file) file.close();
+  if (!ruleCount) parseRules(DEFAULT_RULES, sizeof(DEFAULT_RULES) - 1);
+  Serial.printf("[Alertas] %u reglas\n", (unsigned)ruleCount);
+  return ruleCount;
+}
+
+// ====== EVALUACIÓN ======
+static void transition(uint8_t i, bool active, float value) {
+  RuleState& st = states[i];
+  const AlertRule& rule = rules[i];
+  st.status.value = value;
+
+  if (active && !st.status.active) {
+    // Debounce: la condición tiene que mantenerse "for" segundos
+    if (!st.pending) {
+      st.pending = true;
+      st.pendingSinceMs = millis();
+    }
+    if (millis() - st.pendingSinceMs < rule.forS * 1000UL) return;
+    st.pending = false;
+    st.status.active = true;
+    st.status.raised++;
+    bool cooling = st.everNotified && millis() - st.lastNotifyMs < rule.cooldownS * 1000UL;
+    st.status.notified = !cooling;
+    if (cooling) {
+      st.status.suppressed++;
+      return;
+    }
+    st.everNotified = true;
+    st.lastNotifyMs = millis();
+    if (onAlert) onAlert(rule, true, value);
+  } else if (!active) {
+    st.pending = false;
+    if (!st.status.active) return;
+    st.status.active = false;
+    // Solo se avisa del final si se avisó del principio
+    if (st.status.notified && onAlert) onAlert(rule, false, value);
+    st.status.notified = false;
+  }
+}
+
+// Con histéresis: estando activa, hace falta pasar el umbral en
+// `hysteresis` hacia el otro lado para resolverse.
+static bool beyond(const AlertRule& rule, bool active, float value, bool above) {
+  float limit = active ? (above ? rule.threshold - rule.hysteresis : rule.threshold + rule.hysteresis)
+                       : rule.threshold;
+  return above ? value > limit : value < limit;
+}
+
+// Cambio por minuto respecto a la muestra más antigua dentro de la ventana.
+static bool rateOf(RuleState& st, const AlertRule& rule, float value, float& rate) {
+  uint32_t now = millis();
+  uint32_t spacing = max<uint32_t>(rule.windowS * 1000UL / ALERT_RATE_POINTS, 1);
+  uint8_t newest = (st.pointHead + ALERT_RATE_POINTS - 1) % ALERT_RATE_POINTS;
+  if (!st.pointCount || now - st.points[newest].ms >= spacing) {
+    st.points[st.pointHead] = {now, value};
+    st.pointHead = (st.pointHead + 1) % ALERT_RATE_POINTS;
+    if (st.pointCount < ALERT_RATE_POINTS) st.pointCount++;
+  }
+  uint8_t oldest = (st.pointHead + ALERT_RATE_POINTS - st.pointCount) % ALERT_RATE_POINTS;
+  const RatePoint& ref = st.points[oldest];
+  if (now - ref.ms < rule.windowS * 1000UL / 2) return false;  // aún poca historia
+  rate = (value - ref.value) * 60000.0f / (now - ref.ms);
+  return true;
+}
+
+void alertsOnSample(uint8_t source, float temp, float hum, bool ok) {
+  if (source > ALERT_SOURCE_CHIP) return;
+  if (ok) lastOkMs[source] = millis();
+  for (uint8_t i = 0; i < ruleCount; i++) {
+    const AlertRule& rule = rules[i];
+    if (rule.source != source || rule.type == ALERT_STALE || !ok) continue;
+    float value = rule.metric == ALERT_HUM ? hum : temp;
+    if (isnan(value)) continue;
+    bool active = states[i].status.active;
+    switch (rule.type) {
+      case ALERT_ABOVE:
+        transition(i, beyond(rule, active, value, true), value);
+        break;
+      case ALERT_BELOW:
+        transition(i, beyond(rule, active, value, false), value);
+        break;
+      case ALERT_RATE: {
+        float rate;
+        if (rateOf(states[i], rule, value, rate)) {
+          transition(i, beyond(rule, active, rate, rule.threshold >= 0), rate);
+        }
+        break;
+      }
+      default:
+        break;
+    }
+  }
+}
+
+void alertsTick() {
+  static unsigned long lastTickMs = 0;
+  if (millis() - lastTickMs < 1000) return;
+  lastTickMs = millis();
+  for (uint8_t i = 0; i < ruleCount; i++) {
+    if (rules[i].type != ALERT_STALE) continue;
+    float silentS = (millis() - lastOkMs[rules[i].source]) / 1000.0f;
+    transition(i, silentS > rules[i].windowS, silentS);
+  }
+}
+
+uint8_t alertsCount() { return ruleCount; }
+const AlertRule& alertsRule(uint8_t i) { return rules[i]; }
+AlertStatus alertsStatus(uint8_t i) { return states[i].status; }
@@ -0,0 +1,65 @@
+#pragma once
+#include <Arduino.h>
+#include <FS.h>
+#include "sensors.h"
+
+// ====== ALERTAS ======
+// Reglas cargadas de /config/alerts.json (o las de fábrica si no existe):
+//
+//   {"rules": [
+//     {"id": "chip_caliente", "sensor": "chip", "type": "above", "threshold": 70,
+//      "hysteresis": 5, "for": 10, "cooldown": 600},
+//     {"id": "dht0_mudo", "sensor": "dht0", "type": "stale", "seconds": 60},
+//     {"id": "subida_rapida", "sensor": "dht0", "metric": "temp", "type": "rate",
+//      "threshold": 0.5, "window": 300}
+//   ]}
+//
+// type: "above"/"below" (umbral con histéresis), "rate" (cambio por minuto
+// sobre `window` segundos; umbral negativo = bajada) o "stale" (sin lecturas
+// válidas en `seconds`). "for" exige que la condición dure esos segundos
+// antes de saltar y "cooldown" evita repetir el aviso de la misma regla
+// durante ese tiempo. Solo se notifican los cambios de estado (salta/se
+// resuelve), así que un incidente son dos eventos y no uno por vuelta.
+//
+// Las reglas se evalúan por muestra nueva (alertsOnSample) y, las de tipo
+// stale, una vez por segundo (alertsTick). "chip" es la temperatura interna
+// aunque no esté en SENSOR_TABLE.
+
+#define ALERTS_PATH "/config/alerts.json"
+#define ALERTS_MAX_RULES 16
+#define ALERT_SOURCE_CHIP SENSOR_COUNT  // fuente extra: temperatureRead()
+#define ALERT_RATE_POINTS 16
+
+enum AlertType : uint8_t { ALERT_ABOVE, ALERT_BELOW, ALERT_RATE, ALERT_STALE };
+enum AlertMetric : uint8_t { ALERT_TEMP, ALERT_HUM };
+
+struct AlertRule {
+  char id[24];
+  uint8_t source;     // índice en SENSOR_TABLE o ALERT_SOURCE_CHIP
+  AlertMetric metric;
+  AlertType type;
+  float threshold;
+  float hysteresis;
+  uint32_t forS;
+  uint32_t cooldownS;
+  uint32_t windowS;   // rate: ventana; stale: segundos sin datos
+};
+
+struct AlertStatus {
+  bool active;        // la condición se cumple (ya pasado "for")
+  bool notified;      // se avisó al saltar (no estaba en cooldown)
+  float value;        // último valor evaluado
+  uint32_t raised;    // veces que ha saltado
+  uint32_t suppressed;  // saltos sin aviso por el cooldown
+};
+
+// raised = true al saltar, false al resolverse.
+typedef void (*AlertCallback)(const AlertRule& rule, bool raised, float value);
+
+uint8_t alertsBegin(fs::FS& fs, AlertCallback callback);
+void alertsOnSample(uint8_t source, float temp, float hum, bool ok);
+void alertsTick();
+uint8_t alertsCount();
+const AlertRule& alertsRule(uint8_t i);
+AlertStatus alertsStatus(uint8_t i);
+const char* alertsSourceId(uint8_t source);
@@ -0,0 +1,104 @@
+#include "bench.h"
+
+#ifdef BENCH
+#include "json_writer.h"
+
+// Histograma logarítmico en µs con 8 sub-intervalos por potencia de 2: los
+// percentiles salen con un error < 12,5 % sin guardar las muestras.
+#define BENCH_SUB_BITS 3
+#define BENCH_BUCKETS (32 << BENCH_SUB_BITS)
+
+struct BenchHistogram {
+  uint32_t count;
+  uint64_t sum;
+  uint32_t max;
+  uint32_t buckets[BENCH_BUCKETS];
+};
+
+static const char* const probeNames[BENCH_PROBES] = {"loop", "http", "sensor", "append"};
+static BenchHistogram hist[BENCH_PROBES];
+static uint32_t lastLoopStart = 0;
+static unsigned long lastReportMs = 0;
+
+// En native el reloj del firmware puede ir acelerado (NATIVE_TIME_SCALE):
+// se mide con el reloj real.
+static uint32_t nowMicros() {
+#ifdef ARDUINO_NATIVE
+  return (uint32_t)native::realMicros();
+#else
+  return micros();
+#endif
+}
+
+static uint16_t bucketOf(uint32_t us) {
+  if (us < (1u << BENCH_SUB_BITS)) return us;
+  uint8_t log2 = 31 - __builtin_clz(us);
+  uint8_t sub = (us >> (log2 - BENCH_SUB_BITS)) & ((1 << BENCH_SUB_BITS) - 1);
+  return ((log2 - BENCH_SUB_BITS + 1) << BENCH_SUB_BITS) + sub;
+}
+
+// Límite superior (µs) del intervalo.
+static uint32_t bucketUpper(uint16_t i) {
+  if (i < (1u << BENCH_SUB_BITS)) return i;
+  uint8_t log2 = (i >> BENCH_SUB_BITS) + BENCH_SUB_BITS - 1;
+  uint32_t sub = i & ((1 << BENCH_SUB_BITS) - 1);
+  return ((1u << BENCH_SUB_BITS) + sub + 1) << (log2 - BENCH_SUB_BITS);
+}
+
+static uint32_t percentile(const BenchHistogram& h, uint32_t permille) {
+  uint64_t rank = ((uint64_t)h.count * permille + 999) / 1000;
+  uint64_t seen = 0;
+  for (uint16_t i = 0; i < BENCH_BUCKETS; i++) {
+    seen += h.buckets[i];
+    if (seen >= rank && seen) return min(bucketUpper(i), h.max);
+  }
+  return h.max;
+}
+
+static void record(BenchProbe probe, uint32_t us) {
+  BenchHistogram& h = hist[probe];
+  h.count++;
+  h.sum += us;
+  h.max = max(h.max, us);
+  h.buckets[min<uint16_t>(bucketOf(us), BENCH_BUCKETS - 1)]++;
+}
+
+uint32_t benchStart() { return nowMicros(); }
+
+void benchEnd(BenchProbe probe, uint32_t start) { record(probe, nowMicros() - start); }
+
+static void report() {
+  static char buf[640];
+  JsonWriter json(buf, sizeof(buf));
+  json.beginObject().field("uptimeMs", millis());
+  for (uint8_t p = 0; p < BENCH_PROBES; p++) {
+    const BenchHistogram& h = hist[p];
+    json.key(probeNames[p]).beginObject()
+        .field("n", h.count)
+        .field("mean", h.count ? (double)h.sum / h.count : 0.0, 1)
+        .field("p50", percentile(h, 500)).field("p90", percentile(h, 900))
+        .field("p99", percentile(h, 990)).field("max", h.max)
+        .endObject();
+  }
+  uint32_t freeHeap = ESP.getFreeHeap(), maxAlloc = ESP.getMaxAllocHeap();
+  json.key("heap").beginObject()
+      .field("free", freeHeap).field("minFree", ESP.getMinFreeHeap()).field("maxAlloc", maxAlloc)
+      .field("frag", freeHeap ? 100.0 * (1.0 - (double)maxAlloc / freeHeap) : 0.0, 1)
+      .endObject();
+  json.endObject();
+  Serial.printf("BENCH %s\n", json.c_str());
+}
+
+void benchLoop() {
+  uint32_t now = nowMicros();
+  if (lastLoopStart) record(BENCH_LOOP, now - lastLoopStart);
+  lastLoopStart = now;
+
+  if (millis() - lastReportMs >= BENCH_REPORT_MS) {
+    lastReportMs = millis();
+    report();
+    // El informe no cuenta como vuelta lenta
+    lastLoopStart = nowMicros();
+  }
+}
+#endif
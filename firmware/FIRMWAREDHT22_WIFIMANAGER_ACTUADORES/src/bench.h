@@ -0,0 +1,30 @@
+#pragma once
+#include <Arduino.h>
+
+// ====== BENCHMARK ======
+// Solo con -DBENCH (envs native_bench y esp32doit-devkit-v1_bench). Mide
+// la duración de cada vuelta de loop() y de los bloques marcados con
+// benchStart()/benchEnd(), y cada BENCH_REPORT_MS imprime por Serial una
+// línea "BENCH {json}" que recoge scripts/bench.py (por stdout en native, por
+// el puerto serie en la placa). Sin -DBENCH todo queda en funciones vacías.
+
+#define BENCH_REPORT_MS 60000UL
+
+enum BenchProbe : uint8_t {
+  BENCH_LOOP,     // una vuelta completa de loop()
+  BENCH_HTTP,     // server.handleClient()
+  BENCH_SENSOR,   // lectura del DHT22
+  BENCH_APPEND,   // guardar la muestra en el historial
+  BENCH_PROBES
+};
+
+#ifdef BENCH
+uint32_t benchStart();
+void benchEnd(BenchProbe probe, uint32_t start);
+// Llamar al principio de loop(): cierra la vuelta anterior y reporta.
+void benchLoop();
+#else
+inline uint32_t benchStart() { return 0; }
+inline void benchEnd(BenchProbe, uint32_t) {}
+inline void benchLoop() {}
+#endif
@@ -0,0 +1,212 @@
+#include "boot.h"
+#include <WiFi.h>
+#include <WiFiManager.h>
+#include <time.h>
+#include <stddef.h>
+#include "crc32.h"
+#include "json_reader.h"
+
+static const time_t MIN_VALID_EPOCH = 1600000000;  // antes de esto no hay hora NTP
+
+// ====== CACHÉ DE LA ÚLTIMA CONEXIÓN ======
+struct WiFiCache {
+  char ssid[33];
+  uint8_t bssid[6];
+  uint8_t channel;
+  uint32_t crc;  // de todo lo anterior
+};
+
+enum NetState : uint8_t { NET_FAST, NET_SCAN, NET_PORTAL, NET_UP };
+
+static fs::FS* bootFs = nullptr;
+static const char* bootHostname = nullptr;
+static void (*onConnectedFn)() = nullptr;
+static WiFiManager wm;
+static WiFiCache cache;
+static bool cacheValid = false;
+static NetState state = NET_SCAN;
+static uint32_t stateMs = 0;
+static bool fastConnect = false;
+static uint32_t stageMs[BOOT_STAGES] = {};
+
+static bool loadCache() {
+  File file = bootFs->open(BOOT_WIFI_CACHE_PATH, "r");
+  if (!file) return false;
+  bool ok = file.read((uint8_t*)&cache, sizeof(cache)) == sizeof(cache) &&
+            cache.crc == crc32(&cache, offsetof(WiFiCache, crc)) && cache.ssid[sizeof(cache.ssid) - 1] == '\0';
+  file.close();
+  return ok;
+}
+
+// Solo se reescribe si cambió el AP: no gasta flash en cada arranque.
+static void saveCache() {
+  WiFiCache now = {};
+  strlcpy(now.ssid, WiFi.SSID().c_str(), sizeof(now.ssid));
+  memcpy(now.bssid, WiFi.BSSID(), sizeof(now.bssid));
+  now.channel = WiFi.channel();
+  now.crc = crc32(&now, offsetof(WiFiCache, crc));
+  if (cacheValid && !memcmp(&now, &cache, sizeof(now))) return;
+
+  File file = bootFs->open(BOOT_WIFI_CACHE_PATH, "w");
+  if (!file) return;
+  file.write((const uint8_t*)&now, sizeof(now));
+  file.close();
+  cache = now;
+  cacheValid = true;
+}
+
+// ====== IP FIJA ======
+static bool readAddress(JsonReader& r, IPAddress& out) {
+  char text[16];
+  return r.readString(text, sizeof(text)) && out.fromString(text);
+}
+
+static void applyStaticIp() {
+  File file = bootFs->open(BOOT_NETWORK_PATH, "r");
+  if (!file) return;
+  char text[256];
+  size_t len = file.size() < sizeof(text) ? file.read((uint8_t*)text, sizeof(text) - 1) : 0;
+  file.close();
+  text[len] = '\0';
+
+  IPAddress ip, gateway, subnet(255, 255, 255, 0), dns;
+  bool hasIp = false;
+  JsonReader r(text, len);
+  char key[16];
+  if (!r.beginObject()) return;
+  while (r.nextKey(key, sizeof(key))) {
+    if (!strcmp(key, "ip")) hasIp = readAddress(r, ip);
+    else if (!strcmp(key, "gateway")) readAddress(r, gateway);
+    else if (!strcmp(key, "subnet")) readAddress(r, subnet);
+    else if (!strcmp(key, "dns")) readAddress(r, dns);
+    else r.skipValue();
+  }
+  if (!r.ok() || !hasIp) {
+    Serial.println(F("[WiFi] network.json sin IP válida, se usa DHCP"));
+    return;
+  }
+  if (!(uint32_t)gateway) gateway = IPAddress(ip[0], ip[1], ip[2], 1);
+  if (!(uint32_t)dns) dns = gateway;
+  WiFi.config(ip, gateway, subnet, dns);
+  Serial.printf("[WiFi] IP fija %s\n", ip.toString().c_str());
+}
+
+// ====== CONEXIÓN ======
+static void enter(NetState next) {
+  state = next;
+  stateMs = millis();
+}
+
+static void connected() {
+  fastConnect = state == NET_FAST;
+  enter(NET_UP);
+  bootMark(BOOT_WIFI);
+  Serial.printf("WiFi conectado%s! IP: %s\n", fastConnect ? " (caché)" : "", WiFi.localIP().toString().c_str());
+  saveCache();
+  if (onConnectedFn) onConnectedFn();
+}
+
+void bootBegin(fs::FS& fs, const char* hostname, void (*onConnected)()) {
+  bootFs = &fs;
+  bootHostname = hostname;
+  onConnectedFn = onConnected;
+  WiFi.setHostname(hostname);
+  WiFi.mode(WIFI_STA);
+  applyStaticIp();
+
+  cacheValid = loadCache();
+  if (cacheValid) {
+    Serial.printf("[WiFi] Conectando a %s (canal %u, caché)\n", cache.ssid, (unsigned)cache.channel);
+    WiFi.begin(cache.ssid, WiFi.psk().c_str(), cache.channel, cache.bssid);
+    enter(NET_FAST);
+  } else {
+    Serial.println(F("[WiFi] Conectando con las credenciales guardadas"));
+    WiFi.begin();
+    enter(NET_SCAN);
+  }
+}
+
+void bootLoop() {
+  if (!stageMs[BOOT_TIME] && bootTimeValid()) bootMark(BOOT_TIME);
+
+  switch (state) {
+    case NET_FAST:
+    case NET_SCAN:
+      if (WiFi.status() == WL_CONNECTED) {
+        connected();
+      } else if (state == NET_FAST && millis() - stateMs >= BOOT_FAST_CONNECT_MS) {
+        Serial.println(F("[WiFi] El AP de la caché no responde, escaneando"));
+        WiFi.disconnect();
+        WiFi.begin();
+        enter(NET_SCAN);
+      } else if (state == NET_SCAN && millis() - stateMs >= BOOT_CONNECT_MS) {
+        Serial.printf("[WiFi] Sin conexión, portal de configuración en %s\n", bootHostname);
+        wm.setHostname(bootHostname);
+        wm.setConfigPortalBlocking(false);
+        wm.startConfigPortal(bootHostname);
+        enter(NET_PORTAL);
+      }
+      break;
+    case NET_PORTAL:
+      if (wm.process() || WiFi.status() == WL_CONNECTED) connected();
+      break;
+    case NET_UP:
+      break;
+  }
+}
+
+// ====== TIEMPOS DE ARRANQUE ======
+void bootMark(BootStage stage, uint32_t ms) {
+  if (stageMs[stage]) return;
+  stageMs[stage] = ms ? ms : 1;
+  Serial.printf("[Arranque] %s a los %lu ms\n", bootStageName(stage), (unsigned long)ms);
+}
+
+uint32_t bootStageMs(BootStage stage) { return stageMs[stage]; }
+
+const char* bootStageName(BootStage stage) {
+  static const char* const names[BOOT_STAGES] = {"first_sample", "http_ready", "first_response", "wifi", "time"};
+  return names[stage];
+}
+
+bool bootFastConnect() { return fastConnect; }
+
+// ====== HORA ======
+bool bootTimeValid() { return time(nullptr) >= MIN_VALID_EPOCH; }
+
+uint32_t bootEpoch(uint32_t ms) {
+  time_t now = time(nullptr);
+  if (now < MIN_VALID_EPOCH) return 0;
+  return (uint32_t)now - (millis() - ms) / 1000;
+}
+
+// ====== MUESTRAS SIN HORA ======
+// Anillo pequeño en RAM: si la hora tarda mucho se pierden las más antiguas.
+struct HeldSample {
+  uint32_t ms;
+  float temp;
+  float hum;
+  uint8_t sensor;
+  uint8_t tag;  // HistoryTag
+};
+
+static HeldSample backlog[BOOT_BACKLOG_LEN];
+static uint16_t backlogHead = 0, backlogCount = 0;
+
+void bootHold(uint8_t sensor, float temp, float hum, uint32_t ms, uint8_t tag) {
+  if (backlogCount == BOOT_BACKLOG_LEN) {
+    backlogHead = (backlogHead + 1) % BOOT_BACKLOG_LEN;
+    backlogCount--;
+  }
+  backlog[(backlogHead + backlogCount++) % BOOT_BACKLOG_LEN] = {ms, temp, hum, sensor, tag};
+}
+
+void bootReplay(void (*fn)(uint32_t ts, uint8_t sensor, float temp, float hum, uint8_t tag)) {
+  if (!backlogCount || !bootTimeValid()) return;
+  Serial.printf("[Arranque] %u muestras sin hora pasan al histórico\n", (unsigned)backlogCount);
+  for (; backlogCount; backlogCount--) {
+    const HeldSample& s = backlog[backlogHead];
+    fn(bootEpoch(s.ms), s.sensor, s.temp, s.hum, s.tag);
+    backlogHead = (backlogHead + 1) % BOOT_BACKLOG_LEN;
+  }
+}
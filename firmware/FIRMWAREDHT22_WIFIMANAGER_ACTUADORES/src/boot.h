@@ -0,0 +1,64 @@
+#pragma once
+#include <Arduino.h>
+#include <FS.h>
+
+// ====== ARRANQUE POR ETAPAS ======
+// setup() ya no espera a la red: sensores, histórico, control, uploader y
+// servidor HTTP arrancan primero, y la WiFi avanza desde loop() con
+// bootLoop(), sin bloquear:
+//
+//  1. Con caché (/wifi.bin: SSID, BSSID y canal de la última conexión) se
+//     va directo a ese AP con WiFi.begin(ssid, psk, canal, bssid), sin
+//     escanear todos los canales.
+//  2. Si en BOOT_FAST_CONNECT_MS no conecta (o no hay caché), WiFi.begin()
+//     con las credenciales guardadas, escaneando.
+//  3. Si en BOOT_CONNECT_MS sigue sin red, el portal de WiFiManager en modo
+//     no bloqueante (wm.process() en cada vuelta de loop()).
+//
+// Con /config/network.json se puede fijar la IP y saltarse DHCP:
+//
+//   {"ip": "192.168.1.50", "gateway": "192.168.1.1",
+//    "subnet": "255.255.255.0", "dns": "192.168.1.1"}
+//
+// Al conectar se llama a onConnected (mDNS y configTime(), que no espera a
+// la respuesta del SNTP). Las muestras tomadas antes de tener hora se
+// guardan en RAM con su millis() (bootHold) y se vuelcan al histórico con
+// su epoch en cuanto llega (bootReplay).
+//
+// bootMark() apunta, la primera vez, a cuántos ms del encendido se llegó a
+// cada etapa; salen por Serial y en /api/metrics.
+
+#define BOOT_WIFI_CACHE_PATH "/wifi.bin"
+#define BOOT_NETWORK_PATH "/config/network.json"
+#define BOOT_FAST_CONNECT_MS 3000
+#define BOOT_CONNECT_MS 15000
+#define BOOT_BACKLOG_LEN 96  // muestras sin hora en RAM (~5 min con 3 sensores cada 10 s)
+
+enum BootStage : uint8_t {
+  BOOT_FIRST_SAMPLE,    // primera lectura válida de un sensor
+  BOOT_HTTP_READY,      // server.begin()
+  BOOT_FIRST_RESPONSE,  // primera petición HTTP atendida
+  BOOT_WIFI,            // conectado a la WiFi
+  BOOT_TIME,            // hora NTP válida
+  BOOT_STAGES
+};
+
+void bootBegin(fs::FS& fs, const char* hostname, void (*onConnected)());
+void bootLoop();
+
+void bootMark(BootStage stage, uint32_t ms);
+inline void bootMark(BootStage stage) { bootMark(stage, millis()); }
+// ms desde el encendido hasta la etapa; 0 si aún no se ha llegado.
+uint32_t bootStageMs(BootStage stage);
+const char* bootStageName(BootStage stage);
+// true si la última conexión fue por la caché (sin escanear).
+bool bootFastConnect();
+
+bool bootTimeValid();
+// Epoch de un instante millis() de este arranque; 0 si aún no hay hora.
+uint32_t bootEpoch(uint32_t ms);
+
+void bootHold(uint8_t sensor, float temp, float hum, uint32_t ms, uint8_t tag);
+// Devuelve en orden las muestras retenidas, ya con epoch, y las olvida.
+// No hace nada mientras no haya hora.
+void bootReplay(void (*fn)(uint32_t ts, uint8_t sensor, float temp, float hum, uint8_t tag));
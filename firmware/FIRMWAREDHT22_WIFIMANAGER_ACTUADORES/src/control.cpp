@@ -0,0 +1,299 @@
+#include "control.h"
+#include <time.h>
+#include <algorithm>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include "actuator_journal.h"
+#include "json_reader.h"
+#include "metrics.h"
+#include "sensor_task.h"
+
+struct SchedulePoint {
+  uint16_t minute;  // minuto del día (hora local)
+  float setpoint;
+};
+
+struct ControlConfig {
+  uint8_t sensor = 0;
+  bool humidity = false;
+  ControlMode mode = CONTROL_OFF;
+  bool cooling = false;
+  float setpoint = 21.0f;
+  float hysteresis = 0.5f;
+  float kp = 0.6f, ki = 0.002f, kd = 0.0f;
+  uint32_t windowS = 300;
+  uint32_t minOnS = 60;
+  uint32_t minOffS = 60;
+  uint32_t overrideS = 3600;
+  SchedulePoint schedule[CONTROL_SCHEDULE_MAX];
+  uint8_t scheduleCount = 0;
+};
+
+static ControlConfig config;
+static ControlStatus status = {};
+static uint8_t outputPin = 0;
+static SemaphoreHandle_t outputMutex = nullptr;
+static uint32_t lastChangeMs = 0;
+static uint32_t manualUntilMs = 0;  // 0 con status.manual = sin caducidad
+
+// Estado del PID
+static float integral = 0;
+static float lastInput = NAN;
+static uint32_t windowStartMs = 0;
+
+const char* controlModeName(ControlMode mode) {
+  static const char* const names[] = {"off", "onoff", "pid"};
+  return names[mode];
+}
+
+// ====== CONFIGURACIÓN ======
+static bool parseClock(const char* text, uint16_t& minute) {
+  int h, m;
+  if (sscanf(text, "%d:%d", &h, &m) != 2 || h < 0 || h > 23 || m < 0 || m > 59) return false;
+  minute = h * 60 + m;
+  return true;
+}
+
+static void parseSchedule(JsonReader& r) {
+  if (!r.beginArray()) return;
+  while (r.nextElement()) {
+    SchedulePoint point = {0, config.setpoint};
+    bool hasClock = false;
+    char key[16], text[8];
+    if (!r.beginObject()) return;
+    while (r.nextKey(key, sizeof(key))) {
+      if (!strcmp(key, "at") && r.readString(text, sizeof(text))) hasClock = parseClock(text, point.minute);
+      else if (!strcmp(key, "setpoint")) r.readNumber(point.setpoint);
+      else r.skipValue();
+    }
+    if (hasClock && config.scheduleCount < CONTROL_SCHEDULE_MAX) config.schedule[config.scheduleCount++] = point;
+  }
+  // Ordenado por hora para buscar el tramo actual
+  std::sort(config.schedule, config.schedule + config.scheduleCount,
+            [](const SchedulePoint& a, const SchedulePoint& b) { return a.minute < b.minute; });
+}
+
+static bool parseConfig(const char* text, size_t len) {
+  JsonReader r(text, len);
+  char key[16], value[16];
+  if (!r.beginObject()) return false;
+  while (r.nextKey(key, sizeof(key))) {
+    if (!strcmp(key, "sensor") && r.readString(value, sizeof(value))) {
+      int i = sensorIndex(value);
+      if (i >= 0) config.sensor = i;
+      else Serial.printf("[Control] Sensor desconocido: %s\n", value);
+    } else if (!strcmp(key, "metric") && r.readString(value, sizeof(value))) {
+      config.humidity = !strcmp(value, "hum");
+    } else if (!strcmp(key, "mode") && r.readString(value, sizeof(value))) {
+      config.mode = !strcmp(value, "pid") ? CONTROL_PID : !strcmp(value, "onoff") ? CONTROL_ONOFF : CONTROL_OFF;
+    } else if (!strcmp(key, "action") && r.readString(value, sizeof(value))) {
+      config.cooling = !strcmp(value, "cool");
+    } else if (!strcmp(key, "setpoint")) r.readNumber(config.setpoint);
+    else if (!strcmp(key, "hysteresis")) r.readNumber(config.hysteresis);
+    else if (!strcmp(key, "kp")) r.readNumber(config.kp);
+    else if (!strcmp(key, "ki")) r.readNumber(config.ki);
+    else if (!strcmp(key, "kd")) r.readNumber(config.kd);
+    else if (!strcmp(key, "window")) r.readNumber(config.windowS);
+    else if (!strcmp(key, "minOn")) r.readNumber(config.minOnS);
+    else if (!strcmp(key, "minOff")) r.readNumber(config.minOffS);
+    else if (!strcmp(key, "override")) r.readNumber(config.overrideS);
+    else if (!strcmp(key, "schedule")) parseSchedule(r);
+    else r.skipValue();
+  }
+  return r.ok();
+}
+
+// Consigna del tramo horario actual; el último tramo del día sigue vigente
+// hasta el primero del día siguiente.
+static float currentSetpoint() {
+  time_t now = time(nullptr);
+  if (!config.scheduleCount || now < 1600000000) return config.setpoint;
+  struct tm local;
+  localtime_r(&now, &local);
+  uint16_t minute = local.tm_hour * 60 + local.tm_min;
+  float sp = config.schedule[config.scheduleCount - 1].setpoint;
+  for (uint8_t i = 0; i < config.scheduleCount && config.schedule[i].minute <= minute; i++) {
+    sp = config.schedule[i].setpoint;
+  }
+  return sp;
+}
+
+// ====== SALIDA ======
+// Se llama desde la tarea de control y desde el handler HTTP con outputMutex
+// tomado. Cada cambio queda en el diario (actuator_journal.h), pero eso
+// escribe en flash: se anota con logOutputChange() después de soltar el
+// mutex, para que controlStatus() en loop() no espere a la flash.
+struct OutputChange {
+  bool changed;
+  bool on;
+  JournalSource source;
+  float value;
+};
+
+static OutputChange setOutput(bool on, JournalSource source) {
+  if (on == status.output) return {};
+  digitalWrite(outputPin, on ? HIGH : LOW);
+  status.output = on;
+  status.switches++;
+  lastChangeMs = millis();
+  return {true, on, source, status.input};
+}
+
+static void logOutputChange(const OutputChange& change) {
+  if (!change.changed) return;
+  journalAppend(change.on, change.source, change.value);
+  Serial.printf("Actuador: %s (%s)\n", change.on ? "Encendido" : "Apagado", journalSourceName(change.source));
+}
+
+// Respeta minOn/minOff antes de cambiar en automático.
+static bool canSwitch() {
+  uint32_t heldMs = millis() - lastChangeMs;
+  uint32_t minS = status.output ? config.minOnS : config.minOffS;
+  return status.switches == 0 || heldMs >= minS * 1000UL;
+}
+
+static bool onOffDemand(float input, float sp) {
+  float error = config.cooling ? input - sp : sp - input;
+  if (error > config.hysteresis) return true;
+  if (error < -config.hysteresis) return false;
+  return status.output;  // dentro de la banda: se mantiene
+}
+
+// PID de posición con anti-windup (no integra si la salida está saturada en
+// el mismo sentido) y derivada sobre la medida. dtS: tiempo entre muestras.
+static float pidDuty(float input, float sp, float dtS) {
+  float error = config.cooling ? input - sp : sp - input;
+  float derivative = 0;
+  if (!isnan(lastInput) && dtS > 0) {
+    derivative = (config.cooling ? input - lastInput : lastInput - input) / dtS;
+  }
+  lastInput = input;
+  float rest = config.kp * error + config.kd * derivative;
+  float duty = rest + config.ki * integral;
+  bool saturated = (duty >= 1 && error > 0) || (duty <= 0 && error < 0);
+  if (!saturated) integral += error * dtS;
+  return constrain(rest + config.ki * integral, 0.0f, 1.0f);
+}
+
+static void controlCycle(uint32_t lateUs) {
+  static uint32_t lastSeq = 0;
+  static uint32_t lastSampleMs = 0;
+  SensorSample s = sensorLatest(config.sensor);
+  float input = config.humidity ? s.hum : s.temp;
+  bool fresh = s.status == SENSOR_OK && !isnan(input) && millis() - s.ms < CONTROL_STALE_MS;
+
+  OutputChange change = {};
+  xSemaphoreTake(outputMutex, portMAX_DELAY);
+  status.jitterUs = lateUs;
+  status.jitterMaxUs = max(status.jitterMaxUs, lateUs);
+  status.setpoint = currentSetpoint();
+  status.input = fresh ? input : NAN;
+
+  if (status.manual && manualUntilMs && (int32_t)(millis() - manualUntilMs) >= 0) {
+    status.manual = false;
+    Serial.println(F("Actuador: vuelve a automático"));
+  }
+
+  if (fresh && s.seq != lastSeq) {
+    // Muestra nueva: es lo que marca la latencia del lazo
+    float dtS = lastSampleMs ? (s.ms - lastSampleMs) / 1000.0f : 0;
+    lastSeq = s.seq;
+    lastSampleMs = s.ms;
+    if (config.mode == CONTROL_PID) status.duty = pidDuty(input, status.setpoint, dtS);
+    status.latencyUs = (millis() - s.ms) * 1000UL;
+    status.latencyMaxUs = max(status.latencyMaxUs, status.latencyUs);
+    metrics.controlLatency.record(status.latencyUs);
+  }
+
+  if (!status.manual && config.mode != CONTROL_OFF) {
+    bool demand = false;
+    if (!fresh) {
+      demand = false;  // sin datos: apagado por seguridad
+    } else if (config.mode == CONTROL_ONOFF) {
+      demand = onOffDemand(input, status.setpoint);
+      status.duty = demand ? 1 : 0;
+    } else {
+      // Ventana de tiempo proporcional: encendido duty * window al principio
+      uint32_t windowMs = max<uint32_t>(config.windowS, 1) * 1000UL;
+      if (millis() - windowStartMs >= windowMs) windowStartMs = millis();
+      demand = millis() - windowStartMs < status.duty * windowMs;
+    }
+    if (demand != status.output && (canSwitch() || !fresh)) {
+      change = setOutput(demand, fresh ? JOURNAL_CONTROLLER : JOURNAL_RULE);
+    }
+  }
+  xSemaphoreGive(outputMutex);
+  logOutputChange(change);
+}
+
+static void controlTask(void*) {
+  TickType_t lastWake = xTaskGetTickCount();
+  uint32_t expectedUs = micros();
+  for (;;) {
+    // Cuánto llega tarde respecto al instante ideal
+    // (xTaskDelayUntil va en ticks y puede despertar un poco antes: eso cuenta como 0)
+    uint32_t lateUs = micros() - expectedUs;
+    if ((int32_t)lateUs < 0) lateUs = 0;
+    metrics.controlJitter.record(lateUs);
+    controlCycle(lateUs);
+
+    xTaskDelayUntil(&lastWake, pdMS_TO_TICKS(CONTROL_PERIOD_MS));
+    expectedUs += CONTROL_PERIOD_MS * 1000UL;
+  }
+}
+
+void controlBegin(fs::FS& fs, uint8_t pin) {
+  outputPin = pin;
+  pinMode(outputPin, OUTPUT);
+  digitalWrite(outputPin, LOW);
+
+  File file = fs.open(CONTROL_PATH, "r");
+  if (file && file.size() < 2048) {
+    char text[2048];
+    size_t len = file.read((uint8_t*)text, sizeof(text) - 1);
+    text[len] = '\0';
+    if (!parseConfig(text, len)) {
+      Serial.println(F("[Control] JSON no válido, solo manual"));
+      config = ControlConfig();
+    }
+  }
+  if (file) file.close();
+  status.mode = config.mode;
+  status.input = NAN;
+  Serial.printf("[Control] Modo %s sobre %s, consigna %.1f\n", controlModeName(config.mode),
+                sensorId(config.sensor), currentSetpoint());
+
+  outputMutex = xSemaphoreCreateMutex();
+  xTaskCreatePinnedToCore(controlTask, "control", CONTROL_TASK_STACK, nullptr, CONTROL_TASK_PRIORITY, nullptr, 1);
+}
+
+void controlOverride(bool on, uint32_t seconds) {
+  if (!outputMutex) return;
+  xSemaphoreTake(outputMutex, portMAX_DELAY);
+  if (!seconds) seconds = config.mode == CONTROL_OFF ? 0 : config.overrideS;
+  status.manual = true;
+  manualUntilMs = seconds ? millis() + seconds * 1000UL : 0;
+  OutputChange change = setOutput(on, JOURNAL_API);
+  xSemaphoreGive(outputMutex);
+  logOutputChange(change);
+}
+
+void controlResume() {
+  if (!outputMutex) return;
+  xSemaphoreTake(outputMutex, portMAX_DELAY);
+  status.manual = false;
+  xSemaphoreGive(outputMutex);
+}
+
+ControlStatus controlStatus() {
+  if (!outputMutex) return status;  // antes de controlBegin()
+  xSemaphoreTake(outputMutex, portMAX_DELAY);
+  ControlStatus copy = status;
+  // Vencido pero aún sin quitar (lo quita el próximo controlCycle()): 0, no
+  // la resta sin signo dada la vuelta
+  int32_t leftMs = status.manual && manualUntilMs ? (int32_t)(manualUntilMs - millis()) : 0;
+  copy.manualLeftS = leftMs > 0 ? leftMs / 1000 : 0;
+  xSemaphoreGive(outputMutex);
+  return copy;
+}
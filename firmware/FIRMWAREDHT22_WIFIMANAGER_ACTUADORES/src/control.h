@@ -0,0 +1,62 @@
+#pragma once
+#include <Arduino.h>
+#include <FS.h>
+#include "sensor_task.h"
+
+// ====== CONTROL DEL ACTUADOR ======
+// Termostato en su propia tarea (núcleo 1, prioridad justo por debajo de la
+// de sensores) que despierta cada CONTROL_PERIOD_MS con xTaskDelayUntil(),
+// toma la última muestra del sensor de control (sensorLatest, sin bloquear a
+// la tarea de sensores) y decide la salida. Como el periodo es menor que el
+// de muestreo, cada muestra nueva se aplica como mucho CONTROL_PERIOD_MS
+// después de leerse; esa latencia y el retraso de cada ciclo se miden.
+//
+// Configuración en /config/control.json:
+//
+//   {"sensor": "dht0", "metric": "temp", "mode": "onoff", "action": "heat",
+//    "setpoint": 21, "hysteresis": 0.5, "kp": 0.6, "ki": 0.002, "kd": 0,
+//    "window": 300, "minOn": 60, "minOff": 60, "override": 3600,
+//    "schedule": [{"at": "07:00", "setpoint": 21}, {"at": "23:00", "setpoint": 17}]}
+//
+// mode: "off" (solo manual), "onoff" (con histéresis alrededor de la
+// consigna) o "pid" (ciclo de trabajo 0..1 repartido en una ventana de
+// `window` segundos, para relés). action "heat" enciende por debajo de la
+// consigna y "cool" por encima. La consigna sale de `schedule` según la hora
+// local (NTP); sin hora válida se usa `setpoint`. minOn/minOff protegen el
+// relé en modo automático. Si la muestra tiene más de CONTROL_STALE_MS el
+// actuador se apaga.
+//
+// /api/actuator fuerza la salida durante `override` segundos (0 = hasta
+// volver a automático); el modo "off" no caduca nunca.
+
+#define CONTROL_PATH "/config/control.json"
+#define CONTROL_PERIOD_MS 1000
+#define CONTROL_STALE_MS max<uint32_t>(SENSOR_PERIOD_MS * 4, 12000)
+#define CONTROL_TASK_STACK 4096
+#define CONTROL_TASK_PRIORITY 1
+#define CONTROL_SCHEDULE_MAX 8
+#define CONTROL_OVERRIDE_MAX_MIN 10080  // 7 días; el plazo se compara con millis() en 32 bits
+
+enum ControlMode : uint8_t { CONTROL_OFF, CONTROL_ONOFF, CONTROL_PID };
+
+struct ControlStatus {
+  ControlMode mode;
+  bool output;           // estado actual del actuador
+  bool manual;           // forzado desde /api/actuator
+  uint32_t manualLeftS;  // segundos que le quedan al forzado (0 = sin fin)
+  float setpoint;
+  float input;           // última medida usada (NaN si no hay)
+  float duty;            // pid: 0..1; onoff: 0 o 1
+  uint32_t switches;     // cambios de la salida desde el arranque
+  uint32_t latencyUs;    // de la lectura del sensor a la decisión (última)
+  uint32_t latencyMaxUs;
+  uint32_t jitterUs;     // retraso del último ciclo sobre su instante ideal
+  uint32_t jitterMaxUs;
+};
+
+void controlBegin(fs::FS& fs, uint8_t pin);
+// Fuerza la salida; seconds = 0 usa el "override" de la configuración.
+void controlOverride(bool on, uint32_t seconds = 0);
+void controlResume();
+ControlStatus controlStatus();
+const char* controlModeName(ControlMode mode);
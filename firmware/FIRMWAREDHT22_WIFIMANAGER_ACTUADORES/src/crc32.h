@@ -0,0 +1,17 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// CRC-32 (IEEE 802.3) sin tabla: poco código y suficiente para cabeceras y
+// registros pequeños.
+inline uint32_t crc32Update(uint32_t crc, const void* data, size_t len) {
+  const uint8_t* p = (const uint8_t*)data;
+  crc = ~crc;
+  while (len--) {
+    crc ^= *p++;
+    for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+  }
+  return ~crc;
+}
+
+inline uint32_t crc32(const void* data, size_t len) { return crc32Update(0, data, len); }
@@ -0,0 +1,117 @@
+#include "event_stream.h"
+#include <errno.h>
+#include <sys/socket.h>
+
+struct Subscriber {
+  WiFiClient client;
+  bool active;
+  char buf[STREAM_BUFFER_SIZE];
+  size_t len;
+  unsigned long lastProgressMs;
+};
+
+static Subscriber subs[STREAM_MAX_CLIENTS];
+static unsigned long lastHeartbeatMs = 0;
+static StreamStats stats = {};
+
+static void dropSubscriber(Subscriber& s) {
+  s.client.stop();
+  s.active = false;
+  s.len = 0;
+  stats.closed++;
+}
+
+// Encola un evento completo o nada: nunca se manda medio evento.
+static bool enqueue(Subscriber& s, const char* data, size_t len) {
+  if (s.len + len > sizeof(s.buf)) return false;
+  memcpy(s.buf + s.len, data, len);
+  s.len += len;
+  return true;
+}
+
+static void pump(Subscriber& s) {
+  if (!s.len) {
+    s.lastProgressMs = millis();
+    return;
+  }
+  ssize_t n = send(s.client.fd(), s.buf, s.len, MSG_DONTWAIT);
+  if (n > 0) {
+    memmove(s.buf, s.buf + n, s.len - n);
+    s.len -= n;
+    s.lastProgressMs = millis();
+  } else if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+    dropSubscriber(s);
+  } else if (millis() - s.lastProgressMs > STREAM_STALL_MS) {
+    dropSubscriber(s);
+  }
+}
+
+static size_t formatEvent(char* out, size_t cap, const char* event, const char* json) {
+  int n = snprintf(out, cap, "event: %s\ndata: %s\n\n", event, json);
+  return n < 0 || (size_t)n >= cap ? 0 : n;
+}
+
+bool streamAccept(WiFiClient client, const char* snapshotEvent, const char* snapshotJson) {
+  Subscriber* slot = nullptr;
+  for (auto& s : subs) {
+    if (!s.active) {
+      slot = &s;
+      break;
+    }
+  }
+  if (!slot) {
+    stats.rejected++;
+    client.print("HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+    return false;
+  }
+
+  slot->client = client;
+  slot->active = true;
+  slot->len = 0;
+  slot->lastProgressMs = millis();
+  static const char headers[] =
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Type: text/event-stream\r\n"
+      "Cache-Control: no-cache\r\n"
+      "Connection: keep-alive\r\n"
+      "\r\n"
+      "retry: 3000\n\n";
+  enqueue(*slot, headers, sizeof(headers) - 1);
+  if (snapshotEvent && snapshotJson) {
+    char ev[256];
+    size_t n = formatEvent(ev, sizeof(ev), snapshotEvent, snapshotJson);
+    if (n) enqueue(*slot, ev, n);
+  }
+  stats.accepted++;
+  pump(*slot);
+  return true;
+}
+
+void streamPublish(const char* event, const char* json) {
+  char ev[256];
+  size_t n = formatEvent(ev, sizeof(ev), event, json);
+  if (!n) return;
+  stats.published++;
+  for (auto& s : subs) {
+    if (!s.active) continue;
+    if (!enqueue(s, ev, n)) stats.dropped++;
+    pump(s);
+  }
+}
+
+void streamLoop() {
+  bool heartbeat = millis() - lastHeartbeatMs >= STREAM_HEARTBEAT_MS;
+  if (heartbeat) lastHeartbeatMs = millis();
+  for (auto& s : subs) {
+    if (!s.active) continue;
+    if (heartbeat) enqueue(s, ": ping\n\n", 8);
+    pump(s);
+  }
+}
+
+StreamStats streamStats() {
+  StreamStats s = stats;
+  s.clients = 0;
+  for (auto& sub : subs) s.clients += sub.active ? 1 : 0;
+  return s;
+}
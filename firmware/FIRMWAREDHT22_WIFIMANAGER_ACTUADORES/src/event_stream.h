@@ -0,0 +1,36 @@
+#pragma once
+#include <Arduino.h>
+#include <WiFi.h>
+
+// ====== PUSH EN VIVO (SERVER-SENT EVENTS) ======
+// /api/stream deja la conexión abierta y le va mandando eventos:
+//   event: sample    -> cada lectura del DHT22
+//   event: actuator  -> cada cambio del actuador
+//   ": ping"         -> latido cada STREAM_HEARTBEAT_MS
+// Cada suscriptor tiene un buffer de salida acotado que se vacía desde loop()
+// con send() no bloqueante: un cliente lento pierde eventos (y se cuenta) en
+// lugar de frenar al resto. Si no avanza en STREAM_STALL_MS se le desconecta.
+// El handler de /api/stream se queda el socket con server.detachClient(): el
+// servidor HTTP lo olvida sin cerrarlo y la conexión sigue viva aquí.
+
+#define STREAM_MAX_CLIENTS 4
+#define STREAM_BUFFER_SIZE 1024
+#define STREAM_HEARTBEAT_MS 15000UL
+#define STREAM_STALL_MS 30000UL
+
+struct StreamStats {
+  uint32_t clients;
+  uint32_t accepted;
+  uint32_t rejected;   // sin hueco libre
+  uint32_t published;
+  uint32_t dropped;    // eventos que no cabían en el buffer de algún cliente
+  uint32_t closed;
+};
+
+// Toma el cliente de la petición actual y le manda las cabeceras SSE y el
+// estado inicial (snapshot puede ser nullptr).
+bool streamAccept(WiFiClient client, const char* snapshotEvent, const char* snapshotJson);
+void streamPublish(const char* event, const char* json);
+// Llamar en cada vuelta de loop(): envía lo pendiente y los latidos.
+void streamLoop();
+StreamStats streamStats();
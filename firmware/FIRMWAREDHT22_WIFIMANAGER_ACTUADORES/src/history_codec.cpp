@@ -0,0 +1,182 @@
+#include "history_codec.h"
+
+// Ancho del valor tras cada prefijo 10, 110, 1110 y 1111
+static const uint8_t TS_WIDTHS[4] = {6, 9, 12, 32};
+static const uint8_t VALUE_WIDTHS[4] = {5, 8, 12, 17};
+static const uint8_t SENSOR_BITS = 3;
+static const uint8_t TAG_BITS = 2;
+static const uint8_t NO_SENSOR = 0xFF;  // así "el siguiente" de la primera muestra es el 0
+
+static_assert(HISTORY_CODEC_SENSORS == 1 << SENSOR_BITS, "Índice explícito de 3 bits");
+
+static inline uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+static inline int32_t unzigzag(uint32_t z) { return (int32_t)(z >> 1) ^ -(int32_t)(z & 1); }
+
+// ====== ESCRITURA ======
+void HistoryBlockWriter::begin(uint8_t* buf, size_t cap, uint32_t seq, uint32_t firstTs) {
+  buf_ = buf;
+  capBits_ = cap > sizeof(HistoryBlockHeader) ? (cap - sizeof(HistoryBlockHeader)) * 8 : 0;
+  capBits_ = min<uint32_t>(capBits_, UINT16_MAX);
+  pos_ = 0;
+  overflow_ = false;
+  sensor_ = NO_SENSOR;
+  memset(&header_, 0, sizeof(header_));
+  header_.firstTs = firstTs;
+  header_.seq = seq;
+  header_.version = HISTORY_BLOCK_VERSION;
+  memcpy(buf_, &header_, sizeof(header_));
+  // La primera muestra de cada sensor se predice desde firstTs y cero
+  for (HistoryPredictor& p : last_) p = {firstTs, 0, 0, 0, HISTORY_TAG_RAW};
+}
+
+void HistoryBlockWriter::put(uint32_t value, uint8_t bits) {
+  if (pos_ + bits > capBits_) {
+    overflow_ = true;
+    return;
+  }
+  uint8_t* data = buf_ + sizeof(HistoryBlockHeader);
+  while (bits--) {
+    uint8_t mask = 0x80 >> (pos_ & 7);
+    if (value >> bits & 1) data[pos_ >> 3] |= mask;
+    else data[pos_ >> 3] &= ~mask;
+    pos_++;
+  }
+}
+
+void HistoryBlockWriter::putVar(int32_t value, const uint8_t* widths) {
+  uint32_t z = zigzag(value);
+  if (!z) {
+    put(0, 1);
+    return;
+  }
+  for (uint8_t i = 0; i < 4; i++) {
+    if (i == 3) {
+      put(0xF, 4);
+    } else if (z < (1UL << widths[i])) {
+      put(((1UL << (i + 1)) - 1) << 1, i + 2);
+    } else {
+      continue;
+    }
+    put(z, widths[i]);
+    return;
+  }
+}
+
+bool HistoryBlockWriter::add(const HistoryRecord& r) {
+  if (!buf_ || r.sensor >= HISTORY_CODEC_SENSORS) return false;
+  HistoryPredictor& last = last_[r.sensor];
+  uint32_t start = pos_;
+
+  if (r.sensor == sensor_) put(0, 1);
+  else if (r.sensor == (uint8_t)(sensor_ + 1)) put(0x2, 2);
+  else put(0x3 << SENSOR_BITS | r.sensor, 2 + SENSOR_BITS);
+  if (r.tag == last.tag) put(0, 1);
+  else put(1 << TAG_BITS | (r.tag & 0x3), 1 + TAG_BITS);
+
+  HistoryPredictor next = last;
+  next.ts = r.ts;
+  next.delta = (int32_t)(r.ts - last.ts);
+  int32_t dod = (int32_t)((uint32_t)next.delta - (uint32_t)last.delta);
+  next.temp = r.temp;
+  next.hum = r.hum;
+  next.tag = r.tag & 0x3;
+  putVar(dod, TS_WIDTHS);
+  putVar((int32_t)r.temp - last.temp, VALUE_WIDTHS);
+  putVar((int32_t)r.hum - last.hum, VALUE_WIDTHS);
+
+  if (overflow_) {
+    pos_ = start;
+    overflow_ = false;
+    return false;
+  }
+  last = next;
+  sensor_ = r.sensor;
+  header_.count++;
+  header_.bits = pos_;
+  memcpy(buf_, &header_, sizeof(header_));
+  return true;
+}
+
+// ====== LECTURA ======
+void HistoryBlockReader::reset() {
+  index_ = 0;
+  pos_ = 0;
+}
+
+bool HistoryBlockReader::get(const uint8_t* data, uint32_t limit, uint8_t bits, uint32_t& out) {
+  if (pos_ + bits > limit) return false;
+  out = 0;
+  while (bits--) {
+    out = out << 1 | (data[pos_ >> 3] >> (7 - (pos_ & 7)) & 1);
+    pos_++;
+  }
+  return true;
+}
+
+bool HistoryBlockReader::getVar(const uint8_t* data, uint32_t limit, const uint8_t* widths, int32_t& out) {
+  uint8_t ones = 0;
+  uint32_t bit;
+  while (ones < 4) {
+    if (!get(data, limit, 1, bit)) return false;
+    if (!bit) break;
+    ones++;
+  }
+  if (!ones) {
+    out = 0;
+    return true;
+  }
+  uint32_t z;
+  if (!get(data, limit, widths[ones - 1], z)) return false;
+  out = unzigzag(z);
+  return true;
+}
+
+bool HistoryBlockReader::next(const uint8_t* block, HistoryRecord& out) {
+  HistoryBlockHeader h;
+  memcpy(&h, block, sizeof(h));
+  if (!historyBlockReadable(h) || index_ >= h.count) return false;
+  if (!index_) {
+    pos_ = 0;
+    sensor_ = NO_SENSOR;
+    for (HistoryPredictor& p : last_) p = {h.firstTs, 0, 0, 0, HISTORY_TAG_RAW};
+  }
+  const uint8_t* data = block + sizeof(h);
+
+  uint32_t code;
+  if (!get(data, h.bits, 1, code)) return false;
+  if (!code) {
+    out.sensor = sensor_;
+  } else {
+    if (!get(data, h.bits, 1, code)) return false;
+    if (!code) out.sensor = sensor_ + 1;
+    else if (!get(data, h.bits, SENSOR_BITS, code)) return false;
+    else out.sensor = code;
+  }
+  if (out.sensor >= HISTORY_CODEC_SENSORS) return false;
+
+  HistoryPredictor& last = last_[out.sensor];
+  if (h.version >= 2) {
+    if (!get(data, h.bits, 1, code)) return false;
+    if (code) {
+      if (!get(data, h.bits, TAG_BITS, code)) return false;
+      last.tag = code;
+    }
+  }
+  int32_t dod, dTemp, dHum;
+  if (!getVar(data, h.bits, TS_WIDTHS, dod) || !getVar(data, h.bits, VALUE_WIDTHS, dTemp) ||
+      !getVar(data, h.bits, VALUE_WIDTHS, dHum)) {
+    return false;
+  }
+  last.delta = (int32_t)((uint32_t)last.delta + (uint32_t)dod);
+  last.ts += last.delta;
+  last.temp += dTemp;
+  last.hum += dHum;
+  sensor_ = out.sensor;
+  index_++;
+
+  out.ts = last.ts;
+  out.temp = last.temp;
+  out.hum = last.hum;
+  out.tag = last.tag;
+  return true;
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include <Arduino.h>
+
+// ====== CODIFICACIÓN DEL HISTÓRICO EN BLOQUES ======
+// Compresión al estilo Gorilla: cada muestra se guarda como diferencias con
+// la anterior del mismo sensor, con prefijos de longitud variable:
+//
+//   sensor       0 = el mismo que la muestra anterior, 10 = el siguiente
+//                índice, 11 + 3 bits = índice explícito
+//   tag          0 = la misma etiqueta que la muestra anterior del sensor,
+//                1 + 2 bits = HistoryTag (solo desde la versión 2)
+//   ts           delta-of-delta (zigzag): 0 | 10+6 | 110+9 | 1110+12 | 1111+32
+//   temp, hum    delta en centésimas (zigzag): 0 | 10+5 | 110+8 | 1110+12 | 1111+17
+//
+// Con lecturas cada 10 s y valores que cambian poco una muestra ocupa de 4 a
+// ~20 bits en lugar de 12 bytes. Cada bloque es autónomo (los predictores
+// empiezan de cero en cada uno), así que se puede decodificar sin leer los
+// anteriores. Los bits van en orden MSB primero tras la cabecera; es el mismo
+// formato que sirve /api/history?format=bin y decodifica data/app.js.
+
+#define HISTORY_BLOCK_SIZE 512     // bloque en flash (cabecera incluida)
+#define HISTORY_BLOCK_VERSION 2
+#define HISTORY_BLOCK_VERSION_MIN 1  // v1: sin etiquetas (todo HISTORY_TAG_RAW)
+#define HISTORY_CODEC_SENSORS 8    // el índice explícito usa 3 bits
+#define HISTORY_NO_HUM UINT16_MAX
+
+// Por qué se guardó una muestra (reducer.h). Con cualquier etiqueta salvo
+// RAW el valor se mantuvo dentro de la banda muerta hasta la muestra
+// siguiente del sensor: la serie se reconstruye en escalones, no uniendo
+// puntos.
+enum HistoryTag : uint8_t {
+  HISTORY_TAG_RAW = 0,        // sin reducir (o de antes de reducer.h)
+  HISTORY_TAG_CHANGE = 1,     // salió de la banda muerta
+  HISTORY_TAG_HEARTBEAT = 2,  // sin cambios, latido
+  HISTORY_TAG_FAST = 3        // cambio rápido: ritmo de registro subido
+};
+
+inline const char* historyTagName(uint8_t tag) {
+  static const char* const names[] = {"raw", "change", "heartbeat", "fast"};
+  return names[tag & 0x3];
+}
+
+// Muestra decodificada. Temperatura y humedad en centésimas.
+struct HistoryRecord {
+  uint32_t ts;      // epoch en segundos
+  int16_t temp;     // °C * 100
+  uint16_t hum;     // % * 100 (HISTORY_NO_HUM si el sensor no la mide)
+  uint8_t sensor;   // índice en SENSOR_TABLE
+  uint8_t tag;      // HistoryTag
+};
+
+inline float historyTemp(const HistoryRecord& r) { return r.temp / 100.0f; }
+inline float historyHum(const HistoryRecord& r) { return r.hum / 100.0f; }
+
+// Cabecera de 16 bytes, little-endian. firstTs va primero para que
+// RingStore::lowerBound busque bloques por tiempo.
+struct HistoryBlockHeader {
+  uint32_t firstTs;  // base de los ts del bloque (ts de su primera muestra)
+  uint32_t seq;      // posición en el anillo; identifica el bloque abierto
+  uint16_t count;    // muestras
+  uint16_t bits;     // bits ocupados tras la cabecera
+  uint8_t version;
+  uint8_t reserved[3];
+};
+
+static_assert(sizeof(HistoryBlockHeader) == 16, "Cabecera de 16 bytes");
+
+// Bytes que ocupa un bloque sin el relleno final.
+inline size_t historyBlockLength(const HistoryBlockHeader& h) {
+  return sizeof(HistoryBlockHeader) + (h.bits + 7) / 8;
+}
+
+inline bool historyBlockReadable(const HistoryBlockHeader& h) {
+  return h.version >= HISTORY_BLOCK_VERSION_MIN && h.version <= HISTORY_BLOCK_VERSION;
+}
+
+// Última muestra de cada sensor dentro del bloque.
+struct HistoryPredictor {
+  uint32_t ts;
+  int32_t delta;
+  int16_t temp;
+  uint16_t hum;
+  uint8_t tag;
+};
+
+class HistoryBlockWriter {
+ public:
+  // Empieza un bloque vacío en buf (cap bytes, cabecera incluida).
+  void begin(uint8_t* buf, size_t cap, uint32_t seq, uint32_t firstTs);
+  // false si la muestra ya no cabe; el bloque queda como estaba.
+  bool add(const HistoryRecord& r);
+
+  const HistoryBlockHeader& header() const { return header_; }
+  size_t length() const { return historyBlockLength(header_); }
+
+ private:
+  void put(uint32_t value, uint8_t bits);
+  void putVar(int32_t value, const uint8_t* widths);
+
+  uint8_t* buf_ = nullptr;
+  HistoryBlockHeader header_ = {};
+  uint32_t capBits_ = 0;
+  uint32_t pos_ = 0;
+  bool overflow_ = false;
+  uint8_t sensor_ = 0;
+  HistoryPredictor last_[HISTORY_CODEC_SENSORS];
+};
+
+// Lector incremental: guarda solo la posición y los predictores, no el
+// bloque, así que se puede dejar a medias y seguir más tarde con los mismos
+// bytes (p. ej. entre dos trozos de una respuesta HTTP).
+class HistoryBlockReader {
+ public:
+  void reset();
+  // Siguiente muestra del bloque; false al acabar o si está corrupto.
+  bool next(const uint8_t* block, HistoryRecord& out);
+  uint16_t index() const { return index_; }
+
+ private:
+  bool get(const uint8_t* data, uint32_t limit, uint8_t bits, uint32_t& out);
+  bool getVar(const uint8_t* data, uint32_t limit, const uint8_t* widths, int32_t& out);
+
+  uint16_t index_ = 0;
+  uint16_t pos_ = 0;
+  uint8_t sensor_ = 0;
+  HistoryPredictor last_[HISTORY_CODEC_SENSORS];
+};
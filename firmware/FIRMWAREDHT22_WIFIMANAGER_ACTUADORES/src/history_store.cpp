@@ -0,0 +1,425 @@
+#include "history_store.h"
+#include "rollup.h"
+#include "sensors.h"
+#include "crc32.h"
+#include <stddef.h>
+
+RingStore history(HISTORY_PATH, HISTORY_BLOCK_SIZE, HISTORY_BLOCKS);
+// Bloque abierto (hueco tail() del anillo) y su codificador
+static uint8_t openBlock[HISTORY_BLOCK_SIZE];
+static HistoryBlockWriter writer;
+static size_t savedLength = 0;  // bytes del bloque abierto ya escritos en flash
+// Último bloque cerrado leído, para no releerlo en cada historyNext()
+static uint8_t readCache[HISTORY_BLOCK_SIZE];
+static uint32_t cachedBlock = UINT32_MAX;
+static uint32_t lastTs = 0;
+static uint32_t samples = 0;
+
+// ====== ESCRITURA DIFERIDA ======
+// Copia de las muestras del bloque abierto que aún no están en flash. Vive en
+// memoria RTC sin inicializar, que se conserva en un reinicio por software,
+// WDT o brownout (no en un corte de corriente). Cada entrada lleva su
+// posición en el bloque como número de secuencia y un CRC propio.
+struct PendingRecord {
+  uint32_t block;  // hueco del anillo (tail()) del bloque abierto
+  uint16_t index;  // posición en el bloque
+  uint16_t reserved;
+  uint32_t ts;
+  int16_t temp;
+  uint16_t hum;
+  uint8_t sensor;
+  uint8_t tag;
+  uint16_t reserved2;
+  uint32_t crc;    // de todo lo anterior
+};
+
+struct PendingLog {
+  uint32_t magic;
+  uint32_t count;
+  PendingRecord records[HISTORY_PENDING_MAX];
+};
+
+static const uint32_t PENDING_MAGIC = 0x444E4550;  // "PEND"
+RTC_NOINIT_ATTR static PendingLog pending;
+static uint32_t pendingSinceMs = 0;
+static HistoryWriteStats writeStats = {};
+
+static int16_t quantizeTemp(float temp) {
+  return (int16_t)constrain(lroundf(temp * 100.0f), -32768L, 32767L);
+}
+
+static uint16_t quantizeHum(float hum) {
+  if (isnan(hum)) return HISTORY_NO_HUM;
+  return (uint16_t)constrain(lroundf(hum * 100.0f), 0L, 65534L);
+}
+
+static uint16_t blockCount(uint32_t seq) {
+  HistoryBlockHeader h;
+  if (!history.readBlock(seq, readCache, 1)) return 0;
+  cachedBlock = seq;
+  memcpy(&h, readCache, sizeof(h));
+  return historyBlockReadable(h) ? h.count : 0;
+}
+
+// Escribe en el hueco del bloque abierto lo que ha cambiado desde la última
+// vez: primero los bits nuevos y luego la cabecera, para que un corte a
+// medias deje la cabecera anterior, que sigue siendo válida.
+static bool saveOpenBlock() {
+  size_t length = writer.length();
+  size_t from = savedLength > sizeof(HistoryBlockHeader) ? savedLength - 1 : sizeof(HistoryBlockHeader);
+  bool ok = length <= from || history.writeTail(from, openBlock + from, length - from);
+  ok = history.writeTail(0, openBlock, sizeof(HistoryBlockHeader)) && ok;
+  ok = history.syncTail() && ok;
+  if (ok) savedLength = length;
+  return ok;
+}
+
+// Vuelca al flash lo pendiente del bloque abierto de una vez.
+static bool commitPending() {
+  if (!saveOpenBlock()) return false;
+  if (pending.count) writeStats.commits++;
+  pending.count = 0;
+  return true;
+}
+
+static void holdPending(const HistoryRecord& r) {
+  if (!pending.count) pendingSinceMs = millis();
+  // Si el flash falla y se llena, lo demás sigue solo en el bloque en RAM
+  if (pending.count >= HISTORY_PENDING_MAX) return;
+  PendingRecord& p = pending.records[pending.count];
+  memset(&p, 0, sizeof(p));
+  p.block = history.tail();
+  p.index = writer.header().count - 1;
+  p.ts = r.ts;
+  p.temp = r.temp;
+  p.hum = r.hum;
+  p.sensor = r.sensor;
+  p.tag = r.tag;
+  p.crc = crc32(&p, offsetof(PendingRecord, crc));
+  pending.count++;
+}
+
+// Tras un reinicio, añade al bloque abierto lo que quedó en RTC sin llegar
+// al flash. Se salta lo que ya estaba y se para en la primera entrada con el
+// CRC mal o fuera de secuencia: todo lo anterior es válido y va seguido.
+static uint32_t replayPending() {
+  uint32_t replayed = 0;
+  uint32_t count = pending.magic == PENDING_MAGIC ? min<uint32_t>(pending.count, HISTORY_PENDING_MAX) : 0;
+  for (uint32_t i = 0; i < count; i++) {
+    const PendingRecord& p = pending.records[i];
+    if (p.crc != crc32(&p, offsetof(PendingRecord, crc)) || p.block != history.tail()) break;
+    if (p.index < writer.header().count) continue;
+    if (p.index != writer.header().count) break;
+    HistoryRecord r = {p.ts, p.temp, p.hum, p.sensor, p.tag};
+    if (!writer.header().count) writer.begin(openBlock, sizeof(openBlock), history.tail(), r.ts);
+    if (!writer.add(r)) break;
+    replayed++;
+  }
+  pending.magic = PENDING_MAGIC;
+  pending.count = 0;
+  if (replayed) saveOpenBlock();
+  return replayed;
+}
+
+// Cierra el bloque abierto y empieza otro en el siguiente hueco. El anillo
+// deja siempre libre el hueco de tail(): si está lleno se descarta el bloque
+// más antiguo antes de empezar a escribir encima. El bloque va entero, así
+// que lo pendiente queda confirmado.
+static bool closeOpenBlock(uint32_t firstTs) {
+  if (!history.append(openBlock)) return false;
+  if (pending.count) writeStats.commits++;
+  pending.count = 0;
+  if (history.size() >= history.capacity()) {
+    samples -= min<uint32_t>(samples, blockCount(history.head()));
+    history.consume(1);
+  }
+  writer.begin(openBlock, sizeof(openBlock), history.tail(), firstTs);
+  savedLength = 0;
+  return true;
+}
+
+// Añade al bloque abierto sin tocar los agregados. Con sync llega al flash
+// en el siguiente grupo (HISTORY_COMMIT_RECORDS o HISTORY_COMMIT_MS).
+static bool appendRecord(const HistoryRecord& r, bool sync) {
+  if (!history.ready()) return false;
+  if (!writer.header().count) writer.begin(openBlock, sizeof(openBlock), history.tail(), r.ts);
+  if (!writer.add(r)) {
+    if (!closeOpenBlock(r.ts) || !writer.add(r)) return false;
+  }
+  samples++;
+  lastTs = r.ts;
+  if (!sync) return true;
+  holdPending(r);
+  return pending.count < HISTORY_COMMIT_RECORDS || commitPending();
+}
+
+bool historySync() {
+  savedLength = 0;
+  return commitPending();
+}
+
+void historyLoop() {
+  if (pending.count && millis() - pendingSinceMs >= HISTORY_COMMIT_MS) commitPending();
+}
+
+HistoryWriteStats historyWriteStats() {
+  HistoryWriteStats s = writeStats;
+  s.pending = pending.count;
+  s.flashWrites = history.writes();
+  s.flashPrograms = history.programs();
+  return s;
+}
+
+// Pasa un anillo de registros sin comprimir de versiones anteriores al
+// formato actual. Los agregados ya los contienen, así que no se vuelven a
+// sumar. Los de 8 bytes (de antes de tener varios sensores) son del primero.
+template <typename Record>
+static void migrateRaw(const char* path, uint32_t capacity) {
+  fs::FS& fs = storageFs();
+  if (!fs.exists(path)) return;
+  uint32_t migrated = 0;
+  {
+    RingFile raw(fs, path, sizeof(Record), capacity);
+    if (raw.begin()) {
+      for (uint32_t seq = raw.head(); seq != raw.tail(); seq++) {
+        Record old;
+        if (!raw.read(seq, &old)) continue;
+        HistoryRecord r = {old.ts, old.temp, old.hum, old.sensor(), HISTORY_TAG_RAW};
+        if (r.ts >= lastTs && appendRecord(r, false)) migrated++;
+      }
+      historySync();
+    }
+  }
+  fs.remove(path);
+  Serial.printf("[Historial] Migradas %u muestras de %s\n", (unsigned)migrated, path);
+}
+
+struct LegacyRecord {
+  uint32_t ts;
+  int16_t temp;
+  uint16_t hum;
+  uint8_t sensor() const { return 0; }
+};
+
+struct RawRecord {
+  uint32_t ts;
+  int16_t temp;
+  uint16_t hum;
+  uint8_t sensorIndex;
+  uint8_t reserved[3];
+  uint8_t sensor() const { return sensorIndex; }
+};
+
+// Recupera el bloque abierto de su hueco si es el de este tail(); si no
+// (anillo recién creado o corte antes de su primera muestra) empieza vacío.
+// Uno de una versión anterior se recodifica y se reescribe entero.
+static void recoverOpenBlock() {
+  writer.begin(openBlock, sizeof(openBlock), history.tail(), 0);
+  static uint8_t stored[HISTORY_BLOCK_SIZE];
+  HistoryBlockHeader h;
+  if (!history.readTail(stored)) return;
+  memcpy(&h, stored, sizeof(h));
+  if (!historyBlockReadable(h) || h.seq != history.tail() || !h.count) return;
+  writer.begin(openBlock, sizeof(openBlock), h.seq, h.firstTs);
+  HistoryBlockReader reader;
+  reader.reset();
+  HistoryRecord r;
+  while (reader.next(stored, r) && writer.add(r)) {}
+  savedLength = writer.length();
+  if (h.version != HISTORY_BLOCK_VERSION) {
+    savedLength = 0;
+    saveOpenBlock();
+  }
+}
+
+bool historyBegin() {
+  if (!history.begin()) {
+    Serial.println(F("[Historial] No se pudo abrir " HISTORY_PATH));
+    return false;
+  }
+  if (history.size() >= history.capacity()) history.consume(1);
+  recoverOpenBlock();
+  writeStats.recovered = replayPending();
+  if (writeStats.recovered) {
+    Serial.printf("[Historial] %u muestras recuperadas de la memoria RTC\n", (unsigned)writeStats.recovered);
+  }
+
+  samples = writer.header().count;
+  for (uint32_t seq = history.head(); seq != history.tail(); seq++) samples += blockCount(seq);
+  HistoryCursor cursor = {history.tail() - (writer.header().count || !history.size() ? 0 : 1), {}};
+  cursor.reader.reset();
+  HistoryRecord r;
+  while (historyNext(cursor, r)) lastTs = r.ts;
+
+  migrateRaw<LegacyRecord>(HISTORY_LEGACY_PATH, 17280);
+  migrateRaw<RawRecord>(HISTORY_RAW_PATH, 17280);
+  if (!rollupBegin()) Serial.println(F("[Historial] No se pudieron abrir los agregados"));
+  Serial.printf("[Historial] %u muestras en %u bloques (capacidad %u bloques)\n", (unsigned)samples,
+                (unsigned)history.size() + 1, (unsigned)history.capacity());
+  return true;
+}
+
+bool historyAppend(time_t ts, uint8_t sensor, float temp, float hum, uint8_t tag, bool sync) {
+  // Si NTP atrasa el reloj se repite el último ts: el anillo sigue ordenado.
+  HistoryRecord r = {};
+  r.ts = max((uint32_t)ts, lastTs);
+  r.sensor = sensor;
+  r.temp = quantizeTemp(temp);
+  r.hum = quantizeHum(hum);
+  r.tag = tag;
+  rollupAdd(r.ts, r.sensor, r.temp, r.hum);
+  return appendRecord(r, sync);
+}
+
+void historyObserve(time_t ts, uint8_t sensor, float temp, float hum) {
+  rollupAdd(max((uint32_t)ts, lastTs), sensor, quantizeTemp(temp), quantizeHum(hum));
+}
+
+uint32_t historySamples() { return samples; }
+uint32_t historyLastTs() { return lastTs; }
+
+static const uint8_t* blockData(uint32_t seq) {
+  if (seq == history.tail()) return openBlock;
+  if (seq != cachedBlock) {
+    if (!history.readBlock(seq, readCache, 1)) return nullptr;
+    cachedBlock = seq;
+  }
+  return readCache;
+}
+
+bool historyNext(HistoryCursor& cursor, HistoryRecord& out) {
+  if (!history.ready()) return false;
+  for (;;) {
+    if (cursor.block - history.head() > history.size()) {
+      cursor.block = history.head();
+      cursor.reader.reset();
+    }
+    const uint8_t* data = blockData(cursor.block);
+    if (data && cursor.reader.next(data, out)) return true;
+    if (cursor.block == history.tail()) return false;
+    cursor.block++;
+    cursor.reader.reset();
+  }
+}
+
+HistoryCursor historySeek(uint32_t t) {
+  // El bloque anterior al primero que empieza en t puede tener muestras >= t
+  uint32_t block = history.ready() ? history.lowerBound(t) : 0;
+  if (block != history.head()) block--;
+  HistoryCursor cursor = {block, {}};
+  cursor.reader.reset();
+  HistoryRecord r;
+  for (;;) {
+    HistoryCursor before = cursor;
+    if (!historyNext(cursor, r) || r.ts >= t) return before;
+  }
+}
+
+static void resetBucket(HistoryBucket& b, uint32_t ts) {
+  b.ts = ts;
+  b.count = 0;
+  b.tMin = INT16_MAX;
+  b.tMax = INT16_MIN;
+  b.hMin = UINT16_MAX;
+  b.hMax = 0;
+  b.tSum = 0;
+  b.hSum = 0;
+}
+
+static void addToBucket(HistoryBucket& b, const Rollup& r) {
+  b.count += r.count;
+  b.tMin = min(b.tMin, r.tMin);
+  b.tMax = max(b.tMax, r.tMax);
+  b.hMin = min(b.hMin, r.hMin);
+  b.hMax = max(b.hMax, r.hMax);
+  b.tSum += (int64_t)r.tAvg * r.count;
+  b.hSum += (int64_t)r.hAvg * r.count;
+}
+
+uint32_t historyAggregate(uint8_t sensor, uint32_t from, uint32_t to, uint16_t buckets,
+                          const std::function<void(const HistoryBucket&)>& emit,
+                          const char** source) {
+  if (to < from || !buckets) return 0;
+  buckets = min<uint16_t>(buckets, HISTORY_MAX_BUCKETS);
+  uint32_t step = ((uint64_t)to - from) / buckets + 1;
+
+  HistoryBucket b;
+  resetBucket(b, from);
+  auto add = [&](const Rollup& r) {
+    uint32_t start = from + (r.ts - from) / step * step;
+    if (start != b.ts) {
+      if (b.count) emit(b);
+      resetBucket(b, start);
+    }
+    addToBucket(b, r);
+  };
+
+  int tier = TIER_COUNT - 1;
+  while (tier >= 0 && step < rollupTiers[tier].seconds) tier--;
+  if (source) *source = tier < 0 ? "raw" : rollupTiers[tier].name;
+
+  if (tier < 0) {
+    // Una muestra reducida (reducer.h) vale hasta la siguiente del sensor: los
+    // buckets vacíos anteriores a `until` llevan su valor, como una muestra.
+    HistoryRecord prev = {};
+    auto hold = [&](uint32_t until) {
+      if (!prev.ts || prev.tag == HISTORY_TAG_RAW) return;
+      until = min<uint64_t>(until, (uint64_t)prev.ts + HISTORY_HOLD_MAX_S);
+      for (uint64_t start = (uint64_t)b.ts + step; start < until; start += step) {
+        Rollup r = {(uint32_t)start, 1, sensor, prev.temp, prev.temp, prev.temp, prev.hum, prev.hum, prev.hum, 0};
+        add(r);
+      }
+    };
+    HistoryCursor cursor = historySeek(from);
+    HistoryRecord h;
+    while (historyNext(cursor, h) && h.ts <= to) {
+      if (h.sensor != sensor) continue;
+      hold(from + (h.ts - from) / step * step);
+      Rollup r = {h.ts, 1, sensor, h.temp, h.temp, h.temp, h.hum, h.hum, h.hum, 0};
+      add(r);
+      prev = h;
+    }
+    hold(min(to, lastTs) + 1);
+  } else {
+    RingStore& ring = rollupRing((RollupTier)tier);
+    static Rollup block[32];
+    uint32_t seq = ring.lowerBound(from), end = ring.lowerBound(to + 1);
+    while (seq != end) {
+      uint32_t n = ring.readBlock(seq, block, min<uint32_t>(32, end - seq));
+      if (!n) break;
+      seq += n;
+      for (uint32_t i = 0; i < n; i++) {
+        if (block[i].sensor == sensor) add(block[i]);
+      }
+    }
+    Rollup current = rollupOpen((RollupTier)tier, sensor);
+    if (current.count && current.ts >= from && current.ts <= to) add(current);
+  }
+  if (b.count) emit(b);
+  return step;
+}
+
+uint32_t historyImportCsv(const char* path) {
+  fs::FS& fs = storageFs();
+  if (!fs.exists(path)) return 0;
+  File file = fs.open(path, "r");
+  if (!file) return 0;
+
+  uint32_t imported = 0;
+  char line[64];
+  while (file.available()) {
+    size_t n = file.readBytesUntil('\n', line, sizeof(line) - 1);
+    line[n] = '\0';
+    unsigned long ts;
+    float temp, hum;
+    char id[16] = "";
+    int fields = sscanf(line, "%lu,%f,%f,%15s", &ts, &temp, &hum, id);
+    int sensor = fields == 4 ? sensorIndex(id) : 0;
+    if (fields >= 3 && sensor >= 0 && historyAppend(ts, sensor, temp, hum, HISTORY_TAG_RAW, false)) imported++;
+  }
+  file.close();
+  historySync();
+  fs.remove(path);
+  Serial.printf("[Historial] Importadas %u muestras de %s\n", (unsigned)imported, path);
+  return imported;
+}
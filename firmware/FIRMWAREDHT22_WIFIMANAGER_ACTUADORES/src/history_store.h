@@ -0,0 +1,93 @@
+#pragma once
+#include <Arduino.h>
+#include <functional>
+#include "storage.h"
+#include "history_codec.h"
+
+// ====== HISTÓRICO COMPRIMIDO EN ANILLO ======
+// Sustituye al /data.csv que crecía sin límite. Las muestras se comprimen en
+// bloques de HISTORY_BLOCK_SIZE bytes (history_codec.h) guardados en un
+// anillo preasignado (RingStore, storage.h): el uso de flash es fijo y, al
+// llenarse, se descarta el bloque más antiguo. El bloque que se está llenando vive en RAM y se
+// escribe en su hueco del anillo en cada muestra (solo los bytes nuevos y la
+// cabecera), así que sobrevive a un reinicio. Todos los sensores comparten el
+// anillo; lo anterior queda en los agregados de rollup.h.
+//
+// El bloque abierto no se escribe en cada muestra: las nuevas esperan en RAM
+// (y en una copia en memoria RTC, con número de secuencia y CRC por muestra)
+// y van al flash en grupo cada HISTORY_COMMIT_RECORDS muestras o
+// HISTORY_COMMIT_MS, lo que llegue antes: primero los bits nuevos y después
+// la cabecera, que hace de confirmación. Tras un reinicio por software o
+// brownout se recuperan de la RTC hasta la última entrada válida; con un
+// corte de corriente se pierde como mucho el grupo pendiente.
+
+#define HISTORY_PATH "/history3.bin"
+#define HISTORY_RAW_PATH "/history2.bin"    // registros de 12 bytes sin comprimir
+#define HISTORY_LEGACY_PATH "/history.bin"  // registros de 8 bytes, un solo sensor
+#define HISTORY_BLOCKS 400  // ~205 KB, lo mismo que ocupaban 17280 muestras sin comprimir
+#define HISTORY_MAX_BUCKETS 500
+#define HISTORY_MIN_EPOCH 1600000000  // antes de esto no hay hora NTP
+#define HISTORY_HOLD_MAX_S 3600  // una muestra reducida no se mantiene más de esto
+#define HISTORY_COMMIT_RECORDS 16
+#define HISTORY_COMMIT_MS 300000UL  // 5 min
+#define HISTORY_PENDING_MAX 32      // copia en RTC: 1 KB
+
+// Agregado de un intervalo [ts, ts + step) para consultas reducidas.
+struct HistoryBucket {
+  uint32_t ts;
+  uint32_t count;
+  int16_t tMin, tMax;
+  uint16_t hMin, hMax;
+  int64_t tSum;
+  int64_t hSum;
+};
+
+struct HistoryWriteStats {
+  uint32_t pending;        // muestras aún sin confirmar en flash
+  uint32_t commits;        // grupos confirmados desde el arranque
+  uint32_t recovered;      // muestras recuperadas de la RTC al arrancar
+  uint32_t flashWrites;    // escrituras en el anillo desde el arranque
+  uint32_t flashPrograms;  // páginas de flash escritas (RingStore::programs)
+};
+
+// Posición de lectura: bloque del anillo (tail() es el bloque abierto en
+// RAM) y estado del decodificador dentro de él.
+struct HistoryCursor {
+  uint32_t block;
+  HistoryBlockReader reader;
+};
+
+extern RingStore history;
+
+bool historyBegin();
+bool historyAppend(time_t ts, uint8_t sensor, float temp, float hum, uint8_t tag = HISTORY_TAG_RAW,
+                   bool sync = true);
+// Solo los agregados: para las muestras que reducer.h no deja en el crudo,
+// así minuto/hora/día siguen teniendo todas las lecturas.
+void historyObserve(time_t ts, uint8_t sensor, float temp, float hum);
+// Guarda el bloque abierto entero (tras historyAppend con sync=false) y
+// confirma lo pendiente.
+bool historySync();
+// En cada vuelta de loop(): confirma el grupo pendiente si ya toca por tiempo.
+void historyLoop();
+HistoryWriteStats historyWriteStats();
+uint32_t historySamples();
+uint32_t historyLastTs();
+// Cursor en la primera muestra con ts >= t. Las muestras están en orden de
+// tiempo porque solo se guardan con la hora NTP ya sincronizada, así que se
+// busca el bloque por búsqueda binaria y se decodifica solo ese.
+HistoryCursor historySeek(uint32_t t);
+// Siguiente muestra; false al llegar a la última guardada. Un cursor que se
+// queda atrás porque el anillo pisó su bloque salta al más antiguo.
+bool historyNext(HistoryCursor& cursor, HistoryRecord& out);
+// Recorre [from, to] del sensor y entrega como mucho `buckets` agregados no vacíos, en
+// orden. Lee del nivel de rollup más grueso que no supere el ancho de bucket
+// (o del crudo si es menor de un minuto) y deja su nombre en *source. En el
+// crudo, el valor de una muestra reducida rellena los buckets hasta la
+// siguiente (como mucho HISTORY_HOLD_MAX_S).
+// Devuelve el ancho de cada bucket en segundos.
+uint32_t historyAggregate(uint8_t sensor, uint32_t from, uint32_t to, uint16_t buckets,
+                          const std::function<void(const HistoryBucket&)>& emit,
+                          const char** source = nullptr);
+// Importa un /data.csv antiguo (ts,temp,hum[,sensor] por línea) y lo borra.
+uint32_t historyImportCsv(const char* path);
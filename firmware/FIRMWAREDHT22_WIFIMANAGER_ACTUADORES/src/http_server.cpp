@@ -0,0 +1,506 @@
+#include "http_server.h"
+#include <errno.h>
+#include <strings.h>
+#include <sys/socket.h>
+
+static HttpServerStats stats = {};
+
+static const char* statusText(int code) {
+  switch (code) {
+    case 200: return "OK";
+    case 204: return "No Content";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 406: return "Not Acceptable";
+    case 413: return "Payload Too Large";
+    case 500: return "Internal Server Error";
+    case 503: return "Service Unavailable";
+    default: return "";
+  }
+}
+
+static int hexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+static String urlDecode(const char* in, size_t len) {
+  String out;
+  out.reserve(len);
+  for (size_t i = 0; i < len; i++) {
+    char c = in[i];
+    if (c == '+') {
+      c = ' ';
+    } else if (c == '%' && i + 2 < len && hexValue(in[i + 1]) >= 0 && hexValue(in[i + 2]) >= 0) {
+      c = (char)(hexValue(in[i + 1]) * 16 + hexValue(in[i + 2]));
+      i += 2;
+    }
+    out += c;
+  }
+  return out;
+}
+
+// Busca `needle` en [p, p + len) sin depender de un '\0'.
+static const char* findSeq(const char* p, size_t len, const char* needle) {
+  size_t n = strlen(needle);
+  for (size_t i = 0; i + n <= len; i++) {
+    if (!memcmp(p + i, needle, n)) return p + i;
+  }
+  return nullptr;
+}
+
+// Valor de la cabecera `name` en [p, p + len), sin distinguir mayúsculas en
+// el nombre (HTTP no las distingue). Apunta justo detrás de los dos puntos.
+static const char* findHeader(const char* p, size_t len, const char* name) {
+  size_t n = strlen(name);
+  const char* end = p + len;
+  for (const char* eol = findSeq(p, len, "\r\n"); eol; eol = findSeq(eol + 2, end - eol - 2, "\r\n")) {
+    const char* line = eol + 2;
+    if ((size_t)(end - line) > n && !strncasecmp(line, name, n) && line[n] == ':') return line + n + 1;
+  }
+  return nullptr;
+}
+
+// Content-Length estricto: solo dígitos (y espacios alrededor) hasta el fin
+// de línea. strtoul() aceptaría "-1" y lo convertiría en un tamaño enorme.
+static bool parseContentLength(const char* v, size_t& out) {
+  while (*v == ' ' || *v == '\t') v++;
+  if (*v < '0' || *v > '9') return false;
+  char* end;
+  errno = 0;
+  unsigned long n = strtoul(v, &end, 10);
+  if (errno) return false;
+  while (*end == ' ' || *end == '\t') end++;
+  if (*end != '\r') return false;
+  out = n;
+  return true;
+}
+
+void HttpServer::begin() {
+  server_.begin();
+  server_.setNoDelay(true);
+}
+
+void HttpServer::collectHeaders(const char* headerKeys[], size_t count) {
+  for (size_t i = 0; i < count; i++) collect_.push_back(headerKeys[i]);
+}
+
+// ====== BUCLE ======
+void HttpServer::handleClient() {
+  accept();
+  for (Connection& c : conns_) {
+    if (c.state == CONN_READING) readRequest(c);
+    if (c.state == CONN_WRITING && pump(c)) finishResponse(c);
+  }
+}
+
+// Si no queda hueco se cierra la conexión keep-alive que lleve más tiempo
+// ociosa (al menos HTTP_IDLE_EVICT_MS, para no cruzarse con una petición que
+// ya viene de camino); si no hay ninguna, el cliente espera en el backlog.
+void HttpServer::accept() {
+  while (server_.hasClient()) {
+    Connection* slot = nullptr;
+    Connection* idle = nullptr;
+    for (Connection& c : conns_) {
+      if (c.state == CONN_FREE) {
+        slot = &c;
+        break;
+      }
+      bool idleKeepAlive = c.state == CONN_READING && c.requests && !c.reqLen &&
+                           millis() - c.lastActivityMs >= HTTP_IDLE_EVICT_MS;
+      if (idleKeepAlive && (!idle || c.lastActivityMs < idle->lastActivityMs)) idle = &c;
+    }
+    if (!slot && idle) {
+      close(*idle);
+      slot = idle;
+    }
+    if (!slot) return;
+    slot->client = server_.available();
+    if (!slot->client) return;
+    slot->state = CONN_READING;
+    stats.active++;
+    slot->reqLen = 0;
+    slot->requests = 0;
+    slot->lastActivityMs = millis();
+    stats.accepted++;
+  }
+}
+
+void HttpServer::close(Connection& c) {
+  stats.active--;
+  c.client.stop();
+  c.state = CONN_FREE;
+  c.producer = nullptr;
+  std::vector<char>().swap(c.out);
+  c.outPos = 0;
+}
+
+void HttpServer::readRequest(Connection& c) {
+  int avail = c.client.available();
+  size_t room = sizeof(c.req) - c.reqLen;
+  if (avail > 0 && room) {
+    int n = c.client.read((uint8_t*)c.req + c.reqLen, min<size_t>(room, avail));
+    if (n > 0) c.reqLen += n;
+    c.lastActivityMs = millis();
+  } else if (avail <= 0) {
+    // Keep-alive sin nada nuevo o petición a medias: se cierra al caducar
+    unsigned long limit = c.reqLen ? HTTP_REQUEST_TIMEOUT_MS : HTTP_KEEPALIVE_MS;
+    if (!c.client.connected()) {
+      close(c);
+      return;
+    }
+    if (millis() - c.lastActivityMs > limit) {
+      if (c.reqLen) stats.timeouts++;
+      close(c);
+      return;
+    }
+    if (!c.reqLen) return;
+  }
+
+  const char* end = findSeq(c.req, c.reqLen, "\r\n\r\n");
+  if (!end) {
+    if (c.reqLen == sizeof(c.req)) {
+      c.reqLen = 0;
+      reject(c, 413, "Request Too Large");
+    }
+    return;
+  }
+  size_t headerLen = end + 4 - c.req;
+  const char* cl = findHeader(c.req, headerLen, "Content-Length");
+  size_t bodyLen = 0;
+  if (cl && !parseContentLength(cl, bodyLen)) {
+    c.reqLen = 0;  // sin longitud no se sabe dónde empieza la siguiente
+    reject(c, 400, "Bad Request");
+    return;
+  }
+  if (bodyLen > sizeof(c.req) - headerLen) {
+    c.reqLen = 0;
+    reject(c, 413, "Request Too Large");
+    return;
+  }
+  if (c.reqLen < headerLen + bodyLen) return;  // falta cuerpo
+
+  bool ok = parseRequest(c, headerLen, bodyLen);
+  // Lo que sobre es la siguiente petición (pipelining)
+  size_t used = headerLen + bodyLen;
+  memmove(c.req, c.req + used, c.reqLen - used);
+  c.reqLen -= used;
+  if (!ok) {
+    reject(c, 400, "Bad Request");
+    return;
+  }
+  dispatch(c);
+}
+
+// Respuesta de error sin pasar por las rutas; la conexión se cierra después.
+void HttpServer::reject(Connection& c, int code, const char* text) {
+  stats.rejected++;
+  c.keepAlive = false;
+  current_ = &c;
+  pendingHeaders_ = String();
+  headOnly_ = false;
+  send(code, "text/plain", text);
+  current_ = nullptr;
+  c.state = CONN_WRITING;
+}
+
+// ====== PETICIÓN ======
+bool HttpServer::parseRequest(Connection& c, size_t headerLen, size_t bodyLen) {
+  const char* p = c.req;
+  const char* lineEnd = findSeq(p, headerLen, "\r\n");
+  const char* sp1 = (const char*)memchr(p, ' ', lineEnd - p);
+  const char* sp2 = sp1 ? (const char*)memchr(sp1 + 1, ' ', lineEnd - sp1 - 1) : nullptr;
+  if (!sp1 || !sp2) return false;
+
+  size_t mlen = sp1 - p;
+  method_ = HTTP_GET;
+  if (mlen == 4 && !memcmp(p, "POST", 4)) method_ = HTTP_POST;
+  else if (mlen == 3 && !memcmp(p, "PUT", 3)) method_ = HTTP_PUT;
+  else if (mlen == 6 && !memcmp(p, "DELETE", 6)) method_ = HTTP_DELETE;
+  else if (mlen == 4 && !memcmp(p, "HEAD", 4)) method_ = HTTP_HEAD;
+  else if (mlen == 5 && !memcmp(p, "PATCH", 5)) method_ = HTTP_PATCH;
+  else if (mlen == 7 && !memcmp(p, "OPTIONS", 7)) method_ = HTTP_OPTIONS;
+  else if (mlen != 3 || memcmp(p, "GET", 3)) return false;
+
+  args_.clear();
+  headers_.clear();
+  const char* target = sp1 + 1;
+  const char* q = (const char*)memchr(target, '?', sp2 - target);
+  uri_ = urlDecode(target, (q ? q : sp2) - target);
+  if (q) parseArgs(q + 1, sp2 - q - 1);
+
+  // HTTP/1.1 mantiene la conexión salvo "Connection: close"; 1.0 al revés
+  bool http11 = findSeq(sp2, lineEnd - sp2, "HTTP/1.1") != nullptr;
+  c.keepAlive = http11;
+  bool form = false;
+  const char* line = lineEnd + 2;
+  const char* headersEnd = c.req + headerLen - 2;
+  while (line < headersEnd) {
+    const char* next = findSeq(line, headersEnd + 2 - line, "\r\n");
+    if (!next) break;
+    const char* colon = (const char*)memchr(line, ':', next - line);
+    if (colon) {
+      String key, value;
+      key.concat(line, colon - line);
+      const char* v = colon + 1;
+      while (v < next && *v == ' ') v++;
+      value.concat(v, next - v);
+      if (key.equalsIgnoreCase("Connection")) {
+        if (value.equalsIgnoreCase("close")) c.keepAlive = false;
+        else if (value.equalsIgnoreCase("keep-alive")) c.keepAlive = true;
+      } else if (key.equalsIgnoreCase("Content-Type")) {
+        form = value.startsWith("application/x-www-form-urlencoded");
+      }
+      for (const String& k : collect_) {
+        if (k.equalsIgnoreCase(key)) headers_.push_back({k, value});
+      }
+    }
+    line = next + 2;
+  }
+  if (form && bodyLen) parseArgs(c.req + headerLen, bodyLen);
+  return true;
+}
+
+void HttpServer::parseArgs(const char* data, size_t len) {
+  size_t pos = 0;
+  while (pos < len) {
+    const char* amp = (const char*)memchr(data + pos, '&', len - pos);
+    size_t pairEnd = amp ? amp - data : len;
+    const char* eq = (const char*)memchr(data + pos, '=', pairEnd - pos);
+    if (pairEnd > pos) {
+      if (!eq) args_.push_back({urlDecode(data + pos, pairEnd - pos), String()});
+      else args_.push_back({urlDecode(data + pos, eq - data - pos), urlDecode(eq + 1, data + pairEnd - eq - 1)});
+    }
+    pos = pairEnd + 1;
+  }
+}
+
+String HttpServer::arg(const String& name) const {
+  for (const KV& kv : args_) {
+    if (kv.key == name) return kv.value;
+  }
+  return String();
+}
+
+bool HttpServer::hasArg(const String& name) const {
+  for (const KV& kv : args_) {
+    if (kv.key == name) return true;
+  }
+  return false;
+}
+
+String HttpServer::header(const String& name) const {
+  for (const KV& kv : headers_) {
+    if (kv.key.equalsIgnoreCase(name)) return kv.value;
+  }
+  return String();
+}
+
+void HttpServer::dispatch(Connection& c) {
+  stats.requests++;
+  if (c.requests++) stats.reused++;
+  if (c.requests >= HTTP_KEEPALIVE_MAX_REQUESTS) c.keepAlive = false;
+
+  current_ = &c;
+  pendingHeaders_ = String();
+  contentLength_ = CONTENT_LENGTH_NOT_SET;
+  responded_ = false;
+  detached_ = false;
+  headOnly_ = method_ == HTTP_HEAD;
+  c.state = CONN_WRITING;
+
+  bool handled = false;
+  for (const Route& r : routes_) {
+    bool methodOk = r.method == HTTP_ANY || r.method == method_ || (headOnly_ && r.method == HTTP_GET);
+    if (r.uri == uri_ && methodOk) {
+      r.fn();
+      handled = true;
+      break;
+    }
+  }
+  if (!handled) {
+    if (notFound_) notFound_();
+    else send(404, "text/plain", "404 Not Found");
+  }
+
+  if (detached_) {
+    c.client = WiFiClient();  // el socket lo tiene ahora quien lo pidió
+    c.state = CONN_FREE;
+    stats.active--;
+    std::vector<char>().swap(c.out);
+  } else if (!responded_) {
+    send(500, "text/plain", "Sin respuesta");
+  } else if (contentLength_ == CONTENT_LENGTH_UNKNOWN && !c.producer && !headOnly_) {
+    // Un handler "a la antigua" que no cerró su respuesta chunked
+    append("0\r\n\r\n", 5);
+  }
+  current_ = nullptr;
+}
+
+WiFiClient HttpServer::detachClient() {
+  if (!current_) return WiFiClient();
+  detached_ = true;
+  return current_->client;
+}
+
+// ====== RESPUESTA ======
+void HttpServer::sendHeader(const String& name, const String& value) {
+  pendingHeaders_ += name;
+  pendingHeaders_ += ": ";
+  pendingHeaders_ += value;
+  pendingHeaders_ += "\r\n";
+}
+
+void HttpServer::writeHead(int code, const char* contentType, size_t contentLength) {
+  Connection& c = *current_;
+  char head[192];
+  int n = snprintf(head, sizeof(head), "HTTP/1.1 %d %s\r\n", code, statusText(code));
+  append(head, n);
+  if (contentType && *contentType) {
+    n = snprintf(head, sizeof(head), "Content-Type: %s\r\n", contentType);
+    append(head, n);
+  }
+  c.chunked = contentLength == CONTENT_LENGTH_UNKNOWN;
+  if (c.chunked) n = snprintf(head, sizeof(head), "Transfer-Encoding: chunked\r\n");
+  else n = snprintf(head, sizeof(head), "Content-Length: %u\r\n", (unsigned)contentLength);
+  append(head, n);
+  n = snprintf(head, sizeof(head), "Connection: %s\r\n", c.keepAlive ? "keep-alive" : "close");
+  append(head, n);
+  append(pendingHeaders_.c_str(), pendingHeaders_.length());
+  append("\r\n", 2);
+  pendingHeaders_ = String();
+  responded_ = true;
+}
+
+void HttpServer::send(int code, const char* contentType, const String& content) {
+  send_P(code, contentType, content.c_str(), content.length());
+}
+
+void HttpServer::send_P(int code, const char* contentType, const char* content, size_t len) {
+  if (!current_) return;
+  // Con setContentLength(CONTENT_LENGTH_UNKNOWN) el cuerpo llega después con sendContent()
+  size_t declared = contentLength_ == CONTENT_LENGTH_NOT_SET ? len : contentLength_;
+  writeHead(code, contentType, declared);
+  if (len) sendContent(content, len);
+}
+
+void HttpServer::sendContent(const char* content, size_t len) {
+  if (!current_) return;
+  Connection& c = *current_;
+  if (headOnly_) {
+    if (c.chunked && !len) contentLength_ = CONTENT_LENGTH_NOT_SET;
+    return;
+  }
+  if (c.chunked) {
+    char size[12];
+    int n = snprintf(size, sizeof(size), "%x\r\n", (unsigned)len);
+    append(size, n);
+    if (len) append(content, len);
+    append("\r\n", 2);
+    if (!len) contentLength_ = CONTENT_LENGTH_NOT_SET;  // fin del cuerpo
+  } else {
+    append(content, len);
+  }
+}
+
+void HttpServer::sendProducer(int code, const char* contentType, Producer producer, size_t contentLength) {
+  if (!current_) return;
+  writeHead(code, contentType, contentLength);
+  if (!headOnly_) current_->producer = producer;
+}
+
+void HttpServer::streamFile(fs::File& file, const String& contentType, int code) {
+  // Como en el WebServer: un .gz se sirve con Content-Encoding
+  String name = file.name();
+  if (name.endsWith(".gz") && !contentType.endsWith("gzip")) sendHeader("Content-Encoding", "gzip");
+  fs::File f = file;  // el productor se queda con su propia referencia
+  sendProducer(code, contentType.c_str(), [f](uint8_t* buf, size_t cap) mutable -> size_t {
+    int n = f.read(buf, cap);
+    if (n <= 0) {
+      f.close();
+      return 0;
+    }
+    return n;
+  }, file.size());
+}
+
+// Añade a lo pendiente. Si un handler acumula demasiado se vacía aquí
+// mismo, esperando al socket como mucho HTTP_WRITE_TIMEOUT_MS.
+void HttpServer::append(const char* data, size_t len) {
+  Connection& c = *current_;
+  c.out.insert(c.out.end(), data, data + len);
+  if (c.out.size() - c.outPos <= HTTP_BUFFERED_MAX) return;
+  unsigned long start = millis();
+  while (c.out.size() - c.outPos > HTTP_BUFFERED_MAX / 2 && millis() - start < HTTP_WRITE_TIMEOUT_MS) {
+    size_t before = c.outPos;
+    ssize_t n = ::send(c.client.fd(), c.out.data() + c.outPos, c.out.size() - c.outPos, MSG_DONTWAIT);
+    if (n > 0) c.outPos += n;
+    else if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) break;
+    if (c.outPos == before) delay(1);
+  }
+  c.out.erase(c.out.begin(), c.out.begin() + c.outPos);
+  c.outPos = 0;
+}
+
+// Manda lo que admita el socket y, si se vació, pide otro trozo al
+// productor. Devuelve true cuando la respuesta ha salido entera.
+bool HttpServer::pump(Connection& c) {
+  static uint8_t chunk[HTTP_CHUNK_SIZE];
+  // Unos pocos trozos por pasada y conexión, para repartir loop() entre todas
+  for (uint8_t pass = 0; pass < HTTP_CHUNKS_PER_PASS; pass++) {
+    if (c.outPos < c.out.size()) {
+      ssize_t n = ::send(c.client.fd(), c.out.data() + c.outPos, c.out.size() - c.outPos, MSG_DONTWAIT);
+      if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+        close(c);
+        return false;
+      }
+      if (n > 0) {
+        c.outPos += n;
+        c.lastActivityMs = millis();
+      }
+      if (c.outPos < c.out.size()) {
+        // Cliente que no lee: se le da el mismo margen que a una petición
+        if (millis() - c.lastActivityMs > HTTP_WRITE_TIMEOUT_MS) {
+          stats.timeouts++;
+          close(c);
+        }
+        return false;
+      }
+    }
+    c.out.clear();
+    c.outPos = 0;
+    if (!c.producer) return true;
+
+    size_t n = c.producer(chunk, sizeof(chunk));
+    if (!n) c.producer = nullptr;
+    if (c.chunked) {
+      char size[12];
+      int h = snprintf(size, sizeof(size), "%x\r\n", (unsigned)n);
+      c.out.insert(c.out.end(), size, size + h);
+      c.out.insert(c.out.end(), chunk, chunk + n);
+      c.out.insert(c.out.end(), "\r\n", "\r\n" + 2);
+    } else {
+      c.out.insert(c.out.end(), chunk, chunk + n);
+    }
+    if (c.out.empty()) return true;
+  }
+  return false;
+}
+
+void HttpServer::finishResponse(Connection& c) {
+  if (!c.keepAlive) {
+    close(c);
+    return;
+  }
+  // Los buffers grandes se devuelven al heap entre peticiones
+  if (c.out.capacity() > HTTP_CHUNK_SIZE * 2) std::vector<char>().swap(c.out);
+  c.state = CONN_READING;
+  c.lastActivityMs = millis();
+  if (c.reqLen) readRequest(c);  // ya había otra petición en el buffer
+}
+
+HttpServerStats httpServerStats() { return stats; }
@@ -0,0 +1,146 @@
+#pragma once
+#include <Arduino.h>
+#include <FS.h>
+#include <WiFi.h>
+#include <WebServer.h>  // HTTPMethod y CONTENT_LENGTH_UNKNOWN
+#include <functional>
+#include <vector>
+
+// ====== SERVIDOR HTTP NO BLOQUEANTE ======
+// Sustituye al WebServer de Arduino, que atiende un cliente cada vez y deja
+// loop() parado mientras dura una descarga. Este lleva hasta
+// HTTP_MAX_CONNECTIONS conexiones a la vez sobre WiFiServer. Cada
+// handleClient() da una pasada corta a todas:
+//   - lee lo que haya llegado (sin esperar) hasta tener la petición completa
+//   - ejecuta el handler, que es síncrono como antes
+//   - manda lo pendiente con send(MSG_DONTWAIT) hasta donde admita el socket
+//
+// Las respuestas largas se generan con un productor (sendProducer): el
+// servidor le pide el siguiente trozo solo cuando el socket tiene sitio, así
+// que un cliente lento no retiene a nadie. send()/sendContent() siguen
+// existiendo con la misma API que el WebServer y van a un buffer por
+// conexión; si un handler acumula más de HTTP_BUFFERED_MAX se espera a que
+// el socket lo vaya soltando (acotado por HTTP_WRITE_TIMEOUT_MS).
+//
+// HTTP/1.1 con keep-alive: la conexión se reutiliza hasta
+// HTTP_KEEPALIVE_MAX_REQUESTS peticiones o HTTP_KEEPALIVE_MS sin actividad.
+//
+// HEAD se atiende con la ruta GET de la misma URI: salen las cabeceras que
+// mandaría el GET (Content-Length incluido) y el cuerpo se descarta.
+
+#define HTTP_MAX_CONNECTIONS 8
+#define HTTP_REQUEST_MAX 1024         // línea, cabeceras y cuerpo (formularios)
+#define HTTP_REQUEST_TIMEOUT_MS 5000  // para recibir una petición empezada
+#define HTTP_KEEPALIVE_MS 5000
+#define HTTP_KEEPALIVE_MAX_REQUESTS 100
+#define HTTP_IDLE_EVICT_MS 1000       // ociosa desde hace esto, se cede a un cliente nuevo
+#define HTTP_CHUNK_SIZE 1436          // un segmento TCP con la cabecera del chunk
+#define HTTP_CHUNKS_PER_PASS 4        // lo que cabe en la ventana de envío de lwIP
+#define HTTP_BUFFERED_MAX 16384
+#define HTTP_WRITE_TIMEOUT_MS 5000
+
+struct HttpServerStats {
+  uint32_t active;      // conexiones abiertas ahora
+  uint32_t accepted;
+  uint32_t requests;
+  uint32_t reused;      // peticiones que llegaron por una conexión keep-alive
+  uint32_t timeouts;    // conexiones cerradas por inactividad o petición a medias
+  uint32_t rejected;    // peticiones demasiado grandes o mal formadas
+};
+
+class HttpServer {
+ public:
+  typedef std::function<void(void)> THandlerFunction;
+  // Escribe hasta `cap` bytes del cuerpo en `buf` y devuelve cuántos; 0 = fin.
+  typedef std::function<size_t(uint8_t* buf, size_t cap)> Producer;
+
+  explicit HttpServer(uint16_t port = 80) : server_(port, HTTP_MAX_CONNECTIONS) {}
+
+  void begin();
+  void handleClient();
+
+  void on(const String& uri, HTTPMethod method, THandlerFunction fn) { routes_.push_back({uri, method, fn}); }
+  void onNotFound(THandlerFunction fn) { notFound_ = fn; }
+  void collectHeaders(const char* headerKeys[], size_t count);
+
+  // ====== Petición en curso (solo dentro de un handler) ======
+  const String& uri() const { return uri_; }
+  HTTPMethod method() const { return method_; }
+  String arg(const String& name) const;
+  bool hasArg(const String& name) const;
+  String header(const String& name) const;
+  // Entrega el socket al que llama (p. ej. /api/stream) y olvida la conexión.
+  WiFiClient detachClient();
+
+  // ====== Respuesta ======
+  void sendHeader(const String& name, const String& value);
+  void setContentLength(size_t len) { contentLength_ = len; }
+  void send(int code, const char* contentType = nullptr, const String& content = String());
+  void send(int code, const char* contentType, const char* content) { send_P(code, contentType, content, strlen(content)); }
+  void send_P(int code, const char* contentType, const char* content, size_t len);
+  void sendContent(const char* content, size_t len);
+  void sendContent(const String& content) { sendContent(content.c_str(), content.length()); }
+  void sendProducer(int code, const char* contentType, Producer producer,
+                    size_t contentLength = CONTENT_LENGTH_UNKNOWN);
+  void streamFile(fs::File& file, const String& contentType, int code = 200);
+
+ private:
+  enum ConnState : uint8_t { CONN_FREE, CONN_READING, CONN_WRITING };
+
+  struct Connection {
+    WiFiClient client;
+    ConnState state = CONN_FREE;
+    char req[HTTP_REQUEST_MAX];
+    size_t reqLen = 0;
+    unsigned long lastActivityMs = 0;
+    std::vector<char> out;   // pendiente de mandar
+    size_t outPos = 0;
+    Producer producer;
+    bool chunked = false;
+    bool keepAlive = false;
+    uint16_t requests = 0;
+  };
+
+  struct Route {
+    String uri;
+    HTTPMethod method;
+    THandlerFunction fn;
+  };
+  struct KV {
+    String key;
+    String value;
+  };
+
+  void accept();
+  void readRequest(Connection& c);
+  bool parseRequest(Connection& c, size_t headerLen, size_t bodyLen);
+  void dispatch(Connection& c);
+  void reject(Connection& c, int code, const char* text);
+  void parseArgs(const char* data, size_t len);
+  void writeHead(int code, const char* contentType, size_t contentLength);
+  void append(const char* data, size_t len);
+  bool pump(Connection& c);
+  void finishResponse(Connection& c);
+  void close(Connection& c);
+
+  WiFiServer server_;
+  Connection conns_[HTTP_MAX_CONNECTIONS];
+  std::vector<Route> routes_;
+  THandlerFunction notFound_;
+  std::vector<String> collect_;
+
+  // Petición que está atendiendo el handler
+  Connection* current_ = nullptr;
+  String uri_;
+  HTTPMethod method_ = HTTP_GET;
+  std::vector<KV> args_;
+  std::vector<KV> headers_;
+  String pendingHeaders_;
+  size_t contentLength_ = CONTENT_LENGTH_NOT_SET;
+  bool responded_ = false;
+  bool detached_ = false;
+  bool headOnly_ = false;  // HEAD: solo cabeceras
+};
+
+// Contadores de todos los HttpServer (en la práctica hay uno).
+HttpServerStats httpServerStats();
@@ -0,0 +1,149 @@
+#pragma once
+#include <Arduino.h>
+#include <stdlib.h>
+
+// ====== LECTOR JSON SOBRE BUFFER ======
+// Parser "pull" mínimo para ficheros de configuración: recorre el texto en
+// su sitio, sin árbol ni heap. Quien llama va pidiendo lo que espera y salta
+// con skipValue() lo que no conoce. Ante cualquier error ok() pasa a false y
+// el resto de llamadas devuelven false.
+//
+//   JsonReader r(text, len);
+//   char key[16];
+//   r.beginObject();
+//   while (r.nextKey(key, sizeof(key))) {
+//     if (!strcmp(key, "limite")) r.readNumber(limite);
+//     else r.skipValue();
+//   }
+
+class JsonReader {
+ public:
+  JsonReader(const char* text, size_t len) : p_(text), end_(text + len) {}
+
+  bool ok() const { return ok_; }
+
+  bool beginObject() { return consume('{'); }
+  bool beginArray() { return consume('['); }
+
+  // Siguiente clave del objeto actual; false al llegar a '}'.
+  bool nextKey(char* key, size_t cap) {
+    if (!nextItem('}')) return false;
+    return readString(key, cap) && consume(':');
+  }
+
+  // true si el array actual tiene otro elemento; false al llegar a ']'.
+  bool nextElement() { return nextItem(']'); }
+
+  bool readString(char* out, size_t cap) {
+    if (!consume('"')) return false;
+    size_t n = 0;
+    while (p_ < end_ && *p_ != '"') {
+      char c = *p_++;
+      if (c == '\\' && p_ < end_) {
+        c = *p_++;
+        if (c == 'n') c = '\n';
+        else if (c == 't') c = '\t';
+        else if (c == 'u') return fail();  // no hace falta en la configuración
+      }
+      if (n + 1 < cap) out[n++] = c;
+    }
+    if (cap) out[n] = '\0';
+    if (p_ >= end_) return fail();
+    p_++;
+    return true;
+  }
+
+  bool readNumber(float& out) {
+    skipWs();
+    char* after = nullptr;
+    out = strtof(p_, &after);
+    if (after == p_ || after > end_) return fail();
+    p_ = after;
+    return true;
+  }
+
+  bool readNumber(uint32_t& out) {
+    float v;
+    if (!readNumber(v) || v < 0) return fail();
+    out = (uint32_t)v;
+    return true;
+  }
+
+  bool readBool(bool& out) {
+    skipWs();
+    if (literal("true")) out = true;
+    else if (literal("false")) out = false;
+    else return fail();
+    return true;
+  }
+
+  bool skipValue() {
+    skipWs();
+    if (p_ >= end_) return fail();
+    char c = *p_;
+    if (c == '"') {
+      char dummy[1];
+      return readString(dummy, sizeof(dummy));
+    }
+    if (c == '{' || c == '[') {
+      char close = c == '{' ? '}' : ']';
+      consume(c);
+      while (nextItem(close)) {
+        if (close == '}') {
+          char dummy[1];
+          if (!readString(dummy, sizeof(dummy)) || !consume(':')) return false;
+        }
+        if (!skipValue()) return false;
+      }
+      return ok_;
+    }
+    if (literal("true") || literal("false") || literal("null")) return true;
+    float v;
+    return readNumber(v);
+  }
+
+ private:
+  const char* p_;
+  const char* end_;
+  bool ok_ = true;
+  bool first_ = true;
+
+  bool fail() {
+    ok_ = false;
+    return false;
+  }
+
+  void skipWs() {
+    while (p_ < end_ && (*p_ == ' ' || *p_ == '\n' || *p_ == '\r' || *p_ == '\t')) p_++;
+  }
+
+  bool consume(char c) {
+    if (!ok_) return false;
+    skipWs();
+    if (p_ >= end_ || *p_ != c) return fail();
+    p_++;
+    first_ = c == '{' || c == '[';
+    return true;
+  }
+
+  bool literal(const char* word) {
+    size_t n = strlen(word);
+    if ((size_t)(end_ - p_) < n || strncmp(p_, word, n)) return false;
+    p_ += n;
+    return true;
+  }
+
+  // Salta la coma entre elementos; false (sin error) al encontrar el cierre.
+  bool nextItem(char close) {
+    if (!ok_) return false;
+    skipWs();
+    if (p_ < end_ && *p_ == close) {
+      p_++;
+      first_ = false;
+      return false;
+    }
+    if (!first_ && !consume(',')) return false;
+    first_ = false;
+    return true;
+  }
+};
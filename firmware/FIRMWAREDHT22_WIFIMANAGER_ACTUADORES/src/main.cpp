@@ -1,35 +1,48 @@
 #include <Arduino.h>
 #include <WiFi.h>
-#include <WebServer.h>
-#include <DNSServer.h>
 #include <ESPmDNS.h>
-#include <WiFiManager.h>
 #include <FS.h>
-#include <SPIFFS.h>
 #include <time.h>
 #include <DHT.h>
-#include <HTTPClient.h>
+#include "uploader.h"
+#include "history_store.h"
+#include "json_writer.h"
+#include "event_stream.h"
+#include "static_assets.h"
+#include "bench.h"
+#include "metrics.h"
+#include "sensor_task.h"
+#include "alerts.h"
+#include "control.h"
+#include "actuator_journal.h"
+#include "http_server.h"
+#include "boot.h"
+#include "reducer.h"
+#include "storage.h"
+#include "storage_bench.h"
 
 // ====== CONFIGURACIÓN HARDWARE ======
-#define DHTPIN 4      // GPIO para el DHT22
-#define DHTTYPE DHT22 // Tipo de sensor
-DHT dht(DHTPIN, DHTTYPE);
+// Los sensores (DHT22 en GPIO 4 por defecto) se declaran en sensors.h
 
 // Nuevo pin para el LED azul
 const int ledPin = 2; // Pin del LED azul
 
 // ====== SERVIDOR WEB ======
-WebServer server(80);
+// Varias conexiones a la vez y keep-alive, sin bloquear loop() (http_server.h)
+HttpServer server(80);
 
 // ====== VARIABLES GLOBALES ======
 String apSuffix;
 String apName;
 String mdnsName;
-float currentTemp = NAN;
-float currentHum = NAN;
 
 // ====== CONFIGURACIÓN GOOGLE SHEETS ======
-const char* googleScriptURL = "https://script.google.com/macros/s/AKfycbzWphbim0zWUsFUjIM9X-1GdNkVObZN8qPP0jY_UBYGOSIMc_nOiRqoAnUQZFI1HvFuw/exec";
+// Con -DUPLOAD_URL=\"http://servidor:8090/exec\" se sube al servicio de
+// ingesta propio (server/ingest) en vez de al Apps Script; el JSON es el mismo.
+#ifndef UPLOAD_URL
+#define UPLOAD_URL "https://script.google.com/macros/s/AKfycbzWphbim0zWUsFUjIM9X-1GdNkVObZN8qPP0jY_UBYGOSIMc_nOiRqoAnUQZFI1HvFuw/exec"
+#endif
+const char* googleScriptURL = UPLOAD_URL;
 const char* deviceId = "ESP32_01"; 
 
 // ====== NTP (hora para logs) ======
@@ -46,19 +59,14 @@ String macSuffix() {
   return String(buf);
 }
 
-bool ensureFS() {
-  if (!SPIFFS.begin(true)) {
-    Serial.println(F("[SPIFFS] Falló el montaje"));
-    return false;
-  }
-  return true;
-}
-
 void handleFile(String path) {
+  // Primero el manifiesto en RAM (assets comprimidos + ETag)
+  if (assetsServe(server, storageFs(), path)) return;
+
   if (path.endsWith("/")) path += "index.html";
 
-  if (SPIFFS.exists(path)) {
-    File file = SPIFFS.open(path, "r");
+  File file = storageFs().open(path, "r");
+  if (file && !file.isDirectory()) {
     String contentType = "text/plain";
     if (path.endsWith(".html")) contentType = "text/html";
     else if (path.endsWith(".css")) contentType = "text/css";
@@ -67,199 +75,584 @@ void handleFile(String path) {
     else if (path.endsWith(".jpg")) contentType = "image/jpeg";
     else if (path.endsWith(".gif")) contentType = "image/gif";
     else if (path.endsWith(".ico")) contentType = "image/x-icon";
-    server.streamFile(file, contentType);
-    file.close();
+    server.streamFile(file, contentType);  // el File sigue abierto hasta terminar el envío
   } else {
     server.send(404, "text/plain", "404 Not Found");
   }
 }
 
 // ====== ENVIAR DATOS A GOOGLE SHEETS (Hoja: Datos) ======
-void sendToGoogleSheets(float temp, float hum) {
-  if (WiFi.status() == WL_CONNECTED) {
-    HTTPClient http;
-    http.begin(googleScriptURL);
-    http.addHeader("Content-Type", "application/json");
-
-    String mac = macSuffix();
-    String jsonData = "{";
-    jsonData += "\"type\":\"Datos\",";
-    jsonData += "\"deviceId\":\"" + String(deviceId) + "\",";
-    jsonData += "\"mac\":\"" + mac + "\",";
-    jsonData += "\"temp\":" + String(temp, 2) + ",";
-    jsonData += "\"hum\":" + String(hum, 2);
-    jsonData += "}";
-
-    int httpResponseCode = http.POST(jsonData);
-
-    if (httpResponseCode > 0) {
-      Serial.printf("Datos enviados! Código: %d\n", httpResponseCode);
-    } else {
-      Serial.printf("Error enviando datos: %d\n", httpResponseCode);
-    }
-    http.end();
+// Solo encola; la tarea del uploader lo guarda en el outbox y lo sube por lotes
+// (uploader.cpp).
+void sendToGoogleSheets(uint8_t sensor, float temp, float hum) {
+  // Con carga alta las descartadas solo se cuentan (/api/uploader)
+  if (!uploaderEnqueueReading(sensor, temp, hum) && SENSOR_LOG_EACH) {
+    Serial.println("Cola de subida llena, se descartó la lectura más antigua");
   }
 }
 
 // ====== ENVIAR EVENTOS A GOOGLE SHEETS (Hoja: Estados) ======
 void sendEvent(String evento, String motivo) {
-  if (WiFi.status() == WL_CONNECTED) {
-    HTTPClient http;
-    http.begin(googleScriptURL);
-    http.addHeader("Content-Type", "application/json");
-
-    String mac = macSuffix();
-    float chipTemp = temperatureRead();
-
-    String jsonData = "{";
-    jsonData += "\"type\":\"Estados\",";
-    jsonData += "\"deviceId\":\"" + String(deviceId) + "\",";
-    jsonData += "\"mac\":\"" + mac + "\",";
-    jsonData += "\"evento\":\"" + evento + "\",";
-    jsonData += "\"motivo\":\"" + motivo + "\",";
-    jsonData += "\"tempChip\":" + String(chipTemp, 2);
-    jsonData += "}";
-
-    int httpResponseCode = http.POST(jsonData);
-
-    if (httpResponseCode > 0) {
-      Serial.printf("Evento enviado! Código: %d\n", httpResponseCode);
-    } else {
-      Serial.printf("Error enviando evento: %d\n", httpResponseCode);
-    }
-    http.end();
+  float chipTemp = temperatureRead();
+  if (!uploaderEnqueueEvent(evento.c_str(), motivo.c_str(), chipTemp)) {
+    Serial.println("Cola de subida llena, se descartó la entrada más antigua");
+  }
+}
+
+// ====== RESPUESTAS JSON ======
+// Las respuestas cortas se arman en un buffer de pila y se mandan con
+// send_P (sin pasar por String); las largas van en streaming chunked.
+void sendJson(int code, const JsonWriter& json) {
+  server.send_P(code, "application/json", json.c_str(), json.length());
+}
+
+static void sendJsonChunk(const char* data, size_t len, void*) {
+  server.sendContent(data, len);
+}
+
+static char jsonStreamBuf[1024];
+
+JsonWriter beginJsonStream(int code) {
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(code, "application/json", "");
+  return JsonWriter(jsonStreamBuf, sizeof(jsonStreamBuf), sendJsonChunk);
+}
+
+void endJsonStream(JsonWriter& json) {
+  json.flush();
+  server.sendContent("");
+}
+
+static void writeMinAvgMax(JsonWriter& json, const char* key, int32_t mn, int64_t sum, int32_t mx, uint32_t n) {
+  json.key(key).beginArray()
+      .value(mn / 100.0, 2).value(sum / 100.0 / n, 2).value(mx / 100.0, 2)
+      .endArray();
+}
+
+// ====== RUTAS CON MÉTRICAS ======
+// Como server.on(), pero cronometrando el handler en esp32_http_route_seconds.
+static bool requestServed = false;
+
+std::function<void()> timedRoute(const char* name, std::function<void()> fn) {
+  uint8_t route = metricsRoute(name);
+  return [route, fn]() {
+    uint32_t start = micros();
+    fn();
+    metrics.routes[route].record(micros() - start);
+    requestServed = true;
+    bootMark(BOOT_FIRST_RESPONSE);
+  };
+}
+
+void route(const char* uri, HTTPMethod method, std::function<void()> fn) {
+  server.on(uri, method, timedRoute(uri, fn));
+}
+
+static void sendMetricsChunk(const char* data, size_t len, void*) {
+  server.sendContent(data, len);
+}
+
+// ====== EVENTOS EN VIVO ======
+// Una muestra de un sensor, igual en /api/latest y en los eventos "sample".
+void writeSample(JsonWriter& json, const SensorSample& s) {
+  bool ok = s.status == SENSOR_OK;
+  json.beginObject()
+      .field("sensor", sensorId(s.sensor)).field("ts", s.ts)
+      .field("temp", ok ? s.temp : NAN, 1).field("hum", ok ? s.hum : NAN, 1)
+      .endObject();
+}
+
+// Cambio de estado de una regla (alerts.cpp): a la hoja "Estados" y a /api/stream.
+void onAlert(const AlertRule& rule, bool raised, float value) {
+  char motivo[40];
+  snprintf(motivo, sizeof(motivo), "%s %s %.1f", rule.id, alertsSourceId(rule.source), value);
+  Serial.printf("%s: %s\n", raised ? "Alerta" : "Alerta resuelta", motivo);
+  sendEvent(raised ? "Alerta" : "Alerta resuelta", motivo);
+
+  char buf[96];
+  JsonWriter json(buf, sizeof(buf));
+  json.beginObject()
+      .field("id", rule.id).field("sensor", alertsSourceId(rule.source))
+      .field("active", raised).field("value", value, 2)
+      .endObject();
+  if (!json.overflow()) streamPublish("alert", json.c_str());
+}
+
+void publishSample(const SensorSample& s) {
+  char buf[96];
+  JsonWriter json(buf, sizeof(buf));
+  writeSample(json, s);
+  if (!json.overflow()) streamPublish("sample", json.c_str());
+}
+
+// ?sensor=<id>: índice del sensor, `fallback` si no viene o -1 si no existe.
+int sensorArg(int fallback) {
+  if (!server.hasArg("sensor")) return fallback;
+  return sensorIndex(server.arg("sensor").c_str());
+}
+
+void sendUnknownSensor() {
+  char buf[48];
+  JsonWriter json(buf, sizeof(buf));
+  json.beginObject().field("error", "Sensor desconocido").endObject();
+  sendJson(400, json);
+}
+
+// Estado del actuador para el switch de la web: "auto" es false mientras
+// está forzado desde /api/actuator.
+void writeActuatorState(JsonWriter& json, const ControlStatus& c) {
+  json.beginObject()
+      .field("state", c.output ? "ON" : "OFF").field("auto", !c.manual)
+      .field("mode", controlModeName(c.mode)).field("setpoint", c.setpoint, 1)
+      .endObject();
+}
+
+// ====== HISTÓRICO REDUCIDO (JSON) ======
+// {"buckets":[{"ts":..,"n":..,"temp":[min,avg,max],"hum":[min,avg,max]},...],
+//  "sensor":"dht0","from":..,"to":..,"step":..,"source":"raw|minute|hour|day"}
+// Sin ?sensor= se usa el primero de la tabla.
+void sendHistoryBuckets() {
+  int sensor = sensorArg(0);
+  if (sensor < 0) {
+    sendUnknownSensor();
+    return;
+  }
+  time_t now = time(nullptr);
+  uint32_t to = server.hasArg("to") ? server.arg("to").toInt() : now;
+  uint32_t from = server.hasArg("from") ? server.arg("from").toInt() : (to > 86400 ? to - 86400 : 0);
+  int buckets = server.hasArg("buckets") ? server.arg("buckets").toInt() : 300;
+  if (to < from || buckets <= 0) {
+    char buf[48];
+    JsonWriter json(buf, sizeof(buf));
+    json.beginObject().field("error", "Rango no válido").endObject();
+    sendJson(400, json);
+    return;
   }
+
+  JsonWriter json = beginJsonStream(200);
+  json.beginObject().key("buckets").beginArray();
+  const char* source = "";
+  uint32_t step = historyAggregate(sensor, from, to, buckets, [&](const HistoryBucket& b) {
+    json.beginObject().field("ts", b.ts).field("n", b.count);
+    writeMinAvgMax(json, "temp", b.tMin, b.tSum, b.tMax, b.count);
+    if (sensorHasHumidity(sensor)) writeMinAvgMax(json, "hum", b.hMin, b.hSum, b.hMax, b.count);
+    else json.key("hum").null();
+    json.endObject();
+  }, &source);
+  json.endArray()
+      .field("sensor", sensorId(sensor)).field("from", from).field("to", to).field("step", step).field("source", source)
+      .endObject();
+  endJsonStream(json);
 }
 
 // ====== SETUP ======
+// Ya con WiFi (desde bootLoop): mDNS y hora. configTime() no espera al SNTP;
+// las muestras de antes de tener hora se vuelcan después (boot.h).
+void onWiFiConnected() {
+  mdnsName = "esp32";
+  if (MDNS.begin(mdnsName.c_str())) {
+    Serial.printf("mDNS iniciado: http://%s.local\n", mdnsName.c_str());
+  }
+  configTime(gmtOffset_sec, daylightOffset_sec, ntpServer);
+}
+
+void appendHistory(uint32_t ts, uint8_t sensor, float temp, float hum, uint8_t tag) {
+  uint32_t t0us = micros();
+  uint32_t t0 = benchStart();
+  bool saved = historyAppend(ts, sensor, temp, hum, tag);
+  benchEnd(BENCH_APPEND, t0);
+  metrics.historyAppend.record(micros() - t0us);
+  if (saved && SENSOR_LOG_EACH) {
+    Serial.printf("Datos de %s guardados en el historial!\n", sensorId(sensor));
+  }
+}
+
+// Cada lectura válida nueva pasa por la reducción (reducer.h): las que se
+// guardan van al histórico y a Google Sheets; de las demás, las que tocaban
+// por intervalo solo a los agregados.
+void logSample(const SensorSample& sample) {
+  ReducerDecision d = reducerOffer(sample);
+  if (!d.keep && !d.observe) return;
+  // Lo que se midió antes de tener hora NTP va primero, para que el anillo
+  // quede ordenado por tiempo
+  bootReplay(appendHistory);
+  time_t now = time(nullptr);
+  if (!d.keep) {
+    if (now >= HISTORY_MIN_EPOCH) historyObserve(now, sample.sensor, sample.temp, sample.hum);
+    return;
+  }
+  // Guardar en el histórico; sin hora aún, queda en RAM hasta que llegue
+  if (now >= HISTORY_MIN_EPOCH) appendHistory(now, sample.sensor, sample.temp, sample.hum, d.tag);
+  else bootHold(sample.sensor, sample.temp, sample.hum, sample.ms, d.tag);
+  // Enviar a Google Sheets (Hoja Datos)
+  sendToGoogleSheets(sample.sensor, sample.temp, sample.hum);
+}
+
+// Las pruebas de test/ (pio test -e native) enlazan este fichero por las
+// funciones de arriba y traen su propio setup()/loop().
+#ifndef PIO_UNIT_TESTING
+// Por etapas (boot.h): primero lo que mide y guarda en local, después la
+// web y por último la WiFi, que sigue conectándose desde loop().
 void setup() {
   Serial.begin(115200);
   Serial.println(F("Iniciando..."));
+#ifdef STORAGE_BENCH
+  storageBench();  // no vuelve (storage_bench.h)
+#endif
 
   // Configurar el pin del LED como salida
   pinMode(ledPin, OUTPUT);
 
-  // Inicia SPIFFS
-  if (!ensureFS()) return;
+  // Iniciar los sensores (se leen en su propia tarea, ver sensor_task.cpp)
+  sensorBegin();
 
-  // Configurar WiFi con WiFiManager
-  WiFiManager wm;
-  apSuffix = macSuffix();
-  apName = "ESP32-" + apSuffix;
-  wm.setHostname(apName.c_str());
+  // Sistema de archivos (y partición de anillos si la hay, storage.h)
+  if (!storageBegin()) return;
 
-  if (!wm.autoConnect(apName.c_str())) {
-    Serial.println(F("No se pudo conectar al WiFi, reiniciando..."));
-    ESP.restart();
-  }
+  // Histórico en anillo (migra el /data.csv de versiones anteriores)
+  if (historyBegin()) historyImportCsv("/data.csv");
 
-  Serial.println(F("WiFi conectado!"));
-  Serial.print(F("IP: "));
-  Serial.println(WiFi.localIP());
+  // Banda muerta y latido antes de guardar (/config/reducer.json)
+  reducerBegin(storageFs());
 
-  // Configurar mDNS
-  mdnsName = "esp32";
-  if (MDNS.begin(mdnsName.c_str())) {
-    Serial.printf("mDNS iniciado: http://%s.local\n", mdnsName.c_str());
-  }
+  // Manifiesto de la web (scripts/web_assets.py)
+  assetsBegin(storageFs());
 
-  // Configurar NTP
-  configTime(gmtOffset_sec, daylightOffset_sec, ntpServer);
+  // Reglas de alerta (/config/alerts.json o las de fábrica)
+  alertsBegin(storageFs(), onAlert);
 
-  // Iniciar DHT
-  dht.begin();
+  // Termostato sobre el actuador (ver control.cpp); sus cambios van al diario
+  journalBegin(storageFs());
+  controlBegin(storageFs(), ledPin);
 
-  // Registrar evento de reinicio
+  // WiFi en segundo plano: caché de BSSID/canal, escaneo y, si nada, el
+  // portal de WiFiManager (boot.cpp)
+  apSuffix = macSuffix();
+  apName = "ESP32-" + apSuffix;
+  bootBegin(storageFs(), apName.c_str(), onWiFiConnected);
+
+  // Iniciar la tarea de subida a Google Sheets
+  uploaderBegin(googleScriptURL, deviceId, apSuffix);
+
+  // Registrar evento de reinicio (sale cuando haya red y hora)
   sendEvent("Reinicio", "Encendido o Reset manual");
 
   // ====== Rutas HTTP ======
-  server.on("/api/latest", HTTP_GET, []() {
-    if (isnan(currentTemp) || isnan(currentHum)) {
-      server.send(500, "application/json", "{\"error\":\"Error leyendo DHT22\"}");
+  // temp/hum/ts del sensor principal (el primero, o ?sensor=) y, en
+  // "sensors", la última muestra de todos.
+  route("/api/latest", HTTP_GET, []() {
+    int primary = sensorArg(0);
+    if (primary < 0) {
+      sendUnknownSensor();
       return;
     }
-    String payload = "{";
-    payload += "\"temp\":" + String(currentTemp, 1) + ",";
-    payload += "\"hum\":" + String(currentHum, 1);
-    payload += "}";
-    server.send(200, "application/json", payload);
+    SensorSample s = sensorLatest(primary);
+    char buf[96 + SENSOR_COUNT * 80];
+    JsonWriter json(buf, sizeof(buf));
+    if (s.status != SENSOR_OK) {
+      json.beginObject().field("error", "Error leyendo DHT22").field("sensor", sensorId(primary)).endObject();
+      sendJson(500, json);
+      return;
+    }
+    json.beginObject()
+        .field("temp", s.temp, 1).field("hum", s.hum, 1).field("ts", s.ts)
+        .key("sensors").beginArray();
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) writeSample(json, sensorLatest(i));
+    json.endArray().endObject();
+    sendJson(200, json);
   });
 
-  server.on("/api/history", HTTP_GET, []() {
-    File file = SPIFFS.open("/data.csv", "r");
-    if (!file) {
+  // Exporta el histórico. Por defecto en CSV "ts,temp,hum,sensor"; con
+  // ?format=bin, bloques comprimidos (history_codec.h) uno tras otro. Con
+  // ?from=&to= (epoch) devuelve JSON reducido a como mucho ?buckets=
+  // intervalos con min/avg/max; con format=csv|bin, las muestras del rango.
+  // ?sensor= filtra las muestras. ?tags=1 añade al CSV la columna con el
+  // motivo de cada muestra (raw|change|heartbeat|fast, ver reducer.h); el
+  // formato bin la lleva siempre. ?since=<ts> devuelve solo las muestras
+  // posteriores a ts, en csv o bin y hasta la última: la web la usa para
+  // traer solo lo que no tiene en su caché (history_worker.js).
+  route("/api/history", HTTP_GET, []() {
+    if (!history.ready()) {
       server.send(500, "text/plain", "Failed to open history file");
       return;
     }
-    server.streamFile(file, "text/csv");
-    file.close();
+    bool since = server.hasArg("since");
+    bool ranged = !since && (server.hasArg("from") || server.hasArg("to"));
+    String format = server.arg("format");
+    if (ranged && format != "csv" && format != "bin") {
+      sendHistoryBuckets();
+      return;
+    }
+
+    int sensor = sensorArg(-2);
+    if (sensor == -1) {
+      sendUnknownSensor();
+      return;
+    }
+    uint32_t from = since ? (uint32_t)server.arg("since").toInt() + 1 : ranged ? server.arg("from").toInt() : 0;
+    HistoryCursor cursor = historySeek(from);
+    uint32_t to = ranged && server.hasArg("to") ? server.arg("to").toInt() : UINT32_MAX;
+    // Se genera a trozos a medida que el cliente lee (sin parar loop())
+    bool binary = format == "bin";
+    bool tags = server.arg("tags") == "1";
+    bool done = false;
+    server.sendProducer(200, binary ? "application/octet-stream" : "text/csv",
+                        [cursor, to, sensor, binary, tags, done](uint8_t* buf, size_t cap) mutable -> size_t {
+      HistoryRecord r;
+      if (binary) {
+        // Cada trozo es un bloque autónomo (history_codec.h) con solo las
+        // muestras pedidas
+        HistoryBlockWriter block;
+        bool empty = true;
+        while (!done) {
+          HistoryCursor before = cursor;
+          if (!historyNext(cursor, r) || r.ts > to) {
+            done = true;
+            break;
+          }
+          if (sensor >= 0 && r.sensor != sensor) continue;
+          if (empty) block.begin(buf, cap, 0, r.ts);
+          empty = false;
+          if (!block.add(r)) {
+            cursor = before;
+            break;
+          }
+        }
+        return empty ? 0 : block.length();
+      }
+      size_t len = 0;
+      while (!done && cap - len >= 64) {
+        if (!historyNext(cursor, r) || r.ts > to) {
+          done = true;
+          break;
+        }
+        if (sensor >= 0 && r.sensor != sensor) continue;
+        char* out = (char*)buf + len;
+        len += r.hum == HISTORY_NO_HUM
+                   ? snprintf(out, cap - len, "%lu,%.2f,,%s", (unsigned long)r.ts,
+                              historyTemp(r), sensorId(r.sensor))
+                   : snprintf(out, cap - len, "%lu,%.2f,%.2f,%s", (unsigned long)r.ts,
+                              historyTemp(r), historyHum(r), sensorId(r.sensor));
+        len += tags ? snprintf((char*)buf + len, cap - len, ",%s\n", historyTagName(r.tag))
+                    : snprintf((char*)buf + len, cap - len, "\n");
+      }
+      return len;
+    });
+  });
+
+  // Cuánto guarda la reducción: "ratio" es lo que habría guardado el
+  // intervalo fijo entre lo guardado.
+  route("/api/reducer", HTTP_GET, []() {
+    ReducerStats s = reducerStats();
+    char buf[256];
+    JsonWriter json(buf, sizeof(buf));
+    json.beginObject()
+        .field("offered", s.offered).field("baseline", s.baseline).field("stored", reducerKept(s))
+        .key("byTag").beginObject();
+    for (uint8_t tag = 0; tag < 4; tag++) json.field(historyTagName(tag), s.kept[tag]);
+    json.endObject().field("fastModes", s.fastModes).field("ratio", reducerRatio(s), 2).endObject();
+    sendJson(200, json);
   });
-  
-  // Nuevo endpoint para controlar el actuador (LED azul)
-  server.on("/api/actuator", HTTP_POST, []() {
+
+  route("/api/uploader", HTTP_GET, []() {
+    UploaderStats s = uploaderStats();
+    char buf[320];
+    JsonWriter json(buf, sizeof(buf));
+    json.beginObject()
+        .field("enqueued", s.enqueued).field("queueFull", s.queueFull).field("dropped", s.dropped)
+        .field("depth", s.depth).field("highWater", s.highWater).field("pending", s.pending)
+        .field("overwritten", s.overwritten).field("batches", s.batches).field("sent", s.sent)
+        .field("failed", s.failed).field("backoffMs", s.backoffMs).field("lastCode", s.lastCode)
+        .endObject();
+    sendJson(200, json);
+  });
+
+  // Push en vivo (Server-Sent Events). El socket se queda en event_stream.cpp;
+  // de aquí solo se manda el estado actual del actuador para sincronizar el
+  // switch al conectar (la primera lectura llega con el siguiente "sample").
+  route("/api/stream", HTTP_GET, []() {
+    char buf[96];
+    JsonWriter json(buf, sizeof(buf));
+    writeActuatorState(json, controlStatus());
+    streamAccept(server.detachClient(), "actuator", json.c_str());
+  });
+
+  // Estado de cada regla de alerta
+  route("/api/alerts", HTTP_GET, []() {
+    static const char* const types[] = {"above", "below", "rate", "stale"};
+    char buf[64 + ALERTS_MAX_RULES * 160];
+    JsonWriter json(buf, sizeof(buf));
+    json.beginArray();
+    for (uint8_t i = 0; i < alertsCount(); i++) {
+      const AlertRule& rule = alertsRule(i);
+      AlertStatus st = alertsStatus(i);
+      json.beginObject()
+          .field("id", rule.id).field("sensor", alertsSourceId(rule.source))
+          .field("metric", rule.metric == ALERT_HUM ? "hum" : "temp").field("type", types[rule.type])
+          .field("threshold", rule.threshold, 2).field("active", st.active).field("value", st.value, 2)
+          .field("raised", st.raised).field("suppressed", st.suppressed)
+          .endObject();
+    }
+    json.endArray();
+    sendJson(200, json);
+  });
+
+  route("/api/stream/stats", HTTP_GET, []() {
+    StreamStats s = streamStats();
+    char buf[160];
+    JsonWriter json(buf, sizeof(buf));
+    json.beginObject()
+        .field("clients", s.clients).field("accepted", s.accepted).field("rejected", s.rejected)
+        .field("published", s.published).field("dropped", s.dropped).field("closed", s.closed)
+        .endObject();
+    sendJson(200, json);
+  });
+
+  // Forzado manual del actuador (LED azul): state=ON|OFF durante
+  // ?minutes= (0..CONTROL_OVERRIDE_MAX_MIN; 0 o sin él, el "override" de
+  // control.json) o state=AUTO para devolverlo al termostato. El cambio sale por /api/stream desde loop().
+  route("/api/actuator", HTTP_POST, []() {
     String state = server.arg("state");
-    int ledState = LOW;
-    if (state == "ON") {
-      ledState = HIGH;
-      Serial.println("Actuador: Encendido");
+    if (state == "AUTO") {
+      controlResume();
+      Serial.println("Actuador: Automático");
     } else {
-      ledState = LOW;
-      Serial.println("Actuador: Apagado");
+      long minutes = server.arg("minutes").toInt();
+      if (minutes < 0 || minutes > CONTROL_OVERRIDE_MAX_MIN) {
+        char buf[64];
+        JsonWriter json(buf, sizeof(buf));
+        json.beginObject().field("error", "minutes fuera de rango").field("max", (uint32_t)CONTROL_OVERRIDE_MAX_MIN).endObject();
+        sendJson(400, json);
+        return;
+      }
+      controlOverride(state == "ON", minutes * 60);
     }
-    digitalWrite(ledPin, ledState);
     server.send(200, "text/plain", "OK");
   });
 
-  server.onNotFound([]() {
-    handleFile(server.uri());
+  // Diario del actuador, de lo más reciente hacia atrás:
+  // ?limit= (máx. JOURNAL_PAGE_MAX) y ?before=<seq> con el "next" de la
+  // página anterior. "next" es null al llegar al principio del diario.
+  route("/api/actuator/history", HTTP_GET, []() {
+    static JournalEntry page[JOURNAL_PAGE_MAX];
+    uint32_t before = server.hasArg("before") ? strtoul(server.arg("before").c_str(), nullptr, 10) : UINT32_MAX;
+    long limit = server.hasArg("limit") ? server.arg("limit").toInt() : 20;
+    limit = constrain(limit, 1L, (long)JOURNAL_PAGE_MAX);
+    uint32_t n = journalRead(before, page, limit);
+
+    JsonWriter json = beginJsonStream(200);
+    json.beginObject().key("entries").beginArray();
+    for (uint32_t i = 0; i < n; i++) {
+      const JournalEntry& e = page[i];
+      json.beginObject()
+          .field("seq", e.seq).field("ts", e.ts).field("state", e.state ? "ON" : "OFF")
+          .field("source", journalSourceName(e.source)).field("value", e.value, 2)
+          .endObject();
+    }
+    json.endArray().key("next");
+    if (n && page[n - 1].seq > journalHead()) json.value(page[n - 1].seq);
+    else json.null();
+    json.field("total", journalTail() - journalHead()).endObject();
+    endJsonStream(json);
+  });
+
+  // Estado del lazo de control y sus tiempos
+  route("/api/control", HTTP_GET, []() {
+    ControlStatus c = controlStatus();
+    char buf[384];
+    JsonWriter json(buf, sizeof(buf));
+    json.beginObject()
+        .field("mode", controlModeName(c.mode)).field("output", c.output ? "ON" : "OFF")
+        .field("auto", !c.manual).field("manualLeftS", c.manualLeftS)
+        .field("setpoint", c.setpoint, 2).field("input", c.input, 2).field("duty", c.duty, 3)
+        .field("switches", c.switches)
+        .field("latencyUs", c.latencyUs).field("latencyMaxUs", c.latencyMaxUs)
+        .field("jitterUs", c.jitterUs).field("jitterMaxUs", c.jitterMaxUs)
+        .field("periodMs", (unsigned)CONTROL_PERIOD_MS)
+        .endObject();
+    sendJson(200, json);
+  });
+
+  route("/api/metrics", HTTP_GET, []() {
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "text/plain; version=0.0.4", "");
+    metricsWrite(sendMetricsChunk, nullptr);
+    server.sendContent("");
   });
 
+  server.onNotFound(timedRoute("static", []() {
+    handleFile(server.uri());
+  }));
+
+  // El servidor solo guarda las cabeceras que se le piden
+  const char* headerKeys[] = {"If-None-Match", "Accept-Encoding"};
+  server.collectHeaders(headerKeys, 2);
+
   server.begin();
+  bootMark(BOOT_HTTP_READY);
   Serial.println(F("Servidor HTTP iniciado"));
 }
 
 // ====== LOOP ======
 void loop() {
-  server.handleClient();
-
-  // Leer sensores cada 10s
-  static unsigned long lastSensorReadTime = 0;
-  const unsigned long readInterval = 3000;
+  benchLoop();
+  static uint32_t lastLoopUs = micros();
+  uint32_t loopStartUs = micros();
+  metrics.loopPeriod.record(loopStartUs - lastLoopUs);
+  lastLoopUs = loopStartUs;
 
-  if (millis() - lastSensorReadTime > readInterval) {
-    lastSensorReadTime = millis();
-    currentHum = dht.readHumidity();
-    currentTemp = dht.readTemperature();
+  bootLoop();
 
-    if (isnan(currentHum) || isnan(currentTemp)) {
-      Serial.println("Error leyendo DHT22!");
-    } else {
-      Serial.printf("Temp: %.2f °C | Hum: %.2f %%\n", currentTemp, currentHum);
-    }
+  // El portal y la reconexión WiFi de bootLoop() no cuentan como HTTP
+  uint32_t httpStartUs = micros();
+  uint32_t t0 = benchStart();
+  server.handleClient();
+  benchEnd(BENCH_HTTP, t0);
+  if (requestServed) {
+    metrics.handleClient.record(micros() - httpStartUs);
+    requestServed = false;
   }
-
-  // Guardar en CSV y enviar a Google Sheets cada 5 min
-  static unsigned long lastLogTime = 0;
-  const unsigned long logInterval = 10000;
-
-  if (millis() - lastLogTime > logInterval) {
-    lastLogTime = millis();
-    if (!isnan(currentHum) && !isnan(currentTemp)) {
-      // Guardar en SPIFFS
-      File file = SPIFFS.open("/data.csv", FILE_APPEND);
-      if (file) {
-        time_t now = time(nullptr);
-        file.printf("%ld,%.2f,%.2f\n", now, currentTemp, currentHum);
-        file.close();
-        Serial.println("Datos guardados en CSV!");
+  streamLoop();
+
+  // Cada muestra nueva de la tarea de sensores sale por /api/stream
+  static uint32_t lastSeq[SENSOR_COUNT] = {};
+  SensorSample samples[SENSOR_COUNT];
+  for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+    samples[i] = sensorLatest(i);
+    if (samples[i].seq != lastSeq[i]) {
+      // Si la tarea publicó varias desde la última vuelta, solo se ve la última
+      if (lastSeq[i] && samples[i].seq - lastSeq[i] > 1) {
+        metrics.sensorSkipped[i].fetch_add(samples[i].seq - lastSeq[i] - 1, std::memory_order_relaxed);
       }
-      // Enviar a Google Sheets (Hoja Datos)
-      sendToGoogleSheets(currentTemp, currentHum);
+      lastSeq[i] = samples[i].seq;
+      if (samples[i].status == SENSOR_OK) bootMark(BOOT_FIRST_SAMPLE, samples[i].ms);
+      publishSample(samples[i]);
+      alertsOnSample(i, samples[i].temp, samples[i].hum, samples[i].status == SENSOR_OK);
+      if (samples[i].status == SENSOR_OK) logSample(samples[i]);
     }
   }
-
-  // Ejemplo: evento si chip sobrecalentado (>70 °C)
-  if (temperatureRead() > 70) {
-    sendEvent("Alerta", "Chip sobrecalentado");
+  // El histórico confirma en flash el grupo pendiente cuando toca (history_store.h)
+  historyLoop();
+
+  // La temperatura del chip entra en las alertas al mismo ritmo que los
+  // sensores (y no en cada vuelta de loop)
+  static unsigned long lastChipMs = 0;
+  if (millis() - lastChipMs >= SENSOR_PERIOD_MS) {
+    lastChipMs = millis();
+    alertsOnSample(ALERT_SOURCE_CHIP, temperatureRead(), NAN, true);
+  }
+  alertsTick();
+
+  // Los cambios del actuador (del termostato o manuales) salen por /api/stream
+  static bool lastOutput = false, lastManual = false;
+  ControlStatus control = controlStatus();
+  if (control.output != lastOutput || control.manual != lastManual) {
+    lastOutput = control.output;
+    lastManual = control.manual;
+    char buf[96];
+    JsonWriter json(buf, sizeof(buf));
+    writeActuatorState(json, control);
+    streamPublish("actuator", json.c_str());
   }
-}
\ No newline at end of file
+}
+#endif  // PIO_UNIT_TESTING
@@ -0,0 +1,242 @@
+#include "metrics.h"
+#include <WiFi.h>
+#include "uploader.h"
+#include "sensor_task.h"
+#include "alerts.h"
+#include "control.h"
+#include "http_server.h"
+#include "boot.h"
+#include "reducer.h"
+#include "history_store.h"
+#include "storage.h"
+
+Metrics metrics;
+
+static const char* routeNames[METRICS_MAX_ROUTES];
+static uint8_t routeCount = 0;
+
+uint8_t metricsRoute(const char* name) {
+  for (uint8_t i = 0; i < routeCount; i++) {
+    if (!strcmp(routeNames[i], name)) return i;
+  }
+  if (routeCount == METRICS_MAX_ROUTES) return METRICS_MAX_ROUTES - 1;
+  routeNames[routeCount] = name;
+  return routeCount++;
+}
+
+void metricsUpload(int httpCode, uint32_t us) {
+  UploadResult r = UPLOAD_ERROR;
+  if (httpCode >= 200 && httpCode < 600) r = (UploadResult)(httpCode / 100 - 2);
+  metricsInc(metrics.uploads[r]);
+  metrics.upload.record(us);
+}
+
+// ====== SALIDA EN TEXTO ======
+struct PromWriter {
+  MetricsOut out;
+  void* ctx;
+  char buf[1024];
+  size_t len;
+
+  void flush() {
+    if (len) out(buf, len, ctx);
+    len = 0;
+  }
+
+  void printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+    for (int attempt = 0; attempt < 2; attempt++) {
+      va_list args;
+      va_start(args, fmt);
+      int n = vsnprintf(buf + len, sizeof(buf) - len, fmt, args);
+      va_end(args);
+      if (n >= 0 && (size_t)n < sizeof(buf) - len) {
+        len += n;
+        return;
+      }
+      flush();  // no cabía: se vacía y se reintenta una vez
+    }
+  }
+
+  void header(const char* name, const char* type, const char* help) {
+    printf("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+  }
+
+  // Solo se publican los límites de 16 µs a 16 s (cada 4x) para no inflar la
+  // respuesta; los intervalos finos se van sumando en el acumulado.
+  void histogram(const char* name, const char* labels, const MetricsHistogram& h) {
+    uint32_t cumulative = 0;
+    for (uint8_t i = 0; i < METRICS_HIST_BUCKETS; i++) {
+      cumulative += h.buckets[i].load(std::memory_order_relaxed);
+      if (i >= 4 && i <= 24 && i % 2 == 0) {
+        printf("%s_bucket{%s%sle=\"%g\"} %u\n", name, labels, *labels ? "," : "", (1UL << i) / 1e6,
+               (unsigned)cumulative);
+      }
+    }
+    const char* sep = *labels ? "{" : "";
+    const char* end = *labels ? "}" : "";
+    printf("%s_bucket{%s%sle=\"+Inf\"} %u\n", name, labels, *labels ? "," : "", (unsigned)cumulative);
+    printf("%s_sum%s%s%s %.6f\n", name, sep, labels, end, h.sumUs / 1e6);
+    printf("%s_count%s%s%s %u\n", name, sep, labels, end, (unsigned)h.count.load(std::memory_order_relaxed));
+  }
+
+  // Límite superior (en s) del intervalo log2 donde cae el percentil.
+  static double percentile(const MetricsHistogram& h, double q) {
+    uint32_t count = h.count.load(std::memory_order_relaxed), cumulative = 0;
+    for (uint8_t i = 0; i < METRICS_HIST_BUCKETS && count; i++) {
+      cumulative += h.buckets[i].load(std::memory_order_relaxed);
+      if (cumulative >= q * count) return (1UL << i) / 1e6;
+    }
+    return 0;
+  }
+
+  void gauge(const char* name, const char* help, double value) {
+    header(name, "gauge", help);
+    printf("%s %.10g\n", name, value);
+  }
+
+  void counter(const char* name, const char* help, const std::atomic<uint32_t>& c) {
+    header(name, "counter", help);
+    printf("%s %u\n", name, (unsigned)c.load(std::memory_order_relaxed));
+  }
+};
+
+void metricsWrite(MetricsOut out, void* ctx) {
+  static PromWriter w;
+  w.out = out;
+  w.ctx = ctx;
+  w.len = 0;
+
+  w.header("esp32_loop_period_seconds", "histogram", "Tiempo entre dos vueltas de loop()");
+  w.histogram("esp32_loop_period_seconds", "", metrics.loopPeriod);
+  w.header("esp32_http_handle_client_seconds", "histogram", "server.handleClient() con alguna petición atendida");
+  w.histogram("esp32_http_handle_client_seconds", "", metrics.handleClient);
+
+  w.header("esp32_http_route_seconds", "histogram", "Tiempo del handler por ruta");
+  for (uint8_t i = 0; i < routeCount; i++) {
+    char labels[48];
+    snprintf(labels, sizeof(labels), "route=\"%s\"", routeNames[i]);
+    w.histogram("esp32_http_route_seconds", labels, metrics.routes[i]);
+  }
+
+  HttpServerStats http = httpServerStats();
+  w.gauge("esp32_http_connections", "Conexiones HTTP abiertas", http.active);
+  w.header("esp32_http_requests_total", "counter", "Peticiones HTTP atendidas");
+  w.printf("esp32_http_requests_total %u\n", (unsigned)http.requests);
+  w.header("esp32_http_keepalive_reused_total", "counter", "Peticiones que reutilizaron una conexión");
+  w.printf("esp32_http_keepalive_reused_total %u\n", (unsigned)http.reused);
+  w.header("esp32_http_timeouts_total", "counter", "Conexiones cerradas por inactividad");
+  w.printf("esp32_http_timeouts_total %u\n", (unsigned)http.timeouts);
+  w.header("esp32_http_rejected_total", "counter", "Peticiones rechazadas (400/413)");
+  w.printf("esp32_http_rejected_total %u\n", (unsigned)http.rejected);
+
+  w.header("esp32_upload_seconds", "histogram", "Duración de los POST a Google Sheets");
+  w.histogram("esp32_upload_seconds", "", metrics.upload);
+  static const char* const results[UPLOAD_RESULTS] = {"2xx", "3xx", "4xx", "5xx", "error"};
+  w.header("esp32_upload_responses_total", "counter", "Respuestas de Google Sheets por clase");
+  for (uint8_t i = 0; i < UPLOAD_RESULTS; i++) {
+    w.printf("esp32_upload_responses_total{code=\"%s\"} %u\n", results[i],
+             (unsigned)metrics.uploads[i].load(std::memory_order_relaxed));
+  }
+  UploaderStats up = uploaderStats();
+  w.gauge("esp32_upload_pending", "Registros en el outbox sin subir", up.pending);
+  w.gauge("esp32_upload_queue_depth", "Entradas en la cola del uploader", up.depth);
+
+  w.header("esp32_sensor_jitter_seconds", "histogram", "Retraso de cada lectura sobre su turno");
+  w.histogram("esp32_sensor_jitter_seconds", "", metrics.sensorJitter);
+  SensorJitter j = sensorJitter();
+  w.gauge("esp32_sensor_jitter_max_seconds", "Mayor retraso de una lectura desde el arranque", j.maxUs / 1e6);
+  w.gauge("esp32_sensor_read_seconds", "Duración de la última lectura de un sensor", j.readUs / 1e6);
+  w.header("esp32_sensor_reads_total", "counter", "Lecturas por sensor");
+  for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+    w.printf("esp32_sensor_reads_total{sensor=\"%s\"} %u\n", sensorId(i),
+             (unsigned)metrics.sensorReads[i].load(std::memory_order_relaxed));
+  }
+  w.header("esp32_sensor_read_errors_total", "counter", "Lecturas fallidas por sensor");
+  for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+    w.printf("esp32_sensor_read_errors_total{sensor=\"%s\"} %u\n", sensorId(i),
+             (unsigned)metrics.sensorErrors[i].load(std::memory_order_relaxed));
+  }
+  w.header("esp32_sensor_skipped_total", "counter", "Muestras sustituidas por la siguiente antes de que loop() las viera");
+  for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+    w.printf("esp32_sensor_skipped_total{sensor=\"%s\"} %u\n", sensorId(i),
+             (unsigned)metrics.sensorSkipped[i].load(std::memory_order_relaxed));
+  }
+
+  w.header("esp32_control_latency_seconds", "histogram", "De la lectura del sensor a la decisión del control");
+  w.histogram("esp32_control_latency_seconds", "", metrics.controlLatency);
+  w.header("esp32_control_jitter_seconds", "histogram", "Retraso de cada ciclo del control sobre su turno");
+  w.histogram("esp32_control_jitter_seconds", "", metrics.controlJitter);
+  ControlStatus c = controlStatus();
+  w.gauge("esp32_control_setpoint", "Consigna actual", c.setpoint);
+  w.gauge("esp32_control_duty", "Salida del controlador (0..1)", c.duty);
+  w.gauge("esp32_actuator_on", "1 con el actuador encendido", c.output ? 1 : 0);
+  w.gauge("esp32_actuator_manual", "1 mientras está forzado a mano", c.manual ? 1 : 0);
+  w.header("esp32_actuator_switches_total", "counter", "Cambios del actuador desde el arranque");
+  w.printf("esp32_actuator_switches_total %u\n", (unsigned)c.switches);
+
+  w.header("esp32_alert_active", "gauge", "1 mientras la regla está saltada");
+  for (uint8_t i = 0; i < alertsCount(); i++) {
+    w.printf("esp32_alert_active{rule=\"%s\"} %u\n", alertsRule(i).id, alertsStatus(i).active ? 1u : 0u);
+  }
+  w.header("esp32_alerts_raised_total", "counter", "Veces que ha saltado cada regla");
+  for (uint8_t i = 0; i < alertsCount(); i++) {
+    w.printf("esp32_alerts_raised_total{rule=\"%s\"} %u\n", alertsRule(i).id, (unsigned)alertsStatus(i).raised);
+  }
+  w.header("esp32_alerts_suppressed_total", "counter", "Saltos sin aviso por estar en cooldown");
+  for (uint8_t i = 0; i < alertsCount(); i++) {
+    w.printf("esp32_alerts_suppressed_total{rule=\"%s\"} %u\n", alertsRule(i).id,
+             (unsigned)alertsStatus(i).suppressed);
+  }
+
+  HistoryWriteStats hw = historyWriteStats();
+  w.header("esp32_history_append_seconds", "histogram", "Guardar una muestra en el histórico");
+  w.histogram("esp32_history_append_seconds", "", metrics.historyAppend);
+  w.gauge("esp32_history_append_p99_seconds", "p99 de guardar una muestra (cota del intervalo log2)",
+          PromWriter::percentile(metrics.historyAppend, 0.99));
+  w.gauge("esp32_history_pending", "Muestras en RAM/RTC sin confirmar en flash", hw.pending);
+  w.header("esp32_history_commits_total", "counter", "Grupos de muestras confirmados en flash");
+  w.printf("esp32_history_commits_total %u\n", (unsigned)hw.commits);
+  w.gauge("esp32_history_recovered", "Muestras recuperadas de la memoria RTC al arrancar", hw.recovered);
+  w.header("esp32_history_flash_writes_total", "counter", "Escrituras en el fichero del histórico");
+  w.printf("esp32_history_flash_writes_total %u\n", (unsigned)hw.flashWrites);
+  w.header("esp32_history_flash_programs_total", "counter", "Páginas de flash escritas por el histórico");
+  w.printf("esp32_history_flash_programs_total %u\n", (unsigned)hw.flashPrograms);
+  uint32_t uptimeS = max<uint32_t>(millis() / 1000, 1);
+  w.gauge("esp32_history_flash_programs_per_hour", "Páginas de flash escritas por hora desde el arranque",
+          hw.flashPrograms * 3600.0 / uptimeS);
+
+  ReducerStats rs = reducerStats();
+  w.header("esp32_reducer_samples_total", "counter", "Lecturas que llegan a la reducción y cuáles se guardan");
+  w.printf("esp32_reducer_samples_total{result=\"offered\"} %u\n", (unsigned)rs.offered);
+  w.printf("esp32_reducer_samples_total{result=\"baseline\"} %u\n", (unsigned)rs.baseline);
+  for (uint8_t tag = 0; tag < 4; tag++) {
+    w.printf("esp32_reducer_samples_total{result=\"%s\"} %u\n", historyTagName(tag), (unsigned)rs.kept[tag]);
+  }
+  w.gauge("esp32_reducer_ratio", "Muestras del intervalo fijo por cada una guardada", reducerRatio(rs));
+  w.header("esp32_reducer_fast_total", "counter", "Veces que se subió el ritmo por un cambio rápido");
+  w.printf("esp32_reducer_fast_total %u\n", (unsigned)rs.fastModes);
+
+  w.gauge("esp32_heap_free_bytes", "Heap libre", ESP.getFreeHeap());
+  w.gauge("esp32_heap_min_free_bytes", "Mínimo de heap libre desde el arranque", ESP.getMinFreeHeap());
+  w.gauge("esp32_heap_largest_free_block_bytes", "Mayor bloque de heap libre", ESP.getMaxAllocHeap());
+  w.gauge("esp32_fs_used_bytes", "Sistema de archivos usado", storageUsedBytes());
+  w.gauge("esp32_fs_total_bytes", "Sistema de archivos total", storageTotalBytes());
+  w.header("esp32_storage_info", "gauge", "Backend de almacenamiento de los anillos");
+  w.printf("esp32_storage_info{backend=\"%s\"} 1\n", storageName());
+#if STORAGE_BACKEND == STORAGE_RAW
+  PartitionStats ps = partitionStats();
+  w.gauge("esp32_partition_used_bytes", "Partición de anillos asignada", ps.usedBytes);
+  w.gauge("esp32_partition_total_bytes", "Partición de anillos total", ps.totalBytes);
+  w.header("esp32_partition_erases_total", "counter", "Sectores borrados desde el arranque");
+  w.printf("esp32_partition_erases_total %u\n", (unsigned)ps.erases);
+#endif
+  w.gauge("esp32_wifi_rssi_dbm", "RSSI del WiFi", WiFi.RSSI());
+  w.gauge("esp32_uptime_seconds", "Segundos desde el arranque", millis() / 1000);
+  w.header("esp32_boot_stage_seconds", "gauge", "Del encendido a cada etapa del arranque");
+  for (uint8_t i = 0; i < BOOT_STAGES; i++) {
+    uint32_t ms = bootStageMs((BootStage)i);
+    if (ms) w.printf("esp32_boot_stage_seconds{stage=\"%s\"} %.3f\n", bootStageName((BootStage)i), ms / 1000.0);
+  }
+  w.gauge("esp32_boot_wifi_cached", "1 si la WiFi conectó con el BSSID y canal de la caché", bootFastConnect() ? 1 : 0);
+  w.flush();
+}
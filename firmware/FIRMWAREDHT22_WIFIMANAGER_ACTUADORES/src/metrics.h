@@ -0,0 +1,58 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "sensors.h"
+
+// ====== MÉTRICAS (PROMETHEUS) ======
+// Contadores e histogramas de coste fijo: registrar un evento es un
+// fetch_add relajado (y un __builtin_clz para los histogramas), sin heap ni
+// locks, así que se puede llamar desde loop() y desde la tarea del uploader.
+// /api/metrics las vuelca en formato de texto de Prometheus.
+
+#define METRICS_MAX_ROUTES 16
+#define METRICS_HIST_BUCKETS 32  // intervalos log2 en µs: (2^(i-1), 2^i]
+
+// Cada histograma tiene un solo escritor (loop() o una de las tareas):
+// la suma de 64 bits no es atómica en el ESP32 y no hace falta que lo sea.
+struct MetricsHistogram {
+  std::atomic<uint32_t> buckets[METRICS_HIST_BUCKETS];
+  std::atomic<uint32_t> count;
+  uint64_t sumUs;
+
+  void record(uint32_t us) {
+    uint8_t i = us <= 1 ? 0 : 32 - __builtin_clz(us - 1);
+    buckets[i < METRICS_HIST_BUCKETS ? i : METRICS_HIST_BUCKETS - 1].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sumUs += us;
+  }
+};
+
+enum UploadResult : uint8_t { UPLOAD_2XX, UPLOAD_3XX, UPLOAD_4XX, UPLOAD_5XX, UPLOAD_ERROR, UPLOAD_RESULTS };
+
+struct Metrics {
+  MetricsHistogram loopPeriod;     // entre dos vueltas de loop()
+  MetricsHistogram handleClient;   // server.handleClient() que atendió una petición
+  MetricsHistogram upload;         // POST a Google Sheets
+  MetricsHistogram sensorJitter;   // retraso de cada lectura sobre su periodo
+  MetricsHistogram controlLatency; // de la lectura del sensor a la decisión del control
+  MetricsHistogram controlJitter;  // retraso de cada ciclo del control sobre su periodo
+  MetricsHistogram historyAppend;  // guardar una muestra en el histórico (con su commit si toca)
+  MetricsHistogram routes[METRICS_MAX_ROUTES];
+  std::atomic<uint32_t> uploads[UPLOAD_RESULTS];
+  std::atomic<uint32_t> sensorReads[SENSOR_COUNT];
+  std::atomic<uint32_t> sensorErrors[SENSOR_COUNT];
+  std::atomic<uint32_t> sensorSkipped[SENSOR_COUNT];  // muestras que loop() no llegó a ver
+};
+
+extern Metrics metrics;
+
+inline void metricsInc(std::atomic<uint32_t>& c) { c.fetch_add(1, std::memory_order_relaxed); }
+
+// Da de alta una ruta (en setup(), no es para el camino caliente) y devuelve
+// su índice en metrics.routes; las que no caben comparten la última.
+uint8_t metricsRoute(const char* name);
+void metricsUpload(int httpCode, uint32_t us);
+
+// Vuelca todo en formato Prometheus por trozos a través de `out`.
+typedef void (*MetricsOut)(const char* data, size_t len, void* ctx);
+void metricsWrite(MetricsOut out, void* ctx);
@@ -0,0 +1,525 @@
+#include "partition_ring.h"
+#include "crc32.h"
+#include <stddef.h>
+
+static const uint32_t PARTITION_MAGIC = 0x4E545250;  // "PRTN"
+static const uint32_t PARTITION_VERSION = 1;
+static const uint32_t ERASED = 0xFFFFFFFF;
+static const uint32_t DIR_SECTOR = 0;
+static const uint32_t JOURNAL_FIRST = 1;
+static const uint32_t DATA_FIRST = JOURNAL_FIRST + PARTITION_JOURNAL_SECTORS;
+
+// Cabecera del directorio. `salt` cambia en cada formateo y entra en todos
+// los CRC: lo que quede de antes en los sectores de datos ya no es válido.
+struct DirHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t salt;
+  uint32_t crc;
+};
+
+struct DirEntry {
+  char name[16];
+  uint16_t recordSize;
+  uint16_t sectors;
+  uint32_t capacity;
+  uint32_t firstSector;
+  uint32_t crc;
+};
+
+enum JournalKind : uint8_t {
+  JOURNAL_HEAD = 1,  // value = head tras un consume()
+  JOURNAL_TAIL = 2,  // value = seq del hueco de tail(); le siguen len bytes
+};
+
+struct JournalEntry {
+  uint32_t gen;  // orden global de las entradas
+  uint8_t ring;
+  uint8_t kind;
+  uint16_t len;
+  uint32_t value;
+  uint32_t crc;
+};
+
+struct SlotHeader {
+  uint32_t seq;
+  uint32_t crc;
+};
+
+// Última entrada del diario de cada anillo
+struct JournalLatest {
+  uint32_t gen;
+  uint32_t value;
+  uint32_t offset;  // de los datos (solo JOURNAL_TAIL)
+  uint16_t len;
+};
+
+static const esp_partition_t* part = nullptr;
+static SemaphoreHandle_t lock = nullptr;
+static uint32_t salt = 0;
+static DirEntry dir[PARTITION_MAX_RINGS];
+static uint32_t dirCount = 0;
+static uint32_t nextSector = DATA_FIRST;
+static PartitionRing* rings[PARTITION_MAX_RINGS];
+static JournalLatest latestHead[PARTITION_MAX_RINGS];
+static JournalLatest latestTail[PARTITION_MAX_RINGS];
+static uint32_t journalSector = 0;  // 0..PARTITION_JOURNAL_SECTORS-1
+static uint32_t journalOffset = 0;
+static uint32_t journalGen = 1;
+static uint32_t totalErases = 0;
+static uint32_t totalPrograms = 0;
+
+static uint32_t align4(uint32_t n) { return (n + 3) & ~3u; }
+
+static uint32_t pagesOf(uint32_t offset, uint32_t len) {
+  return (offset + len - 1) / PARTITION_PAGE - offset / PARTITION_PAGE + 1;
+}
+
+// ====== ACCESO AL FLASH ======
+static bool flashRead(uint32_t offset, void* data, uint32_t len) {
+  return esp_partition_read(part, offset, data, len) == ESP_OK;
+}
+
+static bool flashWrite(uint32_t offset, const void* data, uint32_t len) {
+  totalPrograms += pagesOf(offset, len);
+  return esp_partition_write(part, offset, data, len) == ESP_OK;
+}
+
+static bool flashErase(uint32_t sector) {
+  totalErases++;
+  return esp_partition_erase_range(part, sector * PARTITION_SECTOR, PARTITION_SECTOR) == ESP_OK;
+}
+
+// CRC de `len` bytes del flash, leídos por trozos para no necesitar un búfer
+// del tamaño del registro.
+static bool flashCrc(uint32_t offset, uint32_t len, uint32_t& crc) {
+  uint8_t piece[64];
+  for (uint32_t done = 0; done < len;) {
+    uint32_t n = min<uint32_t>(sizeof(piece), len - done);
+    if (!flashRead(offset + done, piece, n)) return false;
+    crc = crc32Update(crc, piece, n);
+    done += n;
+  }
+  return true;
+}
+
+static uint32_t saltedCrc(const void* data, uint32_t len) {
+  return crc32Update(crc32(&salt, sizeof(salt)), data, len);
+}
+
+// ====== DIARIO ======
+static uint32_t journalBase() { return (JOURNAL_FIRST + journalSector) * PARTITION_SECTOR; }
+
+static uint32_t entrySize(uint16_t len) { return sizeof(JournalEntry) + align4(len); }
+
+static bool journalWrite(uint8_t ring, JournalKind kind, uint32_t value, const void* data, uint16_t len) {
+  if (journalOffset + entrySize(len) > PARTITION_SECTOR) return false;
+  JournalEntry e = {journalGen, ring, (uint8_t)kind, len, value, 0};
+  e.crc = crc32Update(saltedCrc(&e, offsetof(JournalEntry, crc)), data, len);
+  uint32_t at = journalBase() + journalOffset;
+  // Los datos antes que la cabecera: sin cabecera completa no hay entrada
+  bool ok = !len || flashWrite(at + sizeof(e), data, len);
+  ok = ok && flashWrite(at, &e, sizeof(e));
+  journalOffset += entrySize(len);
+  if (!ok) return false;
+  JournalLatest& l = kind == JOURNAL_HEAD ? latestHead[ring] : latestTail[ring];
+  l = {journalGen, value, at + (uint32_t)sizeof(e), len};
+  journalGen++;
+  return true;
+}
+
+// Pasa al siguiente sector del diario (el más antiguo) y copia en él el
+// último estado de cada anillo abierto, así el sector nuevo basta por sí solo
+// y el siguiente giro puede borrar el anterior.
+bool journalRotate() {
+  journalSector = (journalSector + 1) % PARTITION_JOURNAL_SECTORS;
+  journalOffset = 0;
+  if (!flashErase(JOURNAL_FIRST + journalSector)) return false;
+  for (uint8_t id = 0; id < PARTITION_MAX_RINGS; id++) {
+    PartitionRing* r = rings[id];
+    if (!r) continue;
+    journalWrite(id, JOURNAL_HEAD, r->head_, nullptr, 0);
+    if (r->tailBuf_ && r->tailUsed_) journalWrite(id, JOURNAL_TAIL, r->tailSeq_, r->tailBuf_, r->tailUsed_);
+  }
+  return true;
+}
+
+static bool journalAppend(uint8_t ring, JournalKind kind, uint32_t value, const void* data, uint16_t len) {
+  if (journalOffset + entrySize(len) > PARTITION_SECTOR && !journalRotate()) return false;
+  return journalWrite(ring, kind, value, data, len);
+}
+
+// Recorre los sectores del diario quedándose con la última entrada de cada
+// anillo. Se sigue escribiendo en el sector con la entrada más reciente; si
+// acaba en una entrada a medias, se pasa al siguiente en la próxima escritura.
+static void journalLoad() {
+  memset(latestHead, 0, sizeof(latestHead));
+  memset(latestTail, 0, sizeof(latestTail));
+  uint32_t newest = 0;
+  journalSector = 0;
+  journalOffset = 0;
+  for (uint32_t s = 0; s < PARTITION_JOURNAL_SECTORS; s++) {
+    uint32_t base = (JOURNAL_FIRST + s) * PARTITION_SECTOR;
+    uint32_t offset = 0, lastGen = 0;
+    bool torn = false;
+    while (offset + sizeof(JournalEntry) <= PARTITION_SECTOR) {
+      JournalEntry e;
+      if (!flashRead(base + offset, &e, sizeof(e)) || e.gen == ERASED) break;
+      uint32_t crc = saltedCrc(&e, offsetof(JournalEntry, crc));
+      if (offset + entrySize(e.len) > PARTITION_SECTOR || e.ring >= PARTITION_MAX_RINGS ||
+          !flashCrc(base + offset + sizeof(e), e.len, crc) || crc != e.crc) {
+        torn = true;
+        break;
+      }
+      JournalLatest& l = e.kind == JOURNAL_HEAD ? latestHead[e.ring] : latestTail[e.ring];
+      if (e.gen > l.gen) l = {e.gen, e.value, base + offset + (uint32_t)sizeof(e), e.len};
+      lastGen = e.gen;
+      offset += entrySize(e.len);
+    }
+    if (lastGen > newest || (!newest && !s)) {
+      if (lastGen > newest) newest = lastGen;
+      journalSector = s;
+      journalOffset = torn ? PARTITION_SECTOR : offset;
+    }
+  }
+  journalGen = newest + 1;
+}
+
+// ====== DIRECTORIO ======
+static bool dirEntryValid(const DirEntry& d) {
+  return d.crc == saltedCrc(&d, offsetof(DirEntry, crc)) && d.sectors && d.recordSize;
+}
+
+static bool format() {
+  DirHeader old;
+  uint32_t previous = flashRead(0, &old, sizeof(old)) ? old.salt : 0;
+  for (uint32_t s = DIR_SECTOR; s < DATA_FIRST; s++) {
+    if (!flashErase(s)) return false;
+  }
+  do {
+    salt = esp_random();
+  } while (salt == previous);
+  DirHeader h = {PARTITION_MAGIC, PARTITION_VERSION, salt, 0};
+  h.crc = crc32(&h, offsetof(DirHeader, crc));
+  if (!flashWrite(0, &h, sizeof(h))) return false;
+  dirCount = 0;
+  nextSector = DATA_FIRST;
+  memset(rings, 0, sizeof(rings));
+  journalLoad();
+  return true;
+}
+
+static bool dirLoad() {
+  DirHeader h;
+  if (!flashRead(0, &h, sizeof(h))) return false;
+  if (h.magic != PARTITION_MAGIC || h.version != PARTITION_VERSION ||
+      h.crc != crc32(&h, offsetof(DirHeader, crc))) {
+    Serial.println(F("[Partición] Sin formato, inicializando " PARTITION_LABEL));
+    return format();
+  }
+  salt = h.salt;
+  dirCount = 0;
+  nextSector = DATA_FIRST;
+  while (dirCount < PARTITION_MAX_RINGS) {
+    DirEntry& d = dir[dirCount];
+    if (!flashRead(sizeof(h) + dirCount * sizeof(DirEntry), &d, sizeof(d)) || !dirEntryValid(d)) break;
+    nextSector = max(nextSector, d.firstSector + d.sectors);
+    dirCount++;
+  }
+  journalLoad();
+  return true;
+}
+
+// Última entrada con ese nombre; si no coincide la geometría se añade otra.
+static int dirFind(const char* name, uint16_t recordSize, uint32_t capacity, uint16_t sectors) {
+  int found = -1;
+  for (uint32_t i = 0; i < dirCount; i++) {
+    if (!strncmp(dir[i].name, name, sizeof(dir[i].name) - 1)) found = i;
+  }
+  if (found >= 0 && dir[found].recordSize == recordSize && dir[found].capacity == capacity) return found;
+  if (dirCount >= PARTITION_MAX_RINGS || nextSector + sectors > part->size / PARTITION_SECTOR) {
+    Serial.printf("[Partición] Sin espacio para %s (%u sectores); borrar la partición\n", name, (unsigned)sectors);
+    return -1;
+  }
+  DirEntry& d = dir[dirCount];
+  memset(&d, 0, sizeof(d));
+  strncpy(d.name, name, sizeof(d.name) - 1);
+  d.recordSize = recordSize;
+  d.sectors = sectors;
+  d.capacity = capacity;
+  d.firstSector = nextSector;
+  d.crc = saltedCrc(&d, offsetof(DirEntry, crc));
+  if (!flashWrite(sizeof(DirHeader) + dirCount * sizeof(DirEntry), &d, sizeof(d))) return -1;
+  Serial.printf("[Partición] %s%s: %u sectores desde el %u\n", name, found >= 0 ? " (geometría nueva, vacío)" : "",
+                (unsigned)sectors, (unsigned)d.firstSector);
+  nextSector += sectors;
+  return dirCount++;
+}
+
+bool partitionBegin() {
+  if (part) return true;
+  part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, PARTITION_LABEL);
+  if (!part) {
+    Serial.println(F("[Partición] No existe \"" PARTITION_LABEL "\" (partitions_logs.csv)"));
+    return false;
+  }
+  lock = xSemaphoreCreateMutex();
+  if (!dirLoad()) {
+    part = nullptr;
+    return false;
+  }
+  return true;
+}
+
+bool partitionFormat() {
+  if (!partitionBegin()) return false;
+  xSemaphoreTake(lock, portMAX_DELAY);
+  bool ok = format();
+  xSemaphoreGive(lock);
+  return ok;
+}
+
+PartitionStats partitionStats() {
+  PartitionStats s = {};
+  if (!part) return s;
+  s.totalBytes = part->size;
+  s.usedBytes = nextSector * PARTITION_SECTOR;
+  s.erases = totalErases;
+  s.programs = totalPrograms;
+  return s;
+}
+
+// ====== ANILLO ======
+PartitionRing::PartitionRing(const char* name, uint16_t recordSize, uint32_t capacity)
+    : name_(name), recordSize_(recordSize), capacity_(capacity) {
+  slotSize_ = align4(sizeof(SlotHeader) + recordSize);
+  perSector_ = PARTITION_SECTOR / slotSize_;
+  sectors_ = (capacity + perSector_ - 1) / perSector_ + 1;
+}
+
+PartitionRing::~PartitionRing() {
+  if (ready_ && rings[id_] == this) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    rings[id_] = nullptr;
+    xSemaphoreGive(lock);
+  }
+  free(tailBuf_);
+}
+
+// El registro seq va en el hueco seq % perSector_ de su sector, así cada
+// sector guarda un tramo seguido de seqs que empieza en un múltiplo de
+// perSector_.
+uint32_t PartitionRing::offsetOf(uint32_t seq) const {
+  uint32_t sector = firstSector_ + (seq / perSector_) % sectors_;
+  return sector * PARTITION_SECTOR + (seq % perSector_) * slotSize_;
+}
+
+bool PartitionRing::write(uint32_t offset, const void* data, uint32_t len) {
+  writes_++;
+  programs_ += pagesOf(offset, len);
+  return flashWrite(offset, data, len);
+}
+
+bool PartitionRing::slotValid(uint32_t offset, uint32_t seq) {
+  SlotHeader h;
+  if (!flashRead(offset, &h, sizeof(h)) || h.seq != seq) return false;
+  uint32_t crc = saltedCrc(&h.seq, sizeof(h.seq));
+  return flashCrc(offset + sizeof(h), recordSize_, crc) && crc == h.crc;
+}
+
+bool PartitionRing::slotErased(uint32_t offset) {
+  uint32_t words[16];
+  for (uint32_t done = 0; done < slotSize_;) {
+    uint32_t n = min<uint32_t>(sizeof(words), slotSize_ - done);
+    if (!flashRead(offset + done, words, n)) return false;
+    for (uint32_t i = 0; i < n / 4; i++) {
+      if (words[i] != ERASED) return false;
+    }
+    done += n;
+  }
+  return true;
+}
+
+bool PartitionRing::readSlot(uint32_t seq, void* record) {
+  uint32_t offset = offsetOf(seq);
+  SlotHeader h;
+  if (!flashRead(offset, &h, sizeof(h)) || h.seq != seq) return false;
+  if (!flashRead(offset + sizeof(h), record, recordSize_)) return false;
+  return h.crc == crc32Update(saltedCrc(&h.seq, sizeof(h.seq)), record, recordSize_);
+}
+
+// Primero los datos y después {seq, CRC}: un corte a medias deja el hueco
+// sin cabecera válida.
+bool PartitionRing::writeSlot(uint32_t seq, const void* record) {
+  uint32_t offset = offsetOf(seq);
+  SlotHeader h = {seq, crc32Update(saltedCrc(&seq, sizeof(seq)), record, recordSize_)};
+  bool ok = write(offset + sizeof(h), record, recordSize_);
+  return write(offset, &h, sizeof(h)) && ok;
+}
+
+bool PartitionRing::eraseSector(uint32_t sector) {
+  erases_++;
+  return flashErase(firstSector_ + sector);
+}
+
+// head/tail a partir de los datos: el sector cuyo primer hueco tiene el seq
+// más alto es el que se estaba llenando, y dentro de él tail va hasta el
+// primer hueco no válido. Lo más antiguo que queda es el primer seq del resto
+// de sectores, limitado por capacity y por la última marca de consume().
+void PartitionRing::recover() {
+  bool any = false;
+  uint32_t oldest = 0, newest = 0;
+  for (uint32_t s = 0; s < sectors_; s++) {
+    SlotHeader h;
+    uint32_t offset = (firstSector_ + s) * PARTITION_SECTOR;
+    if (!flashRead(offset, &h, sizeof(h)) || h.seq == ERASED) continue;
+    if (h.seq % perSector_ || (h.seq / perSector_) % sectors_ != s || !slotValid(offset, h.seq)) continue;
+    if (!any || h.seq < oldest) oldest = h.seq;
+    if (!any || h.seq > newest) newest = h.seq;
+    any = true;
+  }
+  const JournalLatest& mark = latestHead[id_];
+  if (!any) {
+    head_ = tail_ = mark.gen ? mark.value : 0;
+  } else {
+    tail_ = newest + 1;
+    while (tail_ % perSector_ && slotValid(offsetOf(tail_), tail_)) tail_++;
+    head_ = max(oldest, tail_ - min(tail_, capacity_));
+    if (mark.gen) head_ = constrain(mark.value, head_, tail_);
+  }
+  // Hueco siguiente a medio escribir (corte en un append): hay que borrarlo
+  if (tail_ % perSector_ && !slotErased(offsetOf(tail_))) repairSector();
+
+  const JournalLatest& snap = latestTail[id_];
+  if (snap.gen && snap.value == tail_ && snap.len <= recordSize_) {
+    tailBuf_ = (uint8_t*)malloc(recordSize_);
+    if (tailBuf_) {
+      memset(tailBuf_, 0, recordSize_);
+      flashRead(snap.offset, tailBuf_, snap.len);
+      tailUsed_ = snap.len;
+      tailSeq_ = tail_;
+    }
+  }
+}
+
+// Rehace el sector de tail() sin el hueco estropeado: copia los registros
+// válidos a RAM, borra y los vuelve a escribir.
+void PartitionRing::repairSector() {
+  uint32_t first = tail_ - tail_ % perSector_;
+  uint32_t count = tail_ - first;
+  uint8_t* copy = (uint8_t*)malloc(count * recordSize_);
+  uint32_t kept = 0;
+  if (copy) {
+    while (kept < count && readSlot(first + kept, copy + kept * recordSize_)) kept++;
+  }
+  eraseSector((first / perSector_) % sectors_);
+  for (uint32_t i = 0; i < kept; i++) writeSlot(first + i, copy + i * recordSize_);
+  free(copy);
+  tail_ = first + kept;
+  head_ = min(head_, tail_);
+  Serial.printf("[Partición] %s: sector reparado tras un corte (%u registros)\n", name_, (unsigned)kept);
+}
+
+bool PartitionRing::begin() {
+  if (ready_) return true;
+  if (!partitionBegin()) return false;
+  xSemaphoreTake(lock, portMAX_DELAY);
+  int id = perSector_ && sectors_ <= UINT16_MAX ? dirFind(name_, recordSize_, capacity_, sectors_) : -1;
+  if (id >= 0) {
+    id_ = id;
+    firstSector_ = dir[id].firstSector;
+    rings[id] = this;
+    recover();
+    ready_ = true;
+  }
+  xSemaphoreGive(lock);
+  return ready_;
+}
+
+// Al empezar un sector se borra entero: lo que hubiera son seqs anteriores a
+// tail - (sectors_ - 1) * perSector_, que ya están fuera de capacity.
+bool PartitionRing::append(const void* record, bool) {
+  if (!ready_) return false;
+  if (tail_ % perSector_ == 0 && !eraseSector((tail_ / perSector_) % sectors_)) return false;
+  if (!writeSlot(tail_, record)) return false;
+  tail_++;
+  if (tail_ - head_ > capacity_) {
+    head_ = tail_ - capacity_;
+    overwritten_++;
+  }
+  return true;
+}
+
+bool PartitionRing::read(uint32_t seq, void* record) {
+  if (!ready_ || seq - head_ >= size()) return false;
+  return readSlot(seq, record);
+}
+
+uint32_t PartitionRing::readBlock(uint32_t seq, void* records, uint32_t maxRecords) {
+  if (!ready_ || seq - head_ >= size()) return 0;
+  uint32_t n = min(maxRecords, tail_ - seq);
+  uint32_t got = 0;
+  while (got < n && readSlot(seq + got, (uint8_t*)records + got * recordSize_)) got++;
+  return got;
+}
+
+uint32_t PartitionRing::lowerBound(uint32_t t) {
+  uint32_t lo = head_, hi = tail_;
+  while (lo != hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    uint32_t ts;
+    if (!flashRead(offsetOf(mid) + sizeof(SlotHeader), &ts, sizeof(ts))) break;
+    if (ts < t) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
+}
+
+bool PartitionRing::writeTail(uint32_t offset, const void* data, uint32_t len) {
+  if (!ready_ || !len || offset + len > recordSize_) return false;
+  if (!tailBuf_) tailBuf_ = (uint8_t*)malloc(recordSize_);
+  if (!tailBuf_) return false;
+  // Bajo el cerrojo: journalRotate() la puede copiar desde otra tarea
+  xSemaphoreTake(lock, portMAX_DELAY);
+  if (tailSeq_ != tail_) {
+    memset(tailBuf_, 0, recordSize_);
+    tailUsed_ = 0;
+    tailSeq_ = tail_;
+  }
+  memcpy(tailBuf_ + offset, data, len);
+  tailUsed_ = max(tailUsed_, offset + len);
+  xSemaphoreGive(lock);
+  return true;
+}
+
+bool PartitionRing::syncTail() {
+  if (!ready_) return false;
+  if (!tailBuf_ || tailSeq_ != tail_ || !tailUsed_) return true;
+  xSemaphoreTake(lock, portMAX_DELAY);
+  uint32_t programs = totalPrograms;
+  bool ok = journalAppend(id_, JOURNAL_TAIL, tail_, tailBuf_, tailUsed_);
+  writes_++;
+  programs_ += totalPrograms - programs;
+  xSemaphoreGive(lock);
+  return ok;
+}
+
+bool PartitionRing::readTail(void* record) {
+  if (!ready_ || !tailBuf_ || tailSeq_ != tail_) return false;
+  memcpy(record, tailBuf_, recordSize_);
+  return true;
+}
+
+bool PartitionRing::consume(uint32_t count) {
+  if (!ready_) return false;
+  head_ += min(count, size());
+  xSemaphoreTake(lock, portMAX_DELAY);
+  uint32_t programs = totalPrograms;
+  bool ok = journalAppend(id_, JOURNAL_HEAD, head_, nullptr, 0);
+  writes_++;
+  programs_ += totalPrograms - programs;
+  xSemaphoreGive(lock);
+  return ok;
+}
+
+bool PartitionRing::clear() { return consume(size()); }
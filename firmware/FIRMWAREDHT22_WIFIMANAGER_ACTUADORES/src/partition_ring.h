@@ -0,0 +1,107 @@
+#pragma once
+#include <Arduino.h>
+#include <esp_partition.h>
+
+// ====== ANILLO SOBRE UNA PARTICIÓN CRUDA ======
+// Mismo uso que RingFile, pero sin sistema de archivos: los registros van a
+// la partición PARTITION_LABEL (partitions_logs.csv) con esp_partition_*.
+// Nunca se reescribe nada en su sitio: cada registro ocupa un hueco nuevo
+// {seq, CRC, datos} que no cruza sectores, y al entrar en un sector se borra
+// entero (el más antiguo). Así cada append programa solo las páginas del
+// registro, sin la cabecera ni la recolección de basura de SPIFFS, y cada
+// sector se borra una vez por vuelta del anillo. Cada anillo reserva un
+// sector de más para que el borrado nunca se lleve registros vivos.
+//
+// Al arrancar, head/tail salen de los seq de los huecos (el último con el CRC
+// mal, de un corte escribiéndolo, se descarta). Lo que no se deduce de los
+// datos va a un diario compartido de PARTITION_JOURNAL_SECTORS sectores que
+// se recorre en círculo: los consume() (marcas de head) y el contenido del
+// hueco de tail() que se guarda por partes (writeTail() + syncTail()). El
+// sector 0 es un directorio con la posición y geometría de cada anillo,
+// buscados por nombre; si una versión nueva cambia la geometría, el anillo se
+// vuelve a crear vacío en espacio nuevo (el viejo no se recupera hasta borrar
+// la partición entera: pio run -t erase).
+
+#define PARTITION_LABEL "logs"
+#define PARTITION_SECTOR SPI_FLASH_SEC_SIZE
+#define PARTITION_JOURNAL_SECTORS 4
+#define PARTITION_MAX_RINGS 32  // entradas del directorio
+#define PARTITION_PAGE 256      // página de programación del flash
+
+struct PartitionStats {
+  uint32_t totalBytes;
+  uint32_t usedBytes;  // sectores asignados a anillos + directorio y diario
+  uint32_t erases;     // sectores borrados desde el arranque
+  uint32_t programs;   // páginas escritas desde el arranque
+};
+
+bool partitionBegin();
+// Borra directorio y diario: todos los anillos quedan vacíos (los que estén
+// abiertos hay que volver a abrirlos con begin()).
+bool partitionFormat();
+PartitionStats partitionStats();
+
+class PartitionRing {
+ public:
+  PartitionRing(const char* name, uint16_t recordSize, uint32_t capacity);
+  PartitionRing(const PartitionRing&) = delete;
+  ~PartitionRing();
+
+  bool begin();
+  // Cada registro se confirma solo con su CRC: sync no cambia nada.
+  bool append(const void* record, bool sync = true);
+  bool sync() { return ready_; }
+  bool read(uint32_t seq, void* record);
+  uint32_t readBlock(uint32_t seq, void* records, uint32_t maxRecords);
+  uint32_t lowerBound(uint32_t t);
+  // writeTail() solo cambia la copia en RAM; syncTail() la pasa al diario.
+  bool writeTail(uint32_t offset, const void* data, uint32_t len);
+  bool syncTail();
+  bool readTail(void* record);
+  bool consume(uint32_t count);
+  bool clear();
+
+  uint32_t head() const { return head_; }
+  uint32_t tail() const { return tail_; }
+  uint32_t size() const { return tail_ - head_; }
+  uint32_t capacity() const { return capacity_; }
+  uint16_t recordSize() const { return recordSize_; }
+  uint32_t overwritten() const { return overwritten_; }
+  uint32_t writes() const { return writes_; }
+  uint32_t programs() const { return programs_; }
+  uint32_t erases() const { return erases_; }
+  bool ready() const { return ready_; }
+
+ private:
+  friend bool journalRotate();
+
+  uint32_t offsetOf(uint32_t seq) const;
+  bool slotValid(uint32_t offset, uint32_t seq);
+  bool slotErased(uint32_t offset);
+  bool readSlot(uint32_t seq, void* record);
+  bool writeSlot(uint32_t seq, const void* record);
+  bool eraseSector(uint32_t sector);
+  void recover();
+  void repairSector();
+  bool write(uint32_t offset, const void* data, uint32_t len);
+
+  const char* name_;
+  uint16_t recordSize_;
+  uint32_t capacity_;
+  uint8_t id_ = 0;
+  uint32_t slotSize_;
+  uint32_t perSector_;
+  uint32_t sectors_;
+  uint32_t firstSector_ = 0;
+  uint32_t head_ = 0;
+  uint32_t tail_ = 0;
+  uint32_t overwritten_ = 0;
+  uint32_t writes_ = 0;
+  uint32_t programs_ = 0;
+  uint32_t erases_ = 0;
+  // Copia del hueco de tail() (solo si se usa writeTail)
+  uint8_t* tailBuf_ = nullptr;
+  uint32_t tailUsed_ = 0;
+  uint32_t tailSeq_ = UINT32_MAX;
+  bool ready_ = false;
+};
@@ -0,0 +1,151 @@
+#include "reducer.h"
+#include "history_store.h"
+#include "json_reader.h"
+
+struct ReducerConfig {
+  bool enabled = true;
+  float tempDeadband = 0.3f;  // °C (el DHT22 oscila ±0,1)
+  float humDeadband = 1.0f;   // %
+  uint32_t intervalS = 10;
+  uint32_t heartbeatS = 600;
+  float fastTempRate = 1.0f;  // °C/min
+  float fastHumRate = 5.0f;   // %/min
+  uint32_t fastHoldS = 120;
+};
+
+struct ReducerState {
+  bool started;
+  bool fast;
+  uint32_t dueMs;     // última lectura que pasó el intervalo
+  uint32_t keptMs;    // última guardada
+  float keptTemp, keptHum;
+  uint32_t refMs;     // inicio de la ventana del ritmo de cambio
+  float refTemp, refHum;
+  uint32_t fastUntilMs;
+};
+
+static ReducerConfig config;
+static ReducerState state[SENSOR_COUNT];
+static ReducerStats stats = {};
+
+// ====== CONFIGURACIÓN ======
+static bool parseConfig(const char* text, size_t len) {
+  JsonReader r(text, len);
+  char key[16];
+  if (!r.beginObject()) return false;
+  while (r.nextKey(key, sizeof(key))) {
+    if (!strcmp(key, "enabled")) r.readBool(config.enabled);
+    else if (!strcmp(key, "tempDeadband")) r.readNumber(config.tempDeadband);
+    else if (!strcmp(key, "humDeadband")) r.readNumber(config.humDeadband);
+    else if (!strcmp(key, "interval")) r.readNumber(config.intervalS);
+    else if (!strcmp(key, "heartbeat")) r.readNumber(config.heartbeatS);
+    else if (!strcmp(key, "fastTempRate")) r.readNumber(config.fastTempRate);
+    else if (!strcmp(key, "fastHumRate")) r.readNumber(config.fastHumRate);
+    else if (!strcmp(key, "fastHold")) r.readNumber(config.fastHoldS);
+    else r.skipValue();
+  }
+  return r.ok();
+}
+
+void reducerBegin(fs::FS& fs) {
+  File file = fs.open(REDUCER_PATH, "r");
+  if (file && file.size() < 512) {
+    char text[512];
+    size_t len = file.read((uint8_t*)text, sizeof(text) - 1);
+    text[len] = '\0';
+    if (!parseConfig(text, len)) {
+      Serial.println(F("[Reducción] JSON no válido, valores de fábrica"));
+      config = ReducerConfig();
+    }
+  }
+  if (file) file.close();
+  // /api/history mantiene una muestra como mucho HISTORY_HOLD_MAX_S
+  config.heartbeatS = constrain(config.heartbeatS, config.intervalS, (uint32_t)HISTORY_HOLD_MAX_S);
+  if (config.enabled) {
+    Serial.printf("[Reducción] Banda ±%.2f °C / ±%.2f %%, intervalo %u s, latido %u s\n", config.tempDeadband,
+                  config.humDeadband, (unsigned)config.intervalS, (unsigned)config.heartbeatS);
+  } else {
+    Serial.printf("[Reducción] Desactivada, una muestra cada %u s\n", (unsigned)config.intervalS);
+  }
+}
+
+// ====== DECISIÓN ======
+static bool outside(float value, float ref, float band) {
+  if (isnan(value) || isnan(ref)) return isnan(value) != isnan(ref);
+  return fabsf(value - ref) >= band;
+}
+
+// Ritmo de cambio sobre la ventana; el modo rápido dura fastHold desde el
+// último pico.
+static void trackRate(ReducerState& st, const SensorSample& s) {
+  if (s.ms - st.refMs >= REDUCER_RATE_WINDOW_MS) {
+    float minutes = (s.ms - st.refMs) / 60000.0f;
+    bool spike = fabsf(s.temp - st.refTemp) / minutes >= config.fastTempRate ||
+                 (!isnan(s.hum) && fabsf(s.hum - st.refHum) / minutes >= config.fastHumRate);
+    if (spike) {
+      if (!st.fast) {
+        stats.fastModes++;
+        Serial.printf("[Reducción] Cambio rápido en %s, se guarda cada lectura\n", sensorId(s.sensor));
+      }
+      st.fast = true;
+      st.fastUntilMs = s.ms + config.fastHoldS * 1000UL;
+    }
+    st.refMs = s.ms;
+    st.refTemp = s.temp;
+    st.refHum = s.hum;
+  }
+  if (st.fast && (int32_t)(s.ms - st.fastUntilMs) >= 0) st.fast = false;
+}
+
+ReducerDecision reducerOffer(const SensorSample& s) {
+  ReducerDecision d = {false, false, HISTORY_TAG_RAW};
+  if (s.sensor >= SENSOR_COUNT) return d;
+  ReducerState& st = state[s.sensor];
+  stats.offered++;
+
+  bool first = !st.started;
+  if (first) {
+    st = {};
+    st.started = true;
+    st.refMs = s.ms;
+    st.refTemp = s.temp;
+    st.refHum = s.hum;
+  } else {
+    trackRate(st, s);
+  }
+  if (first || s.ms - st.dueMs >= config.intervalS * 1000UL) {
+    st.dueMs = s.ms;
+    stats.baseline++;
+    d.observe = true;
+  }
+
+  if (!config.enabled) {
+    d.keep = d.observe;
+  } else if (d.observe || st.fast) {
+    if (first || outside(s.temp, st.keptTemp, config.tempDeadband) ||
+        outside(s.hum, st.keptHum, config.humDeadband)) {
+      d.keep = true;
+      d.tag = st.fast ? HISTORY_TAG_FAST : HISTORY_TAG_CHANGE;
+    } else if (s.ms - st.keptMs >= config.heartbeatS * 1000UL) {
+      d.keep = true;
+      d.tag = HISTORY_TAG_HEARTBEAT;
+    }
+  }
+  if (d.keep) {
+    st.keptMs = s.ms;
+    st.keptTemp = s.temp;
+    st.keptHum = s.hum;
+    stats.kept[d.tag]++;
+  }
+  return d;
+}
+
+// ====== ESTADÍSTICAS ======
+ReducerStats reducerStats() { return stats; }
+
+uint32_t reducerKept(const ReducerStats& s) { return s.kept[0] + s.kept[1] + s.kept[2] + s.kept[3]; }
+
+float reducerRatio(const ReducerStats& s) {
+  uint32_t kept = reducerKept(s);
+  return kept ? (float)s.baseline / kept : 1.0f;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <Arduino.h>
+#include <FS.h>
+#include "history_codec.h"
+#include "sensor_task.h"
+
+// ====== REDUCCIÓN DE MUESTRAS ======
+// Entre la adquisición y el histórico/subida: en vez de guardar cada
+// `interval` segundos la última lectura de cada sensor, solo se guarda cuando
+// se sale de la banda muerta respecto a la última guardada, o cada
+// `heartbeat` segundos aunque no cambie (así se distingue "sin cambios" de
+// "sin datos"). Si el valor varía más rápido que fastTempRate/fastHumRate
+// (por minuto, medido sobre REDUCER_RATE_WINDOW_MS) se deja de esperar al
+// intervalo durante `fastHold` segundos y entra cada lectura que se salga de
+// la banda (una cada SENSOR_PERIOD_MS), para que el escalón no se retrase.
+//
+// Configuración en /config/reducer.json:
+//
+//   {"enabled": true, "tempDeadband": 0.3, "humDeadband": 1.0,
+//    "interval": 10, "heartbeat": 600,
+//    "fastTempRate": 1.0, "fastHumRate": 5.0, "fastHold": 120}
+//
+// Cada muestra guardada lleva su HistoryTag: /api/history (y la web) la
+// mantienen hasta la siguiente del sensor, así el error de la serie
+// reconstruida no pasa de la banda muerta. Las lecturas descartadas que
+// habrían entrado con el intervalo fijo siguen yendo a los agregados
+// (historyObserve), que conservan min/avg/max completos. Con "enabled":
+// false se vuelve a guardar todo cada `interval` (HISTORY_TAG_RAW).
+
+#define REDUCER_PATH "/config/reducer.json"
+#define REDUCER_RATE_WINDOW_MS 15000  // más corto y el ruido del DHT22 (0,1 °C) parece un cambio rápido
+
+struct ReducerDecision {
+  bool keep;       // al histórico y a la subida, con `tag`
+  bool observe;    // le tocaba por intervalo: al menos a los agregados
+  HistoryTag tag;
+};
+
+struct ReducerStats {
+  uint32_t offered;    // lecturas válidas recibidas
+  uint32_t baseline;   // las que habría guardado el intervalo fijo
+  uint32_t kept[4];    // guardadas, por HistoryTag
+  uint32_t fastModes;  // veces que se subió el ritmo
+};
+
+void reducerBegin(fs::FS& fs);
+// Decide qué hacer con una lectura válida nueva del sensor.
+ReducerDecision reducerOffer(const SensorSample& sample);
+ReducerStats reducerStats();
+uint32_t reducerKept(const ReducerStats& s);
+// Muestras del intervalo fijo por cada una guardada (1 sin reducción).
+float reducerRatio(const ReducerStats& s);
@@ -0,0 +1,227 @@
+#include "ring_file.h"
+#include "crc32.h"
+#include <stddef.h>
+
+static const uint32_t RING_MAGIC = 0x474E4952;  // "RING"
+static const uint16_t RING_VERSION = 1;
+
+RingFile::RingFile(fs::FS& fs, const char* path, uint16_t recordSize, uint32_t capacity)
+    : fs_(fs), path_(path), recordSize_(recordSize), capacity_(capacity) {}
+
+bool RingFile::begin() {
+  if (ready_) return true;
+  // Un .tmp es un redimensionado cortado: si el original ya se había borrado
+  // la copia estaba verificada y pasa a ser el anillo; si no, se descarta.
+  String tmpPath = String(path_) + ".tmp";
+  if (fs_.exists(tmpPath)) {
+    if (!fs_.exists(path_) && fs_.rename(tmpPath, path_)) {
+      Serial.printf("[Ring] %s recuperado de un redimensionado a medias\n", path_);
+    } else {
+      fs_.remove(tmpPath);
+    }
+  }
+  file_ = fs_.open(path_, "r+");
+  uint32_t storedCapacity = 0;
+  if (file_ && loadHeader(file_, storedCapacity)) {
+    if (storedCapacity != capacity_ && !resize(storedCapacity)) {
+      // Sin sitio para la copia: el anillo sigue intacto y se usa con la
+      // capacidad que tiene; recrearlo perdería todo lo guardado. Si el
+      // original ya se borró, la copia verificada la recupera el próximo begin().
+      file_ = fs_.open(path_, "r+");
+      if (!file_ || !loadHeader(file_, storedCapacity)) {
+        if (file_) file_.close();
+        return false;
+      }
+      Serial.printf("[Ring] %s sigue con %u registros\n", path_, (unsigned)storedCapacity);
+      capacity_ = storedCapacity;
+    }
+    ready_ = true;
+    return true;
+  }
+  if (file_) file_.close();
+  Serial.printf("[Ring] %s no válido, creando (%u x %u bytes)\n", path_,
+                (unsigned)capacity_, (unsigned)recordSize_);
+  if (!preallocate(path_)) return false;
+  file_ = fs_.open(path_, "r+");
+  if (!file_) return false;
+  generation_ = 0;
+  head_ = tail_ = 0;
+  ready_ = writeHeader();
+  return ready_;
+}
+
+bool RingFile::preallocate(const char* path) {
+  File f = fs_.open(path, "w");
+  if (!f) return false;
+  uint8_t zeros[256] = {0};
+  uint32_t total = DATA_OFFSET + capacity_ * recordSize_;
+  for (uint32_t written = 0; written < total;) {
+    uint32_t n = min<uint32_t>(sizeof(zeros), total - written);
+    if (f.write(zeros, n) != n) {
+      f.close();
+      fs_.remove(path);
+      return false;
+    }
+    written += n;
+  }
+  f.close();
+  return true;
+}
+
+// Cambio de capacidad entre versiones de firmware: copia los registros más
+// recientes que quepan a un fichero nuevo conservando sus números de seq.
+// El original no se toca hasta que la copia está entera y su cabecera se lee
+// bien; después se borra y la copia ocupa su nombre (SPIFFS no renombra
+// encima de un fichero que existe). Un corte entre los dos pasos lo
+// resuelve begin().
+bool RingFile::resize(uint32_t oldCapacity) {
+  String tmpPath = String(path_) + ".tmp";
+  if (!preallocate(tmpPath.c_str())) return false;
+  File old = file_;
+  file_ = fs_.open(tmpPath, "r+");
+  bool ok = (bool)file_;
+
+  uint32_t keep = min(size(), capacity_);
+  uint32_t oldHead = head_;
+  uint8_t piece[64];
+  for (uint32_t seq = tail_ - keep; ok && seq != tail_; seq++) {
+    for (uint32_t done = 0; ok && done < recordSize_;) {
+      uint32_t n = min<uint32_t>(sizeof(piece), recordSize_ - done);
+      ok = old.seek(DATA_OFFSET + (seq % oldCapacity) * recordSize_ + done) && old.read(piece, n) == n &&
+           write(offsetOf(seq) + done, piece, n);
+      done += n;
+    }
+  }
+  if (ok) {
+    head_ = tail_ - keep;
+    ok = writeHeader();
+  }
+  if (file_) file_.close();
+  old.close();
+
+  // Se relee la copia: la cabecera tiene que decir lo que se acaba de escribir
+  uint32_t copiedTail = tail_, copiedHead = head_, storedCapacity = 0;
+  if (ok) {
+    File check = fs_.open(tmpPath, "r");
+    ok = check && check.size() == DATA_OFFSET + capacity_ * recordSize_ && loadHeader(check, storedCapacity) &&
+         storedCapacity == capacity_ && head_ == copiedHead && tail_ == copiedTail;
+    if (check) check.close();
+  }
+  if (!ok) {
+    fs_.remove(tmpPath);
+    head_ = oldHead;
+    Serial.printf("[Ring] %s no se pudo redimensionar\n", path_);
+    return false;
+  }
+
+  if (!fs_.remove(path_) || !fs_.rename(tmpPath, path_)) return false;
+  file_ = fs_.open(path_, "r+");
+  Serial.printf("[Ring] %s redimensionado de %u a %u registros (%u conservados)\n", path_,
+                (unsigned)oldCapacity, (unsigned)capacity_, (unsigned)keep);
+  return (bool)file_;
+}
+
+bool RingFile::loadHeader(File& file, uint32_t& storedCapacity) {
+  bool found = false;
+  for (uint32_t slot = 0; slot < 2; slot++) {
+    Header h;
+    if (!file.seek(slot * HEADER_SLOT) || file.read((uint8_t*)&h, sizeof(h)) != sizeof(h)) continue;
+    if (h.magic != RING_MAGIC || h.version != RING_VERSION) continue;
+    if (h.crc != crc32(&h, offsetof(Header, crc))) continue;
+    if (h.recordSize != recordSize_ || !h.capacity) continue;
+    if (h.tail - h.head > h.capacity) continue;
+    if (!found || (int32_t)(h.generation - generation_) > 0) {
+      generation_ = h.generation;
+      head_ = h.head;
+      tail_ = h.tail;
+      storedCapacity = h.capacity;
+      found = true;
+    }
+  }
+  return found;
+}
+
+bool RingFile::writeHeader() {
+  Header h;
+  h.magic = RING_MAGIC;
+  h.version = RING_VERSION;
+  h.recordSize = recordSize_;
+  h.capacity = capacity_;
+  h.generation = ++generation_;
+  h.head = head_;
+  h.tail = tail_;
+  h.crc = crc32(&h, offsetof(Header, crc));
+  bool ok = write((h.generation & 1) * HEADER_SLOT, &h, sizeof(h));
+  file_.flush();
+  return ok;
+}
+
+bool RingFile::write(uint32_t offset, const void* data, uint32_t len) {
+  writes_++;
+  programs_ += (offset + len - 1) / RING_FLASH_PAGE - offset / RING_FLASH_PAGE + 1;
+  return file_.seek(offset) && file_.write((const uint8_t*)data, len) == len;
+}
+
+bool RingFile::append(const void* record, bool sync) {
+  if (!file_) return false;
+  if (!write(offsetOf(tail_), record, recordSize_)) return false;
+  tail_++;
+  if (tail_ - head_ > capacity_) {
+    head_ = tail_ - capacity_;
+    overwritten_++;
+  }
+  return sync ? writeHeader() : true;
+}
+
+bool RingFile::read(uint32_t seq, void* record) {
+  if (!file_ || seq - head_ >= size()) return false;
+  file_.seek(offsetOf(seq));
+  return file_.read((uint8_t*)record, recordSize_) == recordSize_;
+}
+
+uint32_t RingFile::readBlock(uint32_t seq, void* records, uint32_t maxRecords) {
+  if (!file_ || seq - head_ >= size()) return 0;
+  uint32_t n = min(maxRecords, tail_ - seq);
+  n = min(n, capacity_ - seq % capacity_);
+  file_.seek(offsetOf(seq));
+  size_t got = file_.read((uint8_t*)records, n * recordSize_);
+  return got / recordSize_;
+}
+
+uint32_t RingFile::lowerBound(uint32_t t) {
+  uint32_t lo = head_, hi = tail_;
+  while (lo != hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    uint32_t ts;
+    file_.seek(offsetOf(mid));
+    if (file_.read((uint8_t*)&ts, sizeof(ts)) != sizeof(ts)) break;
+    if (ts < t) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
+}
+
+bool RingFile::writeTail(uint32_t offset, const void* data, uint32_t len) {
+  if (!file_ || !len || offset + len > recordSize_) return false;
+  bool ok = write(offsetOf(tail_) + offset, data, len);
+  file_.flush();
+  return ok;
+}
+
+bool RingFile::readTail(void* record) {
+  if (!file_) return false;
+  file_.seek(offsetOf(tail_));
+  return file_.read((uint8_t*)record, recordSize_) == recordSize_;
+}
+
+bool RingFile::consume(uint32_t count) {
+  if (!file_) return false;
+  head_ += min(count, size());
+  return writeHeader();
+}
+
+bool RingFile::clear() {
+  if (!file_) return false;
+  head_ = tail_;
+  return writeHeader();
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <Arduino.h>
+#include <FS.h>
+
+// ====== FICHERO CIRCULAR DE REGISTROS DE TAMAÑO FIJO ======
+// El fichero se preasigna entero al crearlo, así que su tamaño en flash nunca
+// cambia. Los registros se identifican por un número de secuencia absoluto:
+// el registro seq vive en el hueco seq % capacity. Cuando el anillo está lleno
+// append() sobrescribe el más antiguo.
+//
+// La cabecera (head/tail + CRC) se guarda en dos copias alternas con un
+// contador de generación: si se corta la luz a mitad de escritura queda la
+// copia anterior. Si una versión nueva del firmware cambia la capacidad, el
+// fichero se redimensiona conservando los registros más recientes, sobre una
+// copia (<path>.tmp) que solo reemplaza al original una vez verificada. Si la
+// copia no cabe, el anillo sigue con la capacidad que tenía (capacity()).
+//
+// Cada escritura se cuenta en programs(): las páginas de flash
+// (RING_FLASH_PAGE bytes) que toca, que es lo que reprograma SPIFFS aunque
+// solo cambie un byte.
+
+#define RING_FLASH_PAGE 256
+
+class RingFile {
+ public:
+  RingFile(fs::FS& fs, const char* path, uint16_t recordSize, uint32_t capacity);
+
+  bool begin();
+  // Con sync=false no se reescribe la cabecera (importaciones masivas);
+  // hay que llamar a sync() al terminar.
+  bool append(const void* record, bool sync = true);
+  bool sync() { return file_ && writeHeader(); }
+  bool read(uint32_t seq, void* record);
+  // Lee registros consecutivos desde seq sin pasar del final físico del
+  // fichero; devuelve cuántos leyó (puede ser menos que maxRecords).
+  uint32_t readBlock(uint32_t seq, void* records, uint32_t maxRecords);
+  // Para anillos cuyos registros empiezan por un uint32_t ts no decreciente:
+  // primer seq con ts >= t, por búsqueda binaria.
+  uint32_t lowerBound(uint32_t t);
+  // Hueco de tail(), el registro que se está llenando antes del append():
+  // permite guardarlo por partes y recuperarlo tras un reinicio.
+  bool writeTail(uint32_t offset, const void* data, uint32_t len);
+  bool syncTail() { return (bool)file_; }  // writeTail() ya escribe en el fichero
+  bool readTail(void* record);
+  bool consume(uint32_t count);  // descarta los count registros más antiguos
+  bool clear();
+
+  uint32_t head() const { return head_; }  // seq del registro más antiguo
+  uint32_t tail() const { return tail_; }  // seq que tendrá el próximo append
+  uint32_t size() const { return tail_ - head_; }
+  uint32_t capacity() const { return capacity_; }
+  uint16_t recordSize() const { return recordSize_; }
+  uint32_t overwritten() const { return overwritten_; }
+  uint32_t writes() const { return writes_; }      // escrituras desde el arranque
+  uint32_t programs() const { return programs_; }  // páginas de flash escritas desde el arranque
+  bool ready() const { return ready_; }
+
+ private:
+  struct Header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t capacity;
+    uint32_t generation;
+    uint32_t head;
+    uint32_t tail;
+    uint32_t crc;
+  };
+
+  static const uint32_t HEADER_SLOT = 32;  // cada copia ocupa 32 bytes
+  static const uint32_t DATA_OFFSET = 2 * HEADER_SLOT;
+
+  bool preallocate(const char* path);
+  bool resize(uint32_t oldCapacity);
+  bool loadHeader(File& file, uint32_t& storedCapacity);
+  bool writeHeader();
+  uint32_t offsetOf(uint32_t seq) const { return DATA_OFFSET + (seq % capacity_) * recordSize_; }
+  bool write(uint32_t offset, const void* data, uint32_t len);
+
+  fs::FS& fs_;
+  const char* path_;
+  uint16_t recordSize_;
+  uint32_t capacity_;
+  File file_;
+  uint32_t generation_ = 0;
+  uint32_t head_ = 0;
+  uint32_t tail_ = 0;
+  uint32_t overwritten_ = 0;
+  uint32_t writes_ = 0;
+  uint32_t programs_ = 0;
+  bool ready_ = false;
+};
@@ -0,0 +1,172 @@
+#include "rollup.h"
+#include "history_store.h"
+#include "sensors.h"
+
+const RollupTierInfo rollupTiers[TIER_COUNT] = {
+  {"minute", "/rollup2_m.bin", 60, 10080},     // 7 días   (~242 KB)
+  {"hour", "/rollup2_h.bin", 3600, 8784},      // 1 año    (~211 KB)
+  {"day", "/rollup2_d.bin", 86400, 3660},      // 10 años  (~88 KB)
+};
+// Formato 1: se borran para no ocupar la flash dos veces. En la partición
+// cruda no se puede (partition_ring.h): hay que borrarla al actualizar.
+static const char* const OLD_PATHS[] = {"/rollup_m.bin", "/rollup_h.bin", "/rollup_d.bin"};
+
+static RingStore rings[TIER_COUNT] = {
+  RingStore(rollupTiers[TIER_MINUTE].path, sizeof(Rollup), rollupTiers[TIER_MINUTE].capacity),
+  RingStore(rollupTiers[TIER_HOUR].path, sizeof(Rollup), rollupTiers[TIER_HOUR].capacity),
+  RingStore(rollupTiers[TIER_DAY].path, sizeof(Rollup), rollupTiers[TIER_DAY].capacity),
+};
+
+// Bucket abierto en RAM, con las sumas exactas
+struct OpenBucket {
+  uint32_t ts;
+  uint32_t count;
+  int16_t tMin, tMax;
+  uint16_t hMin, hMax;
+  int64_t tSum;
+  int64_t hSum;
+};
+
+// Todos los sensores abren y cierran bucket a la vez: así los anillos siguen
+// ordenados por ts aunque un sensor pase un rato sin lecturas.
+static OpenBucket openBuckets[TIER_COUNT][SENSOR_COUNT];
+static uint32_t openStart[TIER_COUNT];
+
+static void startBucket(OpenBucket& b, uint32_t ts) {
+  b.ts = ts;
+  b.count = 0;
+  b.tMin = INT16_MAX;
+  b.tMax = INT16_MIN;
+  b.hMin = UINT16_MAX;
+  b.hMax = 0;
+  b.tSum = 0;
+  b.hSum = 0;
+}
+
+// Media redondeada al entero más cercano
+static int32_t average(int64_t sum, uint32_t count) {
+  return (sum + (sum < 0 ? -(int64_t)count : (int64_t)count) / 2) / (int64_t)count;
+}
+
+static Rollup toRecord(const OpenBucket& b, uint8_t sensor) {
+  Rollup r = {};
+  r.ts = b.ts;
+  r.count = b.count;
+  r.sensor = sensor;
+  r.tMin = b.tMin;
+  r.tMax = b.tMax;
+  r.hMin = b.hMin;
+  r.hMax = b.hMax;
+  if (b.count) {
+    r.tAvg = average(b.tSum, b.count);
+    r.hAvg = average(b.hSum, b.count);
+  }
+  return r;
+}
+
+static void merge(OpenBucket& into, const Rollup& from) {
+  if (!from.count) return;
+  into.count += from.count;
+  into.tMin = min(into.tMin, from.tMin);
+  into.tMax = max(into.tMax, from.tMax);
+  into.hMin = min(into.hMin, from.hMin);
+  into.hMax = max(into.hMax, from.hMax);
+  into.tSum += (int64_t)from.tAvg * from.count;
+  into.hSum += (int64_t)from.hAvg * from.count;
+}
+
+static void merge(OpenBucket& into, const OpenBucket& from) {
+  if (!from.count) return;
+  into.count += from.count;
+  into.tMin = min(into.tMin, from.tMin);
+  into.tMax = max(into.tMax, from.tMax);
+  into.hMin = min(into.hMin, from.hMin);
+  into.hMax = max(into.hMax, from.hMax);
+  into.tSum += from.tSum;
+  into.hSum += from.hSum;
+}
+
+static void addSample(OpenBucket& b, int16_t temp, uint16_t hum) {
+  b.count++;
+  b.tMin = min(b.tMin, temp);
+  b.tMax = max(b.tMax, temp);
+  b.hMin = min(b.hMin, hum);
+  b.hMax = max(b.hMax, hum);
+  b.tSum += temp;
+  b.hSum += hum;
+}
+
+// Reconstruye el bucket abierto de un nivel a partir del nivel inferior ya
+// cerrado, para no perder la hora/día en curso al reiniciar.
+static void startAll(uint8_t tier, uint32_t start) {
+  openStart[tier] = start;
+  for (uint8_t s = 0; s < SENSOR_COUNT; s++) startBucket(openBuckets[tier][s], start);
+}
+
+static void recoverOpen(RollupTier tier, uint32_t now) {
+  uint32_t start = now - now % rollupTiers[tier].seconds;
+  startAll(tier, start);
+  if (tier == TIER_MINUTE) {
+    HistoryCursor cursor = historySeek(start);
+    HistoryRecord h;
+    while (historyNext(cursor, h)) {
+      if (h.sensor < SENSOR_COUNT) addSample(openBuckets[tier][h.sensor], h.temp, h.hum);
+    }
+    return;
+  }
+  RingStore& lower = rings[tier - 1];
+  for (uint32_t seq = lower.lowerBound(start); seq != lower.tail(); seq++) {
+    Rollup r;
+    if (lower.read(seq, &r) && r.sensor < SENSOR_COUNT) merge(openBuckets[tier][r.sensor], r);
+  }
+  for (uint8_t s = 0; s < SENSOR_COUNT; s++) merge(openBuckets[tier][s], openBuckets[tier - 1][s]);
+}
+
+bool rollupBegin() {
+#if STORAGE_BACKEND != STORAGE_RAW
+  for (const char* path : OLD_PATHS) {
+    if (storageFs().exists(path)) storageFs().remove(path);
+  }
+#endif
+  bool ok = true;
+  for (uint8_t t = 0; t < TIER_COUNT; t++) ok = rings[t].begin() && ok;
+
+  // Sin agregados previos (primer arranque con esta versión) se generan a
+  // partir del histórico crudo que haya.
+  if (!rings[TIER_MINUTE].size() && historySamples()) {
+    for (uint8_t t = 0; t < TIER_COUNT; t++) startAll(t, 0);
+    HistoryCursor cursor = historySeek(0);
+    HistoryRecord h;
+    while (historyNext(cursor, h)) {
+      if (h.sensor < SENSOR_COUNT) rollupAdd(h.ts, h.sensor, h.temp, h.hum);
+    }
+    Serial.printf("[Rollup] Generados desde %u muestras crudas\n", (unsigned)historySamples());
+    return ok;
+  }
+
+  uint32_t now = historyLastTs();
+  for (uint8_t t = 0; t < TIER_COUNT; t++) recoverOpen((RollupTier)t, now);
+  return ok;
+}
+
+void rollupAdd(uint32_t ts, uint8_t sensor, int16_t temp, uint16_t hum) {
+  if (sensor >= SENSOR_COUNT) return;
+  for (uint8_t t = 0; t < TIER_COUNT; t++) {
+    uint32_t start = ts - ts % rollupTiers[t].seconds;
+    if (start > openStart[t]) {
+      for (uint8_t s = 0; s < SENSOR_COUNT; s++) {
+        if (!openBuckets[t][s].count) continue;
+        Rollup r = toRecord(openBuckets[t][s], s);
+        rings[t].append(&r);
+      }
+      startAll(t, start);
+    }
+    addSample(openBuckets[t][sensor], temp, hum);
+  }
+}
+
+RingStore& rollupRing(RollupTier tier) { return rings[tier]; }
+Rollup rollupOpen(RollupTier tier, uint8_t sensor) {
+  if (sensor >= SENSOR_COUNT) sensor = 0;
+  return toRecord(openBuckets[tier][sensor], sensor);
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <Arduino.h>
+#include "storage.h"
+
+// ====== AGREGADOS POR MINUTO / HORA / DÍA ======
+// Cada muestra que entra al histórico actualiza en O(1) el bucket abierto de
+// cada nivel (count/min/max/suma). Cuando una muestra cae fuera del bucket
+// abierto, éste se cierra y se añade a su propio anillo, cada uno con su
+// retención. Así una consulta de un mes lee ~30 registros del nivel diario en
+// lugar de recorrer el histórico crudo.
+
+enum RollupTier : uint8_t {
+  TIER_MINUTE = 0,
+  TIER_HOUR = 1,
+  TIER_DAY = 2,
+  TIER_COUNT = 3
+};
+
+// Registro en flash (24 bytes). Temperatura y humedad en centésimas. Cada
+// sensor tiene sus propios buckets; todos comparten los anillos.
+// Se guarda la media redondeada y no la suma: con los sensores simulados a
+// 250 Hz un día son 21,6 M muestras por sensor, y ni count en 16 bits ni las
+// sumas en 32 caben. Las sumas exactas (64 bits) solo existen en RAM
+// mientras el bucket está abierto; al agregar varios registros se pondera la
+// media por count, con un error de media centésima como mucho.
+// Formato 2: el 1 (count de 16 bits y sumas de 32) va en otros ficheros y se
+// borra al arrancar.
+struct Rollup {
+  uint32_t ts;       // inicio del intervalo (epoch)
+  uint32_t count;
+  uint16_t sensor;   // índice en SENSOR_TABLE
+  int16_t tMin, tMax, tAvg;
+  uint16_t hMin, hMax, hAvg;
+  uint16_t reserved;
+};
+static_assert(sizeof(Rollup) == 24, "Mismo tamaño en flash que el formato 1");
+
+struct RollupTierInfo {
+  const char* name;
+  const char* path;
+  uint32_t seconds;   // resolución
+  uint32_t capacity;  // retención = capacity * seconds
+};
+
+extern const RollupTierInfo rollupTiers[TIER_COUNT];
+
+bool rollupBegin();
+void rollupAdd(uint32_t ts, uint8_t sensor, int16_t temp, uint16_t hum);
+RingStore& rollupRing(RollupTier tier);
+// Bucket aún abierto del nivel para ese sensor (count == 0 si no hay ninguno).
+Rollup rollupOpen(RollupTier tier, uint8_t sensor);
@@ -0,0 +1,138 @@
+#pragma once
+#include <Arduino.h>
+
+// ====== SENSOR SIMULADO ======
+// Se incluye desde sensors.h (usa SensorKind y SENSOR_PERIOD_US).
+// Driver del tipo SENSOR_SIM de SENSOR_TABLE (el campo del pin es el perfil)
+// y, con -DSENSOR_SIMULATE, sustituto de los DHT22/DHT11 de la tabla con sus
+// mismos ids (perfil SIM_INDOOR). Sirve para cargar el registro, la subida y
+// el HTTP sin hardware, más rápido de lo que un DHT22 puede leer.
+//
+// Cada lectura es una función pura de (SENSOR_SIM_SEED, sensor, número de
+// lectura): no hay generador aleatorio global ni randomSeed(), así que con la
+// misma semilla la serie es la misma en cada ejecución, aunque cambie el
+// reparto de tiempo entre tareas. El reloj simulado avanza
+// SENSOR_PERIOD_US por lectura desde SENSOR_SIM_START_S (hora del día),
+// no con millis(). La serie es:
+//
+//   base + ciclo diario (mínimo a las 4 h, máximo a las 16 h; la humedad al
+//   revés) + deriva lenta (ruido interpolado cada SENSOR_SIM_DRIFT_S) +
+//   ruido de lectura, redondeado a 0,1 como el DHT22
+//
+// y falla como uno de verdad: NaN sueltos (nanRate por lectura) y cortes de
+// dropoutS segundos seguidos (una fracción dropoutRate del tiempo).
+//
+// Para buscar el techo de la cadena (env native_stress o
+// esp32doit-devkit-v1_stress):
+//
+//   -DSENSOR_SIMULATE -DSENSOR_TABLE_ENTRIES=SIM_SENSORS_4
+//   -DSENSOR_PERIOD_US=4000   (4 sensores x 250 Hz = 1 kHz)
+//
+// y en /config/reducer.json "enabled": false, "interval": 0 para que cada
+// lectura vaya al histórico y a la subida. Lo que no da abasto se ve en
+// /api/metrics: esp32_sensor_skipped_total (lecturas que loop() no llegó a
+// ver), las descartadas de la cola del uploader y los histogramas de loop(),
+// del append y de las rutas.
+
+#ifndef SENSOR_SIM_SEED
+#define SENSOR_SIM_SEED 1
+#endif
+#ifndef SENSOR_SIM_START_S
+#define SENSOR_SIM_START_S (8 * 3600UL)  // empieza a las 8:00 simuladas
+#endif
+#define SENSOR_SIM_DRIFT_S 10800UL  // un punto de deriva cada 3 h
+
+enum SimProfile : uint8_t {
+  SIM_INDOOR,   // habitación: poco ciclo diario, ruido del DHT22
+  SIM_OUTDOOR,  // exterior: ciclo diario amplio y algún corte
+  SIM_FLAKY,    // cable largo o sensor que falla a menudo
+};
+
+struct SimProfileDef {
+  float tempBase, tempDaily, tempDrift, tempNoise;  // °C
+  float humBase, humDaily, humDrift, humNoise;      // %
+  float nanRate;      // probabilidad de NaN por lectura
+  float dropoutRate;  // fracción del tiempo sin lecturas
+  uint16_t dropoutS;  // duración de cada corte
+};
+
+constexpr SimProfileDef SIM_PROFILES[] = {
+  {22.0f, 1.5f, 1.0f, 0.1f, 50.0f, 5.0f, 4.0f, 0.5f, 0.001f, 0.0f, 60},
+  {15.0f, 6.0f, 3.0f, 0.15f, 65.0f, 15.0f, 8.0f, 1.0f, 0.002f, 0.005f, 120},
+  {22.0f, 1.5f, 1.0f, 0.2f, 50.0f, 5.0f, 4.0f, 1.0f, 0.05f, 0.02f, 300},
+};
+
+// Tablas de sensores simulados para -DSENSOR_TABLE_ENTRIES=SIM_SENSORS_<n>
+#define SIM_SENSORS_1 {"sim0", SENSOR_SIM, SIM_INDOOR}
+#define SIM_SENSORS_2 SIM_SENSORS_1, {"sim1", SENSOR_SIM, SIM_OUTDOOR}
+#define SIM_SENSORS_3 SIM_SENSORS_2, {"sim2", SENSOR_SIM, SIM_FLAKY}
+#define SIM_SENSORS_4 SIM_SENSORS_3, {"sim3", SENSOR_SIM, SIM_INDOOR}
+#define SIM_SENSORS_5 SIM_SENSORS_4, {"sim4", SENSOR_SIM, SIM_OUTDOOR}
+#define SIM_SENSORS_6 SIM_SENSORS_5, {"sim5", SENSOR_SIM, SIM_INDOOR}
+#define SIM_SENSORS_7 SIM_SENSORS_6, {"sim6", SENSOR_SIM, SIM_OUTDOOR}
+#define SIM_SENSORS_8 SIM_SENSORS_7, {"sim7", SENSOR_SIM, SIM_FLAKY}
+
+// Canales independientes de la misma semilla
+enum SimChannel : uint8_t { SIM_TEMP_NOISE, SIM_HUM_NOISE, SIM_TEMP_DRIFT, SIM_HUM_DRIFT, SIM_NAN, SIM_DROPOUT };
+
+// Mezcla de splitmix64: cada (semilla, sensor, canal, n) da 32 bits
+// independientes sin estado.
+inline uint32_t simHash(uint8_t sensor, uint8_t channel, uint32_t n) {
+  uint64_t z = ((uint64_t)SENSOR_SIM_SEED << 32) ^ ((uint64_t)sensor << 24 | (uint64_t)channel << 16) ^
+               ((uint64_t)n * 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return (uint32_t)((z ^ (z >> 31)) >> 32);
+}
+
+// Uniforme en [0, 1)
+inline float simUniform(uint8_t sensor, uint8_t channel, uint32_t n) {
+  return (simHash(sensor, channel, n) >> 8) * (1.0f / 16777216.0f);
+}
+
+// Casi normal (media 0, desviación 1): suma de 4 uniformes de 16 bits.
+inline float simGauss(uint8_t sensor, uint8_t channel, uint32_t n) {
+  uint32_t a = simHash(sensor, channel, n), b = simHash(sensor, channel, ~n);
+  float sum = (a & 0xFFFF) + (a >> 16) + (b & 0xFFFF) + (b >> 16);
+  return (sum / 65536.0f - 2.0f) * 1.7320508f;
+}
+
+// Ruido de valor interpolado (suave) entre puntos cada SENSOR_SIM_DRIFT_S.
+inline float simDrift(uint8_t sensor, uint8_t channel, uint64_t ms) {
+  uint32_t k = ms / (SENSOR_SIM_DRIFT_S * 1000);
+  float f = (ms % (SENSOR_SIM_DRIFT_S * 1000)) / (SENSOR_SIM_DRIFT_S * 1000.0f);
+  f = f * f * (3 - 2 * f);
+  return simGauss(sensor, channel, k) * (1 - f) + simGauss(sensor, channel, k + 1) * f;
+}
+
+// Lectura `n` del sensor simulado `sensor` (perfil `profile`) tomada cada
+// periodUs: la misma entrada da siempre la misma salida.
+inline void simSample(uint8_t profile, uint8_t sensor, uint32_t n, uint32_t periodUs, float& temp, float& hum) {
+  const SimProfileDef& p = SIM_PROFILES[profile < sizeof(SIM_PROFILES) / sizeof(SIM_PROFILES[0]) ? profile : 0];
+  uint64_t ms = SENSOR_SIM_START_S * 1000ULL + (uint64_t)n * periodUs / 1000;
+  if (p.dropoutRate > 0 && simUniform(sensor, SIM_DROPOUT, ms / (p.dropoutS * 1000UL)) < p.dropoutRate) {
+    temp = hum = NAN;
+    return;
+  }
+  if (simUniform(sensor, SIM_NAN, n) < p.nanRate) {
+    temp = hum = NAN;
+    return;
+  }
+  float day = (float)(ms % 86400000ULL) / 86400000.0f;
+  float cycle = -cosf(2 * (float)M_PI * (day - 4.0f / 24));  // -1 a las 4 h, +1 a las 16 h
+  float t = p.tempBase + p.tempDaily * cycle + p.tempDrift * simDrift(sensor, SIM_TEMP_DRIFT, ms) +
+            p.tempNoise * simGauss(sensor, SIM_TEMP_NOISE, n);
+  float h = p.humBase - p.humDaily * cycle + p.humDrift * simDrift(sensor, SIM_HUM_DRIFT, ms) +
+            p.humNoise * simGauss(sensor, SIM_HUM_NOISE, n);
+  temp = roundf(t * 10) / 10;
+  hum = roundf(constrain(h, 0.0f, 100.0f) * 10) / 10;
+}
+
+struct SimDriver {
+  uint8_t profile;
+  uint8_t sensor;
+  uint32_t n = 0;
+  SimDriver(uint8_t profile, uint8_t sensor) : profile(profile), sensor(sensor) {}
+  void begin() {}
+  void read(float& temp, float& hum) { simSample(profile, sensor, n++, SENSOR_PERIOD_US, temp, hum); }
+};
@@ -0,0 +1,104 @@
+#include "sensor_task.h"
+#include <atomic>
+#include <time.h>
+#include "bench.h"
+#include "metrics.h"
+
+static SensorDrivers drivers = makeSensorDrivers(std::make_index_sequence<SENSOR_COUNT>());
+
+struct PublishedSample {
+  std::atomic<uint32_t> seqlock;
+  SensorSample sample;
+};
+
+static PublishedSample published[SENSOR_COUNT];
+static SensorJitter jitter = {};
+
+static void publish(const SensorSample& s) {
+  PublishedSample& p = published[s.sensor];
+  uint32_t v = p.seqlock.load(std::memory_order_relaxed);
+  p.seqlock.store(v + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  p.sample = s;
+  p.seqlock.store(v + 2, std::memory_order_release);
+}
+
+SensorSample sensorLatest(uint8_t sensor) {
+  PublishedSample& p = published[sensor < SENSOR_COUNT ? sensor : 0];
+  SensorSample copy;
+  uint32_t before, after;
+  do {
+    before = p.seqlock.load(std::memory_order_acquire);
+    copy = p.sample;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    after = p.seqlock.load(std::memory_order_relaxed);
+  } while ((before & 1) || before != after);
+  copy.sensor = sensor;
+  return copy;
+}
+
+SensorJitter sensorJitter() { return jitter; }
+
+static void readAndPublish(uint8_t sensor, uint32_t* counts) {
+  uint32_t t0 = benchStart();
+  uint32_t readStart = micros();
+  SensorSample s;
+  readSensorDriver(drivers, sensor, s.temp, s.hum, std::make_index_sequence<SENSOR_COUNT>());
+  jitter.readUs = micros() - readStart;
+  benchEnd(BENCH_SENSOR, t0);
+  metricsInc(metrics.sensorReads[sensor]);
+
+  time_t now = time(nullptr);
+  s.sensor = sensor;
+  s.seq = ++counts[sensor];
+  s.ts = now >= 1600000000 ? (uint32_t)now : 0;
+  s.ms = millis();
+  bool valid = !isnan(s.temp) && (!sensorHasHumidity(sensor) || !isnan(s.hum));
+  s.status = valid ? SENSOR_OK : SENSOR_ERROR;
+  publish(s);
+
+  if (!valid) metricsInc(metrics.sensorErrors[sensor]);
+  if (!SENSOR_LOG_EACH) return;
+  if (!valid) {
+    Serial.printf("Error leyendo %s!\n", sensorId(sensor));
+  } else {
+    Serial.printf("[%s] Temp: %.2f °C | Hum: %.2f %%\n", sensorId(sensor), s.temp, s.hum);
+  }
+}
+
+static void sensorTask(void*) {
+  static uint32_t counts[SENSOR_COUNT] = {};
+  // Turno de cada lectura; la tarea despierta cada tantos ticks enteros como
+  // quepan en él (al menos uno) y lee las que ya tocan, así un turno que no
+  // sea múltiplo del tick, o menor que él, mantiene el ritmo medio.
+  const uint32_t slotUs = max<uint32_t>(SENSOR_PERIOD_US / SENSOR_COUNT, 1);
+  const uint32_t tickUs = portTICK_PERIOD_MS * 1000UL;
+  const TickType_t wakeTicks = max<uint32_t>(slotUs / tickUs, 1);
+  uint32_t dueUs = slotUs;  // la primera lectura, nada más arrancar
+  uint8_t next = 0;
+  TickType_t lastWake = xTaskGetTickCount();
+  uint32_t expectedUs = micros();
+  for (;;) {
+    // Cuánto llega tarde respecto al instante ideal
+    // (xTaskDelayUntil va en ticks y puede despertar un poco antes: eso cuenta como 0)
+    uint32_t lateUs = micros() - expectedUs;
+    if ((int32_t)lateUs < 0) lateUs = 0;
+    jitter.lastUs = lateUs;
+    jitter.maxUs = max(jitter.maxUs, lateUs);
+    metrics.sensorJitter.record(lateUs);
+
+    for (; dueUs >= slotUs; dueUs -= slotUs) {
+      readAndPublish(next, counts);
+      next = (next + 1) % SENSOR_COUNT;
+    }
+
+    xTaskDelayUntil(&lastWake, wakeTicks);
+    expectedUs += wakeTicks * tickUs;
+    dueUs += wakeTicks * tickUs;
+  }
+}
+
+void sensorBegin() {
+  beginSensorDrivers(drivers, std::make_index_sequence<SENSOR_COUNT>());
+  xTaskCreatePinnedToCore(sensorTask, "sensor", SENSOR_TASK_STACK, nullptr, SENSOR_TASK_PRIORITY, nullptr, 1);
+}
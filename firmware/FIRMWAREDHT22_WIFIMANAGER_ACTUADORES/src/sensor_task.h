@@ -0,0 +1,43 @@
+#pragma once
+#include <Arduino.h>
+#include "sensors.h"
+
+// ====== ADQUISICIÓN DE SENSORES ======
+// Los sensores de SENSOR_TABLE se leen en su propia tarea (núcleo 1, por
+// encima de loop()). Cada uno se lee una vez por SENSOR_PERIOD_US (sensors.h),
+// pero escalonados: la tarea despierta cada SENSOR_PERIOD_US / SENSOR_COUNT
+// con xTaskDelayUntil() y lee solo el siguiente, así el bus y la CPU llevan
+// una carga pareja en vez de un pico por periodo. Si ese turno es menor que
+// un tick (1 ms, solo con sensores simulados), en cada tick se leen las
+// lecturas que tocaban en él, una tras otra.
+//
+// Cada lectura se publica con un seqlock por sensor: el escritor marca la
+// secuencia como impar mientras copia y los lectores reintentan si la ven
+// impar o cambiada, así que temp y hum siempre salen de la misma muestra sin
+// bloquear a nadie.
+
+#define SENSOR_TASK_STACK 4096
+#define SENSOR_TASK_PRIORITY 2
+
+enum SensorStatus : uint8_t { SENSOR_NONE, SENSOR_OK, SENSOR_ERROR };
+
+struct SensorSample {
+  uint32_t seq;   // número de muestra de este sensor (0 = todavía ninguna)
+  uint32_t ts;    // epoch (0 si aún no hay hora NTP)
+  uint32_t ms;    // millis() de la lectura
+  float temp;
+  float hum;      // NaN en sensores sin humedad
+  uint8_t sensor; // índice en SENSOR_TABLE
+  SensorStatus status;
+};
+
+struct SensorJitter {
+  uint32_t lastUs;  // retraso de la última lectura respecto a su instante ideal
+  uint32_t maxUs;
+  uint32_t readUs;  // lo que tardó la última lectura
+};
+
+void sensorBegin();
+// Copia consistente de la última muestra del sensor.
+SensorSample sensorLatest(uint8_t sensor);
+SensorJitter sensorJitter();
@@ -0,0 +1,147 @@
+#pragma once
+#include <Arduino.h>
+#include <DHT.h>
+#include <tuple>
+#include <utility>
+
+// ====== SENSORES DE LA PLACA ======
+// Tabla fija en tiempo de compilación. Cada entrada tiene un id corto (el que
+// aparece en el histórico, la API y las subidas), un tipo y un pin. El índice
+// en la tabla es el id numérico que se guarda en flash, así que conviene
+// añadir sensores al final y no reordenar.
+//
+// Para otra instalación basta con cambiar SENSOR_TABLE_ENTRIES, aquí o por
+// build_flags. Por ejemplo, dos DHT22 y la temperatura interna del chip:
+//   {"dht0", SENSOR_DHT22, 4}, {"dht1", SENSOR_DHT22, 5}, {"chip", SENSOR_CHIP, 0}
+//
+// Para pruebas de carga sin hardware hay sensores simulados (sensor_sim.h):
+// -DSENSOR_TABLE_ENTRIES=SIM_SENSORS_4, o -DSENSOR_SIMULATE para que los DHT
+// de la tabla sean simulados conservando sus ids.
+
+enum SensorKind : uint8_t {
+  SENSOR_DHT22,
+  SENSOR_DHT11,
+  SENSOR_CHIP,  // temperatureRead(), sin humedad
+  SENSOR_SIM,   // simulado (sensor_sim.h); el pin es el perfil
+};
+
+// Cada sensor se lee una vez por SENSOR_PERIOD_US. Por debajo de 2 s el DHT22
+// devuelve la lectura anterior, así que valores más bajos solo tienen sentido
+// con sensores simulados.
+#ifndef SENSOR_PERIOD_US
+#define SENSOR_PERIOD_US 3000000UL
+#endif
+#define SENSOR_PERIOD_MS ((SENSOR_PERIOD_US + 999) / 1000)
+
+#include "sensor_sim.h"
+
+struct SensorDef {
+  const char* id;
+  SensorKind kind;
+  uint8_t pin;
+};
+
+#ifndef SENSOR_TABLE_ENTRIES
+#define SENSOR_TABLE_ENTRIES {"dht0", SENSOR_DHT22, 4}
+#endif
+
+constexpr SensorDef SENSOR_TABLE[] = {SENSOR_TABLE_ENTRIES};
+constexpr uint8_t SENSOR_COUNT = sizeof(SENSOR_TABLE) / sizeof(SENSOR_TABLE[0]);
+static_assert(SENSOR_COUNT > 0 && SENSOR_COUNT <= 8, "Entre 1 y 8 sensores");
+
+inline const char* sensorId(uint8_t sensor) {
+  return SENSOR_TABLE[sensor < SENSOR_COUNT ? sensor : 0].id;
+}
+
+// Índice del sensor con ese id, o -1.
+inline int sensorIndex(const char* id) {
+  for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+    if (!strcmp(SENSOR_TABLE[i].id, id)) return i;
+  }
+  return -1;
+}
+
+// Con cargas altas no se imprime cada lectura ni cada guardado: a 115200
+// baudios el puerto serie sería lo primero en saturarse.
+constexpr bool SENSOR_LOG_EACH = SENSOR_PERIOD_US / SENSOR_COUNT >= 250000;
+
+// ====== DRIVERS ======
+// Un driver por tipo, elegido por plantilla: la tarea del sensor los guarda
+// en una tupla y los llama sin funciones virtuales. Se construyen con
+// (pin, índice en la tabla).
+template <SensorKind K>
+struct SensorDriver;
+
+template <>
+struct SensorDriver<SENSOR_SIM> : SimDriver {
+  using SimDriver::SimDriver;
+};
+
+#ifdef SENSOR_SIMULATE
+template <>
+struct SensorDriver<SENSOR_DHT22> : SimDriver {
+  SensorDriver(uint8_t, uint8_t index) : SimDriver(SIM_INDOOR, index) {}
+};
+
+template <>
+struct SensorDriver<SENSOR_DHT11> : SimDriver {
+  SensorDriver(uint8_t, uint8_t index) : SimDriver(SIM_INDOOR, index) {}
+};
+#else
+template <uint8_t DhtType>
+struct DhtDriver {
+  DHT dht;
+  DhtDriver(uint8_t pin, uint8_t) : dht(pin, DhtType) {}
+  void begin() { dht.begin(); }
+  void read(float& temp, float& hum) {
+    hum = dht.readHumidity();
+    temp = dht.readTemperature();
+  }
+};
+
+template <>
+struct SensorDriver<SENSOR_DHT22> : DhtDriver<DHT22> {
+  using DhtDriver<DHT22>::DhtDriver;
+};
+
+template <>
+struct SensorDriver<SENSOR_DHT11> : DhtDriver<DHT11> {
+  using DhtDriver<DHT11>::DhtDriver;
+};
+#endif
+
+template <>
+struct SensorDriver<SENSOR_CHIP> {
+  SensorDriver(uint8_t, uint8_t) {}
+  void begin() {}
+  void read(float& temp, float& hum) {
+    temp = temperatureRead();
+    hum = NAN;
+  }
+};
+
+// El chip solo da temperatura: su lectura es válida sin humedad.
+constexpr bool sensorHasHumidity(uint8_t sensor) {
+  return SENSOR_TABLE[sensor].kind != SENSOR_CHIP;
+}
+
+template <size_t... I>
+std::tuple<SensorDriver<SENSOR_TABLE[I].kind>...> makeSensorDrivers(std::index_sequence<I...>) {
+  return std::tuple<SensorDriver<SENSOR_TABLE[I].kind>...>(
+      SensorDriver<SENSOR_TABLE[I].kind>(SENSOR_TABLE[I].pin, I)...);
+}
+
+using SensorDrivers = decltype(makeSensorDrivers(std::make_index_sequence<SENSOR_COUNT>()));
+
+// Lee el sensor `sensor` de la tupla (una cadena de comparaciones que el
+// compilador resuelve, sin vtable).
+template <size_t... I>
+void readSensorDriver(SensorDrivers& drivers, uint8_t sensor, float& temp, float& hum,
+                      std::index_sequence<I...>) {
+  ((sensor == I ? std::get<I>(drivers).read(temp, hum) : void()), ...);
+}
+
+template <size_t... I>
+void beginSensorDrivers(SensorDrivers& drivers, std::index_sequence<I...>) {
+  (std::get<I>(drivers).begin(), ...);
+}
@@ -0,0 +1,85 @@
+#include "static_assets.h"
+
+static StaticAsset assets[ASSETS_MAX];
+static uint8_t assetCount = 0;
+
+static const StaticAsset* findAsset(const String& path) {
+  for (uint8_t i = 0; i < assetCount; i++) {
+    if (path == assets[i].path) return &assets[i];
+  }
+  return nullptr;
+}
+
+uint8_t assetsBegin(fs::FS& fs) {
+  assetCount = 0;
+  File file = fs.open(ASSETS_MANIFEST, "r");
+  if (!file) return 0;
+
+  char line[96];
+  while (file.available() && assetCount < ASSETS_MAX) {
+    size_t n = file.readBytesUntil('\n', line, sizeof(line) - 1);
+    line[n] = '\0';
+    StaticAsset& a = assets[assetCount];
+    char etag[17], encoding[4];
+    if (sscanf(line, "%31s %16s %27s %3s", a.path, etag, a.type, encoding) != 4) continue;
+    snprintf(a.etag, sizeof(a.etag), "\"%s\"", etag);
+    a.gz = strcmp(encoding, "gz") == 0;
+    assetCount++;
+  }
+  file.close();
+  Serial.printf("[Web] %u assets en el manifiesto\n", (unsigned)assetCount);
+  return assetCount;
+}
+
+// true si Accept-Encoding admite gzip: un "gzip", "x-gzip" o "*" que no
+// venga con q=0. Sin la cabecera (curl, scripts) se manda sin comprimir.
+static bool acceptsGzip(const String& header) {
+  int pos = 0;
+  while (pos < (int)header.length()) {
+    int comma = header.indexOf(',', pos);
+    if (comma < 0) comma = header.length();
+    String item = header.substring(pos, comma);
+    pos = comma + 1;
+    int semi = item.indexOf(';');
+    String coding = item.substring(0, semi < 0 ? item.length() : semi);
+    coding.trim();
+    if (!coding.equalsIgnoreCase("gzip") && !coding.equalsIgnoreCase("x-gzip") && coding != "*") continue;
+    if (semi < 0) return true;
+    String params = item.substring(semi + 1);
+    params.replace(" ", "");
+    int q = params.indexOf("q=");
+    if (q < 0 || params.substring(q + 2).toFloat() > 0) return true;
+  }
+  return false;
+}
+
+bool assetsServe(HttpServer& server, fs::FS& fs, String path) {
+  if (path.endsWith("/")) path += "index.html";
+  const StaticAsset* a = findAsset(path);
+  if (!a) return false;
+
+  // Sin nombres con hash, el navegador revalida siempre; el 304 sale de RAM.
+  server.sendHeader("ETag", a->etag);
+  server.sendHeader("Cache-Control", "no-cache");
+  if (a->gz) server.sendHeader("Vary", "Accept-Encoding");
+  if (server.header("If-None-Match") == a->etag) {
+    server.send(304);
+    return true;
+  }
+
+  // Un cliente que no admite gzip recibe el original si se subió también;
+  // web_assets.py normalmente solo deja el .gz, y entonces no hay qué darle.
+  bool gzip = a->gz && acceptsGzip(server.header("Accept-Encoding"));
+  if (a->gz && !gzip && !fs.exists(path)) {
+    server.send(406, "text/plain", "Solo disponible con Content-Encoding: gzip");
+    return true;
+  }
+  File file = fs.open(gzip ? path + ".gz" : path, "r");
+  if (!file) {
+    server.send(404, "text/plain", "404 Not Found");
+    return true;
+  }
+  // streamFile() añade "Content-Encoding: gzip" a los .gz y cierra el File al terminar
+  server.streamFile(file, a->type);
+  return true;
+}
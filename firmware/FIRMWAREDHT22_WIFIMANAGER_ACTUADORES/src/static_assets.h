@@ -0,0 +1,28 @@
+#pragma once
+#include <Arduino.h>
+#include <FS.h>
+#include "http_server.h"
+
+// ====== ARCHIVOS ESTÁTICOS ======
+// scripts/web_assets.py genera build_data/ con los assets comprimidos y un
+// /manifest.txt ("<ruta> <etag> <content-type> <gz|raw>"). Al arrancar se
+// carga en RAM; cada petición se resuelve contra él:
+//   - If-None-Match igual al ETag -> 304, sin abrir nada en la flash
+//   - si no, una sola apertura (del .gz si lo hay y Accept-Encoding admite
+//     gzip) y streamFile(); sin gzip, el original o 406 si solo está el .gz
+// Sin manifiesto (data/ subido a mano, sin comprimir) se sirve como antes.
+
+#define ASSETS_MANIFEST "/manifest.txt"
+#define ASSETS_MAX 16
+
+struct StaticAsset {
+  char path[32];
+  char etag[20];  // con comillas, tal cual va en la cabecera
+  char type[28];
+  bool gz;
+};
+
+// Devuelve cuántos assets hay en el manifiesto (0 si no existe).
+uint8_t assetsBegin(fs::FS& fs);
+// true si la ruta estaba en el manifiesto y se ha contestado.
+bool assetsServe(HttpServer& server, fs::FS& fs, String path);
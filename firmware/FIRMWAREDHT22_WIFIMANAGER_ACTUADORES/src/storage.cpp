@@ -0,0 +1,36 @@
+#include "storage.h"
+#if STORAGE_BACKEND == STORAGE_LITTLEFS
+#include <LittleFS.h>
+#define STORAGE_FS LittleFS
+#else
+#include <SPIFFS.h>
+#define STORAGE_FS SPIFFS
+#endif
+
+fs::FS& storageFs() { return STORAGE_FS; }
+
+size_t storageUsedBytes() { return STORAGE_FS.usedBytes(); }
+
+size_t storageTotalBytes() { return STORAGE_FS.totalBytes(); }
+
+const char* storageName() {
+#if STORAGE_BACKEND == STORAGE_RAW
+  return "raw";
+#elif STORAGE_BACKEND == STORAGE_LITTLEFS
+  return "littlefs";
+#else
+  return "spiffs";
+#endif
+}
+
+bool storageBegin() {
+  if (!STORAGE_FS.begin(true)) {
+    Serial.printf("[%s] Falló el montaje\n", STORAGE_BACKEND == STORAGE_LITTLEFS ? "LittleFS" : "SPIFFS");
+    return false;
+  }
+#if STORAGE_BACKEND == STORAGE_RAW
+  // Sin la partición los anillos no abren, pero la web sigue funcionando
+  partitionBegin();
+#endif
+  return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <Arduino.h>
+#include <FS.h>
+#include "ring_file.h"
+#include "partition_ring.h"
+
+// ====== BACKEND DE ALMACENAMIENTO ======
+// Se elige al compilar con -DSTORAGE_BACKEND (ver platformio.ini):
+//
+//   STORAGE_SPIFFS    todo en SPIFFS (por defecto, lo de siempre)
+//   STORAGE_LITTLEFS  todo en LittleFS (board_build.filesystem = littlefs)
+//   STORAGE_RAW       los anillos (histórico, agregados y outbox) en la
+//                     partición cruda "logs" (partition_ring.h); la web y la
+//                     configuración siguen en SPIFFS, más pequeña
+//                     (board_build.partitions = partitions_logs.csv)
+//
+// Los módulos no saben cuál es: abren ficheros con storageFs() y declaran
+// sus anillos como RingStore, que es un RingFile sobre storageFs() o un
+// PartitionRing. En native los tres funcionan igual que en la placa: SPIFFS
+// y LittleFS son directorios y la partición un fichero que se comporta como
+// un NOR (lib/ArduinoNative/README.md).
+
+#define STORAGE_SPIFFS 1
+#define STORAGE_LITTLEFS 2
+#define STORAGE_RAW 3
+
+#ifndef STORAGE_BACKEND
+#define STORAGE_BACKEND STORAGE_SPIFFS
+#endif
+
+bool storageBegin();
+fs::FS& storageFs();
+const char* storageName();  // "spiffs", "littlefs" o "raw"
+// Del sistema de archivos (fs::FS no los tiene en la placa)
+size_t storageUsedBytes();
+size_t storageTotalBytes();
+
+#if STORAGE_BACKEND == STORAGE_RAW
+class RingStore : public PartitionRing {
+ public:
+  RingStore(const char* path, uint16_t recordSize, uint32_t capacity) : PartitionRing(path, recordSize, capacity) {}
+};
+#else
+class RingStore : public RingFile {
+ public:
+  RingStore(const char* path, uint16_t recordSize, uint32_t capacity)
+      : RingFile(storageFs(), path, recordSize, capacity) {}
+};
+#endif
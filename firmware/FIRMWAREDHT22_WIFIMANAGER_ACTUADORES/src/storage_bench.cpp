@@ -0,0 +1,240 @@
+#include "storage_bench.h"
+
+#ifdef STORAGE_BENCH
+#include <SPIFFS.h>
+#include <LittleFS.h>
+#include "ring_file.h"
+#include "partition_ring.h"
+#include "json_writer.h"
+
+#define BENCH_RING_PATH "/bench.bin"
+#define BENCH_FILL_DIR "/fill"
+
+struct BenchRecord {
+  uint32_t ts;
+  uint8_t payload[STORAGE_BENCH_RECORD - sizeof(uint32_t)];
+};
+
+struct BenchPhase {
+  float appendPerS;
+  uint32_t appendP50, appendP99, appendMax;
+  uint32_t readP50, readP99;
+};
+
+struct BenchResult {
+  uint32_t capacity;
+  uint32_t createMs, mountMs;
+  BenchPhase empty, full;
+  uint32_t appends, pages, erases;
+};
+
+static uint32_t samples[STORAGE_BENCH_APPENDS];
+static uint32_t nextTs = 0;
+
+// Igual que bench.cpp: en native se mide con el reloj real.
+static uint32_t nowMicros() {
+#ifdef ARDUINO_NATIVE
+  return (uint32_t)native::realMicros();
+#else
+  return micros();
+#endif
+}
+
+static uint32_t pick(uint32_t* v, uint32_t n, uint32_t permille) {
+  std::sort(v, v + n);
+  return n ? v[min<uint32_t>(n - 1, (uint64_t)n * permille / 1000)] : 0;
+}
+
+static BenchRecord makeRecord() {
+  BenchRecord r;
+  r.ts = nextTs;
+  nextTs += 10;
+  for (uint32_t i = 0; i < sizeof(r.payload); i++) r.payload[i] = (uint8_t)(r.ts + i);
+  return r;
+}
+
+// ====== MEDIDAS SOBRE UN ANILLO ======
+static uint32_t erasesOf(RingFile&) { return 0; }
+static uint32_t erasesOf(PartitionRing& ring) { return ring.erases(); }
+
+// Solo cuentan para páginas y borrados los appends medidos (con sync).
+template <typename Ring>
+static void measure(Ring& ring, BenchPhase& phase, BenchResult& result) {
+  uint32_t pages = ring.programs(), erases = erasesOf(ring);
+  uint32_t start = nowMicros();
+  for (uint32_t i = 0; i < STORAGE_BENCH_APPENDS; i++) {
+    BenchRecord r = makeRecord();
+    uint32_t t0 = nowMicros();
+    ring.append(&r);
+    samples[i] = nowMicros() - t0;
+  }
+  uint32_t total = nowMicros() - start;
+  result.appends += STORAGE_BENCH_APPENDS;
+  result.pages += ring.programs() - pages;
+  result.erases += erasesOf(ring) - erases;
+  phase.appendPerS = total ? STORAGE_BENCH_APPENDS * 1e6f / total : 0;
+  phase.appendMax = pick(samples, STORAGE_BENCH_APPENDS, 999);
+  phase.appendP50 = pick(samples, STORAGE_BENCH_APPENDS, 500);
+  phase.appendP99 = pick(samples, STORAGE_BENCH_APPENDS, 990);
+
+  // Rangos que empiezan en un instante al azar de lo que hay en el anillo
+  static BenchRecord block[STORAGE_BENCH_SPAN];
+  BenchRecord first, last;
+  ring.read(ring.head(), &first);
+  ring.read(ring.tail() - 1, &last);
+  for (uint32_t i = 0; i < STORAGE_BENCH_READS; i++) {
+    uint32_t t = first.ts + random(last.ts - first.ts + 1);
+    uint32_t t0 = nowMicros();
+    uint32_t seq = ring.lowerBound(t);
+    for (uint32_t got = 0; got < STORAGE_BENCH_SPAN && seq != ring.tail();) {
+      uint32_t n = ring.readBlock(seq, block, STORAGE_BENCH_SPAN - got);
+      if (!n) break;
+      seq += n;
+      got += n;
+    }
+    samples[i] = nowMicros() - t0;
+  }
+  phase.readP50 = pick(samples, STORAGE_BENCH_READS, 500);
+  phase.readP99 = pick(samples, STORAGE_BENCH_READS, 990);
+}
+
+template <typename Ring>
+static void wrap(Ring& ring) {
+  for (uint32_t i = 0; i < ring.capacity(); i++) {
+    BenchRecord r = makeRecord();
+    ring.append(&r, false);
+  }
+  ring.sync();
+}
+
+static void report(const char* backend, const BenchResult& r) {
+  static char buf[640];
+  JsonWriter json(buf, sizeof(buf));
+  json.beginObject()
+      .field("backend", backend).field("record", (uint32_t)STORAGE_BENCH_RECORD).field("capacity", r.capacity)
+      .field("createMs", r.createMs).field("mountMs", r.mountMs);
+  const BenchPhase* phases[] = {&r.empty, &r.full};
+  const char* names[] = {"empty", "full"};
+  for (uint8_t i = 0; i < 2; i++) {
+    const BenchPhase& p = *phases[i];
+    json.key(names[i]).beginObject()
+        .field("appendPerS", p.appendPerS, 0)
+        .field("appendP50", p.appendP50).field("appendP99", p.appendP99).field("appendMax", p.appendMax)
+        .field("readP50", p.readP50).field("readP99", p.readP99)
+        .endObject();
+  }
+  json.field("slowdown", r.empty.appendP99 ? (double)r.full.appendP99 / r.empty.appendP99 : 0.0, 2)
+      .field("pagesPerAppend", r.appends ? (double)r.pages / r.appends : 0.0, 2);
+  if (r.erases) json.field("erasesPer1000", 1000.0 * r.erases / r.appends, 1);
+  json.endObject();
+  Serial.printf("STORAGE %s\n", json.c_str());
+}
+
+// ====== SPIFFS / LITTLEFS ======
+static void removeFill(fs::FS& fs) {
+  for (uint32_t i = 0;; i++) {
+    String path = String(BENCH_FILL_DIR "/") + i + ".bin";
+    if (!fs.exists(path)) break;
+    fs.remove(path);
+  }
+  fs.rmdir(BENCH_FILL_DIR);
+}
+
+// Ficheros de relleno hasta que el sistema de archivos esté al `percent` %.
+template <typename Fs>
+static void fillTo(Fs& fs, uint8_t percent) {
+  static uint8_t chunk[4096];
+  memset(chunk, 0xA5, sizeof(chunk));
+  size_t target = fs.totalBytes() / 100 * percent;
+  fs.mkdir(BENCH_FILL_DIR);  // LittleFS no crea directorios al abrir
+  for (uint32_t i = 0; fs.usedBytes() < target; i++) {
+    File f = fs.open(String(BENCH_FILL_DIR "/") + i + ".bin", "w");
+    if (!f) break;
+    bool full = false;
+    for (uint32_t n = 0; n < 16 && !full; n++) full = f.write(chunk, sizeof(chunk)) != sizeof(chunk);
+    f.close();
+    if (full) break;
+  }
+}
+
+template <typename Fs>
+static void benchFs(Fs& fs, const char* backend, bool (*mount)()) {
+  if (!mount()) {
+    Serial.printf("[Storage] %s no monta\n", backend);
+    return;
+  }
+  fs.remove(BENCH_RING_PATH);
+  removeFill(fs);
+  BenchResult result = {};
+  // El anillo ocupa la cuarta parte; el relleno, el resto hasta el 90 %
+  result.capacity = fs.totalBytes() / 4 / STORAGE_BENCH_RECORD;
+  {
+    uint32_t t0 = nowMicros();
+    RingFile ring(fs, BENCH_RING_PATH, STORAGE_BENCH_RECORD, result.capacity);
+    if (!ring.begin()) {
+      Serial.printf("[Storage] %s: no se pudo crear el anillo\n", backend);
+      return;
+    }
+    result.createMs = (nowMicros() - t0) / 1000;
+    measure(ring, result.empty, result);
+    wrap(ring);
+    fillTo(fs, STORAGE_BENCH_FILL);
+    measure(ring, result.full, result);
+  }
+  fs.end();
+  uint32_t t0 = nowMicros();
+  mount();
+  RingFile ring(fs, BENCH_RING_PATH, STORAGE_BENCH_RECORD, result.capacity);
+  ring.begin();
+  result.mountMs = (nowMicros() - t0) / 1000;
+  report(backend, result);
+  fs.remove(BENCH_RING_PATH);
+  removeFill(fs);
+}
+
+static bool mountSpiffs() { return SPIFFS.begin(true); }
+static bool mountLittleFs() { return LittleFS.begin(true, "/littlefs", 10, "littlefs"); }
+
+// ====== PARTICIÓN CRUDA ======
+// El anillo ocupa el STORAGE_BENCH_FILL % de la partición: tras la primera
+// vuelta está tan lleno como los sistemas de archivos de la segunda pasada.
+static void benchRaw() {
+  if (!partitionFormat()) return;
+  PartitionStats ps = partitionStats();
+  uint32_t slot = (8 + STORAGE_BENCH_RECORD + 3) & ~3u;
+  uint32_t sectors = ps.totalBytes / 100 * STORAGE_BENCH_FILL / PARTITION_SECTOR;
+  sectors -= min(sectors, ps.usedBytes / PARTITION_SECTOR + 1);
+  BenchResult result = {};
+  result.capacity = sectors * (PARTITION_SECTOR / slot);
+  {
+    uint32_t t0 = nowMicros();
+    PartitionRing ring(BENCH_RING_PATH, STORAGE_BENCH_RECORD, result.capacity);
+    if (!ring.begin()) return;
+    result.createMs = (nowMicros() - t0) / 1000;
+    measure(ring, result.empty, result);
+    wrap(ring);
+    measure(ring, result.full, result);
+  }
+  uint32_t t0 = nowMicros();
+  PartitionRing ring(BENCH_RING_PATH, STORAGE_BENCH_RECORD, result.capacity);
+  ring.begin();
+  result.mountMs = (nowMicros() - t0) / 1000;
+  report("raw", result);
+  partitionFormat();
+}
+
+void storageBench() {
+  randomSeed(1);
+  Serial.printf("[Storage] Benchmark: registros de %u bytes, %u appends y %u lecturas por pasada\n",
+                (unsigned)STORAGE_BENCH_RECORD, (unsigned)STORAGE_BENCH_APPENDS, (unsigned)STORAGE_BENCH_READS);
+  benchFs(SPIFFS, "spiffs", mountSpiffs);
+  benchFs(LittleFS, "littlefs", mountLittleFs);
+  benchRaw();
+  Serial.println(F("[Storage] Fin"));
+#ifdef ARDUINO_NATIVE
+  exit(0);
+#else
+  for (;;) delay(1000);
+#endif
+}
+#endif
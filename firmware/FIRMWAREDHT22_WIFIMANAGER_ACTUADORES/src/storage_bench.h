@@ -0,0 +1,35 @@
+#pragma once
+#include <Arduino.h>
+
+// ====== BENCHMARK DE ALMACENAMIENTO ======
+// Solo con -DSTORAGE_BENCH (envs native_storage_bench y
+// esp32doit-devkit-v1_storage_bench, este con partitions_bench.csv, que tiene
+// SPIFFS, LittleFS y la partición cruda a la vez). Sustituye al firmware:
+// storageBench() mide los tres backends con el mismo anillo de registros de
+// STORAGE_BENCH_RECORD bytes y se queda parado. Por cada uno imprime una
+// línea "STORAGE {json}" con:
+//
+//   createMs / mountMs   crear el anillo vacío / montar y abrir el lleno
+//   empty / full         appends por segundo y latencia (µs) p50/p99/max,
+//                        y lecturas de rango (lowerBound + readBlock de
+//                        STORAGE_BENCH_SPAN registros) p50/p99, con el
+//                        almacenamiento vacío y al STORAGE_BENCH_FILL %
+//   slowdown             p99 del append lleno / vacío: cuánto se degrada al
+//                        llenarse (recolección de basura, fragmentación)
+//   pagesPerAppend       páginas de flash que programa cada append
+//   erasesPer1000        borrados de sector por cada 1000 (solo raw; en
+//                        SPIFFS/LittleFS los decide el sistema de archivos)
+//
+// Borra los anillos de la partición cruda: no usar en una placa con datos.
+// En native SPIFFS y LittleFS son el mismo directorio del host, así que solo
+// la partición cruda (que emula el NOR) da números comparables con la placa.
+
+#define STORAGE_BENCH_RECORD 64
+#define STORAGE_BENCH_APPENDS 500
+#define STORAGE_BENCH_READS 200
+#define STORAGE_BENCH_SPAN 32
+#define STORAGE_BENCH_FILL 90  // % ocupado en la segunda pasada
+
+#ifdef STORAGE_BENCH
+void storageBench();
+#endif
@@ -0,0 +1,251 @@
+#include "uploader.h"
+#include "metrics.h"
+#include "storage.h"
+#include "json_writer.h"
+#include "sensors.h"
+#include "boot.h"
+#include <WiFi.h>
+#include <HTTPClient.h>
+#include <time.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+// La tarea de Arduino (loop) corre en el núcleo 1; la red va al 0.
+static const BaseType_t UPLOADER_CORE = 0;
+static const uint32_t UPLOADER_STACK = 8192;
+static const uint16_t HTTP_TIMEOUT_MS = 8000;
+static const time_t MIN_VALID_EPOCH = 1600000000;  // antes de esto no hay hora NTP
+
+static QueueHandle_t uploadQueue = nullptr;
+static_assert(sizeof(UploadItem) == 76, "Mismo registro que los outbox ya grabados");
+static RingStore outbox("/outbox.bin", sizeof(UploadItem), UPLOAD_OUTBOX_CAPACITY);
+static const char* uploadURL = nullptr;
+static const char* uploadDeviceId = nullptr;
+static char uploadMac[7] = "";
+static uint16_t bootId = 0;  // al azar en cada arranque, nunca 0
+
+// Cuerpo del POST: se reutiliza para todos los lotes (sin heap).
+static char batchBuf[UPLOAD_BATCH_MAX * 192 + 8];
+
+static std::atomic<uint32_t> statEnqueued{0};
+static std::atomic<uint32_t> statQueueFull{0};
+static std::atomic<uint32_t> statDropped{0};
+static std::atomic<uint32_t> statHighWater{0};
+static std::atomic<uint32_t> statPending{0};
+static std::atomic<uint32_t> statOverwritten{0};
+static std::atomic<uint32_t> statBatches{0};
+static std::atomic<uint32_t> statSent{0};
+static std::atomic<uint32_t> statFailed{0};
+static std::atomic<uint32_t> statBackoffMs{0};
+static std::atomic<int32_t> statLastCode{0};
+
+// Epoch del registro; 0 si se encoló sin hora y ya no se puede saber.
+// (En outboxes anteriores `boot` era relleno: manda el ts.)
+static uint32_t itemEpoch(const UploadItem& item) {
+  if (item.ts >= MIN_VALID_EPOCH) return item.ts;
+  if (!item.ts || item.boot != bootId) return 0;
+  return bootEpoch((item.ts - 1) * 1000);
+}
+
+static size_t formatItem(const UploadItem& item, char* out, size_t len) {
+  JsonWriter json(out, len);
+  json.beginObject();
+  if (item.kind == UPLOAD_DATOS) {
+    json.field("type", "Datos").field("deviceId", uploadDeviceId).field("mac", uploadMac)
+        .field("sensor", sensorId(item.sensor)).field("temp", item.temp, 2).field("hum", item.hum, 2);
+  } else {
+    json.field("type", "Estados").field("deviceId", uploadDeviceId).field("mac", uploadMac)
+        .field("evento", item.evento).field("motivo", item.motivo).field("tempChip", item.temp, 2);
+  }
+  uint32_t ts = itemEpoch(item);
+  if (ts) json.field("ts", ts);
+  json.endObject();
+  return json.overflow() ? 0 : json.length();
+}
+
+// Arma "[{...},{...}]" con los registros más antiguos del outbox.
+// Devuelve cuántos registros entraron en el lote.
+static uint32_t buildBatch(size_t& len) {
+  JsonWriter batch(batchBuf, sizeof(batchBuf));
+  batch.beginArray();
+  uint32_t count = 0;
+  uint32_t available = min<uint32_t>(outbox.size(), UPLOAD_BATCH_MAX);
+  for (uint32_t i = 0; i < available; i++) {
+    UploadItem item;
+    if (!outbox.read(outbox.head() + i, &item)) break;
+    char one[256];
+    size_t n = formatItem(item, one, sizeof(one));
+    // Deja sitio para la coma y el ']' final; si no cabe va en el siguiente lote.
+    if (!n || batch.length() + n + 2 >= sizeof(batchBuf)) break;
+    batch.rawValue(one, n);
+    count++;
+  }
+  batch.endArray();
+  len = batch.length();
+  return count;
+}
+
+static bool postBatch() {
+  size_t len;
+  uint32_t count = buildBatch(len);
+  if (!count) return false;
+
+  uint32_t start = micros();
+  HTTPClient http;
+  http.setTimeout(HTTP_TIMEOUT_MS);
+  http.begin(uploadURL);
+  http.addHeader("Content-Type", "application/json");
+  int httpResponseCode = http.POST((uint8_t*)batchBuf, len);
+  http.end();
+  statLastCode = httpResponseCode;
+  metricsUpload(httpResponseCode, micros() - start);
+
+  // Apps Script responde 302 a la URL del resultado: también es un acuse.
+  if (httpResponseCode >= 200 && httpResponseCode < 400) {
+    outbox.consume(count);
+    statBatches++;
+    statSent += count;
+    Serial.printf("Lote enviado! %u registros, Código: %d\n", (unsigned)count, httpResponseCode);
+    return true;
+  }
+  statFailed++;
+  Serial.printf("Error enviando lote de %u registros: %d\n", (unsigned)count, httpResponseCode);
+  return false;
+}
+
+static void uploaderTask(void*) {
+  // Todo lo que se sube pasa por el outbox: sin él se reintenta abrirlo y,
+  // mientras, lo encolado espera en uploadQueue (si se llena, enqueue()
+  // descarta lo más antiguo y lo cuenta en statDropped).
+  uint32_t openBackoffMs = UPLOAD_BACKOFF_MIN_MS;
+  while (!outbox.begin()) {
+    Serial.printf("[Uploader] No se pudo abrir el outbox, se reintenta en %u s\n", (unsigned)(openBackoffMs / 1000));
+    vTaskDelay(pdMS_TO_TICKS(openBackoffMs));
+    openBackoffMs = min<uint32_t>(openBackoffMs * 2, UPLOAD_BACKOFF_MAX_MS);
+  }
+  if (outbox.size()) {
+    Serial.printf("[Uploader] %u registros pendientes de un arranque anterior\n", (unsigned)outbox.size());
+  }
+
+  // Lo que quedó de otro arranque ya cumplió su intervalo: se intenta enseguida.
+  unsigned long firstPendingMs = millis() - UPLOAD_BATCH_INTERVAL_MS;
+  unsigned long nextAttemptMs = millis();
+  uint32_t backoffMs = 0;
+  bool urgent = false;
+
+  for (;;) {
+    UploadItem item;
+    while (xQueueReceive(uploadQueue, &item, pdMS_TO_TICKS(1000)) == pdTRUE) {
+      if (!outbox.size()) firstPendingMs = millis();
+      if (item.kind == UPLOAD_ESTADOS) urgent = true;
+      outbox.append(&item);
+      if (outbox.size() >= UPLOAD_BATCH_MAX) break;
+    }
+    statPending = outbox.size();
+    statOverwritten = outbox.overwritten();
+
+    if (!outbox.size()) continue;
+    if ((long)(millis() - nextAttemptMs) < 0) continue;
+    bool due = urgent || outbox.size() >= UPLOAD_BATCH_MAX ||
+               millis() - firstPendingMs >= UPLOAD_BATCH_INTERVAL_MS;
+    if (!due || WiFi.status() != WL_CONNECTED) continue;
+    if (!bootTimeValid() && millis() < UPLOAD_TIME_WAIT_MS) continue;
+
+    if (postBatch()) {
+      backoffMs = 0;
+      urgent = false;
+      // Si queda algo es porque ya estaba atrasado: sigue sin esperar.
+      if (!outbox.size()) firstPendingMs = millis();
+    } else {
+      backoffMs = backoffMs ? min<uint32_t>(backoffMs * 2, UPLOAD_BACKOFF_MAX_MS) : UPLOAD_BACKOFF_MIN_MS;
+      nextAttemptMs = millis() + backoffMs + random(backoffMs / 4 + 1);
+    }
+    statBackoffMs = backoffMs;
+    statPending = outbox.size();
+  }
+}
+
+bool uploaderBegin(const char* url, const char* deviceId, const String& mac) {
+  if (uploadQueue) return true;
+  uploadURL = url;
+  bootId = esp_random() % 0xFFFF + 1;
+  uploadDeviceId = deviceId;
+  strlcpy(uploadMac, mac.c_str(), sizeof(uploadMac));
+
+  uploadQueue = xQueueCreate(UPLOAD_QUEUE_LEN, sizeof(UploadItem));
+  if (!uploadQueue) {
+    Serial.println(F("[Uploader] No se pudo crear la cola"));
+    return false;
+  }
+  if (xTaskCreatePinnedToCore(uploaderTask, "uploader", UPLOADER_STACK, nullptr, 1,
+                              nullptr, UPLOADER_CORE) != pdPASS) {
+    Serial.println(F("[Uploader] No se pudo crear la tarea"));
+    vQueueDelete(uploadQueue);
+    uploadQueue = nullptr;
+    return false;
+  }
+  return true;
+}
+
+// Nunca bloquea: si la cola está llena saca la entrada más antigua y reintenta.
+static bool enqueue(UploadItem& item) {
+  if (!uploadQueue) return false;
+
+  time_t now = time(nullptr);
+  bool hasTime = now >= MIN_VALID_EPOCH;
+  item.ts = hasTime ? (uint32_t)now : millis() / 1000 + 1;
+  item.boot = hasTime ? 0 : bootId;
+
+  bool droppedOld = false;
+  while (xQueueSend(uploadQueue, &item, 0) != pdTRUE) {
+    statQueueFull++;
+    UploadItem oldest;
+    if (xQueueReceive(uploadQueue, &oldest, 0) == pdTRUE) {
+      statDropped++;
+      droppedOld = true;
+    }
+  }
+  statEnqueued++;
+
+  uint32_t depth = uxQueueMessagesWaiting(uploadQueue);
+  uint32_t hw = statHighWater.load();
+  while (depth > hw && !statHighWater.compare_exchange_weak(hw, depth)) {}
+  return !droppedOld;
+}
+
+bool uploaderEnqueueReading(uint8_t sensor, float temp, float hum) {
+  UploadItem item = {};
+  item.kind = UPLOAD_DATOS;
+  item.sensor = sensor;
+  item.temp = temp;
+  item.hum = hum;
+  return enqueue(item);
+}
+
+bool uploaderEnqueueEvent(const char* evento, const char* motivo, float chipTemp) {
+  UploadItem item = {};
+  item.kind = UPLOAD_ESTADOS;
+  item.temp = chipTemp;
+  strlcpy(item.evento, evento, sizeof(item.evento));
+  strlcpy(item.motivo, motivo, sizeof(item.motivo));
+  return enqueue(item);
+}
+
+UploaderStats uploaderStats() {
+  UploaderStats s;
+  s.enqueued = statEnqueued;
+  s.queueFull = statQueueFull;
+  s.dropped = statDropped;
+  s.depth = uploadQueue ? uxQueueMessagesWaiting(uploadQueue) : 0;
+  s.highWater = statHighWater;
+  s.pending = statPending;
+  s.overwritten = statOverwritten;
+  s.batches = statBatches;
+  s.sent = statSent;
+  s.failed = statFailed;
+  s.backoffMs = statBackoffMs;
+  s.lastCode = statLastCode;
+  return s;
+}
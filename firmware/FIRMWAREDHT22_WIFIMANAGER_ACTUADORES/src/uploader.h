@@ -0,0 +1,61 @@
+#pragma once
+#include <Arduino.h>
+
+// ====== SUBIDA A GOOGLE SHEETS EN SEGUNDO PLANO ======
+// loop() solo encola lecturas y eventos en una cola acotada en RAM; una tarea
+// FreeRTOS fijada al núcleo 0 los pasa a un outbox persistente en flash
+// (/outbox.bin) y lo vacía por lotes: un POST con un array JSON cada
+// UPLOAD_BATCH_MAX registros o UPLOAD_BATCH_INTERVAL_MS, lo que llegue antes
+// (los eventos se envían sin esperar). Un lote solo se borra del outbox cuando
+// el servidor responde 2xx/3xx; si falla se reintenta con backoff exponencial.
+// Sin WiFi los registros esperan en flash y sobreviven a un reinicio.
+//
+// Lo encolado antes de tener hora NTP guarda los segundos desde el arranque
+// y se le pone el epoch al enviarlo (boot.h). Por eso no se sube nada hasta
+// tener hora o hasta UPLOAD_TIME_WAIT_MS desde el arranque; lo de otro
+// arranque que no llegó a tener hora sale sin ts, como antes.
+
+#define UPLOAD_QUEUE_LEN 16
+#define UPLOAD_OUTBOX_CAPACITY 2048        // ~5,5 h de lecturas cada 10 s
+#define UPLOAD_BATCH_MAX 30
+#define UPLOAD_BATCH_INTERVAL_MS 300000UL  // 5 min
+#define UPLOAD_BACKOFF_MIN_MS 5000UL
+#define UPLOAD_BACKOFF_MAX_MS 600000UL     // 10 min
+#define UPLOAD_TIME_WAIT_MS 60000UL        // sin hora NTP, se sube igual pasado esto
+
+enum UploadKind : uint8_t {
+  UPLOAD_DATOS = 0,   // Hoja "Datos"
+  UPLOAD_ESTADOS = 1  // Hoja "Estados"
+};
+
+// Registro tal cual se guarda en el outbox (tamaño fijo).
+struct UploadItem {
+  uint32_t ts;       // epoch; sin hora NTP, segundos desde el arranque `boot` + 1
+  UploadKind kind;
+  uint8_t sensor;    // Solo Datos: índice en SENSOR_TABLE (usa el hueco de alineación)
+  uint16_t boot;     // arranque en que se encoló sin hora (0 = ts ya es epoch)
+  float temp;        // Datos: temperatura DHT / Estados: tempChip
+  float hum;         // Solo Datos
+  char evento[20];   // Solo Estados
+  char motivo[40];   // Solo Estados
+};
+
+struct UploaderStats {
+  uint32_t enqueued;     // entradas aceptadas por la cola RAM
+  uint32_t queueFull;    // veces que la cola RAM estaba llena al encolar (backpressure)
+  uint32_t dropped;      // entradas antiguas descartadas de la cola RAM
+  uint32_t depth;        // entradas en la cola RAM ahora mismo
+  uint32_t highWater;    // máximo de entradas en la cola RAM observado
+  uint32_t pending;      // registros en el outbox pendientes de confirmar
+  uint32_t overwritten;  // registros perdidos porque el outbox se llenó
+  uint32_t batches;      // lotes confirmados por el servidor
+  uint32_t sent;         // registros confirmados
+  uint32_t failed;       // lotes fallidos (se reintentan)
+  uint32_t backoffMs;    // espera actual antes del próximo intento
+  int32_t lastCode;      // último código HTTP (o error de HTTPClient)
+};
+
+bool uploaderBegin(const char* url, const char* deviceId, const String& mac);
+bool uploaderEnqueueReading(uint8_t sensor, float temp, float hum);
+bool uploaderEnqueueEvent(const char* evento, const char* motivo, float chipTemp);
+UploaderStats uploaderStats();
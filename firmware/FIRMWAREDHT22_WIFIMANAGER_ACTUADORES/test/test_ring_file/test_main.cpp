@@ -0,0 +1,186 @@
+// Pruebas de RingFile (src/ring_file.h) sobre el SPIFFS de native:
+// recuperación tras una cabecera a medio escribir y redimensionado.
+//   pio test -e native -f test_ring_file
+#include <Arduino.h>
+#include <SPIFFS.h>
+#include <unity.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "ring_file.h"
+
+static const char* PATH = "/ring.bin";
+static const uint32_t HEADER_SLOT = 32;  // como RingFile::HEADER_SLOT
+
+struct Record {
+  uint32_t ts;
+  uint32_t value;
+};
+
+static void appendRange(RingFile& ring, uint32_t from, uint32_t to) {
+  for (uint32_t i = from; i < to; i++) {
+    Record r = {i, i * 10};
+    TEST_ASSERT_TRUE(ring.append(&r));
+  }
+}
+
+// Pisa una copia de la cabecera como lo dejaría un corte a mitad de escritura
+static void tearSlot(const char* path, uint32_t slot) {
+  File f = SPIFFS.open(path, "r+");
+  TEST_ASSERT_TRUE((bool)f);
+  uint8_t garbage[12];
+  memset(garbage, 0x5A, sizeof(garbage));
+  f.seek(slot * HEADER_SLOT + 16);
+  f.write(garbage, sizeof(garbage));
+  f.close();
+}
+
+void setUp() {
+  SPIFFS.remove(PATH);
+  SPIFFS.remove(String(PATH) + ".tmp");
+}
+void tearDown() {}
+
+static void test_reopen_keeps_records() {
+  {
+    RingFile ring(SPIFFS, PATH, sizeof(Record), 8);
+    TEST_ASSERT_TRUE(ring.begin());
+    appendRange(ring, 0, 11);
+    TEST_ASSERT_EQUAL(3, ring.overwritten());
+  }
+  RingFile ring(SPIFFS, PATH, sizeof(Record), 8);
+  TEST_ASSERT_TRUE(ring.begin());
+  TEST_ASSERT_EQUAL(3, ring.head());
+  TEST_ASSERT_EQUAL(11, ring.tail());
+  Record r;
+  TEST_ASSERT_TRUE(ring.read(3, &r));
+  TEST_ASSERT_EQUAL(30, r.value);
+  TEST_ASSERT_EQUAL(5, ring.lowerBound(5));
+}
+
+static void test_torn_header_falls_back_to_other_copy() {
+  uint32_t generation;
+  {
+    RingFile ring(SPIFFS, PATH, sizeof(Record), 8);
+    TEST_ASSERT_TRUE(ring.begin());  // generación 1
+    appendRange(ring, 0, 5);         // generaciones 2..6
+    generation = 6;
+  }
+  // La última cabecera (generación 6, copia 0) queda rota: vale la 5
+  tearSlot(PATH, generation & 1);
+  RingFile ring(SPIFFS, PATH, sizeof(Record), 8);
+  TEST_ASSERT_TRUE(ring.begin());
+  TEST_ASSERT_EQUAL(0, ring.head());
+  TEST_ASSERT_EQUAL(4, ring.tail());
+  Record r;
+  TEST_ASSERT_TRUE(ring.read(3, &r));
+  TEST_ASSERT_EQUAL(30, r.value);
+  // Sigue escribiendo encima sin problemas
+  appendRange(ring, 4, 6);
+  TEST_ASSERT_EQUAL(6, ring.tail());
+}
+
+static void test_both_headers_torn_recreates_empty() {
+  {
+    RingFile ring(SPIFFS, PATH, sizeof(Record), 8);
+    TEST_ASSERT_TRUE(ring.begin());
+    appendRange(ring, 0, 3);
+  }
+  tearSlot(PATH, 0);
+  tearSlot(PATH, 1);
+  RingFile ring(SPIFFS, PATH, sizeof(Record), 8);
+  TEST_ASSERT_TRUE(ring.begin());
+  TEST_ASSERT_EQUAL(0, ring.size());
+}
+
+static void test_resize_keeps_newest_records() {
+  {
+    RingFile ring(SPIFFS, PATH, sizeof(Record), 10);
+    TEST_ASSERT_TRUE(ring.begin());
+    appendRange(ring, 0, 15);
+  }
+  RingFile ring(SPIFFS, PATH, sizeof(Record), 4);
+  TEST_ASSERT_TRUE(ring.begin());
+  TEST_ASSERT_EQUAL(11, ring.head());
+  TEST_ASSERT_EQUAL(15, ring.tail());
+  Record r;
+  TEST_ASSERT_TRUE(ring.read(11, &r));
+  TEST_ASSERT_EQUAL(110, r.value);
+  TEST_ASSERT_FALSE(SPIFFS.exists(String(PATH) + ".tmp"));
+}
+
+static void test_resize_cut_after_remove_recovers_copy() {
+  {
+    RingFile ring(SPIFFS, PATH, sizeof(Record), 4);
+    TEST_ASSERT_TRUE(ring.begin());
+    appendRange(ring, 0, 6);
+  }
+  // Corte entre el remove del original y el rename de la copia verificada
+  TEST_ASSERT_TRUE(SPIFFS.rename(PATH, String(PATH) + ".tmp"));
+  RingFile ring(SPIFFS, PATH, sizeof(Record), 4);
+  TEST_ASSERT_TRUE(ring.begin());
+  TEST_ASSERT_EQUAL(2, ring.head());
+  TEST_ASSERT_EQUAL(6, ring.tail());
+  TEST_ASSERT_FALSE(SPIFFS.exists(String(PATH) + ".tmp"));
+}
+
+static void test_resize_cut_before_remove_keeps_original() {
+  {
+    RingFile ring(SPIFFS, PATH, sizeof(Record), 4);
+    TEST_ASSERT_TRUE(ring.begin());
+    appendRange(ring, 0, 3);
+  }
+  // Copia a medias junto al original intacto: se descarta la copia
+  File tmp = SPIFFS.open(String(PATH) + ".tmp", "w");
+  tmp.write((const uint8_t*)"medio", 5);
+  tmp.close();
+  RingFile ring(SPIFFS, PATH, sizeof(Record), 4);
+  TEST_ASSERT_TRUE(ring.begin());
+  TEST_ASSERT_EQUAL(3, ring.size());
+  TEST_ASSERT_FALSE(SPIFFS.exists(String(PATH) + ".tmp"));
+}
+
+static void test_resize_without_room_keeps_ring() {
+  {
+    RingFile ring(SPIFFS, PATH, sizeof(Record), 8);
+    TEST_ASSERT_TRUE(ring.begin());
+    appendRange(ring, 0, 5);
+  }
+  // Un directorio no vacío con el nombre del .tmp: la copia no se puede
+  // crear, como con la flash llena
+  String tmpDir = String(getenv("NATIVE_FS_ROOT")) + "/spiffs" + PATH + ".tmp";
+  TEST_ASSERT_EQUAL(0, mkdir(tmpDir.c_str(), 0755));
+  FILE* f = fopen((tmpDir + "/x").c_str(), "w");
+  fclose(f);
+
+  RingFile ring(SPIFFS, PATH, sizeof(Record), 4);
+  TEST_ASSERT_TRUE(ring.begin());
+  TEST_ASSERT_EQUAL(8, ring.capacity());
+  TEST_ASSERT_EQUAL(0, ring.head());
+  TEST_ASSERT_EQUAL(5, ring.tail());
+  Record r;
+  TEST_ASSERT_TRUE(ring.read(4, &r));
+  TEST_ASSERT_EQUAL(40, r.value);
+  appendRange(ring, 5, 7);
+  TEST_ASSERT_EQUAL(7, ring.size());
+
+  remove((tmpDir + "/x").c_str());
+  rmdir(tmpDir.c_str());
+}
+
+void setup() {
+  char root[] = "/tmp/test_ring_file_XXXXXX";
+  setenv("NATIVE_FS_ROOT", mkdtemp(root), 1);
+  SPIFFS.begin(true);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_reopen_keeps_records);
+  RUN_TEST(test_torn_header_falls_back_to_other_copy);
+  RUN_TEST(test_both_headers_torn_recreates_empty);
+  RUN_TEST(test_resize_keeps_newest_records);
+  RUN_TEST(test_resize_cut_after_remove_recovers_copy);
+  RUN_TEST(test_resize_cut_before_remove_keeps_original);
+  RUN_TEST(test_resize_without_room_keeps_ring);
+  exit(UNITY_END());
+}
+
+void loop() {}
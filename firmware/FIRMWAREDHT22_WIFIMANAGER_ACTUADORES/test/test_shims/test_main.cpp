@@ -0,0 +1,148 @@
+// Pruebas de los shims de lib/ArduinoNative: que SPIFFS, LittleFS y el
+// WebServer se comporten como en la placa, para que lo que pasa en native
+// valga también para el ESP32.
+//   pio test -e native -f test_shims
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <SPIFFS.h>
+#include <WebServer.h>
+#include <WiFiClient.h>
+#include <unity.h>
+#include <atomic>
+#include <thread>
+
+static const uint16_t TEST_PORT = 18091;
+
+void setUp() {}
+void tearDown() {}
+
+// ====== SISTEMAS DE ARCHIVOS ======
+static void test_spiffs_is_flat() {
+  // En SPIFFS una ruta con '/' es solo un nombre: se abre sin mkdir
+  File f = SPIFFS.open("/plano/a.bin", "w");
+  TEST_ASSERT_TRUE((bool)f);
+  TEST_ASSERT_EQUAL(3, f.write((const uint8_t*)"abc", 3));
+  f.close();
+  TEST_ASSERT_TRUE(SPIFFS.exists("/plano/a.bin"));
+}
+
+static void test_littlefs_needs_parent_dir() {
+  TEST_ASSERT_FALSE((bool)LittleFS.open("/dir/a.bin", "w"));
+  TEST_ASSERT_FALSE((bool)LittleFS.open("/dir/a.bin", "a"));
+  TEST_ASSERT_FALSE(LittleFS.mkdir("/p/q"));  // un solo nivel, como en la placa
+  TEST_ASSERT_TRUE(LittleFS.mkdir("/dir"));
+  File f = LittleFS.open("/dir/a.bin", "a");
+  TEST_ASSERT_TRUE((bool)f);
+  f.close();
+  // create=true sí crea los directorios intermedios
+  f = LittleFS.open("/p/q/b.bin", "w", true);
+  TEST_ASSERT_TRUE((bool)f);
+  f.close();
+  TEST_ASSERT_TRUE(LittleFS.exists("/p/q/b.bin"));
+}
+
+static void test_file_seek_read_rename() {
+  File f = SPIFFS.open("/datos.bin", "w");
+  const uint8_t data[] = {1, 2, 3, 4, 5, 6, 7, 8};
+  TEST_ASSERT_EQUAL(sizeof(data), f.write(data, sizeof(data)));
+  f.close();
+
+  f = SPIFFS.open("/datos.bin", "r+");
+  TEST_ASSERT_EQUAL(sizeof(data), f.size());
+  TEST_ASSERT_TRUE(f.seek(4));
+  const uint8_t patch[] = {9, 9};
+  TEST_ASSERT_EQUAL(2, f.write(patch, 2));
+  TEST_ASSERT_TRUE(f.seek(3));
+  uint8_t got[3];
+  TEST_ASSERT_EQUAL(3, f.read(got, 3));
+  const uint8_t expected[] = {4, 9, 9};
+  TEST_ASSERT_EQUAL_MEMORY(expected, got, 3);
+  f.close();
+
+  TEST_ASSERT_TRUE(SPIFFS.rename("/datos.bin", "/otro.bin"));
+  TEST_ASSERT_FALSE(SPIFFS.exists("/datos.bin"));
+  TEST_ASSERT_TRUE(SPIFFS.exists("/otro.bin"));
+  TEST_ASSERT_TRUE(SPIFFS.remove("/otro.bin"));
+  TEST_ASSERT_FALSE((bool)SPIFFS.open("/otro.bin", "r"));
+}
+
+// ====== WEBSERVER ======
+// Manda `raw` desde otro hilo y atiende con handleClient() hasta que el
+// cliente tiene la respuesta completa (el WebServer cierra al terminar).
+static String roundTrip(WebServer& server, const char* raw) {
+  String response;
+  std::atomic<bool> done{false};
+  std::thread client([&]() {
+    WiFiClient c;
+    if (c.connect("127.0.0.1", TEST_PORT)) {
+      c.write((const uint8_t*)raw, strlen(raw));
+      unsigned long start = millis();
+      while (millis() - start < 3000) {
+        int ch = c.read();
+        if (ch >= 0) response += (char)ch;
+        else if (!c.connected()) break;
+        else delay(1);
+      }
+      c.stop();
+    }
+    done = true;
+  });
+  while (!done) server.handleClient();
+  client.join();
+  return response;
+}
+
+static void test_webserver_args_headers_response() {
+  WebServer server(TEST_PORT);
+  const char* keys[] = {"X-Prueba"};
+  server.collectHeaders(keys, 1);
+  server.on("/eco", HTTP_POST, [&]() {
+    String body = server.arg("q") + "," + server.arg("form") + "," + server.header("X-Prueba");
+    server.sendHeader("X-Respuesta", "si");
+    server.send(200, "text/plain", body);
+  });
+  server.begin();
+
+  String r = roundTrip(server,
+                       "POST /eco?q=hola%20mundo HTTP/1.1\r\n"
+                       "Content-Type: application/x-www-form-urlencoded\r\n"
+                       "content-length: 8\r\n"
+                       "x-prueba: 42\r\n"
+                       "\r\n"
+                       "form=a+b");
+  server.close();
+  TEST_ASSERT_TRUE(r.startsWith("HTTP/1.1 200 OK\r\n"));
+  TEST_ASSERT_TRUE(r.indexOf("X-Respuesta: si\r\n") > 0);
+  TEST_ASSERT_TRUE(r.indexOf("Content-Length: 17\r\n") > 0);
+  TEST_ASSERT_TRUE(r.endsWith("\r\n\r\nhola mundo,a b,42"));
+}
+
+static void test_webserver_method_and_not_found() {
+  WebServer server(TEST_PORT);
+  server.on("/solo-get", HTTP_GET, [&]() { server.send(200, "text/plain", "ok"); });
+  server.begin();
+  String r = roundTrip(server, "POST /solo-get HTTP/1.1\r\nContent-Length: 0\r\n\r\n");
+  TEST_ASSERT_TRUE(r.startsWith("HTTP/1.1 404 Not Found\r\n"));
+  r = roundTrip(server, "GET /solo-get HTTP/1.1\r\n\r\n");
+  server.close();
+  TEST_ASSERT_TRUE(r.startsWith("HTTP/1.1 200 OK\r\n"));
+  TEST_ASSERT_TRUE(r.endsWith("\r\n\r\nok"));
+}
+
+void setup() {
+  // Cada ejecución en un directorio nuevo (NATIVE_FS_ROOT se lee en begin())
+  char root[] = "/tmp/test_shims_XXXXXX";
+  setenv("NATIVE_FS_ROOT", mkdtemp(root), 1);
+  SPIFFS.begin(true);
+  LittleFS.begin(true);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_spiffs_is_flat);
+  RUN_TEST(test_littlefs_needs_parent_dir);
+  RUN_TEST(test_file_seek_read_rename);
+  RUN_TEST(test_webserver_args_headers_response);
+  RUN_TEST(test_webserver_method_and_not_found);
+  exit(UNITY_END());
+}
+
+void loop() {}
@@ -0,0 +1,149 @@
+// Pruebas del uploader (src/uploader.h) contra un servidor HTTP lento en
+// 127.0.0.1: mientras la tarea está esperando la respuesta del POST, encolar
+// desde loop() no se bloquea; un lote solo sale del outbox con 2xx y un fallo
+// pone el backoff.
+//   pio test -e native -f test_uploader
+#include <Arduino.h>
+#include <WiFiServer.h>
+#include <unity.h>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "storage.h"
+#include "uploader.h"
+
+static const uint16_t TEST_PORT = 18092;
+static const uint32_t REPLY_DELAY_MS = 1500;  // lo que tarda en contestar Apps Script en un día malo
+static const uint32_t ENQUEUE_MAX_US = 5000;  // cota holgada para una llamada que no espera
+
+// ====== SERVIDOR DE PRUEBA ======
+static std::atomic<int> replyCode{200};
+static std::atomic<bool> inFlight{false};  // petición recibida, respuesta aún no enviada
+static std::atomic<uint32_t> posts{0};
+static std::mutex bodyMutex;
+static String lastBody;
+
+static void serveOne(WiFiClient& c) {
+  String req;
+  long contentLength = -1;
+  int headerEnd = -1;
+  unsigned long start = millis();
+  while (millis() - start < 5000) {
+    int ch = c.read();
+    if (ch < 0) {
+      if (!c.connected()) return;
+      delay(1);
+      continue;
+    }
+    req += (char)ch;
+    if (headerEnd < 0 && req.endsWith("\r\n\r\n")) {
+      headerEnd = req.length();
+      String head = req;
+      head.toLowerCase();
+      int p = head.indexOf("content-length:");
+      contentLength = p >= 0 ? head.substring(p + 15).toInt() : 0;
+    }
+    if (headerEnd >= 0 && (long)req.length() - headerEnd >= contentLength) break;
+  }
+  if (headerEnd < 0) return;
+
+  {
+    std::lock_guard<std::mutex> lock(bodyMutex);
+    lastBody = req.substring(headerEnd);
+  }
+  inFlight = true;
+  delay(REPLY_DELAY_MS);
+  posts++;
+  String resp = String("HTTP/1.1 ") + String(replyCode.load()) +
+                " X\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+  c.write((const uint8_t*)resp.c_str(), resp.length());
+  c.stop();
+  inFlight = false;
+}
+
+static void slowServer() {
+  WiFiServer server(TEST_PORT);
+  server.begin();
+  for (;;) {
+    WiFiClient c = server.accept();
+    if (c) serveOne(c);
+    else delay(5);
+  }
+}
+
+static bool waitFor(const std::function<bool()>& cond, uint32_t ms) {
+  unsigned long start = millis();
+  while (!cond()) {
+    if (millis() - start > ms) return false;
+    delay(10);
+  }
+  return true;
+}
+
+void setUp() {}
+void tearDown() {}
+
+// ====== PRUEBAS ======
+static void test_enqueue_does_not_block_during_slow_post() {
+  replyCode = 200;
+  TEST_ASSERT_TRUE(uploaderEnqueueEvent("Prueba", "lote urgente", 40.0f));
+  TEST_ASSERT_TRUE(waitFor([] { return inFlight.load(); }, 5000));
+
+  // La tarea está dentro de http.POST(): loop() sigue encolando sin esperar
+  // (con la cola llena se descarta lo más antiguo, pero nunca se bloquea).
+  uint32_t worstUs = 0;
+  for (int i = 0; i < 200; i++) {
+    uint32_t start = micros();
+    uploaderEnqueueReading(0, 20.0f + i / 100.0f, 50.0f);
+    worstUs = max(worstUs, (uint32_t)(micros() - start));
+  }
+  TEST_ASSERT_TRUE(inFlight.load());
+  TEST_ASSERT_LESS_THAN(ENQUEUE_MAX_US, worstUs);
+  TEST_ASSERT_GREATER_THAN(0, uploaderStats().dropped);
+
+  TEST_ASSERT_TRUE(waitFor([] { return uploaderStats().sent >= 1; }, 10000));
+  UploaderStats s = uploaderStats();
+  TEST_ASSERT_EQUAL(1, s.batches);
+  TEST_ASSERT_EQUAL(200, s.lastCode);
+  TEST_ASSERT_EQUAL(0, s.backoffMs);
+  std::lock_guard<std::mutex> lock(bodyMutex);
+  TEST_ASSERT_TRUE(lastBody.startsWith("[{\"type\":\"Estados\""));
+  TEST_ASSERT_TRUE(lastBody.indexOf("\"deviceId\":\"test\"") > 0);
+  TEST_ASSERT_TRUE(lastBody.endsWith("]"));
+}
+
+static void test_failed_post_keeps_outbox_and_backs_off() {
+  // Las lecturas de la prueba anterior esperan en el outbox (no hay lote
+  // lleno ni evento); un evento fuerza el envío y el servidor falla.
+  TEST_ASSERT_TRUE(waitFor([] { return uploaderStats().depth == 0; }, 5000));
+  replyCode = 500;
+  uint32_t postsBefore = posts;
+  TEST_ASSERT_TRUE(uploaderEnqueueEvent("Prueba", "debe fallar", 40.0f));
+  TEST_ASSERT_TRUE(waitFor([] { return uploaderStats().failed >= 1; }, 10000));
+  TEST_ASSERT_TRUE(waitFor([] { return uploaderStats().backoffMs != 0; }, 2000));
+
+  UploaderStats s = uploaderStats();
+  TEST_ASSERT_EQUAL(postsBefore + 1, posts.load());
+  TEST_ASSERT_EQUAL(500, s.lastCode);
+  TEST_ASSERT_EQUAL(1, s.batches);
+  TEST_ASSERT_EQUAL(UPLOAD_BACKOFF_MIN_MS, s.backoffMs);
+  TEST_ASSERT_GREATER_THAN(UPLOAD_QUEUE_LEN, s.pending);  // nada sale del outbox sin 2xx
+  std::lock_guard<std::mutex> lock(bodyMutex);
+  TEST_ASSERT_TRUE(lastBody.indexOf("debe fallar") > 0);
+}
+
+void setup() {
+  char root[] = "/tmp/test_uploader_XXXXXX";
+  setenv("NATIVE_FS_ROOT", mkdtemp(root), 1);
+  std::thread(slowServer).detach();
+  storageBegin();
+  uploaderBegin("http://127.0.0.1:18092/exec", "test", "AABBCC");
+
+  UNITY_BEGIN();
+  RUN_TEST(test_enqueue_does_not_block_during_slow_post);
+  RUN_TEST(test_failed_post_keeps_outbox_and_backs_off);
+  exit(UNITY_END());
+}
+
+void loop() {}
@@ -0,0 +1,170 @@
+#pragma once
+#include <Arduino.h>
+#include <stdarg.h>
+
+// ====== ESCRITOR JSON SOBRE BUFFER FIJO ======
+// Escribe JSON en un buffer que pone quien llama (pila o estático), sin usar
+// String ni heap. Si se le da una función de vaciado, cada vez que el buffer
+// se llena se entrega lo escrito (p. ej. a server.sendContent() en una
+// respuesta chunked), así que el pico de memoria no depende del tamaño de la
+// respuesta. Sin función de vaciado, lo que no cabe marca overflow().
+//
+//   char buf[96];
+//   JsonWriter json(buf, sizeof(buf));
+//   json.beginObject().field("temp", 23.4f, 1).endObject();
+
+class JsonWriter {
+ public:
+  typedef void (*FlushFn)(const char* data, size_t len, void* ctx);
+
+  JsonWriter(char* buf, size_t capacity, FlushFn flush = nullptr, void* ctx = nullptr)
+      : buf_(buf), cap_(capacity), flushFn_(flush), ctx_(ctx) {
+    buf_[0] = '\0';
+  }
+
+  JsonWriter& beginObject() { return open('{'); }
+  JsonWriter& endObject() { return close('}'); }
+  JsonWriter& beginArray() { return open('['); }
+  JsonWriter& endArray() { return close(']'); }
+
+  JsonWriter& key(const char* k) {
+    separator();
+    string(k);
+    put(':');
+    afterKey_ = true;
+    return *this;
+  }
+
+  JsonWriter& value(const char* s) {
+    separator();
+    string(s);
+    return *this;
+  }
+  JsonWriter& value(bool b) {
+    separator();
+    raw(b ? "true" : "false");
+    return *this;
+  }
+  JsonWriter& value(int v) { return number("%d", v); }
+  JsonWriter& value(unsigned v) { return number("%u", v); }
+  JsonWriter& value(long v) { return number("%ld", v); }
+  JsonWriter& value(unsigned long v) { return number("%lu", v); }
+  // NaN/Inf no existen en JSON: se escriben como null.
+  JsonWriter& value(double v, uint8_t decimals) {
+    if (isnan(v) || isinf(v)) return null();
+    return number("%.*f", (int)decimals, v);
+  }
+  JsonWriter& null() {
+    separator();
+    raw("null");
+    return *this;
+  }
+
+  template <typename T>
+  JsonWriter& field(const char* k, T v) { return key(k).value(v); }
+  JsonWriter& field(const char* k, double v, uint8_t decimals) { return key(k).value(v, decimals); }
+
+  // Fragmento ya serializado (p. ej. un objeto construido en otro buffer).
+  JsonWriter& rawValue(const char* json, size_t len) {
+    separator();
+    write(json, len);
+    return *this;
+  }
+
+  // Entrega lo pendiente a la función de vaciado.
+  void flush() {
+    if (flushFn_ && len_) flushFn_(buf_, len_, ctx_);
+    len_ = 0;
+    buf_[0] = '\0';
+  }
+
+  const char* c_str() const { return buf_; }
+  size_t length() const { return len_; }
+  bool overflow() const { return overflow_; }
+
+ private:
+  static const uint8_t MAX_DEPTH = 16;
+
+  JsonWriter& open(char c) {
+    separator();
+    put(c);
+    if (depth_ < MAX_DEPTH) hasItems_[depth_] = false;
+    depth_++;
+    return *this;
+  }
+
+  JsonWriter& close(char c) {
+    if (depth_) depth_--;
+    put(c);
+    return *this;
+  }
+
+  // Coma entre elementos, salvo justo después de una clave.
+  void separator() {
+    if (afterKey_) {
+      afterKey_ = false;
+      return;
+    }
+    if (!depth_ || depth_ > MAX_DEPTH) return;
+    if (hasItems_[depth_ - 1]) put(',');
+    hasItems_[depth_ - 1] = true;
+  }
+
+  JsonWriter& number(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+    separator();
+    char tmp[24];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(tmp, sizeof(tmp), fmt, ap);
+    va_end(ap);
+    if (n < 0 || (size_t)n >= sizeof(tmp)) raw("null");
+    else write(tmp, n);
+    return *this;
+  }
+
+  void string(const char* s) {
+    put('"');
+    for (; s && *s; s++) {
+      char c = *s;
+      if (c == '"' || c == '\\') {
+        put('\\');
+        put(c);
+      } else if ((uint8_t)c < 0x20) {
+        char esc[7];
+        snprintf(esc, sizeof(esc), "\\u%04x", c);
+        raw(esc);
+      } else {
+        put(c);
+      }
+    }
+    put('"');
+  }
+
+  void raw(const char* s) { write(s, strlen(s)); }
+
+  void write(const char* s, size_t n) {
+    while (n--) put(*s++);
+  }
+
+  void put(char c) {
+    if (len_ + 1 >= cap_) {
+      if (!flushFn_) {
+        overflow_ = true;
+        return;
+      }
+      flush();
+    }
+    buf_[len_++] = c;
+    buf_[len_] = '\0';
+  }
+
+  char* buf_;
+  size_t cap_;
+  size_t len_ = 0;
+  FlushFn flushFn_;
+  void* ctx_;
+  uint8_t depth_ = 0;
+  bool hasItems_[MAX_DEPTH];
+  bool afterKey_ = false;
+  bool overflow_ = false;
+};
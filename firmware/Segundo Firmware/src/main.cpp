@@ -3,6 +3,7 @@
 #include <LittleFS.h>
 #include <WebServer.h>
 #include <time.h>
+#include "json_writer.h"
 
 // --- CONFIG: credenciales WiFi ---
 const char* ssid     = "Tobar_2";
@@ -11,51 +12,92 @@ const char* password = "Homb0549";
 // ---------------------------------
 WebServer server(80);
 
-// Utilidad: formatear timestamp ISO8601
-String isoNow(time_t t) {
-  struct tm *tmstruct = localtime(&t);
-  char buf[30];
-  snprintf(buf, sizeof(buf), "%04d-%02d-%02dT%02d:%02d:%02dZ",
-           tmstruct->tm_year + 1900,
-           tmstruct->tm_mon + 1,
-           tmstruct->tm_mday,
-           tmstruct->tm_hour,
-           tmstruct->tm_min,
-           tmstruct->tm_sec);
-  return String(buf);
+// Utilidad: formatear timestamp ISO8601 en un buffer del que llama
+// (sin String: se llama una vez por muestra del histórico)
+const char* isoNow(time_t t, char* buf, size_t len) {
+  struct tm tmstruct;
+  gmtime_r(&t, &tmstruct);
+  snprintf(buf, len, "%04d-%02d-%02dT%02d:%02d:%02dZ",
+           tmstruct.tm_year + 1900,
+           tmstruct.tm_mon + 1,
+           tmstruct.tm_mday,
+           tmstruct.tm_hour,
+           tmstruct.tm_min,
+           tmstruct.tm_sec);
+  return buf;
 }
 
 // Simulación de DHT22
+// Cada muestra es una función pura de (SIM_SEED, ts): la misma hora da
+// siempre el mismo valor, en /api/latest y en el histórico, sin reiniciar el
+// generador global con randomSeed() en cada muestra (que lo deja en un
+// estado predecible para el resto del programa y cuesta una siembra por
+// punto).
+#ifndef SIM_SEED
+#define SIM_SEED 1
+#endif
 float simulateTempBase = 24.0;
 float simulateHumBase  = 55.0;
+const float simulateTempDaily = 2.0;  // amplitud del ciclo diario, °C
+const float simulateHumDaily  = 8.0;  // %, al revés que la temperatura
+
+// Mezcla de splitmix64: 32 bits independientes por (ts, canal)
+static uint32_t sampleHash(uint32_t ts, uint8_t channel) {
+  uint64_t z = ((uint64_t)SIM_SEED << 40) ^ ((uint64_t)channel << 32) ^ ts;
+  z *= 0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return (uint32_t)((z ^ (z >> 31)) >> 32);
+}
+
+// Casi normal (media 0, desviación 1): suma de dos pares de 16 bits.
+static float sampleGauss(uint32_t ts, uint8_t channel) {
+  uint32_t a = sampleHash(ts, channel), b = sampleHash(ts, channel + 1);
+  float sum = (a & 0xFFFF) + (a >> 16) + (b & 0xFFFF) + (b >> 16);
+  return (sum / 65536.0f - 2.0f) * 1.7320508f;
+}
 
 void generateSample(time_t ts, float &temp, float &hum) {
-  long seed = ts;
-  randomSeed((uint32_t)seed);
-  float tNoise = ((float)random(-50, 51)) / 100.0;   // ±0.5 °C
-  float hNoise = ((float)random(-200, 201)) / 100.0; // ±2.0 %
-  temp = simulateTempBase + tNoise;
-  hum  = simulateHumBase + hNoise;
+  // Mínimo a las 4:00 UTC, máximo a las 16:00
+  float day = (float)((uint32_t)ts % 86400) / 86400.0f;
+  float cycle = -cosf(2 * (float)M_PI * (day - 4.0f / 24));
+  float tNoise = 0.2f * sampleGauss((uint32_t)ts, 0);  // el DHT22 oscila ±0,5 °C
+  float hNoise = 0.8f * sampleGauss((uint32_t)ts, 2);  // ±2 %
+  temp = roundf((simulateTempBase + simulateTempDaily * cycle + tNoise) * 10) / 10;
+  hum  = roundf(constrain(simulateHumBase - simulateHumDaily * cycle + hNoise, 0.0f, 100.0f) * 10) / 10;
 }
 
-String buildHistoryJson(int hoursBack = 168, int stepMinutes = 60) {
-  String out = "[";
+// Respuestas JSON largas: se escriben en un buffer fijo que se va vaciando
+// como chunks HTTP, así que la memoria no crece con hoursBack/stepMinutes.
+static char jsonStreamBuf[1024];
+
+static void sendJsonChunk(const char* data, size_t len, void*) {
+  server.sendContent(data, len);
+}
+
+void sendHistoryJson(int hoursBack = 168, int stepMinutes = 60) {
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+
+  JsonWriter json(jsonStreamBuf, sizeof(jsonStreamBuf), sendJsonChunk);
+  json.beginArray();
   time_t now = time(nullptr);
   time_t step = stepMinutes * 60;
   int samples = (hoursBack * 60) / stepMinutes;
+  char ts[24];
   for (int i = samples - 1; i >= 0; --i) {
-    time_t ts = now - (i * step);
-    float t, h;
-    generateSample(ts, t, h);
-    if (out.length() > 1) out += ",";
-    out += "{";
-    out += "\"ts\":\"" + isoNow(ts) + "\",";
-    out += "\"temp\":" + String(t, 2) + ",";
-    out += "\"hum\":" + String(h, 2);
-    out += "}";
+    time_t t = now - (i * step);
+    float temp, hum;
+    generateSample(t, temp, hum);
+    json.beginObject()
+        .field("ts", isoNow(t, ts, sizeof(ts)))
+        .field("temp", temp, 2)
+        .field("hum", hum, 2)
+        .endObject();
   }
-  out += "]";
-  return out;
+  json.endArray();
+  json.flush();
+  server.sendContent("");
 }
 
 // Servir archivos estáticos desde LittleFS
@@ -82,19 +124,24 @@ void setupRoutes() {
     time_t now = time(nullptr);
     float t, h;
     generateSample(now, t, h);
-    String payload = "{";
-    payload += "\"ts\":\"" + isoNow(now) + "\",";
-    payload += "\"temp\":" + String(t, 2) + ",";
-    payload += "\"hum\":" + String(h, 2);
-    payload += "}";
-    server.send(200, "application/json", payload);
+    char buf[96], ts[24];
+    JsonWriter json(buf, sizeof(buf));
+    json.beginObject()
+        .field("ts", isoNow(now, ts, sizeof(ts)))
+        .field("temp", t, 2)
+        .field("hum", h, 2)
+        .endObject();
+    server.send_P(200, "application/json", json.c_str(), json.length());
   });
 
   server.on("/api/history", HTTP_GET, []() {
     int hoursBack   = server.hasArg("hoursBack") ? server.arg("hoursBack").toInt() : 168;
     int stepMinutes = server.hasArg("stepMinutes") ? server.arg("stepMinutes").toInt() : 60;
-    String payload  = buildHistoryJson(hoursBack, stepMinutes);
-    server.send(200, "application/json", payload);
+    if (hoursBack <= 0 || hoursBack > 24 * 366 || stepMinutes <= 0) {
+      server.send(400, "application/json", "{\"error\":\"hoursBack o stepMinutes no válidos\"}");
+      return;
+    }
+    sendHistoryJson(hoursBack, stepMinutes);
   });
 
   server.onNotFound([]() {
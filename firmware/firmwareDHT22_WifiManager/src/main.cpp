@@ -9,6 +9,7 @@
 #include <time.h>
 #include <DHT.h>
 #include <HTTPClient.h>
+#include "json_writer.h"
 
 // ====== CONFIGURACIÓN HARDWARE ======
 #define DHTPIN 4      // GPIO para el DHT22
@@ -79,15 +80,17 @@ void sendToGoogleSheets(float temp, float hum) {
     http.addHeader("Content-Type", "application/json");
 
     String mac = macSuffix();
-    String jsonData = "{";
-    jsonData += "\"type\":\"Datos\",";
-    jsonData += "\"deviceId\":\"" + String(deviceId) + "\",";
-    jsonData += "\"mac\":\"" + mac + "\",";
-    jsonData += "\"temp\":" + String(temp, 2) + ",";
-    jsonData += "\"hum\":" + String(hum, 2);
-    jsonData += "}";
-
-    int httpResponseCode = http.POST(jsonData);
+    char jsonData[160];
+    JsonWriter json(jsonData, sizeof(jsonData));
+    json.beginObject()
+        .field("type", "Datos")
+        .field("deviceId", deviceId)
+        .field("mac", mac.c_str())
+        .field("temp", temp, 2)
+        .field("hum", hum, 2)
+        .endObject();
+
+    int httpResponseCode = http.POST((uint8_t*)jsonData, json.length());
 
     if (httpResponseCode > 0) {
       Serial.printf("Datos enviados! Código: %d\n", httpResponseCode);
@@ -108,16 +111,18 @@ void sendEvent(String evento, String motivo) {
     String mac = macSuffix();
     float chipTemp = temperatureRead(); // temperatura interna del chip
 
-    String jsonData = "{";
-    jsonData += "\"type\":\"Estados\",";
-    jsonData += "\"deviceId\":\"" + String(deviceId) + "\",";
-    jsonData += "\"mac\":\"" + mac + "\",";
-    jsonData += "\"evento\":\"" + evento + "\",";
-    jsonData += "\"motivo\":\"" + motivo + "\",";
-    jsonData += "\"tempChip\":" + String(chipTemp, 2);
-    jsonData += "}";
+    char jsonData[256];
+    JsonWriter json(jsonData, sizeof(jsonData));
+    json.beginObject()
+        .field("type", "Estados")
+        .field("deviceId", deviceId)
+        .field("mac", mac.c_str())
+        .field("evento", evento.c_str())
+        .field("motivo", motivo.c_str())
+        .field("tempChip", chipTemp, 2)
+        .endObject();
 
-    int httpResponseCode = http.POST(jsonData);
+    int httpResponseCode = http.POST((uint8_t*)jsonData, json.length());
 
     if (httpResponseCode > 0) {
       Serial.printf("Evento enviado! Código: %d\n", httpResponseCode);
@@ -172,11 +177,10 @@ void setup() {
       server.send(500, "application/json", "{\"error\":\"Error leyendo DHT22\"}");
       return;
     }
-    String payload = "{";
-    payload += "\"temp\":" + String(currentTemp, 1) + ",";
-    payload += "\"hum\":" + String(currentHum, 1);
-    payload += "}";
-    server.send(200, "application/json", payload);
+    char payload[64];
+    JsonWriter json(payload, sizeof(payload));
+    json.beginObject().field("temp", currentTemp, 1).field("hum", currentHum, 1).endObject();
+    server.send_P(200, "application/json", payload, json.length());
   });
 
   server.on("/api/history", HTTP_GET, []() {
@@ -0,0 +1,392 @@
+#include "http_server.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <unordered_set>
+
+static uint64_t nowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static const char* statusText(int code) {
+  switch (code) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 411: return "Length Required";
+    case 413: return "Payload Too Large";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 503: return "Service Unavailable";
+    default: return "";
+  }
+}
+
+std::string_view HttpRequest::arg(std::string_view name) const {
+  std::string_view q = query;
+  while (!q.empty()) {
+    size_t amp = q.find('&');
+    std::string_view pair = q.substr(0, amp);
+    size_t eq = pair.find('=');
+    if (pair.substr(0, eq) == name) return eq == std::string_view::npos ? std::string_view() : pair.substr(eq + 1);
+    if (amp == std::string_view::npos) break;
+    q.remove_prefix(amp + 1);
+  }
+  return std::string_view();
+}
+
+bool HttpRequest::hasArg(std::string_view name) const {
+  std::string_view q = query;
+  while (!q.empty()) {
+    size_t amp = q.find('&');
+    std::string_view pair = q.substr(0, amp);
+    if (pair.substr(0, pair.find('=')) == name) return true;
+    if (amp == std::string_view::npos) break;
+    q.remove_prefix(amp + 1);
+  }
+  return false;
+}
+
+struct HttpServer::Connection {
+  int fd;
+  std::string in;
+  std::string out;
+  size_t outPos = 0;
+  HttpResponse pending;      // respuesta esperando a su época
+  bool waiting = false;
+  bool closeAfter = false;   // Connection: close o HTTP/1.0
+  bool closeNext = false;    // la respuesta en espera cierra la conexión
+  bool writable = false;     // EPOLLOUT activado
+  bool eof = false;          // el cliente ya cerró su lado
+  bool closed = false;       // cerrada; se libera al acabar la tanda de eventos
+  uint64_t lastActiveMs = 0;
+};
+
+struct HttpServer::Worker {
+  int listenFd = -1;
+  int epollFd = -1;
+  int eventFd = -1;
+  std::vector<Connection*> waiting;
+  std::vector<Connection*> closed;
+  std::unordered_set<Connection*> all;
+};
+
+HttpServer::HttpServer(uint16_t port, unsigned threads, Handler handler, ReadyFn isReady)
+    : port_(port), threadCount_(std::max(1u, threads)), handler_(std::move(handler)), isReady_(std::move(isReady)) {}
+
+HttpServer::~HttpServer() {
+  stop();
+  for (Worker* w : workers_) {
+    for (Connection* c : w->all) {
+      ::close(c->fd);
+      delete c;
+    }
+    for (Connection* c : w->closed) delete c;
+    if (w->listenFd >= 0) ::close(w->listenFd);
+    if (w->epollFd >= 0) ::close(w->epollFd);
+    if (w->eventFd >= 0) ::close(w->eventFd);
+    delete w;
+  }
+}
+
+bool HttpServer::start(std::string& error) {
+  for (unsigned i = 0; i < threadCount_; i++) {
+    Worker* w = new Worker();
+    workers_.push_back(w);
+    w->listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int one = 1;
+    setsockopt(w->listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    setsockopt(w->listenFd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port_);
+    if (bind(w->listenFd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(w->listenFd, 1024) < 0) {
+      error = std::string("no se pudo escuchar en el puerto ") + std::to_string(port_) + ": " + strerror(errno);
+      return false;
+    }
+    w->epollFd = epoll_create1(EPOLL_CLOEXEC);
+    w->eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.ptr = &w->listenFd;
+    epoll_ctl(w->epollFd, EPOLL_CTL_ADD, w->listenFd, &ev);
+    ev.data.ptr = &w->eventFd;
+    epoll_ctl(w->epollFd, EPOLL_CTL_ADD, w->eventFd, &ev);
+  }
+  running_ = true;
+  for (Worker* w : workers_) threads_.emplace_back(&HttpServer::run, this, std::ref(*w));
+  return true;
+}
+
+void HttpServer::stop() {
+  if (!running_.exchange(false)) return;
+  notify();
+  for (std::thread& t : threads_) t.join();
+  threads_.clear();
+}
+
+void HttpServer::notify() {
+  uint64_t one = 1;
+  for (Worker* w : workers_) {
+    if (write(w->eventFd, &one, sizeof(one)) < 0) {}
+  }
+}
+
+// ====== BUCLE DE CADA HILO ======
+void HttpServer::run(Worker& w) {
+  epoll_event events[128];
+  uint64_t lastSweepMs = nowMs();
+  while (running_) {
+    int n = epoll_wait(w.epollFd, events, 128, 1000);
+    for (int i = 0; i < n; i++) {
+      void* ptr = events[i].data.ptr;
+      if (ptr == &w.listenFd) {
+        for (;;) {
+          int fd = accept4(w.listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+          if (fd < 0) break;
+          int one = 1;
+          setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+          Connection* c = new Connection();
+          c->fd = fd;
+          c->lastActiveMs = nowMs();
+          epoll_event ev = {};
+          ev.events = EPOLLIN | EPOLLRDHUP;
+          ev.data.ptr = c;
+          epoll_ctl(w.epollFd, EPOLL_CTL_ADD, fd, &ev);
+          w.all.insert(c);
+          connections_++;
+        }
+      } else if (ptr == &w.eventFd) {
+        uint64_t count;
+        if (read(w.eventFd, &count, sizeof(count)) < 0) {}
+        // Respuestas cuya época ya es durable
+        std::vector<Connection*> ready;
+        auto it = std::partition(w.waiting.begin(), w.waiting.end(),
+                                 [this](Connection* c) { return !isReady_(c->pending); });
+        ready.assign(it, w.waiting.end());
+        w.waiting.erase(it, w.waiting.end());
+        for (Connection* c : ready) {
+          c->waiting = false;
+          c->closeAfter = c->closeNext;
+          finish(c, c->pending);
+          if (flush(w, c)) process(w, c);
+        }
+      } else {
+        Connection* c = (Connection*)ptr;
+        if (c->closed) continue;
+        if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+          close(w, c);
+          continue;
+        }
+        if (events[i].events & (EPOLLIN | EPOLLRDHUP)) {
+          onReadable(w, c);
+        } else if (events[i].events & EPOLLOUT) {
+          if (flush(w, c) && !c->waiting) process(w, c);
+        }
+      }
+    }
+    // Una conexión cerrada puede salir más tarde en la misma tanda
+    for (Connection* c : w.closed) delete c;
+    w.closed.clear();
+
+    // Conexiones inactivas (sin nada en espera)
+    uint64_t now = nowMs();
+    if (now - lastSweepMs >= 1000) {
+      lastSweepMs = now;
+      std::vector<Connection*> idle;
+      for (Connection* c : w.all) {
+        if (!c->waiting && now - c->lastActiveMs > HTTP_IDLE_TIMEOUT_MS) idle.push_back(c);
+      }
+      for (Connection* c : idle) close(w, c);
+      for (Connection* c : w.closed) delete c;
+      w.closed.clear();
+    }
+  }
+}
+
+void HttpServer::onReadable(Worker& w, Connection* c) {
+  char buf[16384];
+  for (;;) {
+    ssize_t n = recv(c->fd, buf, sizeof(buf), 0);
+    if (n > 0) {
+      c->in.append(buf, n);
+      if ((size_t)n < sizeof(buf)) break;
+      continue;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0) {
+      close(w, c);
+      return;
+    }
+    // El cliente cerró su lado: se responde a lo que ya mandó y se cierra.
+    // Sin EPOLLIN para que el cierre no despierte al hilo en bucle.
+    c->eof = true;
+    epoll_event ev = {};
+    ev.events = c->writable ? (uint32_t)EPOLLOUT : 0u;
+    ev.data.ptr = c;
+    epoll_ctl(w.epollFd, EPOLL_CTL_MOD, c->fd, &ev);
+    break;
+  }
+  c->lastActiveMs = nowMs();
+  if (c->waiting) {
+    flush(w, c);
+  } else {
+    process(w, c);
+  }
+}
+
+// Atiende las peticiones completas que haya en el buffer, en orden.
+void HttpServer::process(Worker& w, Connection* c) {
+  size_t consumed = 0;
+  while (!c->waiting && !c->closeAfter) {
+    std::string_view in(c->in.data() + consumed, c->in.size() - consumed);
+    size_t headerEnd = in.find("\r\n\r\n");
+    HttpResponse res;
+    if (headerEnd == std::string_view::npos) {
+      if (in.size() <= HTTP_MAX_HEADER) break;
+      res.status = 431;
+      c->closeAfter = true;
+      finish(c, res);
+      break;
+    }
+
+    std::string_view head = in.substr(0, headerEnd);
+    size_t lineEnd = head.find("\r\n");
+    std::string_view line = head.substr(0, lineEnd);
+    size_t sp1 = line.find(' '), sp2 = line.rfind(' ');
+    if (sp1 == std::string_view::npos || sp2 <= sp1) {
+      res.status = 400;
+      c->closeAfter = true;
+      finish(c, res);
+      break;
+    }
+    HttpRequest req;
+    req.method = line.substr(0, sp1);
+    std::string_view target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+    std::string_view version = line.substr(sp2 + 1);
+    size_t q = target.find('?');
+    req.path = target.substr(0, q);
+    if (q != std::string_view::npos) req.query = target.substr(q + 1);
+
+    bool keepAlive = version == "HTTP/1.1";
+    size_t contentLength = 0;
+    bool chunked = false;
+    std::string_view headers = lineEnd == std::string_view::npos ? std::string_view() : head.substr(lineEnd + 2);
+    while (!headers.empty()) {
+      size_t end = headers.find("\r\n");
+      std::string_view h = headers.substr(0, end);
+      headers = end == std::string_view::npos ? std::string_view() : headers.substr(end + 2);
+      size_t colon = h.find(':');
+      if (colon == std::string_view::npos) continue;
+      std::string_view name = h.substr(0, colon), value = h.substr(colon + 1);
+      while (!value.empty() && value.front() == ' ') value.remove_prefix(1);
+      if (name.size() == 14 && !strncasecmp(name.data(), "Content-Length", 14)) {
+        contentLength = strtoull(std::string(value).c_str(), nullptr, 10);
+      } else if (name.size() == 10 && !strncasecmp(name.data(), "Connection", 10)) {
+        if (value.size() >= 5 && !strncasecmp(value.data(), "close", 5)) keepAlive = false;
+        if (value.size() >= 10 && !strncasecmp(value.data(), "keep-alive", 10)) keepAlive = true;
+      } else if (name.size() == 17 && !strncasecmp(name.data(), "Transfer-Encoding", 17)) {
+        chunked = true;
+      }
+    }
+    if (chunked || contentLength > HTTP_MAX_BODY) {
+      res.status = chunked ? 411 : 413;
+      c->closeAfter = true;
+      finish(c, res);
+      break;
+    }
+    size_t total = headerEnd + 4 + contentLength;
+    if (in.size() < total) break;  // falta cuerpo
+    req.body = in.substr(headerEnd + 4, contentLength);
+
+    handler_(req, res);
+    requests_++;
+    consumed += total;
+    if (res.wait && !isReady_(res)) {
+      c->pending = std::move(res);
+      c->waiting = true;
+      c->closeNext = !keepAlive;
+      w.waiting.push_back(c);
+      break;
+    }
+    c->closeAfter = !keepAlive;
+    finish(c, res);
+  }
+  if (consumed) c->in.erase(0, consumed);
+  if (c->eof && !c->waiting) c->closeAfter = true;
+  flush(w, c);
+}
+
+void HttpServer::finish(Connection* c, HttpResponse& res) {
+  char head[256];
+  int n = snprintf(head, sizeof(head),
+                   "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\n%s\r\n", res.status,
+                   statusText(res.status), res.contentType, res.body.size(),
+                   c->closeAfter ? "Connection: close\r\n" : "");
+  c->out.append(head, n);
+  c->out.append(res.body);
+  res.body.clear();
+}
+
+// Envía lo pendiente; false si la conexión se cerró o queda por enviar.
+bool HttpServer::flush(Worker& w, Connection* c) {
+  while (c->outPos < c->out.size()) {
+    ssize_t n = send(c->fd, c->out.data() + c->outPos, c->out.size() - c->outPos, MSG_NOSIGNAL);
+    if (n > 0) {
+      c->outPos += n;
+      continue;
+    }
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      if (!c->writable) {
+        epoll_event ev = {};
+        ev.events = c->eof ? EPOLLOUT : EPOLLIN | EPOLLRDHUP | EPOLLOUT;
+        ev.data.ptr = c;
+        epoll_ctl(w.epollFd, EPOLL_CTL_MOD, c->fd, &ev);
+        c->writable = true;
+      }
+      return false;
+    }
+    close(w, c);
+    return false;
+  }
+  c->out.clear();
+  c->outPos = 0;
+  c->lastActiveMs = nowMs();
+  if (c->writable) {
+    epoll_event ev = {};
+    ev.events = c->eof ? 0 : EPOLLIN | EPOLLRDHUP;
+    ev.data.ptr = c;
+    epoll_ctl(w.epollFd, EPOLL_CTL_MOD, c->fd, &ev);
+    c->writable = false;
+  }
+  if (c->closeAfter) {
+    close(w, c);
+    return false;
+  }
+  return true;
+}
+
+void HttpServer::close(Worker& w, Connection* c) {
+  epoll_ctl(w.epollFd, EPOLL_CTL_DEL, c->fd, nullptr);
+  ::close(c->fd);
+  if (c->waiting) w.waiting.erase(std::find(w.waiting.begin(), w.waiting.end(), c));
+  w.all.erase(c);
+  connections_--;
+  c->closed = true;
+  w.closed.push_back(c);
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// ====== SERVIDOR HTTP/1.1 CON EPOLL ======
+// Un hilo por núcleo, cada uno con su epoll y su socket de escucha
+// (SO_REUSEPORT, el kernel reparte las conexiones). Keep-alive y pipelining;
+// los cuerpos llegan con Content-Length, que es lo que manda HTTPClient.
+//
+// Un handler puede dejar la respuesta en espera de una época (wait): la
+// conexión no lee más peticiones hasta que isReady(res) sea true, y notify()
+// despierta a todos los hilos para que lo comprueben. isReady puede cambiar
+// la respuesta antes de que salga (p. ej. un 5xx si la época falló). Es lo
+// que usa el POST de ingesta para no confirmar nada que no esté ya en disco.
+
+#define HTTP_MAX_HEADER 8192
+#define HTTP_MAX_BODY (4 * 1024 * 1024)
+#define HTTP_IDLE_TIMEOUT_MS 60000
+
+struct HttpRequest {
+  std::string_view method;
+  std::string_view path;   // sin la query
+  std::string_view query;  // lo que va tras '?'
+  std::string_view body;
+
+  // Valor de ?name= tal cual (sin decodificar %xx); vacío si no está.
+  std::string_view arg(std::string_view name) const;
+  bool hasArg(std::string_view name) const;
+};
+
+struct HttpResponse {
+  int status = 200;
+  const char* contentType = "application/json";
+  std::string body;
+  uint64_t wait = 0;  // época que hay que esperar antes de enviarla (0 = ya)
+};
+
+class HttpServer {
+ public:
+  typedef std::function<void(const HttpRequest&, HttpResponse&)> Handler;
+  typedef std::function<bool(HttpResponse&)> ReadyFn;
+
+  HttpServer(uint16_t port, unsigned threads, Handler handler, ReadyFn isReady);
+  ~HttpServer();
+
+  bool start(std::string& error);
+  void stop();
+  // Se puede llamar desde cualquier hilo.
+  void notify();
+
+  uint64_t requests() const { return requests_.load(std::memory_order_relaxed); }
+  uint32_t connections() const { return connections_.load(std::memory_order_relaxed); }
+
+ private:
+  struct Worker;
+  struct Connection;
+
+  void run(Worker& w);
+  void onReadable(Worker& w, Connection* c);
+  void process(Worker& w, Connection* c);
+  bool flush(Worker& w, Connection* c);
+  void finish(Connection* c, HttpResponse& res);
+  void close(Worker& w, Connection* c);
+
+  uint16_t port_;
+  unsigned threadCount_;
+  Handler handler_;
+  ReadyFn isReady_;
+  std::vector<Worker*> workers_;
+  std::vector<std::thread> threads_;
+  std::atomic<bool> running_{false};
+  std::atomic<uint64_t> requests_{0};
+  std::atomic<uint32_t> connections_{0};
+};
@@ -0,0 +1,155 @@
+#pragma once
+#include <charconv>
+#include <cstring>
+#include <string_view>
+
+// ====== ESCÁNER JSON SIN COPIAS ======
+// Recorre el cuerpo de la petición en su sitio, sin árbol ni reservas de
+// memoria: las cadenas se devuelven como string_view sobre el propio buffer
+// (con los escapes tal cual, que es justo lo que hace falta para volver a
+// escribirlas en JSON) y los números se convierten al vuelo. Mismo estilo que
+// el JsonReader del firmware: quien llama pide lo que espera y salta con
+// skipValue() lo que no conoce. Ante cualquier error ok() pasa a false y el
+// resto de llamadas devuelven false.
+//
+//   JsonScanner json(body);
+//   std::string_view key;
+//   json.beginObject();
+//   while (json.nextKey(key)) {
+//     if (key == "temp") json.readNumber(temp);
+//     else json.skipValue();
+//   }
+
+class JsonScanner {
+ public:
+  explicit JsonScanner(std::string_view text) : p_(text.data()), end_(text.data() + text.size()) {}
+
+  bool ok() const { return ok_; }
+
+  // Primer carácter significativo sin consumirlo ('\0' al final).
+  char peek() {
+    skipWs();
+    return p_ < end_ ? *p_ : '\0';
+  }
+
+  bool atEnd() { return ok_ && peek() == '\0'; }
+
+  bool beginObject() { return consume('{'); }
+  bool beginArray() { return consume('['); }
+
+  // Siguiente clave del objeto actual; false al llegar a '}'.
+  bool nextKey(std::string_view& key) {
+    if (!nextItem('}')) return false;
+    return readString(key) && consume(':');
+  }
+
+  // true si el array actual tiene otro elemento; false al llegar a ']'.
+  bool nextElement() { return nextItem(']'); }
+
+  // La cadena sin comillas y con los escapes sin resolver; *escaped dice si
+  // había alguno.
+  bool readString(std::string_view& out, bool* escaped = nullptr) {
+    if (!consume('"')) return false;
+    const char* start = p_;
+    bool esc = false;
+    while (p_ < end_ && *p_ != '"') {
+      if ((unsigned char)*p_ < 0x20) return fail();
+      if (*p_ == '\\') {
+        esc = true;
+        if (++p_ == end_) break;
+      }
+      p_++;
+    }
+    if (p_ >= end_) return fail();
+    out = std::string_view(start, p_ - start);
+    p_++;
+    if (escaped) *escaped = esc;
+    return true;
+  }
+
+  bool readNumber(double& out) {
+    skipWs();
+    if (!ok_ || p_ >= end_) return fail();
+    auto r = std::from_chars(p_, end_, out);
+    if (r.ec != std::errc() || r.ptr == p_) return fail();
+    p_ = r.ptr;
+    return true;
+  }
+
+  // null se acepta como "sin valor": devuelve true y deja *isNull a true.
+  bool readNumberOrNull(double& out, bool& isNull) {
+    isNull = peek() == 'n';
+    if (isNull) return literal("null") || fail();
+    return readNumber(out);
+  }
+
+  bool skipValue() {
+    char c = peek();
+    if (!ok_ || !c) return fail();
+    if (c == '"') {
+      std::string_view dummy;
+      return readString(dummy);
+    }
+    if (c == '{' || c == '[') {
+      char close = c == '{' ? '}' : ']';
+      consume(c);
+      while (nextItem(close)) {
+        if (close == '}') {
+          std::string_view dummy;
+          if (!readString(dummy) || !consume(':')) return false;
+        }
+        if (!skipValue()) return false;
+      }
+      return ok_;
+    }
+    if (literal("true") || literal("false") || literal("null")) return true;
+    double v;
+    return readNumber(v);
+  }
+
+ private:
+  const char* p_;
+  const char* end_;
+  bool ok_ = true;
+  bool first_ = true;
+
+  bool fail() {
+    ok_ = false;
+    return false;
+  }
+
+  void skipWs() {
+    while (p_ < end_ && (*p_ == ' ' || *p_ == '\n' || *p_ == '\r' || *p_ == '\t')) p_++;
+  }
+
+  bool consume(char c) {
+    if (!ok_) return false;
+    skipWs();
+    if (p_ >= end_ || *p_ != c) return fail();
+    p_++;
+    first_ = c == '{' || c == '[';
+    return true;
+  }
+
+  bool literal(const char* word) {
+    size_t n = strlen(word);
+    if ((size_t)(end_ - p_) < n || strncmp(p_, word, n)) return false;
+    p_ += n;
+    first_ = false;
+    return true;
+  }
+
+  // Salta la coma entre elementos; false (sin error) al encontrar el cierre.
+  bool nextItem(char close) {
+    if (!ok_) return false;
+    skipWs();
+    if (p_ < end_ && *p_ == close) {
+      p_++;
+      first_ = false;
+      return false;
+    }
+    if (!first_ && !consume(',')) return false;
+    first_ = false;
+    return true;
+  }
+};
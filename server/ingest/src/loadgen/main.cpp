@@ -0,0 +1,259 @@
+// ====== GENERADOR DE CARGA: UNA FLOTA SIMULADA ======
+// Simula --devices placas subiendo su outbox al servicio de ingesta con el
+// mismo JSON que uploader.cpp ("Datos" y, ~1% de las veces, "Estados"), en
+// lotes de --batch filas por POST. Cada conexión keep-alive va rotando entre
+// sus dispositivos y tiene siempre una petición en vuelo.
+//
+//   loadgen [--host 127.0.0.1] [--port 8090] [--devices 2000]
+//           [--connections 64] [--batch 30] [--seconds 10]
+//
+// Al final imprime filas/s (lecturas y eventos), peticiones/s, latencias p50/p99 y errores.
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+struct Options {
+  std::string host = "127.0.0.1";
+  uint16_t port = 8090;
+  uint32_t devices = 2000;
+  uint32_t connections = 64;
+  uint32_t batch = 30;
+  uint32_t seconds = 10;
+};
+
+struct Client {
+  int fd = -1;
+  bool connected = false;
+  std::string out;
+  size_t outPos = 0;
+  std::string in;
+  uint32_t rows = 0;        // filas de la petición en vuelo
+  uint64_t sentUs = 0;
+  uint32_t nextDevice = 0;  // índice dentro de los dispositivos de esta conexión
+};
+
+static Options opt;
+static std::vector<uint32_t> deviceTs;  // último ts de cada dispositivo
+static uint32_t rng = 12345;
+static uint64_t okRequests = 0, okRows = 0, errors = 0;
+static std::vector<uint32_t> latencies;
+
+static uint64_t nowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint32_t nextRandom() {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+// Un lote de un dispositivo, igual que buildBatch() del firmware
+static void buildRequest(Client& c, uint32_t device) {
+  char id[24], mac[24], row[256];
+  snprintf(id, sizeof(id), "ESP32_%05u", device);
+  snprintf(mac, sizeof(mac), "24:6F:28:%02X:%02X:%02X", (device >> 16) & 0xFF, (device >> 8) & 0xFF, device & 0xFF);
+  std::string body = "[";
+  for (uint32_t i = 0; i < opt.batch; i++) {
+    uint32_t ts = deviceTs[device] += 5;
+    int n;
+    if (nextRandom() % 100 == 0) {
+      n = snprintf(row, sizeof(row),
+                   "{\"type\":\"Estados\",\"deviceId\":\"%s\",\"mac\":\"%s\",\"evento\":\"Ventilador ON\","
+                   "\"motivo\":\"Temp 31.20 > 30.00\",\"tempChip\":%.2f,\"ts\":%u}",
+                   id, mac, 45 + (nextRandom() % 1000) / 100.0, ts);
+    } else {
+      n = snprintf(row, sizeof(row),
+                   "{\"type\":\"Datos\",\"deviceId\":\"%s\",\"mac\":\"%s\",\"sensor\":\"dht%u\","
+                   "\"temp\":%.2f,\"hum\":%.2f,\"ts\":%u}",
+                   id, mac, i % 3, 20 + (nextRandom() % 1500) / 100.0, 40 + (nextRandom() % 3000) / 100.0, ts);
+    }
+    if (i) body += ',';
+    body.append(row, n);
+  }
+  body += ']';
+
+  char head[256];
+  int n = snprintf(head, sizeof(head),
+                   "POST /exec HTTP/1.1\r\nHost: %s\r\nContent-Type: application/json\r\n"
+                   "Content-Length: %zu\r\n\r\n",
+                   opt.host.c_str(), body.size());
+  c.out.assign(head, n);
+  c.out += body;
+  c.outPos = 0;
+  c.rows = opt.batch;
+}
+
+static void nextRequest(Client& c, uint32_t index) {
+  // La conexión i atiende los dispositivos i, i + connections, ...
+  uint32_t perConnection = (opt.devices - index + opt.connections - 1) / opt.connections;
+  uint32_t device = index + (c.nextDevice++ % std::max(1u, perConnection)) * opt.connections;
+  buildRequest(c, std::min(device, opt.devices - 1));
+  c.sentUs = nowUs();
+}
+
+static bool connectClient(int epollFd, Client& c, const sockaddr_in& addr) {
+  c.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (c.fd < 0) return false;
+  int one = 1;
+  setsockopt(c.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  if (connect(c.fd, (const sockaddr*)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS) {
+    ::close(c.fd);
+    c.fd = -1;
+    return false;
+  }
+  c.connected = false;
+  c.in.clear();
+  // Por flanco: recv/send siempre hasta EAGAIN
+  epoll_event ev = {};
+  ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
+  ev.data.ptr = &c;
+  epoll_ctl(epollFd, EPOLL_CTL_ADD, c.fd, &ev);
+  return true;
+}
+
+static void dropClient(int epollFd, Client& c) {
+  epoll_ctl(epollFd, EPOLL_CTL_DEL, c.fd, nullptr);
+  ::close(c.fd);
+  c.fd = -1;
+  errors++;
+}
+
+static bool sendPending(Client& c) {
+  while (c.outPos < c.out.size()) {
+    ssize_t n = send(c.fd, c.out.data() + c.outPos, c.out.size() - c.outPos, MSG_NOSIGNAL);
+    if (n > 0) {
+      c.outPos += n;
+      continue;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+    if (n < 0 && errno == EINTR) continue;
+    return false;
+  }
+  return true;
+}
+
+// Consume las respuestas completas; false si la conexión hay que tirarla.
+static bool readResponses(Client& c, uint32_t index) {
+  char buf[16384];
+  for (;;) {
+    ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+    if (n > 0) {
+      c.in.append(buf, n);
+      continue;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+    if (n < 0 && errno == EINTR) continue;
+    return false;
+  }
+  size_t headerEnd = c.in.find("\r\n\r\n");
+  if (headerEnd == std::string::npos) return true;
+  const char* cl = strcasestr(c.in.c_str(), "Content-Length:");
+  size_t length = cl ? strtoul(cl + 15, nullptr, 10) : 0;
+  if (c.in.size() < headerEnd + 4 + length) return true;
+
+  int status = c.in.size() > 12 ? atoi(c.in.c_str() + 9) : 0;
+  if (status == 200) {
+    okRequests++;
+    okRows += c.rows;
+    latencies.push_back((uint32_t)std::min<uint64_t>(nowUs() - c.sentUs, UINT32_MAX));
+  } else {
+    errors++;
+  }
+  c.in.erase(0, headerEnd + 4 + length);
+  nextRequest(c, index);
+  return sendPending(c);
+}
+
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    std::string a = argv[i];
+    if (i + 1 >= argc) a = "";
+    if (a == "--host") opt.host = argv[++i];
+    else if (a == "--port") opt.port = atoi(argv[++i]);
+    else if (a == "--devices") opt.devices = std::max(1, atoi(argv[++i]));
+    else if (a == "--connections") opt.connections = std::max(1, atoi(argv[++i]));
+    else if (a == "--batch") opt.batch = std::max(1, atoi(argv[++i]));
+    else if (a == "--seconds") opt.seconds = std::max(1, atoi(argv[++i]));
+    else {
+      fprintf(stderr,
+              "uso: %s [--host H] [--port N] [--devices N] [--connections N] [--batch N] [--seconds N]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  opt.connections = std::min(opt.connections, opt.devices);
+
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(opt.port);
+  if (inet_pton(AF_INET, opt.host.c_str(), &addr.sin_addr) != 1) {
+    fprintf(stderr, "Host no válido (solo IPv4): %s\n", opt.host.c_str());
+    return 2;
+  }
+
+  // Cada dispositivo empieza hace un día, como si vaciara su outbox
+  deviceTs.assign(opt.devices, (uint32_t)time(nullptr) - 86400);
+  int epollFd = epoll_create1(EPOLL_CLOEXEC);
+  std::vector<Client> clients(opt.connections);
+  for (uint32_t i = 0; i < opt.connections; i++) {
+    if (!connectClient(epollFd, clients[i], addr)) {
+      fprintf(stderr, "No se pudo conectar: %s\n", strerror(errno));
+      return 1;
+    }
+  }
+
+  printf("Flota simulada: %u dispositivos, %u conexiones, lotes de %u filas, %u s\n", opt.devices,
+         opt.connections, opt.batch, opt.seconds);
+  fflush(stdout);
+  uint64_t start = nowUs(), end = start + (uint64_t)opt.seconds * 1000000;
+  epoll_event events[256];
+  while (nowUs() < end) {
+    int n = epoll_wait(epollFd, events, 256, 100);
+    for (int i = 0; i < n; i++) {
+      Client& c = *(Client*)events[i].data.ptr;
+      uint32_t index = &c - clients.data();
+      bool ok = !(events[i].events & EPOLLERR);
+      if (ok && (events[i].events & EPOLLOUT)) {
+        if (!c.connected) {
+          c.connected = true;
+          nextRequest(c, index);
+        }
+        ok = sendPending(c);
+      }
+      if (ok && (events[i].events & (EPOLLIN | EPOLLHUP))) {
+        ok = readResponses(c, index);
+      }
+      if (!ok) {
+        dropClient(epollFd, c);
+        connectClient(epollFd, c, addr);
+      }
+    }
+  }
+  double elapsed = (nowUs() - start) / 1e6;
+
+  std::sort(latencies.begin(), latencies.end());
+  auto pct = [](double p) {
+    return latencies.empty() ? 0.0 : latencies[std::min(latencies.size() - 1, (size_t)(latencies.size() * p))] / 1000.0;
+  };
+  printf("Peticiones: %llu (%.0f/s)\n", (unsigned long long)okRequests, okRequests / elapsed);
+  printf("Filas:      %llu (%.0f/s)\n", (unsigned long long)okRows, okRows / elapsed);
+  printf("Latencia:   p50 %.2f ms, p99 %.2f ms, máx %.2f ms\n", pct(0.5), pct(0.99), pct(1.0));
+  printf("Errores:    %llu\n", (unsigned long long)errors);
+  return errors ? 1 : 0;
+}
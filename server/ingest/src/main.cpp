@@ -0,0 +1,167 @@
+// ====== SERVICIO DE INGESTA PARA LA FLOTA ======
+// Sustituye al Apps Script de Google Sheets: los firmwares hacen el mismo
+// POST (una fila o un lote) a http://<servidor>:<puerto>/ con cualquier ruta
+// fuera de /api/, y las filas acaban en el almacén por dispositivo de
+// store.h. La respuesta (200) solo sale cuando las filas ya están en disco;
+// si no se pudieron escribir sale un 503 y el firmware las reintenta.
+//
+//   ingestd [--port 8090] [--data ./ingest_data] [--threads N] [--no-sync]
+//
+// Consultas:
+//   GET /api/devices                                   dispositivos conocidos
+//   GET /api/readings?device=&from=&to=&sensor=&limit= CSV ts,temp,hum,sensor
+//   GET /api/events?device=&from=&to=                  eventos (hoja Estados)
+//   GET /api/stats                                     contadores del servicio
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <sys/resource.h>
+#include <thread>
+#include <vector>
+#include "http_server.h"
+#include "payload.h"
+#include "store.h"
+
+#define DEFAULT_PORT 8090
+#define DEFAULT_DATA_DIR "./ingest_data"
+#define DEFAULT_READINGS_LIMIT 100000
+
+static uint32_t argUint(const HttpRequest& req, const char* name, uint32_t fallback) {
+  std::string_view v = req.arg(name);
+  if (v.empty()) return fallback;
+  return (uint32_t)strtoul(std::string(v).c_str(), nullptr, 10);
+}
+
+static void jsonError(HttpResponse& res, int status, const char* error) {
+  res.status = status;
+  res.body = std::string("{\"ok\":false,\"error\":\"") + error + "\"}";
+}
+
+static void ingest(Store& store, const HttpRequest& req, HttpResponse& res) {
+  static thread_local std::vector<Row> rows;
+  rows.clear();
+  ParseResult parsed = parseRows(req.body, (uint32_t)time(nullptr), rows);
+  if (!parsed.ok) {
+    jsonError(res, 400, parsed.error);
+    return;
+  }
+  if (!rows.empty()) res.wait = store.append(rows.data(), rows.size());
+  char buf[80];
+  snprintf(buf, sizeof(buf), "{\"ok\":true,\"rows\":%zu,\"rejected\":%u}", rows.size(), (unsigned)parsed.rejected);
+  res.body = buf;
+}
+
+static void route(Store& store, HttpServer& server, const HttpRequest& req, HttpResponse& res) {
+  bool api = req.path.substr(0, 5) == "/api/";
+  if (req.method == "POST" && !api) {
+    ingest(store, req, res);
+    return;
+  }
+  if (req.method != "GET") {
+    jsonError(res, 405, "Método no permitido");
+    return;
+  }
+
+  if (req.path == "/api/devices") {
+    store.devices(res.body);
+  } else if (req.path == "/api/readings" || req.path == "/api/events") {
+    std::string_view device = req.arg("device");
+    uint32_t from = argUint(req, "from", 0);
+    uint32_t to = argUint(req, "to", UINT32_MAX);
+    bool found;
+    if (req.path == "/api/readings") {
+      res.contentType = "text/csv";
+      found = store.readings(device, from, to, req.arg("sensor"),
+                             argUint(req, "limit", DEFAULT_READINGS_LIMIT), res.body);
+    } else {
+      found = store.events(device, from, to, res.body);
+    }
+    if (!found) {
+      res.contentType = "application/json";
+      jsonError(res, 404, "Dispositivo desconocido");
+    }
+  } else if (req.path == "/api/stats") {
+    StoreStats s = store.stats();
+    char buf[384];
+    snprintf(buf, sizeof(buf),
+             "{\"readings\":%llu,\"events\":%llu,\"commits\":%llu,\"failedCommits\":%llu,\"avgCommitRows\":%.1f,"
+             "\"lastCommitUs\":%llu,\"maxCommitUs\":%llu,\"pending\":%llu,\"devices\":%u,"
+             "\"requests\":%llu,\"connections\":%u}",
+             (unsigned long long)s.readings, (unsigned long long)s.events, (unsigned long long)s.commits,
+             (unsigned long long)s.failedCommits, s.commits ? (double)s.commitRows / s.commits : 0.0,
+             (unsigned long long)s.lastCommitUs,
+             (unsigned long long)s.maxCommitUs, (unsigned long long)s.pending, (unsigned)s.devices,
+             (unsigned long long)server.requests(), (unsigned)server.connections());
+    res.body = buf;
+  } else {
+    jsonError(res, 404, "No encontrado");
+  }
+}
+
+int main(int argc, char** argv) {
+  uint16_t port = DEFAULT_PORT;
+  std::string dataDir = DEFAULT_DATA_DIR;
+  unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  bool sync = true;
+  for (int i = 1; i < argc; i++) {
+    std::string a = argv[i];
+    if (a == "--port" && i + 1 < argc) port = atoi(argv[++i]);
+    else if (a == "--data" && i + 1 < argc) dataDir = argv[++i];
+    else if (a == "--threads" && i + 1 < argc) threads = atoi(argv[++i]);
+    else if (a == "--no-sync") sync = false;
+    else {
+      fprintf(stderr, "uso: %s [--port N] [--data DIR] [--threads N] [--no-sync]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  // Un descriptor por dispositivo: se sube el límite al máximo permitido
+  rlimit lim;
+  if (getrlimit(RLIMIT_NOFILE, &lim) == 0) {
+    lim.rlim_cur = lim.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &lim);
+  }
+
+  // Las señales se atienden con sigwait desde este hilo
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+  signal(SIGPIPE, SIG_IGN);
+
+  Store store(dataDir);
+  std::string error;
+  if (!store.open(error)) {
+    fprintf(stderr, "[Ingesta] %s\n", error.c_str());
+    return 1;
+  }
+  HttpServer* serverPtr = nullptr;
+  HttpServer server(
+      port, threads, [&](const HttpRequest& req, HttpResponse& res) { route(store, *serverPtr, req, res); },
+      [&](HttpResponse& res) {
+        if (store.durable() < res.wait) return false;
+        if (store.failed(res.wait)) jsonError(res, 503, "No se pudo guardar");
+        return true;
+      });
+  serverPtr = &server;
+  store.start(sync, [&] { server.notify(); });
+  if (!server.start(error)) {
+    fprintf(stderr, "[Ingesta] %s\n", error.c_str());
+    return 1;
+  }
+  printf("[Ingesta] Escuchando en el puerto %u, %u hilos, datos en %s (%u dispositivos)%s\n", (unsigned)port,
+         threads, dataDir.c_str(), (unsigned)store.stats().devices, sync ? "" : ", sin sync");
+  fflush(stdout);
+
+  int sig;
+  sigwait(&signals, &sig);
+  printf("[Ingesta] Parando...\n");
+  server.stop();
+  store.stop();
+  return 0;
+}
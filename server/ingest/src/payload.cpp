@@ -0,0 +1,77 @@
+#include "payload.h"
+#include "json_scan.h"
+
+static const uint32_t MIN_VALID_EPOCH = 1600000000;  // como en el firmware
+
+bool validDeviceId(std::string_view id) {
+  if (id.empty() || id.size() > 64 || id[0] == '.') return false;
+  for (char c : id) {
+    bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+              c == '_' || c == '-' || c == '.';
+    if (!ok) return false;
+  }
+  return true;
+}
+
+// Un objeto; false si el JSON está mal (se aborta todo el cuerpo).
+static bool parseObject(JsonScanner& json, uint32_t now, Row& row, bool& valid) {
+  row = Row();
+  std::string_view key, type;
+  double ts = 0, value;
+  bool isNull;
+  if (!json.beginObject()) return false;
+  while (json.nextKey(key)) {
+    if (key == "type") json.readString(type);
+    else if (key == "deviceId") json.readString(row.deviceId);
+    else if (key == "mac") json.readString(row.mac);
+    else if (key == "sensor") json.readString(row.sensor);
+    else if (key == "evento") json.readString(row.evento);
+    else if (key == "motivo") json.readString(row.motivo);
+    else if (key == "temp" || key == "tempChip") {
+      if (json.readNumberOrNull(value, isNull) && !isNull) row.temp = value;
+    } else if (key == "hum") {
+      if (json.readNumberOrNull(value, isNull) && !isNull) row.hum = value;
+    } else if (key == "ts") {
+      json.readNumber(ts);
+    } else {
+      json.skipValue();
+    }
+  }
+  if (!json.ok()) return false;
+
+  row.ts = ts >= MIN_VALID_EPOCH && ts < 4294967296.0 ? (uint32_t)ts : now;
+  if (type == "Datos") row.kind = ROW_DATOS;
+  else if (type == "Estados") row.kind = ROW_ESTADOS;
+  else {
+    valid = false;
+    return true;
+  }
+  valid = validDeviceId(row.deviceId) && row.sensor.size() <= 8 && row.evento.size() <= 64 &&
+          row.motivo.size() <= 256 &&
+          (row.kind == ROW_ESTADOS ? !row.evento.empty() : !std::isnan(row.temp));
+  return true;
+}
+
+ParseResult parseRows(std::string_view body, uint32_t now, std::vector<Row>& rows) {
+  ParseResult result = {true, 0, nullptr};
+  size_t start = rows.size();
+  JsonScanner json(body);
+  Row row;
+  bool valid;
+  if (json.peek() == '[') {
+    json.beginArray();
+    while (json.nextElement()) {
+      if (!parseObject(json, now, row, valid)) break;
+      if (valid) rows.push_back(row);
+      else result.rejected++;
+    }
+  } else if (parseObject(json, now, row, valid)) {
+    if (valid) rows.push_back(row);
+    else result.rejected++;
+  }
+  if (!json.ok() || !json.atEnd()) {
+    rows.resize(start);
+    result = {false, 0, "JSON no válido"};
+  }
+  return result;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// ====== FILAS DEL FIRMWARE ======
+// Lo mismo que recibía el Apps Script: un objeto por fila o, desde el outbox
+// del firmware, un array de objetos por POST.
+//
+//   {"type":"Datos","deviceId":"ESP32_01","mac":"A1B2C3","sensor":"dht0",
+//    "temp":23.45,"hum":55.12,"ts":1729180000}
+//   {"type":"Estados","deviceId":"ESP32_01","mac":"A1B2C3","evento":"Alerta",
+//    "motivo":"...","tempChip":71.2}
+//
+// Las cadenas son vistas sobre el cuerpo de la petición: solo valen mientras
+// éste exista. "ts" es opcional (el firmware lo omite sin hora NTP); sin él
+// se usa la hora de llegada.
+
+enum RowKind : uint8_t {
+  ROW_DATOS = 0,
+  ROW_ESTADOS = 1
+};
+
+struct Row {
+  RowKind kind;
+  std::string_view deviceId;
+  std::string_view mac;
+  std::string_view sensor;   // solo Datos; vacío = "dht0" (firmwares de un sensor)
+  std::string_view evento;   // solo Estados, escapes sin resolver
+  std::string_view motivo;   // solo Estados, escapes sin resolver
+  double temp = NAN;         // Datos: temperatura / Estados: tempChip
+  double hum = NAN;
+  uint32_t ts = 0;
+};
+
+struct ParseResult {
+  bool ok;              // false si el cuerpo no es JSON válido
+  uint32_t rejected;    // objetos válidos a los que les falta algo o sobra rango
+  const char* error;
+};
+
+// Añade a rows las filas válidas del cuerpo. Un cuerpo mal formado no añade
+// ninguna; una fila incompleta se cuenta en rejected y se sigue con la próxima.
+ParseResult parseRows(std::string_view body, uint32_t now, std::vector<Row>& rows);
+
+// Ids que se pueden usar tal cual como nombre de directorio.
+bool validDeviceId(std::string_view id);
@@ -0,0 +1,422 @@
+#include "store.h"
+#include "json_scan.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdarg>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static uint64_t nowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool writeAll(int fd, const void* data, size_t len) {
+  const char* p = (const char*)data;
+  while (len) {
+    ssize_t n = ::write(fd, p, len);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    p += n;
+    len -= n;
+  }
+  return true;
+}
+
+static void appendf(std::string& out, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+static void appendf(std::string& out, const char* fmt, ...) {
+  char buf[256];
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+  if (n > 0) out.append(buf, std::min<size_t>(n, sizeof(buf) - 1));
+}
+
+// "24:6F:28:AA:BB:CC"; cualquier otra cosa no se guarda
+static bool validMac(std::string_view mac) {
+  if (mac.empty() || mac.size() > 17) return false;
+  for (char c : mac) {
+    if (!isxdigit((unsigned char)c) && c != ':') return false;
+  }
+  return true;
+}
+
+static std::string_view sensorName(const StoredReading& r) {
+  return std::string_view(r.sensor, strnlen(r.sensor, sizeof(r.sensor)));
+}
+
+Store::Store(std::string root) : root_(std::move(root)) {}
+
+Store::~Store() {
+  stop();
+  closeAll();
+  if (rootFd_ >= 0) ::close(rootFd_);
+}
+
+// ====== ARRANQUE ======
+bool Store::open(std::string& error) {
+  if (mkdir(root_.c_str(), 0755) < 0 && errno != EEXIST) {
+    error = "no se pudo crear " + root_ + ": " + strerror(errno);
+    return false;
+  }
+  rootFd_ = ::open(root_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (rootFd_ < 0) {
+    error = "no se pudo abrir " + root_ + ": " + strerror(errno);
+    return false;
+  }
+  DIR* dir = opendir(root_.c_str());
+  if (!dir) {
+    error = "no se pudo leer " + root_;
+    return false;
+  }
+  while (dirent* entry = readdir(dir)) {
+    if (validDeviceId(entry->d_name)) load(entry->d_name);
+  }
+  closedir(dir);
+  stats_.devices = devices_.size();
+  return true;
+}
+
+// Carga un dispositivo de disco y reconstruye su índice. Si un corte dejó
+// una lectura a medias al final, se recorta.
+bool Store::load(const std::string& id) {
+  std::string path = root_ + "/" + id;
+  struct stat st;
+  if (stat(path.c_str(), &st) < 0 || !S_ISDIR(st.st_mode)) return false;
+
+  auto d = std::make_unique<Device>();
+  d->id = id;
+  if (FILE* f = fopen((path + "/mac").c_str(), "r")) {
+    char mac[32] = "";
+    if (fgets(mac, sizeof(mac), f)) d->mac = std::string(mac, strcspn(mac, "\n"));
+    fclose(f);
+  }
+  int fd = ::open((path + "/readings.bin").c_str(), O_RDWR | O_CLOEXEC);
+  if (fd >= 0) {
+    off_t size = lseek(fd, 0, SEEK_END);
+    uint64_t count = size / sizeof(StoredReading);
+    if ((off_t)(count * sizeof(StoredReading)) != size && ftruncate(fd, count * sizeof(StoredReading)) < 0) {
+      count = 0;
+    }
+    std::vector<StoredReading> block(STORE_INDEX_STRIDE);
+    for (uint64_t done = 0; done < count;) {
+      size_t n = std::min<uint64_t>(STORE_INDEX_STRIDE, count - done);
+      ssize_t got = pread(fd, block.data(), n * sizeof(StoredReading), done * sizeof(StoredReading));
+      if (got != (ssize_t)(n * sizeof(StoredReading))) break;
+      indexAppend(*d, block.data(), n);
+      done += n;
+    }
+    ::close(fd);
+  }
+  devices_[id] = std::move(d);
+  return true;
+}
+
+// ====== ESCRITURA ======
+Store::Device* Store::device(std::string_view id) {
+  auto it = devices_.find(std::string(id));
+  if (it != devices_.end()) return it->second.get();
+  auto d = std::make_unique<Device>();
+  d->id = std::string(id);
+  Device* raw = d.get();
+  devices_[d->id] = std::move(d);
+  stats_.devices = devices_.size();
+  return raw;
+}
+
+uint64_t Store::append(const Row* rows, size_t count) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Device* d = nullptr;
+  for (size_t i = 0; i < count; i++) {
+    const Row& row = rows[i];
+    // Un lote del firmware es siempre del mismo dispositivo: una búsqueda
+    if (!d || row.deviceId != d->id) d = device(row.deviceId);
+    if (validMac(row.mac) && row.mac != d->mac) {
+      d->mac = std::string(row.mac);
+      d->macChanged = true;
+    }
+    if (row.kind == ROW_DATOS) {
+      StoredReading r = {};
+      r.ts = row.ts;
+      r.temp = (float)row.temp;
+      r.hum = std::isnan(row.hum) ? NAN : (float)row.hum;
+      std::string_view sensor = row.sensor.empty() ? std::string_view("dht0") : row.sensor;
+      memcpy(r.sensor, sensor.data(), std::min(sensor.size(), sizeof(r.sensor)));
+      d->pending.push_back(r);
+    } else {
+      // evento y motivo ya vienen escapados: se copian tal cual
+      std::string& out = d->pendingEvents;
+      appendf(out, "{\"ts\":%u,\"evento\":\"", (unsigned)row.ts);
+      out.append(row.evento);
+      out.append("\",\"motivo\":\"");
+      out.append(row.motivo);
+      if (std::isnan(row.temp)) out.append("\",\"tempChip\":null}\n");
+      else appendf(out, "\",\"tempChip\":%.2f}\n", row.temp);
+    }
+    if (!d->dirty) {
+      d->dirty = true;
+      dirty_.push_back(d);
+    }
+  }
+  pendingRows_ += count;
+  if (pendingRows_ >= STORE_EARLY_COMMIT_ROWS) wake_.notify_one();
+  return next_;
+}
+
+void Store::indexAppend(Device& d, const StoredReading* records, size_t count) {
+  for (size_t i = 0; i < count; i++, d.count++) {
+    uint32_t ts = records[i].ts;
+    if (d.count % STORE_INDEX_STRIDE == 0) d.index.push_back({ts, ts});
+    IndexEntry& e = d.index.back();
+    e.minTs = std::min(e.minTs, ts);
+    e.maxTs = std::max(e.maxTs, ts);
+    d.lastTs = std::max(d.lastTs, ts);
+  }
+}
+
+// Los descriptores quedan abiertos entre commits; si se acaban, se cierran
+// todos y se vuelve a empezar.
+int Store::openAppend(Device& d, const char* file, int& fd) {
+  if (fd >= 0) return fd;
+  std::string dir = root_ + "/" + d.id;
+  std::string path = dir + "/" + file;
+  for (int attempt = 0; attempt < 2 && fd < 0; attempt++) {
+    if (mkdir(dir.c_str(), 0755) < 0 && errno != EEXIST && errno != EMFILE) return -1;
+    fd = ::open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0 && (errno == EMFILE || errno == ENFILE)) closeAll();
+  }
+  if (fd >= 0) openFiles_.push_back(&d);
+  return fd;
+}
+
+void Store::closeAll() {
+  for (Device* d : openFiles_) {
+    if (d->readingsFd >= 0) ::close(d->readingsFd);
+    if (d->eventsFd >= 0) ::close(d->eventsFd);
+    d->readingsFd = d->eventsFd = -1;
+  }
+  openFiles_.clear();
+}
+
+bool Store::commit() {
+  std::vector<Device*> batch;
+  uint64_t epoch, rows;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (dirty_.empty()) return false;
+    batch.swap(dirty_);
+    for (Device* d : batch) {
+      d->writing.swap(d->pending);
+      d->writingEvents.swap(d->pendingEvents);
+      d->dirty = false;
+    }
+    epoch = next_++;
+    rows = pendingRows_;
+    pendingRows_ = 0;
+  }
+
+  uint64_t start = nowUs();
+  uint64_t readings = 0, events = 0;
+  bool ok = true;
+  for (Device* d : batch) {
+    if (!d->writing.empty()) {
+      int fd = openAppend(*d, "readings.bin", d->readingsFd);
+      if (fd < 0 || !writeAll(fd, d->writing.data(), d->writing.size() * sizeof(StoredReading))) {
+        // Sin índice para estas lecturas y sin dejar un registro a medias
+        fprintf(stderr, "[Store] Error escribiendo %s: %s\n", d->id.c_str(), strerror(errno));
+        if (fd >= 0 && ftruncate(fd, d->count * sizeof(StoredReading)) < 0) {}
+        d->writing.clear();
+        ok = false;
+      }
+      readings += d->writing.size();
+    }
+    if (!d->writingEvents.empty()) {
+      int fd = openAppend(*d, "events.jsonl", d->eventsFd);
+      off_t before = fd >= 0 ? lseek(fd, 0, SEEK_END) : -1;
+      if (before < 0 || !writeAll(fd, d->writingEvents.data(), d->writingEvents.size())) {
+        // Sin una línea a medias que se pegaría al próximo evento
+        fprintf(stderr, "[Store] Error escribiendo eventos de %s: %s\n", d->id.c_str(), strerror(errno));
+        if (before >= 0 && ftruncate(fd, before) < 0) {}
+        ok = false;
+      } else {
+        events += std::count(d->writingEvents.begin(), d->writingEvents.end(), '\n');
+      }
+      d->writingEvents.clear();
+    }
+  }
+  // Un único sync para todo el grupo
+  if (sync_ && syncfs(rootFd_) < 0) {
+    fprintf(stderr, "[Store] syncfs: %s\n", strerror(errno));
+    ok = false;
+  }
+  uint64_t elapsed = nowUs() - start;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (Device* d : batch) {
+    indexAppend(*d, d->writing.data(), d->writing.size());
+    d->writing.clear();
+    if (d->macChanged) {
+      d->macChanged = false;
+      if (FILE* f = fopen((root_ + "/" + d->id + "/mac").c_str(), "w")) {
+        fprintf(f, "%s\n", d->mac.c_str());
+        fclose(f);
+      }
+    }
+  }
+  stats_.readings += readings;
+  stats_.events += events;
+  stats_.commits++;
+  stats_.commitRows += rows;
+  stats_.lastCommitUs = elapsed;
+  stats_.maxCommitUs = std::max(stats_.maxCommitUs, elapsed);
+  // El fallo se anota antes de publicar la época: nadie la ve durable sin él
+  if (!ok) {
+    stats_.failedCommits++;
+    failedEpochs_.push_back(epoch);
+    if (failedEpochs_.size() > STORE_FAILED_EPOCHS) {
+      failedFloor_ = failedEpochs_.front();
+      failedEpochs_.pop_front();
+    }
+    lastFailed_.store(epoch, std::memory_order_release);
+  }
+  durable_.store(epoch, std::memory_order_release);
+  return true;
+}
+
+bool Store::failed(uint64_t epoch) {
+  // Lo normal es que no haya fallado ninguna: sin tomar el mutex
+  if (epoch > lastFailed_.load(std::memory_order_acquire)) return false;
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (epoch <= failedFloor_) return true;
+  return std::binary_search(failedEpochs_.begin(), failedEpochs_.end(), epoch);
+}
+
+void Store::run() {
+  while (running_) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait_for(lock, std::chrono::milliseconds(STORE_COMMIT_MS),
+                     [this] { return !running_ || pendingRows_ >= STORE_EARLY_COMMIT_ROWS; });
+    }
+    if (commit() && onDurable_) onDurable_();
+  }
+  if (commit() && onDurable_) onDurable_();
+}
+
+void Store::start(bool sync, std::function<void()> onDurable) {
+  sync_ = sync;
+  onDurable_ = std::move(onDurable);
+  running_ = true;
+  thread_ = std::thread(&Store::run, this);
+}
+
+void Store::stop() {
+  if (!running_.exchange(false)) return;
+  wake_.notify_one();
+  if (thread_.joinable()) thread_.join();
+}
+
+// ====== CONSULTAS ======
+bool Store::readings(std::string_view device, uint32_t from, uint32_t to, std::string_view sensor,
+                     size_t limit, std::string& csv) {
+  std::vector<IndexEntry> index;
+  uint64_t count;
+  std::string path;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = devices_.find(std::string(device));
+    if (it == devices_.end()) return false;
+    index = it->second->index;
+    count = it->second->count;
+    path = root_ + "/" + it->second->id + "/readings.bin";
+  }
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return true;  // aún sin lecturas en disco
+
+  std::vector<StoredReading> block(STORE_INDEX_STRIDE);
+  size_t emitted = 0;
+  for (size_t i = 0; i < index.size() && emitted < limit; i++) {
+    if (index[i].maxTs < from || index[i].minTs > to) continue;
+    uint64_t first = (uint64_t)i * STORE_INDEX_STRIDE;
+    size_t n = std::min<uint64_t>(STORE_INDEX_STRIDE, count - first);
+    ssize_t got = pread(fd, block.data(), n * sizeof(StoredReading), first * sizeof(StoredReading));
+    if (got < 0) break;
+    n = got / sizeof(StoredReading);
+    for (size_t k = 0; k < n && emitted < limit; k++) {
+      const StoredReading& r = block[k];
+      if (r.ts < from || r.ts > to) continue;
+      std::string_view name = sensorName(r);
+      if (!sensor.empty() && name != sensor) continue;
+      // Mismo CSV que /api/history del firmware
+      if (std::isnan(r.hum)) appendf(csv, "%u,%.2f,,", (unsigned)r.ts, r.temp);
+      else appendf(csv, "%u,%.2f,%.2f,", (unsigned)r.ts, r.temp, r.hum);
+      csv.append(name);
+      csv.push_back('\n');
+      emitted++;
+    }
+  }
+  ::close(fd);
+  return true;
+}
+
+bool Store::events(std::string_view device, uint32_t from, uint32_t to, std::string& json) {
+  std::string path;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = devices_.find(std::string(device));
+    if (it == devices_.end()) return false;
+    path = root_ + "/" + it->second->id + "/events.jsonl";
+  }
+  json.push_back('[');
+  bool first = true;
+  if (FILE* f = fopen(path.c_str(), "r")) {
+    char line[1024];
+    while (fgets(line, sizeof(line), f)) {
+      size_t len = strcspn(line, "\n");
+      JsonScanner scan(std::string_view(line, len));
+      std::string_view key;
+      double ts = 0;
+      scan.beginObject();
+      while (scan.nextKey(key)) {
+        if (key == "ts") scan.readNumber(ts);
+        else scan.skipValue();
+      }
+      if (!scan.ok() || ts < from || ts > to) continue;
+      if (!first) json.push_back(',');
+      json.append(line, len);
+      first = false;
+    }
+    fclose(f);
+  }
+  json.push_back(']');
+  return true;
+}
+
+void Store::devices(std::string& json) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  json.push_back('[');
+  bool first = true;
+  for (auto& entry : devices_) {
+    const Device& d = *entry.second;
+    if (!first) json.push_back(',');
+    appendf(json, "{\"deviceId\":\"%s\",\"mac\":\"%s\",\"readings\":%llu,\"lastTs\":%u}", d.id.c_str(),
+            d.mac.c_str(), (unsigned long long)d.count, (unsigned)d.lastTs);
+    first = false;
+  }
+  json.push_back(']');
+}
+
+StoreStats Store::stats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  StoreStats s = stats_;
+  s.pending = pendingRows_;
+  return s;
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "payload.h"
+
+// ====== ALMACÉN POR DISPOSITIVO CON COMMIT EN GRUPO ======
+// Un directorio por deviceId bajo la raíz, con ficheros de solo añadir:
+//
+//   <raíz>/<deviceId>/readings.bin   StoredReading de 20 bytes por lectura
+//   <raíz>/<deviceId>/events.jsonl   una línea JSON por evento (hoja Estados)
+//   <raíz>/<deviceId>/mac            última MAC recibida
+//
+// Los hilos de red solo copian las filas a la cola del próximo commit
+// (append) y reciben la época en la que serán durables. Un hilo aparte hace
+// cada STORE_COMMIT_MS un commit de todo lo pendiente: un write() por
+// dispositivo y un único syncfs() para el grupo entero, y después avisa para
+// que se respondan las peticiones de esa época. Así cada POST se confirma
+// solo cuando sus filas están en disco, pero el coste del fsync se reparte
+// entre todas las peticiones que llegaron en ese intervalo.
+//
+// Si falla una escritura o el syncfs, la época se marca como fallida
+// (failed()) y sus peticiones reciben un 5xx: el firmware no borra nada de su
+// outbox y lo reintenta. Lo que sí llegó a escribirse puede quedar repetido,
+// pero nunca se confirma algo que no está en disco.
+//
+// Para las consultas por rango se guarda en RAM el ts mínimo y máximo de cada
+// tramo de STORE_INDEX_STRIDE lecturas: solo se leen los tramos que tocan el
+// rango, aunque un dispositivo suba tarde lo que tenía en el outbox.
+
+#define STORE_COMMIT_MS 5
+#define STORE_INDEX_STRIDE 1024
+#define STORE_EARLY_COMMIT_ROWS 50000  // con tanto pendiente no se espera al intervalo
+#define STORE_FAILED_EPOCHS 4096       // épocas fallidas recordadas; las anteriores se dan por fallidas
+
+struct StoredReading {
+  uint32_t ts;
+  float temp;
+  float hum;        // NAN si el sensor no la mide
+  char sensor[8];   // id del sensor, sin '\0' si ocupa los 8
+};
+
+static_assert(sizeof(StoredReading) == 20, "Registro de 20 bytes");
+
+struct StoreStats {
+  uint64_t readings;      // lecturas confirmadas desde el arranque
+  uint64_t events;
+  uint64_t commits;
+  uint64_t failedCommits; // commits con algún error de escritura (sus POST reciben 5xx)
+  uint64_t commitRows;    // filas de todos los commits (media = commitRows / commits)
+  uint64_t lastCommitUs;  // duración del último commit (escritura + sync)
+  uint64_t maxCommitUs;
+  uint64_t pending;       // filas esperando al próximo commit
+  uint32_t devices;
+};
+
+class Store {
+ public:
+  explicit Store(std::string root);
+  ~Store();
+
+  // Crea la raíz si no existe y carga los dispositivos que ya tenga.
+  bool open(std::string& error);
+  // Hilo de commit. onDurable se llama tras cada commit (desde ese hilo).
+  // Con sync=false no hay syncfs: más rápido, pero un corte de luz puede
+  // perder lo confirmado en los últimos segundos.
+  void start(bool sync, std::function<void()> onDurable);
+  void stop();
+
+  // Encola las filas y devuelve la época en la que estarán en disco.
+  uint64_t append(const Row* rows, size_t count);
+  uint64_t durable() const { return durable_.load(std::memory_order_acquire); }
+  // Para una época ya durable: true si algo de ella no llegó a disco.
+  bool failed(uint64_t epoch);
+
+  // Consultas. false si el dispositivo no existe.
+  bool readings(std::string_view device, uint32_t from, uint32_t to, std::string_view sensor,
+                size_t limit, std::string& csv);
+  bool events(std::string_view device, uint32_t from, uint32_t to, std::string& json);
+  void devices(std::string& json);
+  StoreStats stats();
+
+ private:
+  struct IndexEntry {
+    uint32_t minTs;
+    uint32_t maxTs;
+  };
+
+  struct Device {
+    std::string id;
+    std::string mac;
+    uint64_t count = 0;              // lecturas ya en disco
+    uint32_t lastTs = 0;
+    std::vector<IndexEntry> index;
+    // Pendiente del próximo commit (protegido por mutex_)
+    std::vector<StoredReading> pending;
+    std::string pendingEvents;
+    bool macChanged = false;
+    bool dirty = false;
+    // Solo del hilo de commit
+    std::vector<StoredReading> writing;
+    std::string writingEvents;
+    int readingsFd = -1;
+    int eventsFd = -1;
+  };
+
+  Device* device(std::string_view id);  // con mutex_ tomado
+  bool load(const std::string& id);
+  void indexAppend(Device& d, const StoredReading* records, size_t count);
+  int openAppend(Device& d, const char* file, int& fd);
+  void closeAll();
+  bool commit();
+  void run();
+
+  std::string root_;
+  int rootFd_ = -1;
+  bool sync_ = true;
+  std::function<void()> onDurable_;
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::unordered_map<std::string, std::unique_ptr<Device>> devices_;
+  std::vector<Device*> dirty_;
+  std::vector<Device*> openFiles_;  // con descriptores abiertos (hilo de commit)
+  uint64_t next_ = 1;        // época del próximo commit
+  uint64_t pendingRows_ = 0;
+  StoreStats stats_ = {};
+  std::atomic<uint64_t> durable_{0};
+  std::deque<uint64_t> failedEpochs_;  // crecientes (mutex_)
+  uint64_t failedFloor_ = 0;           // hasta aquí ya no se recuerda: se dan por fallidas
+  std::atomic<uint64_t> lastFailed_{0};
+  std::atomic<bool> running_{false};
+  std::thread thread_;
+};